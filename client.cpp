@@ -26,6 +26,8 @@
 #include <queue>
 #include <condition_variable>
 #include <map>
+#include <fstream>
+#include <iterator>
 
 // POSIX socket headers
 #include <sys/socket.h>
@@ -47,6 +49,8 @@
 // PROTOCOL LAYER (Refactored to include/protocol/)
 // ============================================================================
 #include "include/protocol/all.h"
+#include <openssl/evp.h>
+#include <sys/stat.h>
 
 // Using declarations for protocol utilities
 using english_learning::protocol::getJsonValue;
@@ -56,6 +60,8 @@ using english_learning::protocol::parseJsonArray;
 using english_learning::protocol::escapeJson;
 using english_learning::protocol::unescapeJson;
 using english_learning::protocol::utils::getCurrentTimestamp;
+using english_learning::protocol::utils::base64Encode;
+using english_learning::protocol::utils::base64Decode;
 namespace MessageType = english_learning::protocol::MessageType;
 
 // ============================================================================
@@ -70,6 +76,7 @@ std::string currentRole = "student";  // Role: student, teacher, admin
 std::atomic<bool> running(true);
 std::atomic<bool> loggedIn(false);
 std::atomic<bool> inChatMode(false);
+std::atomic<bool> partnerMessagesUnread(false);  // shown live in the open chat, not yet marked read
 
 // [FIX] Mutex để bảo vệ socket khi gửi dữ liệu
 std::mutex socketMutex;
@@ -103,11 +110,42 @@ std::string currentChatPartnerId = "";
 std::string currentChatPartnerName = "";
 std::mutex chatPartnerMutex;
 
+// Vị trí trong inbox chat của server: gửi lại khi login để chỉ nhận phần bị lỡ
+std::string inboxEpoch = "";     // lượt chạy server mà seq thuộc về
+std::string inboxEmail = "";     // tài khoản sở hữu inbox
+uint64_t inboxLastSeq = 0;       // seq lớn nhất đã nhận
+std::mutex inboxMutex;
+
+// Thư mục cache nội dung (bài học, trò chơi) của server đang kết nối
+std::string catalogCacheDir = "";   // "cache/<server>_<port>", set in main
+
+// Tệp đính kèm đã hiện trong cuộc trò chuyện đang mở, đánh số cho /save
+struct ShownAttachment {
+    std::string attachmentId;
+    std::string fileName;
+};
+std::vector<ShownAttachment> shownAttachments;
+std::mutex shownAttachmentsMutex;
+
 // ============================================================================
 // HÀM TIỆN ÍCH
 // ============================================================================
 // NOTE: getCurrentTimestamp() is now provided by include/protocol/utils.h
 
+// SHA-256 of data as lowercase hex
+std::string sha256Hex(const std::string& data) {
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digestLength = 0;
+    EVP_Digest(data.data(), data.size(), digest, &digestLength, EVP_sha256(), nullptr);
+    static const char hexDigits[] = "0123456789abcdef";
+    std::string hex;
+    for (unsigned int i = 0; i < digestLength; ++i) {
+        hex += hexDigits[digest[i] >> 4];
+        hex += hexDigits[digest[i] & 15];
+    }
+    return hex;
+}
+
 std::string generateMessageId() {
     static int counter = 0;
     return "msg_" + std::to_string(++counter);
@@ -155,6 +193,20 @@ void waitEnter() {
     std::cin.get();
 }
 
+// " [#n name, size]" for each attachment of a message in the open
+// conversation; the number is what /save takes
+std::string describeAttachments(const std::string& messageJson) {
+    std::string described;
+    std::lock_guard<std::mutex> lock(shownAttachmentsMutex);
+    for (const std::string& item : parseJsonArray(getJsonArray(messageJson, "attachments"))) {
+        shownAttachments.push_back({getJsonValue(item, "attachmentId"), getJsonValue(item, "fileName")});
+        unsigned long long kb = (std::strtoull(getJsonValue(item, "size").c_str(), nullptr, 10) + 1023) / 1024;
+        described += " [📎 #" + std::to_string(shownAttachments.size()) + " " +
+                     getJsonValue(item, "fileName") + ", " + std::to_string(kb) + " KB]";
+    }
+    return described;
+}
+
 // NOTE: JSON parsing functions (getJsonValue, getJsonObject, getJsonArray,
 // parseJsonArray, escapeJson, unescapeJson) are now provided by
 // include/protocol/json_parser.h
@@ -164,6 +216,28 @@ void waitEnter() {
 // Xử lý tin nhắn push từ server (tin nhắn chat real-time)
 // ============================================================================
 
+bool sendMessage(const std::string& message);
+
+// Fields for LOGIN_REQUEST that let the server resume this client's inbox
+std::string inboxResumeFields(const std::string& email) {
+    std::lock_guard<std::mutex> lock(inboxMutex);
+    if (inboxEpoch.empty() || inboxEmail != email) return "";
+    return R"(,"inboxEpoch":)" + inboxEpoch + R"(,"lastSeq":)" + std::to_string(inboxLastSeq);
+}
+
+// Called on the receive thread, so it runs before any push that follows the login
+void trackInboxEpoch(const std::string& loginResponse) {
+    std::string data = getJsonObject(loginResponse, "data");
+    std::string epoch = getJsonValue(data, "inboxEpoch");
+    if (epoch.empty()) return;
+
+    std::lock_guard<std::mutex> lock(inboxMutex);
+    std::string email = getJsonValue(data, "email");
+    if (epoch != inboxEpoch || email != inboxEmail) inboxLastSeq = 0;  // sequences restarted
+    inboxEpoch = epoch;
+    inboxEmail = email;
+}
+
 void handlePushNotification(const std::string& message) {
     std::string messageType = getJsonValue(message, "messageType");
 
@@ -174,6 +248,14 @@ void handlePushNotification(const std::string& message) {
         std::string senderName = getJsonValue(payload, "senderName");
         std::string messageContent = getJsonValue(payload, "messageContent");
 
+        // Pushes arrive in seq order; anything at or below the last one was
+        // already shown before a reconnect
+        uint64_t seq = std::strtoull(getJsonValue(payload, "seq").c_str(), nullptr, 10);
+        if (seq > 0) {
+            std::lock_guard<std::mutex> lock(inboxMutex);
+            if (seq <= inboxLastSeq) return;
+        }
+
         // [FIX] Kiểm tra xem có đang chat với người này không
         bool isChattingWithSender = false;
         {
@@ -183,8 +265,10 @@ void handlePushNotification(const std::string& message) {
 
         if (isChattingWithSender) {
             // [FIX] Đang chat với người này -> hiển thị tin nhắn trực tiếp
+            partnerMessagesUnread = true;
             std::lock_guard<std::mutex> lock(printMutex);
-            std::cout << "\n\033[33m" << senderName << ": \033[0m" << messageContent << "\n";
+            std::cout << "\n\033[33m" << senderName << ": \033[0m" << messageContent
+                      << describeAttachments(payload) << "\n";
             std::cout << "\033[32mYou: \033[0m" << std::flush;
         } else {
             // Không đang chat với người này -> lưu thông báo và hiện popup
@@ -207,6 +291,15 @@ void handlePushNotification(const std::string& message) {
                 std::cout << std::flush;
             }
         }
+
+        if (seq > 0) {
+            {
+                std::lock_guard<std::mutex> lock(inboxMutex);
+                inboxLastSeq = seq;
+            }
+            sendMessage(R"({"messageType":"INBOX_ACK","sessionToken":")" + sessionToken +
+                        R"(","payload":{"seq":)" + std::to_string(seq) + "}}");
+        }
     }
     else if (messageType == "UNREAD_MESSAGES_NOTIFICATION") {
         // Thông báo có tin nhắn chưa đọc khi mới login
@@ -234,6 +327,7 @@ void handlePushNotification(const std::string& message) {
                 for (const std::string& msg : messages) {
                     std::string senderName = getJsonValue(msg, "senderName");
                     std::string content = getJsonValue(msg, "content");
+                    if (content.empty() && !getJsonArray(msg, "attachments").empty()) content = "[📎 attachment]";
                     std::string preview = content.length() > 25 ? content.substr(0, 25) + "..." : content;
                     std::cout << "\033[33m║  \033[36m" << senderName << "\033[0m: " << preview << "\n";
                 }
@@ -245,6 +339,76 @@ void handlePushNotification(const std::string& message) {
             }
         }
     }
+    else if (messageType == "CHANNEL_MESSAGE") {
+        // Tin nhắn nhóm (kênh lớp học / trình độ)
+        std::string payload = getJsonObject(message, "payload");
+        std::string channelId = getJsonValue(payload, "channelId");
+        std::string channelName = getJsonValue(payload, "channelName");
+        std::string senderName = getJsonValue(payload, "senderName");
+        std::string messageContent = getJsonValue(payload, "messageContent");
+
+        bool inChannel = false;
+        {
+            std::lock_guard<std::mutex> lock(chatPartnerMutex);
+            inChannel = (inChatMode && currentChatPartnerId == channelId);
+        }
+
+        std::lock_guard<std::mutex> lock(printMutex);
+        if (inChannel) {
+            std::cout << "\n\033[33m" << senderName << ": \033[0m" << messageContent
+                      << describeAttachments(payload) << "\n";
+            std::cout << "\033[32mYou: \033[0m" << std::flush;
+        } else if (canShowNotification) {
+            std::cout << "\n\033[33m📢 [" << channelName << "] \033[36m" << senderName
+                      << "\033[0m: " << messageContent << "\n" << std::flush;
+        }
+    }
+    else if (messageType == "PRESENCE_UPDATE") {
+        // Batched online/offline changes; only the current chat partner is shown
+        std::string payload = getJsonObject(message, "payload");
+        std::vector<std::string> changes = parseJsonArray(getJsonArray(payload, "changes"));
+
+        std::string partnerId, partnerName;
+        {
+            std::lock_guard<std::mutex> lock(chatPartnerMutex);
+            if (inChatMode) {
+                partnerId = currentChatPartnerId;
+                partnerName = currentChatPartnerName;
+            }
+        }
+        if (partnerId.empty()) return;
+
+        for (const std::string& change : changes) {
+            if (getJsonValue(change, "userId") != partnerId) continue;
+            bool online = getJsonValue(change, "status") == "online";
+            std::lock_guard<std::mutex> lock(printMutex);
+            std::cout << "\n\033[90m[" << partnerName << (online ? " is now online" : " went offline")
+                      << "]\033[0m\n";
+            std::cout << "\033[32mYou: \033[0m" << std::flush;
+        }
+    }
+    else if (messageType == "TYPING") {
+        // Chỉ hiện khi đang mở đúng cuộc trò chuyện; "stopped" không cần hiển thị
+        std::string payload = getJsonObject(message, "payload");
+        if (getJsonValue(payload, "state") != "typing") return;
+        {
+            std::lock_guard<std::mutex> lock(chatPartnerMutex);
+            if (!inChatMode || currentChatPartnerId != getJsonValue(payload, "conversationId")) return;
+        }
+        std::lock_guard<std::mutex> lock(printMutex);
+        std::cout << "\n\033[90m[" << getJsonValue(payload, "userName") << " is typing...]\033[0m\n";
+        std::cout << "\033[32mYou: \033[0m" << std::flush;
+    }
+    else if (messageType == "READ_RECEIPT") {
+        std::string payload = getJsonObject(message, "payload");
+        {
+            std::lock_guard<std::mutex> lock(chatPartnerMutex);
+            if (!inChatMode || currentChatPartnerId != getJsonValue(payload, "conversationId")) return;
+        }
+        std::lock_guard<std::mutex> lock(printMutex);
+        std::cout << "\n\033[90m[Seen by " << getJsonValue(payload, "readerName") << "]\033[0m\n";
+        std::cout << "\033[32mYou: \033[0m" << std::flush;
+    }
     // Voice Call notifications
     else if (messageType == "VOICE_CALL_INCOMING") {
         std::string payload = getJsonObject(message, "payload");
@@ -385,11 +549,14 @@ void receiveThreadFunc() {
 
             if (messageType == "RECEIVE_MESSAGE" || messageType == "UNREAD_MESSAGES_NOTIFICATION" ||
                 messageType == "VOICE_CALL_INCOMING" || messageType == "VOICE_CALL_ACCEPTED" ||
-                messageType == "VOICE_CALL_REJECTED" || messageType == "VOICE_CALL_ENDED") {
+                messageType == "VOICE_CALL_REJECTED" || messageType == "VOICE_CALL_ENDED" ||
+                messageType == "PRESENCE_UPDATE" || messageType == "CHANNEL_MESSAGE" ||
+                messageType == "TYPING" || messageType == "READ_RECEIPT") {
                 // [FIX] Đây là push notification, xử lý ngay
                 handlePushNotification(buffer);
             } else {
                 // [FIX] Đây là response cho request, đưa vào queue
+                if (messageType == "LOGIN_RESPONSE") trackInboxEpoch(buffer);
                 {
                     std::lock_guard<std::mutex> lock(responseQueueMutex);
                     responseQueue.push(buffer);
@@ -452,11 +619,61 @@ std::string waitForResponse(int timeoutMs = 10000) {
 }
 
 // [FIX] Gửi request và chờ response (sử dụng queue thay vì blocking recv)
+// A RATE_LIMITED answer is retried after the delay the server asks for, a
+// few times at most, so callers only see it if the limit persists
 std::string sendAndReceive(const std::string& request) {
-    if (!sendMessage(request)) {
-        return "";
+    const int maxAttempts = 3;
+    for (int attempt = 1;; ++attempt) {
+        if (!sendMessage(request)) {
+            return "";
+        }
+        std::string response = waitForResponse();
+        if (attempt == maxAttempts || getJsonValue(response, "messageType") != "RATE_LIMITED") return response;
+
+        long long retryAfterMs = std::atoll(getJsonValue(response, "retryAfterMs").c_str());
+        std::this_thread::sleep_for(std::chrono::milliseconds(std::min(std::max(retryAfterMs, 100LL), 5000LL)));
     }
-    return waitForResponse();
+}
+
+// Gửi request nội dung (GET_LESSONS, GET_LESSON_DETAIL, GET_GAME_LIST) qua
+// cache trên đĩa. The last response to the same request by the same user is
+// kept in catalogCacheDir; its version goes out as ifVersion, and when the
+// server answers not_modified the cached response is returned instead.
+// payloadFields are the payload's members without braces.
+std::string sendCatalogRequest(const std::string& messageType, const std::string& payloadFields) {
+    std::string path = catalogCacheDir + "/" +
+                       sha256Hex(currentUserId + "\n" + messageType + "\n" + payloadFields).substr(0, 32) + ".json";
+    std::ifstream in(path, std::ios::binary);
+    std::string cached((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::string version = cached.empty() ? "" : getJsonValue(getJsonObject(cached, "data"), "version");
+
+    std::string request = R"({"messageType":")" + messageType + R"(","messageId":")" + generateMessageId() +
+                          R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+                          R"(,"sessionToken":")" + sessionToken +
+                          R"(","payload":{)" + payloadFields;
+    if (!version.empty()) request += R"(,"ifVersion":")" + version + R"(")";
+    request += "}}";
+
+    std::string response = sendAndReceive(request);
+    std::string status = getJsonValue(response, "status");
+    if (status == "not_modified" && !version.empty()) return cached;
+
+    if (status == "success" && !catalogCacheDir.empty() &&
+        !getJsonValue(getJsonObject(response, "data"), "version").empty()) {
+        // Written aside and renamed, so a crash never leaves half a response
+        ::mkdir("cache", 0755);
+        ::mkdir(catalogCacheDir.c_str(), 0755);
+        std::string temp = path + ".tmp";
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        out << response;
+        out.close();
+        if (out) {
+            std::rename(temp.c_str(), path.c_str());
+        } else {
+            std::remove(temp.c_str());
+        }
+    }
+    return response;
 }
 
 // ============================================================================
@@ -610,7 +827,8 @@ bool login() {
     std::string request = R"({"messageType":"LOGIN_REQUEST","messageId":")" + generateMessageId() +
                           R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
                           R"(,"payload":{"email":")" + escapeJson(email) +
-                          R"(","password":")" + escapeJson(password) + R"("}})";
+                          R"(","password":")" + escapeJson(password) + R"(")" +
+                          inboxResumeFields(email) + "}}";
 
     std::string response = sendAndReceive(request);
     if (response.empty()) {
@@ -695,6 +913,54 @@ void setLevel() {
 // XEM DANH SÁCH BÀI HỌC + XEM CHI TIẾT
 // ============================================================================
 
+// Print a search result's snippet with the matched words highlighted
+void printSnippet(const std::string& result) {
+    std::string snippet = getJsonValue(result, "snippet");
+    size_t printed = 0;
+    for (const std::string& highlight : parseJsonArray(getJsonArray(result, "highlights"))) {
+        size_t offset = std::strtoul(getJsonValue(highlight, "offset").c_str(), nullptr, 10);
+        size_t length = std::strtoul(getJsonValue(highlight, "length").c_str(), nullptr, 10);
+        if (offset < printed || offset + length > snippet.size()) continue;
+        printf("%s", snippet.substr(printed, offset - printed).c_str());
+        printColored(snippet.substr(offset, length), "yellow");
+        printed = offset + length;
+    }
+    printf("%s\n", snippet.substr(printed).c_str());
+}
+
+// Tìm kiếm toàn văn trong bài học, bài tập và trò chơi
+void searchContent(const std::string& query) {
+    std::string request = R"({"messageType":"SEARCH_CONTENT_REQUEST","messageId":")" + generateMessageId() +
+                          R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+                          R"(,"sessionToken":")" + sessionToken +
+                          R"(","payload":{"query":")" + escapeJson(query) + R"("}})";
+
+    std::string response = sendAndReceive(request);
+    if (getJsonValue(response, "status") != "success") {
+        printColored("\n[ERROR] " + getJsonValue(response, "message") + "\n", "red");
+        waitEnter();
+        return;
+    }
+
+    std::string data = getJsonObject(response, "data");
+    std::vector<std::string> results = parseJsonArray(getJsonArray(data, "results"));
+    if (results.empty()) {
+        printColored("\nNothing matches \"" + query + "\".\n", "yellow");
+        waitEnter();
+        return;
+    }
+
+    printColored("\nContent matching \"" + query + "\" (" + getJsonValue(data, "matchCount") + " found):\n", "yellow");
+    int idx = 1;
+    for (const std::string& result : results) {
+        printf("  %2d. [%s] ", idx++, getJsonValue(result, "kind").c_str());
+        printColored(getJsonValue(result, "title"), "cyan");
+        printf("  (%s, %s)\n      ", getJsonValue(result, "id").c_str(), getJsonValue(result, "level").c_str());
+        printSnippet(result);
+    }
+    waitEnter();
+}
+
 void viewLessons() {
     while (true) {
         clearScreen();
@@ -702,19 +968,20 @@ void viewLessons() {
         printColored("║              VIEW LESSONS                ║\n", "cyan");
         printColored("╚══════════════════════════════════════════╝\n", "cyan");
 
-        printColored("Filter by topic (press Enter for all):\n", "");
+        printColored("Filter by topic (press Enter for all, ?words to search all content):\n", "");
         printColored("  grammar | vocabulary | listening | speaking | reading | writing\n", "magenta");
         printColored("Topic: ", "green");
 
         std::string topic;
         std::getline(std::cin, topic);
 
-        std::string request = R"({"messageType":"GET_LESSONS_REQUEST","messageId":")" + generateMessageId() +
-                              R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
-                              R"(,"sessionToken":")" + sessionToken +
-                              R"(","payload":{"level":"","topic":")" + topic + R"(","page":1,"limit":20}})";
+        if (topic.size() > 1 && topic[0] == '?') {
+            searchContent(topic.substr(1));
+            continue;
+        }
 
-        std::string response = sendAndReceive(request);
+        std::string response = sendCatalogRequest("GET_LESSONS_REQUEST",
+                                                  R"("level":"","topic":")" + escapeJson(topic) + R"(","page":1,"limit":20)");
         std::string status = getJsonValue(response, "status");
 
         if (status != "success") {
@@ -747,11 +1014,15 @@ void viewLessons() {
             std::string title = getJsonValue(lesson, "title");
             std::string lessonTopic = getJsonValue(lesson, "topic");
             std::string level = getJsonValue(lesson, "level");
+            bool completed = getJsonValue(lesson, "completionStatus") == "true";
 
             lessonIds.push_back(lessonId);
 
-            // Truncate title if too long
-            if (title.length() > 34) title = title.substr(0, 31) + "...";
+            // Truncate title if too long; completed lessons are marked
+            std::string mark = completed ? " (done)" : "";
+            size_t room = 34 - mark.length();
+            if (title.length() > room) title = title.substr(0, room - 3) + "...";
+            title += mark;
 
             printf("│ %-2d │ %-11s │ %-34s │ %-12s │ %-8s │\n",
                    idx, lessonId.c_str(), title.c_str(), lessonTopic.c_str(), level.c_str());
@@ -778,12 +1049,8 @@ void viewLessons() {
                 // Học bài học
                 std::string selectedLessonId = lessonIds[lessonNum - 1];
 
-                std::string detailRequest = R"({"messageType":"GET_LESSON_DETAIL_REQUEST","messageId":")" + generateMessageId() +
-                                            R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
-                                            R"(,"sessionToken":")" + sessionToken +
-                                            R"(","payload":{"lessonId":")" + selectedLessonId + R"("}})";
-
-                std::string detailResponse = sendAndReceive(detailRequest);
+                std::string detailResponse = sendCatalogRequest("GET_LESSON_DETAIL_REQUEST",
+                                                                R"("lessonId":")" + selectedLessonId + R"(")");
                 std::string detailStatus = getJsonValue(detailResponse, "status");
 
                 if (detailStatus != "success") {
@@ -825,6 +1092,12 @@ void viewLessons() {
                 printColored("════════════════════════════════════════════════════════════════════════════════\n", "cyan");
 
                 waitEnter();
+
+                // The whole text has been shown: report the lesson as read (no response)
+                sendMessage(R"({"messageType":"LESSON_PROGRESS_UPDATE","messageId":")" + generateMessageId() +
+                            R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+                            R"(,"sessionToken":")" + sessionToken +
+                            R"(","payload":{"lessonId":")" + selectedLessonId + R"(","percent":100}})");
             } else {
                 printColored("\n[ERROR] Invalid choice.\n", "red");
                 waitEnter();
@@ -1565,55 +1838,215 @@ void trim(std::string &s) {
         [](unsigned char ch){ return !std::isspace(ch); }).base(), s.end());
 }
 
-// Hàm mở chat với một người dùng cụ thể
-void openChatWith(const std::string& recipientId, const std::string& recipientName) {
-    clearScreen();
-    printColored("╔══════════════════════════════════════════╗\n", "cyan");
-    printColored("║  Chatting with: ", "cyan");
-    printColored(recipientName, "yellow");
-    printColored("\n", "");
-    printColored("╠══════════════════════════════════════════╣\n", "cyan");
-    printColored("║  Type 'exit' to leave chat               ║\n", "magenta");
-    printColored("╚══════════════════════════════════════════╝\n\n", "cyan");
+// Tải một trang lịch sử chat cũ hơn `before` (rỗng = trang mới nhất) và in ra.
+// Returns the cursor of the next older page, or "" once the start is reached.
+// Chọn kiểu MIME theo đuôi tệp; chỉ ảnh và âm thanh được đính kèm
+std::string attachmentMimeType(const std::string& path) {
+    static const std::map<std::string, std::string> types = {
+        {"png", "image/png"}, {"jpg", "image/jpeg"}, {"jpeg", "image/jpeg"}, {"gif", "image/gif"},
+        {"webp", "image/webp"}, {"mp3", "audio/mpeg"}, {"wav", "audio/wav"}, {"ogg", "audio/ogg"},
+        {"m4a", "audio/mp4"}};
+    size_t dot = path.rfind('.');
+    if (dot == std::string::npos) return "";
+    std::string extension = path.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    auto it = types.find(extension);
+    return it == types.end() ? "" : it->second;
+}
 
-    // Lấy lịch sử chat
+// Tải một tệp lên server theo từng đoạn. The file is named by its SHA-256, so
+// one the server already has is not sent again. Returns the JSON object to
+// put in a message's "attachments", or "" after printing what went wrong.
+std::string uploadAttachment(const std::string& path) {
+    std::string mimeType = attachmentMimeType(path);
+    if (mimeType.empty()) {
+        printColored("[ERROR] Only images (png, jpg, gif, webp) and audio (mp3, wav, ogg, m4a) can be attached\n", "red");
+        return "";
+    }
+    std::ifstream file(path, std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (!file.good() && !file.eof()) contents.clear();
+    if (contents.empty()) {
+        printColored("[ERROR] Cannot read " + path + "\n", "red");
+        return "";
+    }
+
+    std::string attachmentId = sha256Hex(contents);
+
+    std::string request = R"({"messageType":"START_UPLOAD_REQUEST","messageId":")" + generateMessageId() +
+                          R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+                          R"(,"sessionToken":")" + sessionToken +
+                          R"(","payload":{"attachmentId":")" + attachmentId +
+                          R"(","size":)" + std::to_string(contents.size()) + R"(}})";
+    std::string response = sendAndReceive(request);
+    if (getJsonValue(response, "status") != "success") {
+        printColored("[ERROR] " + getJsonValue(response, "message") + "\n", "red");
+        return "";
+    }
+
+    // Resumes where an earlier attempt at the same file stopped
+    std::string data = getJsonObject(response, "data");
+    std::string uploadId = getJsonValue(data, "uploadId");
+    size_t offset = std::strtoull(getJsonValue(data, "offset").c_str(), nullptr, 10);
+    size_t chunkSize = std::strtoull(getJsonValue(data, "chunkSize").c_str(), nullptr, 10);
+    bool complete = getJsonValue(data, "complete") == "true";
+    while (!complete) {
+        std::string chunk = contents.substr(offset, chunkSize);
+        request = R"({"messageType":"UPLOAD_CHUNK_REQUEST","messageId":")" + generateMessageId() +
+                  R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+                  R"(,"sessionToken":")" + sessionToken +
+                  R"(","payload":{"uploadId":")" + uploadId +
+                  R"(","offset":)" + std::to_string(offset) +
+                  R"(,"data":")" + base64Encode(chunk) + R"("}})";
+        response = sendAndReceive(request);
+        if (getJsonValue(response, "status") != "success") {
+            printColored("\n[ERROR] " + getJsonValue(response, "message") + "\n", "red");
+            return "";
+        }
+        data = getJsonObject(response, "data");
+        offset = std::strtoull(getJsonValue(data, "offset").c_str(), nullptr, 10);
+        complete = getJsonValue(data, "complete") == "true";
+        printColored("\r[Uploading " + std::to_string(offset * 100 / contents.size()) + "%]", "cyan");
+    }
+
+    std::string fileName = path.substr(path.find_last_of("/\\") + 1);
+    printColored("\r[Attached " + fileName + "]   \n", "green");
+    return R"({"attachmentId":")" + attachmentId +
+           R"(","mimeType":")" + mimeType +
+           R"(","fileName":")" + escapeJson(fileName) + R"("})";
+}
+
+// /save <n>: tải tệp đính kèm số n về thư mục downloads/, từng đoạn một
+void saveAttachment(size_t number) {
+    ShownAttachment attachment;
+    {
+        std::lock_guard<std::mutex> lock(shownAttachmentsMutex);
+        if (number == 0 || number > shownAttachments.size()) {
+            printColored("[ERROR] No attachment #" + std::to_string(number) + "\n", "red");
+            return;
+        }
+        attachment = shownAttachments[number - 1];
+    }
+
+    // The name comes from the sender: keep only its last path component
+    std::string fileName = attachment.fileName.substr(attachment.fileName.find_last_of("/\\") + 1);
+    if (fileName.empty() || fileName == "." || fileName == "..") fileName = attachment.attachmentId.substr(0, 16);
+    ::mkdir("downloads", 0755);
+    std::string path = "downloads/" + fileName;
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        printColored("[ERROR] Cannot write " + path + "\n", "red");
+        return;
+    }
+
+    size_t offset = 0;
+    while (true) {
+        std::string request = R"({"messageType":"GET_ATTACHMENT_REQUEST","messageId":")" + generateMessageId() +
+                              R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+                              R"(,"sessionToken":")" + sessionToken +
+                              R"(","payload":{"attachmentId":")" + attachment.attachmentId +
+                              R"(","offset":)" + std::to_string(offset) + R"(}})";
+        std::string response = sendAndReceive(request);
+        std::string data = getJsonObject(response, "data");
+        std::string bytes;
+        if (getJsonValue(response, "status") != "success" || !base64Decode(getJsonValue(data, "data"), bytes)) {
+            printColored("\n[ERROR] Download failed: " + getJsonValue(response, "message") + "\n", "red");
+            return;
+        }
+        out.write(bytes.data(), bytes.size());
+        offset += bytes.size();
+        if (getJsonValue(data, "eof") == "true" || bytes.empty()) break;
+    }
+    printColored("[Saved " + path + "]\n", "green");
+}
+
+// /attach <file> [text]: tải tệp lên; trả về trường "attachments" cho tin nhắn
+// và để lại phần chữ trong message. Empty if the upload failed.
+std::string attachFromCommand(std::string& message) {
+    std::string rest = message.substr(std::string("/attach ").size());
+    size_t space = rest.find(' ');
+    std::string item = uploadAttachment(rest.substr(0, space));
+    if (item.empty()) return "";
+    message = space == std::string::npos ? "" : rest.substr(space + 1);
+    return R"(,"attachments":[)" + item + "]";
+}
+
+std::string showChatHistoryPage(const std::string& recipientId, const std::string& recipientName,
+                                const std::string& before) {
     std::string historyRequest = R"({"messageType":"GET_CHAT_HISTORY_REQUEST","messageId":")" + generateMessageId() +
                                   R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
                                   R"(,"sessionToken":")" + sessionToken +
-                                  R"(","payload":{"recipientId":")" + recipientId + R"("}})";
+                                  R"(","payload":{"recipientId":")" + recipientId +
+                                  R"(","before":")" + before + R"("}})";
 
     std::string historyResponse = sendAndReceive(historyRequest);
     std::string historyStatus = getJsonValue(historyResponse, "status");
+    if (historyStatus != "success") return "";
 
-    if (historyStatus == "success") {
-        std::string historyData = getJsonObject(historyResponse, "data");
-        std::string messagesArray = getJsonArray(historyData, "messages");
-        std::vector<std::string> messages = parseJsonArray(messagesArray);
+    std::string historyData = getJsonObject(historyResponse, "data");
+    std::string messagesArray = getJsonArray(historyData, "messages");
+    std::vector<std::string> messages = parseJsonArray(messagesArray);
+    bool hasMore = getJsonValue(historyData, "hasMore") == "true";
 
-        if (!messages.empty()) {
-            printColored("--- Chat History ---\n", "magenta");
-            for (const std::string& msg : messages) {
-                std::string msgSenderId = getJsonValue(msg, "senderId");
-                std::string msgContent = getJsonValue(msg, "content");
-
-                if (msgSenderId == currentUserId) {
-                    printColored("You: ", "green");
-                    printColored(msgContent + "\n", "");
-                } else {
-                    printColored(recipientName + ": ", "yellow");
-                    printColored(msgContent + "\n", "");
-                }
+    if (!messages.empty()) {
+        printColored(before.empty() ? "--- Chat History ---\n" : "--- Earlier Messages ---\n", "magenta");
+        if (hasMore) {
+            printColored("(type /older to load earlier messages)\n", "magenta");
+        }
+        for (const std::string& msg : messages) {
+            std::string msgSenderId = getJsonValue(msg, "senderId");
+            std::string msgContent = getJsonValue(msg, "content");
+
+            msgContent += describeAttachments(msg);
+
+            if (msgSenderId == currentUserId) {
+                printColored("You: ", "green");
+                printColored(msgContent + "\n", "");
+            } else {
+                printColored(recipientName + ": ", "yellow");
+                printColored(msgContent + "\n", "");
             }
-            printColored("--- End of History ---\n\n", "magenta");
         }
+        printColored("--- End of History ---\n\n", "magenta");
+    } else if (!before.empty()) {
+        printColored("--- No earlier messages ---\n", "magenta");
     }
 
-    // Đánh dấu tin nhắn đã đọc
+    return hasMore ? getJsonValue(historyData, "nextCursor") : "";
+}
+
+// Đánh dấu đã đọc tin nhắn từ một người; server gửi READ_RECEIPT cho họ
+void markChatRead(const std::string& senderId) {
     std::string markReadRequest = R"({"messageType":"MARK_MESSAGES_READ_REQUEST","messageId":")" + generateMessageId() +
                                    R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
                                    R"(,"sessionToken":")" + sessionToken +
-                                   R"(","payload":{"senderId":")" + recipientId + R"("}})";
+                                   R"(","payload":{"senderId":")" + senderId + R"("}})";
     sendAndReceive(markReadRequest);
+}
+
+// Hàm mở chat với một người dùng cụ thể
+void openChatWith(const std::string& recipientId, const std::string& recipientName) {
+    clearScreen();
+    printColored("╔══════════════════════════════════════════╗\n", "cyan");
+    printColored("║  Chatting with: ", "cyan");
+    printColored(recipientName, "yellow");
+    printColored("\n", "");
+    printColored("╠══════════════════════════════════════════╣\n", "cyan");
+    printColored("║  Type 'exit' to leave chat               ║\n", "magenta");
+    printColored("║  /attach <file> [text], /save <n>: files ║\n", "magenta");
+    printColored("╚══════════════════════════════════════════╝\n\n", "cyan");
+
+    {
+        std::lock_guard<std::mutex> lock(shownAttachmentsMutex);
+        shownAttachments.clear();
+    }
+
+    // Lấy trang lịch sử chat mới nhất; /older tải các trang cũ hơn
+    std::string olderCursor = showChatHistoryPage(recipientId, recipientName, "");
+
+    // Đánh dấu tin nhắn đã đọc
+    markChatRead(recipientId);
+    partnerMessagesUnread = false;
 
     // Reset thông báo pending
     {
@@ -1641,18 +2074,37 @@ void openChatWith(const std::string& recipientId, const std::string& recipientNa
         std::getline(std::cin, message);
 
         trim(message);  // [FIX] Loại bỏ khoảng trắng đầu/cuối
+        // Tin nhắn hiện trong lúc chat đã được đọc khi user trả lời hoặc thoát
+        if (partnerMessagesUnread.exchange(false)) markChatRead(recipientId);
         if (message == "exit") {
             inChatMode = false;
             break;
         }
         if (message.empty()) continue;
+        if (message == "/older") {
+            if (olderCursor.empty()) {
+                printColored("--- No earlier messages ---\n", "magenta");
+            } else {
+                olderCursor = showChatHistoryPage(recipientId, recipientName, olderCursor);
+            }
+            continue;
+        }
+        if (message.rfind("/save ", 0) == 0) {
+            saveAttachment(std::strtoul(message.c_str() + 6, nullptr, 10));
+            continue;
+        }
+        std::string attachments;
+        if (message.rfind("/attach ", 0) == 0) {
+            attachments = attachFromCommand(message);
+            if (attachments.empty()) continue;
+        }
 
         std::string chatRequest = R"({"messageType":"SEND_MESSAGE_REQUEST","messageId":")" + generateMessageId() +
                                   R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
                                   R"(,"sessionToken":")" + sessionToken +
                                   R"(","payload":{"recipientId":")" + recipientId +
                                   R"(","messageContent":")" + escapeJson(message) +
-                                  R"(","messageType":"text"}})";
+                                  R"(","messageType":"text")" + attachments + "}}";
 
         std::string chatResponse = sendAndReceive(chatRequest);
         std::string chatStatus = getJsonValue(chatResponse, "status");
@@ -1660,10 +2112,11 @@ void openChatWith(const std::string& recipientId, const std::string& recipientNa
         if (chatStatus == "success") {
             std::string chatData = getJsonObject(chatResponse, "data");
             std::string delivered = getJsonValue(chatData, "delivered");
+            std::string attached = describeAttachments(chatData);
             if (delivered == "true") {
-                printColored("[Delivered ✓]\n", "green");
+                printColored("[Delivered ✓]" + attached + "\n", "green");
             } else {
-                printColored("[Sent - User offline]\n", "yellow");
+                printColored("[Sent - User offline]" + attached + "\n", "yellow");
             }
         } else {
             std::string errorMsg = getJsonValue(chatResponse, "message");
@@ -1680,6 +2133,220 @@ void openChatWith(const std::string& recipientId, const std::string& recipientNa
     inChatMode = false;
 }
 
+// Hiển thị một trang lịch sử kênh; trả về cursor của trang cũ hơn (rỗng nếu hết)
+std::string showChannelHistoryPage(const std::string& channelId, const std::string& before) {
+    std::string historyRequest = R"({"messageType":"GET_CHANNEL_HISTORY_REQUEST","messageId":")" + generateMessageId() +
+                                  R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+                                  R"(,"sessionToken":")" + sessionToken +
+                                  R"(","payload":{"channelId":")" + channelId +
+                                  R"(","before":")" + before + R"("}})";
+
+    std::string historyResponse = sendAndReceive(historyRequest);
+    if (getJsonValue(historyResponse, "status") != "success") return "";
+
+    std::string historyData = getJsonObject(historyResponse, "data");
+    std::vector<std::string> messages = parseJsonArray(getJsonArray(historyData, "messages"));
+    bool hasMore = getJsonValue(historyData, "hasMore") == "true";
+
+    if (!messages.empty()) {
+        printColored(before.empty() ? "--- Channel History ---\n" : "--- Earlier Messages ---\n", "magenta");
+        if (hasMore) {
+            printColored("(type /older to load earlier messages)\n", "magenta");
+        }
+        for (const std::string& msg : messages) {
+            std::string content = getJsonValue(msg, "content") + describeAttachments(msg);
+            if (getJsonValue(msg, "senderId") == currentUserId) {
+                printColored("You: ", "green");
+            } else {
+                printColored(getJsonValue(msg, "senderName") + ": ", "yellow");
+            }
+            printColored(content + "\n", "");
+        }
+        printColored("--- End of History ---\n\n", "magenta");
+    } else if (!before.empty()) {
+        printColored("--- No earlier messages ---\n", "magenta");
+    }
+
+    return hasMore ? getJsonValue(historyData, "nextCursor") : "";
+}
+
+// Mở một kênh nhóm: tin nhắn gửi tới mọi thành viên
+void openChannel(const std::string& channelId, const std::string& channelName) {
+    clearScreen();
+    printColored("╔══════════════════════════════════════════╗\n", "cyan");
+    printColored("║  Channel: ", "cyan");
+    printColored(channelName, "yellow");
+    printColored("\n", "");
+    printColored("╠══════════════════════════════════════════╣\n", "cyan");
+    printColored("║  Type 'exit' to leave channel            ║\n", "magenta");
+    printColored("║  /attach <file> [text], /save <n>: files ║\n", "magenta");
+    printColored("╚══════════════════════════════════════════╝\n\n", "cyan");
+
+    {
+        std::lock_guard<std::mutex> lock(shownAttachmentsMutex);
+        shownAttachments.clear();
+    }
+
+    // Trang mới nhất cũng đánh dấu kênh là đã đọc
+    std::string olderCursor = showChannelHistoryPage(channelId, "");
+
+    {
+        std::lock_guard<std::mutex> lock(chatPartnerMutex);
+        currentChatPartnerId = channelId;
+        currentChatPartnerName = channelName;
+    }
+    inChatMode = true;
+    canShowNotification = true;
+
+    while (inChatMode && running) {
+        printColored("You: ", "green");
+        std::string message;
+        std::getline(std::cin, message);
+
+        trim(message);
+        if (message == "exit") break;
+        if (message.empty()) continue;
+        if (message == "/older") {
+            if (olderCursor.empty()) {
+                printColored("--- No earlier messages ---\n", "magenta");
+            } else {
+                olderCursor = showChannelHistoryPage(channelId, olderCursor);
+            }
+            continue;
+        }
+        if (message.rfind("/save ", 0) == 0) {
+            saveAttachment(std::strtoul(message.c_str() + 6, nullptr, 10));
+            continue;
+        }
+        std::string attachments;
+        if (message.rfind("/attach ", 0) == 0) {
+            attachments = attachFromCommand(message);
+            if (attachments.empty()) continue;
+        }
+
+        std::string request = R"({"messageType":"SEND_CHANNEL_MESSAGE_REQUEST","messageId":")" + generateMessageId() +
+                              R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+                              R"(,"sessionToken":")" + sessionToken +
+                              R"(","payload":{"channelId":")" + channelId +
+                              R"(","messageContent":")" + escapeJson(message) + R"(")" + attachments + "}}";
+
+        std::string response = sendAndReceive(request);
+        if (getJsonValue(response, "status") == "success") {
+            std::string data = getJsonObject(response, "data");
+            printColored("[Sent to " + getJsonValue(data, "onlineCount") + " online of " +
+                         getJsonValue(data, "memberCount") + " members ✓]" + describeAttachments(data) + "\n", "green");
+        } else {
+            printColored("[ERROR] " + getJsonValue(response, "message") + "\n", "red");
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(chatPartnerMutex);
+        currentChatPartnerId = "";
+        currentChatPartnerName = "";
+    }
+    inChatMode = false;
+}
+
+// Danh sách kênh nhóm của user kèm số tin chưa đọc
+void channels() {
+    std::string request = R"({"messageType":"GET_CHANNELS_REQUEST","messageId":")" + generateMessageId() +
+                          R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+                          R"(,"sessionToken":")" + sessionToken + R"(","payload":{}})";
+
+    std::string response = sendAndReceive(request);
+    if (getJsonValue(response, "status") != "success") {
+        printColored("\n[ERROR] " + getJsonValue(response, "message") + "\n", "red");
+        waitEnter();
+        return;
+    }
+
+    std::vector<std::string> channelList = parseJsonArray(getJsonArray(getJsonObject(response, "data"), "channels"));
+    if (channelList.empty()) {
+        printColored("\nYou are not in any channel.\n", "yellow");
+        waitEnter();
+        return;
+    }
+
+    printColored("\nYour Channels:\n", "yellow");
+    int idx = 1;
+    for (const std::string& channel : channelList) {
+        std::string unread = getJsonValue(channel, "unreadCount");
+        printf("  %2d. %-28s %4s members", idx++, getJsonValue(channel, "name").c_str(),
+               getJsonValue(channel, "memberCount").c_str());
+        if (unread != "0") printColored("  (" + unread + " unread)", "yellow");
+        printf("\n");
+    }
+
+    printColored("\nEnter channel number (0 to go back): ", "green");
+    std::string input;
+    std::getline(std::cin, input);
+
+    int choice;
+    try {
+        choice = std::stoi(input);
+    } catch (...) {
+        return;
+    }
+    if (choice <= 0 || choice > (int)channelList.size()) return;
+
+    const std::string& channel = channelList[choice - 1];
+    openChannel(getJsonValue(channel, "channelId"), getJsonValue(channel, "name"));
+}
+
+// Tìm kiếm toàn văn trong tin nhắn; chọn kết quả để mở cuộc trò chuyện
+void searchChatHistory(const std::string& query) {
+    std::string request = R"({"messageType":"SEARCH_CHAT_REQUEST","messageId":")" + generateMessageId() +
+                          R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+                          R"(,"sessionToken":")" + sessionToken +
+                          R"(","payload":{"query":")" + escapeJson(query) + R"("}})";
+
+    std::string response = sendAndReceive(request);
+    if (getJsonValue(response, "status") != "success") {
+        printColored("\n[ERROR] " + getJsonValue(response, "message") + "\n", "red");
+        waitEnter();
+        return;
+    }
+
+    std::string data = getJsonObject(response, "data");
+    std::vector<std::string> results = parseJsonArray(getJsonArray(data, "results"));
+    if (results.empty()) {
+        printColored("\nNo messages match \"" + query + "\".\n", "yellow");
+        waitEnter();
+        return;
+    }
+
+    printColored("\nMessages matching \"" + query + "\" (" + getJsonValue(data, "matchCount") + " found):\n", "yellow");
+    int idx = 1;
+    for (const std::string& result : results) {
+        std::string where = getJsonValue(result, "conversationType") == "channel" ? "#" : "@";
+        printf("  %2d. ", idx++);
+        printColored(where + getJsonValue(result, "conversationName"), "cyan");
+        printf("  %s: ", getJsonValue(result, "senderName").c_str());
+
+        printSnippet(result);
+    }
+
+    printColored("\nEnter result number to open the conversation (0 to go back): ", "green");
+    std::string input;
+    std::getline(std::cin, input);
+
+    int choice;
+    try {
+        choice = std::stoi(input);
+    } catch (...) {
+        return;
+    }
+    if (choice <= 0 || choice > (int)results.size()) return;
+
+    const std::string& result = results[choice - 1];
+    if (getJsonValue(result, "conversationType") == "channel") {
+        openChannel(getJsonValue(result, "conversationId"), getJsonValue(result, "conversationName"));
+    } else {
+        openChatWith(getJsonValue(result, "conversationId"), getJsonValue(result, "conversationName"));
+    }
+}
+
 // ============================================================================
 // VIEW TEACHER FEEDBACK
 // ============================================================================
@@ -2016,12 +2683,8 @@ void playGames() {
     printColored("╚══════════════════════════════════════════╝\n", "cyan");
 
     // Get game list
-    std::string request = R"({"messageType":"GET_GAME_LIST_REQUEST","messageId":")" + generateMessageId() +
-                          R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
-                          R"(,"sessionToken":")" + sessionToken +
-                          R"(","payload":{"gameType":"all","level":")" + currentLevel + R"("}})";
-
-    std::string response = sendAndReceive(request);
+    std::string response = sendCatalogRequest("GET_GAME_LIST_REQUEST",
+                                              R"("gameType":"all","level":")" + currentLevel + R"(")");
     std::string status = getJsonValue(response, "status");
 
     if (status != "success") {
@@ -2413,57 +3076,88 @@ void chat() {
                           R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
                           R"(,"sessionToken":")" + sessionToken +
                           R"(","payload":{"contactType":"all","online":false}})";
+    std::string searchQuery;
 
-    std::string response = sendAndReceive(request);
-    std::string status = getJsonValue(response, "status");
+    std::vector<std::pair<std::string, std::string>> contactList;
+    std::string input;
 
-    if (status != "success") {
-        std::string message = getJsonValue(response, "message");
-        printColored("\n[ERROR] " + message + "\n", "red");
-        waitEnter();
-        return;
-    }
+    // Show the full list, then narrow it with "/name" searches until a contact is picked
+    while (true) {
+        std::string response = sendAndReceive(request);
+        std::string status = getJsonValue(response, "status");
 
-    std::string data = getJsonObject(response, "data");
-    std::string contactsArray = getJsonArray(data, "contacts");
-    std::vector<std::string> contacts = parseJsonArray(contactsArray);
+        if (status != "success") {
+            std::string message = getJsonValue(response, "message");
+            printColored("\n[ERROR] " + message + "\n", "red");
+            waitEnter();
+            return;
+        }
 
-    if (contacts.empty()) {
-        printColored("\nNo contacts available.\n", "yellow");
-        waitEnter();
-        return;
-    }
+        std::string data = getJsonObject(response, "data");
+        std::string contactsArray = getJsonArray(data, "contacts");
+        std::vector<std::string> contacts = parseJsonArray(contactsArray);
 
-    printColored("\nAvailable Contacts:\n", "yellow");
-    printColored("┌────┬────────────────────────┬──────────────┬──────────┐\n", "cyan");
-    printColored("│ #  │ Name                   │ Role         │ Status   │\n", "cyan");
-    printColored("├────┼────────────────────────┼──────────────┼──────────┤\n", "cyan");
+        if (contacts.empty() && searchQuery.empty()) {
+            printColored("\nNo contacts available.\n", "yellow");
+            waitEnter();
+            return;
+        }
 
-    int idx = 1;
-    std::vector<std::pair<std::string, std::string>> contactList;
+        if (searchQuery.empty()) {
+            printColored("\nAvailable Contacts:\n", "yellow");
+        } else {
+            printColored("\nContacts matching \"" + searchQuery + "\":\n", "yellow");
+        }
+        printColored("┌────┬────────────────────────┬──────────────┬──────────┐\n", "cyan");
+        printColored("│ #  │ Name                   │ Role         │ Status   │\n", "cyan");
+        printColored("├────┼────────────────────────┼──────────────┼──────────┤\n", "cyan");
 
-    for (const std::string& contact : contacts) {
-        std::string contactId = getJsonValue(contact, "userId");
-        std::string fullName = getJsonValue(contact, "fullName");
-        std::string role = getJsonValue(contact, "role");
-        std::string contactStatus = getJsonValue(contact, "status");
+        int idx = 1;
+        contactList.clear();
 
-        contactList.push_back({contactId, fullName});
+        for (const std::string& contact : contacts) {
+            std::string contactId = getJsonValue(contact, "userId");
+            std::string fullName = getJsonValue(contact, "fullName");
+            std::string role = getJsonValue(contact, "role");
+            std::string contactStatus = getJsonValue(contact, "status");
 
-        std::string statusColor = (contactStatus == "online") ? "green" : "red";
+            contactList.push_back({contactId, fullName});
 
-        printf("│ %-2d │ %-22s │ %-12s │ ", idx, fullName.c_str(), role.c_str());
-        printColored(contactStatus, statusColor);
-        printf("%*s│\n", 8 - (int)contactStatus.length(), "");
-        idx++;
-    }
+            std::string statusColor = (contactStatus == "online") ? "green" : "red";
 
-    printColored("└────┴────────────────────────┴──────────────┴──────────┘\n", "cyan");
+            printf("│ %-2d │ %-22s │ %-12s │ ", idx, fullName.c_str(), role.c_str());
+            printColored(contactStatus, statusColor);
+            printf("%*s│\n", 8 - (int)contactStatus.length(), "");
+            idx++;
+        }
 
-    printColored("\nEnter contact number to chat (0 to go back): ", "green");
+        printColored("└────┴────────────────────────┴──────────────┴──────────┘\n", "cyan");
 
-    std::string input;
-    std::getline(std::cin, input);
+        printColored("\nEnter contact number to chat, /name to search, ?words to search messages,\n"
+                     "# for channels (0 to go back): ", "green");
+
+        std::getline(std::cin, input);
+
+        if (input == "#") {
+            channels();
+            return;
+        }
+
+        if (input.size() > 1 && input[0] == '?') {
+            searchChatHistory(input.substr(1));
+            return;
+        }
+
+        if (input.size() > 1 && input[0] == '/') {
+            searchQuery = input.substr(1);
+            request = R"({"messageType":"SEARCH_CONTACTS_REQUEST","messageId":")" + generateMessageId() +
+                      R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+                      R"(,"sessionToken":")" + sessionToken +
+                      R"(","payload":{"query":")" + escapeJson(searchQuery) + R"("}})";
+            continue;
+        }
+        break;
+    }
 
     int choice;
     try {
@@ -2611,7 +3305,7 @@ void voiceCall() {
     std::string request = R"({"messageType":"GET_CONTACT_LIST_REQUEST","messageId":")" + generateMessageId() +
                           R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
                           R"(,"sessionToken":")" + sessionToken +
-                          R"(","payload":{"contactType":"all","online":true}})";
+                          R"(","payload":{"contactType":"all","onlineOnly":true}})";
 
     std::string response = sendAndReceive(request);
     std::string status = getJsonValue(response, "status");
@@ -2626,7 +3320,7 @@ void voiceCall() {
     std::string contactsArray = getJsonArray(data, "contacts");
     std::vector<std::string> contacts = parseJsonArray(contactsArray);
 
-    // Filter only online contacts
+    // Filter only online contacts (older servers ignore onlineOnly)
     std::vector<std::pair<std::string, std::string>> onlineContacts;
     for (const std::string& contact : contacts) {
         std::string contactStatus = getJsonValue(contact, "status");
@@ -2779,6 +3473,7 @@ int main_cli(int argc, char* argv[]) {
 
     if (argc > 1) serverIP = argv[1];
     if (argc > 2) port = std::stoi(argv[2]);
+    catalogCacheDir = "cache/" + serverIP + "_" + std::to_string(port);
 
     signal(SIGINT, signalHandler);
     signal(SIGTERM, signalHandler);
@@ -17,6 +17,7 @@ bool connectToServer(const char* ip, int port);
 bool sendMessage(const std::string& message);
 std::string waitForResponse(int timeoutMs = 3000);
 void receiveThreadFunc();
+std::string inboxResumeFields(const std::string& email);  // resume chat inbox on login
 
 // Use namespace-qualified JSON functions from protocol library
 using english_learning::protocol::getJsonValue;
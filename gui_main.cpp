@@ -7,6 +7,7 @@
 #include <iostream>
 #include <map>
 #include <regex>
+#include <set>
 #include <sstream>
 #include <string>
 #include <thread>
@@ -78,7 +79,11 @@ struct ConversationState {
   GtkWidget *scroll_window;  // Store scrolled window reference
   std::string recipientId;
   std::string recipientLabel;
-  int messageCount;
+  std::set<std::string> seenIds; // messageIds already rendered
+  std::string olderCursor;       // cursor for the next older page ("" = none)
+  bool loadingOlder;
+  bool restorePending;           // re-anchor the view once the layout grows
+  double restoreFromBottom;      // distance from the bottom to restore
   guint timeout_id;
 };
 static ConversationState *g_conv_state = nullptr;
@@ -1424,12 +1429,63 @@ void show_lesson_content(const char *lessonId) {
     gtk_text_buffer_set_text(buffer, content.c_str(), -1);
     gtk_container_add(GTK_CONTAINER(scroll), tv);
 
+    // Track reading progress; "changed" covers a lesson short enough to be
+    // read without scrolling
+    LessonProgressTracker tracker;
+    tracker.lessonId = lessonId;
+    GtkAdjustment *vadj =
+        gtk_scrolled_window_get_vadjustment(GTK_SCROLLED_WINDOW(scroll));
+    g_signal_connect(vadj, "value-changed", G_CALLBACK(on_lesson_scrolled),
+                     &tracker);
+    g_signal_connect(vadj, "changed", G_CALLBACK(on_lesson_scrolled),
+                     &tracker);
+    guint progress_timer = g_timeout_add(2000, flush_lesson_progress, &tracker);
+
     gtk_widget_show_all(dialog);
     gtk_dialog_run(GTK_DIALOG(dialog));
+    g_source_remove(progress_timer);
+    g_signal_handlers_disconnect_by_data(vadj, &tracker);
+    flush_lesson_progress(&tracker);
     gtk_widget_destroy(dialog);
   }
 }
 
+// How far the learner has scrolled through the open lesson. Reported with
+// LESSON_PROGRESS_UPDATE (no response) at most every 2 s while it changes,
+// and once more when the lesson is closed.
+struct LessonProgressTracker {
+  std::string lessonId;
+  int percent = 0;
+  int position = 0;
+  bool dirty = false;
+};
+
+static void on_lesson_scrolled(GtkAdjustment *adj, gpointer data) {
+  LessonProgressTracker *tracker = (LessonProgressTracker *)data;
+  double upper = gtk_adjustment_get_upper(adj);
+  double seen = gtk_adjustment_get_value(adj) + gtk_adjustment_get_page_size(adj);
+  int percent = upper > 0 ? std::min(100, (int)(seen * 100 / upper)) : 100;
+  int position = (int)gtk_adjustment_get_value(adj);
+  if (percent > tracker->percent || position != tracker->position) {
+    tracker->percent = std::max(tracker->percent, percent);
+    tracker->position = position;
+    tracker->dirty = true;
+  }
+}
+
+static gboolean flush_lesson_progress(gpointer data) {
+  LessonProgressTracker *tracker = (LessonProgressTracker *)data;
+  if (tracker->dirty) {
+    sendMessage("{\"messageType\":\"LESSON_PROGRESS_UPDATE\", \"sessionToken\":\"" +
+                sessionToken + "\", \"payload\":{\"lessonId\":\"" +
+                tracker->lessonId + "\", \"percent\":" +
+                std::to_string(tracker->percent) + ", \"position\":" +
+                std::to_string(tracker->position) + "}}");
+    tracker->dirty = false;
+  }
+  return G_SOURCE_CONTINUE;
+}
+
 static void on_lesson_btn_clicked(GtkWidget *widget, gpointer data) {
   char *lessonId = (char *)data;
   show_lesson_content(lessonId);
@@ -1461,14 +1517,20 @@ void show_lessons_dialog() {
 
     try {
       std::regex re_lesson("\"lessonId\"\\s*:\\s*\"([^\"]+)\"[^}]*\"title\"\\s*"
-                           ":\\s*\"([^\"]+)\"");
+                           ":\\s*\"([^\"]+)\"(?:[^}]*\"progress\"\\s*:\\s*(\\d+))?");
       auto words_begin =
           std::sregex_iterator(response.begin(), response.end(), re_lesson);
       auto words_end = std::sregex_iterator();
       int count = 0;
       for (std::sregex_iterator i = words_begin; i != words_end; ++i) {
         std::smatch match = *i;
-        GtkWidget *btn = gtk_button_new_with_label(match.str(2).c_str());
+        std::string label = match.str(2);
+        int percent = match[3].matched ? std::stoi(match.str(3)) : 0;
+        if (percent >= 100)
+          label += "  ✓";
+        else if (percent > 0)
+          label += "  (" + std::to_string(percent) + "%)";
+        GtkWidget *btn = gtk_button_new_with_label(label.c_str());
         g_signal_connect(btn, "clicked", G_CALLBACK(on_lesson_btn_clicked),
                          strdup(match.str(1).c_str()));
         gtk_box_pack_start(GTK_BOX(vbox_list), btn, FALSE, FALSE, 0);
@@ -1632,7 +1694,8 @@ void show_chat_dialog() {
 
 // Forward declaration for add_chat_bubble
 static void add_chat_bubble(GtkWidget *box, const std::string &content,
-                            bool isMine, const std::string &senderLabel);
+                            bool isMine, const std::string &senderLabel,
+                            int position = -1);
 
 // Struct to pass data to the send callback
 struct ConversationContext {
@@ -1640,94 +1703,159 @@ struct ConversationContext {
   GtkWidget *entry;
   std::string recipientId;
   std::string recipientLabel;
+  gint64 typingSentAt = 0; // monotonic time of the last "typing" sent, 0 if stopped
 };
 
-// Auto-refresh function: fetches new messages and updates UI
+// One message of a GET_CHAT_HISTORY page
+struct ChatLine {
+  std::string messageId;
+  std::string senderId;
+  std::string content;
+};
+
+// Read the string value of `key` at or after `from`
+static std::string find_string_field(const std::string &resp,
+                                     const std::string &key, size_t from,
+                                     size_t *endPos = nullptr) {
+  std::string pattern = "\"" + key + "\"";
+  size_t pos = resp.find(pattern, from);
+  if (pos == std::string::npos)
+    return "";
+  size_t vStart = resp.find('"', pos + pattern.size());
+  size_t vEnd = resp.find('"', vStart + 1);
+  if (vStart == std::string::npos || vEnd == std::string::npos)
+    return "";
+  if (endPos)
+    *endPos = vEnd + 1;
+  return resp.substr(vStart + 1, vEnd - vStart - 1);
+}
+
+// Request one history page (newest page when `before` is empty)
+static std::string fetch_chat_page(const std::string &recipientId,
+                                   const std::string &before, int timeoutMs) {
+  std::string req = std::string("{\"messageType\":\"GET_CHAT_HISTORY_"
+                                "REQUEST\", \"sessionToken\":\"") +
+                    sessionToken + "\", \"payload\":{\"recipientId\":\"" +
+                    recipientId + "\", \"before\":\"" + before + "\"}}";
+  if (!sendMessage(req))
+    return "";
+  return waitForResponse(timeoutMs);
+}
+
+// Parse a history page (oldest first) and its cursor for the older page
+static std::vector<ChatLine> parse_chat_page(const std::string &resp,
+                                             std::string &olderCursor) {
+  std::vector<ChatLine> msgs;
+  olderCursor = "";
+  size_t p = resp.find("\"messages\"");
+  if (p == std::string::npos)
+    return msgs;
+  size_t arrayEnd = resp.find("\"hasMore\"", p);
+
+  while (true) {
+    size_t idPos = resp.find("\"messageId\"", p);
+    if (idPos == std::string::npos ||
+        (arrayEnd != std::string::npos && idPos > arrayEnd))
+      break;
+    ChatLine line;
+    size_t next = idPos;
+    line.messageId = find_string_field(resp, "messageId", idPos, &next);
+    line.senderId = find_string_field(resp, "senderId", next, &next);
+    line.content = find_string_field(resp, "content", next, &next);
+    size_t np = 0;
+    while ((np = line.content.find("\\n", np)) != std::string::npos) {
+      line.content.replace(np, 2, "\n");
+      np++;
+    }
+    msgs.push_back(line);
+    p = next;
+  }
+
+  const std::string hasMoreTrue = "\"hasMore\":true";
+  if (arrayEnd != std::string::npos &&
+      resp.compare(arrayEnd, hasMoreTrue.size(), hasMoreTrue) == 0)
+    olderCursor = find_string_field(resp, "nextCursor", arrayEnd);
+  return msgs;
+}
+
+// Auto-refresh function: polls the newest page and appends unseen messages
 static gboolean refresh_conversation_messages(gpointer data) {
   if (!g_conv_state || !g_conv_state->dialog)
     return FALSE; // Stop if window closed
 
-  // Fetch chat history again
-  std::string req = std::string("{\"messageType\":\"GET_CHAT_HISTORY_REQUEST\", "
-                                "\"sessionToken\":\"") +
-                    sessionToken + "\", \"payload\":{\"recipientId\":\"" +
-                    g_conv_state->recipientId + "\"}}";
-  if (!sendMessage(req))
+  std::string resp = fetch_chat_page(g_conv_state->recipientId, "", 1000);
+  if (resp.empty())
     return TRUE; // Keep trying
 
-  std::string resp = waitForResponse(1000);
+  std::string ignored;
+  int added = 0;
+  for (auto &m : parse_chat_page(resp, ignored)) {
+    if (!g_conv_state->seenIds.insert(m.messageId).second)
+      continue;
+    bool isMine = (m.senderId != g_conv_state->recipientId);
+    add_chat_bubble(g_conv_state->box_msgs, m.content, isMine,
+                    isMine ? "You" : g_conv_state->recipientLabel);
+    added++;
+  }
 
-  // Count messages
-  int newCount = 0;
-  size_t pos = 0;
-  while ((pos = resp.find("\"senderId\"", pos)) != std::string::npos) {
-    newCount++;
-    pos += 10;
-  }
-
-  // If new messages, show notification and refresh
-  if (newCount > g_conv_state->messageCount) {
-    g_print("[CHAT] New messages! %d -> %d\n", g_conv_state->messageCount,
-            newCount);
-    g_conv_state->messageCount = newCount;
-
-    // Show notification
-    // GtkWidget *notif = gtk_message_dialog_new(
-    //     NULL, GTK_DIALOG_MODAL, GTK_MESSAGE_INFO, GTK_BUTTONS_OK,
-    //     "📬 New message from %s!", g_conv_state->recipientLabel.c_str());
-    // gtk_dialog_run(GTK_DIALOG(notif));
-    // gtk_widget_destroy(notif);
-
-    // Clear and rebuild message list
-    gtk_container_foreach(GTK_CONTAINER(g_conv_state->box_msgs),
-                          (GtkCallback)gtk_widget_destroy, NULL);
-
-    // Re-parse and display all messages
-    std::vector<std::pair<std::string, std::string>> msgs;
-    pos = 0;
-    while ((pos = resp.find("\"senderId\"", pos)) != std::string::npos) {
-      size_t sStart = resp.find('"', pos + 10);
-      size_t sEnd = resp.find('"', sStart + 1);
-      std::string sid = resp.substr(sStart + 1, sEnd - sStart - 1);
-      size_t cPos = resp.find("\"content\"", pos);
-      if (cPos == std::string::npos)
-        break;
-      size_t cStart = resp.find('"', cPos + 9);
-      size_t cEnd = resp.find('"', cStart + 1);
-      std::string cont = resp.substr(cStart + 1, cEnd - cStart - 1);
-      size_t np = 0;
-      while ((np = cont.find("\\n", np)) != std::string::npos) {
-        cont.replace(np, 2, "\n");
-        np++;
-      }
-      msgs.emplace_back(sid, cont);
-      pos = cEnd + 1;
-    }
+  if (added > 0) {
+    g_print("[CHAT] %d new message(s)\n", added);
+    // Scroll to bottom once the new rows are laid out
+    g_conv_state->restoreFromBottom = 0;
+    g_conv_state->restorePending = true;
+  }
 
-    // Rebuild UI with all messages
-    for (auto &m : msgs) {
-      bool isMine = (m.first != g_conv_state->recipientId);
-      add_chat_bubble(g_conv_state->box_msgs, m.second, isMine,
-                      isMine ? "You" : g_conv_state->recipientLabel);
-    }
-    gtk_widget_show_all(g_conv_state->box_msgs);
-
-    // Scroll to bottom - use stored scroll window reference
-    if (g_conv_state->scroll_window && GTK_IS_SCROLLED_WINDOW(g_conv_state->scroll_window)) {
-      GtkAdjustment *adj =
-          gtk_scrolled_window_get_vadjustment(GTK_SCROLLED_WINDOW(g_conv_state->scroll_window));
-      if (adj) {
-        gtk_adjustment_set_value(adj, gtk_adjustment_get_upper(adj));
-      }
+  return TRUE; // Keep the timer running
+}
+
+// Lazy loading: reaching the top of the conversation fetches the older page
+static void on_conversation_edge_reached(GtkScrolledWindow *scroll,
+                                         GtkPositionType pos,
+                                         gpointer /*data*/) {
+  if (pos != GTK_POS_TOP || !g_conv_state || g_conv_state->loadingOlder ||
+      g_conv_state->olderCursor.empty())
+    return;
+
+  g_conv_state->loadingOlder = true;
+  std::string resp =
+      fetch_chat_page(g_conv_state->recipientId, g_conv_state->olderCursor, 2000);
+  if (!resp.empty()) {
+    std::string cursor;
+    std::vector<ChatLine> older = parse_chat_page(resp, cursor);
+    g_conv_state->olderCursor = cursor;
+
+    // Prepend in order, then keep the current message under the viewport
+    GtkAdjustment *adj = gtk_scrolled_window_get_vadjustment(scroll);
+    g_conv_state->restoreFromBottom =
+        gtk_adjustment_get_upper(adj) - gtk_adjustment_get_value(adj);
+    int position = 0;
+    for (auto &m : older) {
+      if (!g_conv_state->seenIds.insert(m.messageId).second)
+        continue;
+      bool isMine = (m.senderId != g_conv_state->recipientId);
+      add_chat_bubble(g_conv_state->box_msgs, m.content, isMine,
+                      isMine ? "You" : g_conv_state->recipientLabel,
+                      position++);
     }
+    g_conv_state->restorePending = position > 0;
   }
+  g_conv_state->loadingOlder = false;
+}
 
-  return TRUE; // Keep the timer running
+// Apply a pending scroll position after the message list changed size
+static void on_conversation_adjustment_changed(GtkAdjustment *adj,
+                                               gpointer /*data*/) {
+  if (!g_conv_state || !g_conv_state->restorePending)
+    return;
+  g_conv_state->restorePending = false;
+  gtk_adjustment_set_value(adj, gtk_adjustment_get_upper(adj) -
+                                    g_conv_state->restoreFromBottom);
 }
 
 // Helper to add a chat bubble (reused for history and new messages)
 static void add_chat_bubble(GtkWidget *box, const std::string &content,
-                            bool isMine, const std::string &senderLabel) {
+                            bool isMine, const std::string &senderLabel,
+                            int position) {
   std::string bubbleText = (isMine ? "You: " : senderLabel + ": ") + content;
 
   GtkWidget *row = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 6);
@@ -1750,6 +1878,8 @@ static void add_chat_bubble(GtkWidget *box, const std::string &content,
   }
 
   gtk_box_pack_start(GTK_BOX(box), row, FALSE, FALSE, 4);
+  if (position >= 0)
+    gtk_box_reorder_child(GTK_BOX(box), row, position);
   gtk_widget_show_all(row);
 }
 
@@ -1773,10 +1903,13 @@ static void on_conversation_send_clicked(GtkWidget *widget, gpointer data) {
   if (sendMessage(json)) {
     // Assume success for UI responsiveness or wait?
     // Let's do a quick wait to ensure it went through.
-    waitForResponse(500);
+    std::string resp = waitForResponse(500);
 
-    // Append to UI
+    // Append to UI; remember the id so the next refresh does not repeat it
     add_chat_bubble(ctx->box_msgs, msg, true, "You");
+    size_t dataPos = resp.find("\"data\"");
+    if (g_conv_state && dataPos != std::string::npos)
+      g_conv_state->seenIds.insert(find_string_field(resp, "messageId", dataPos));
 
     // Clear entry
     gtk_entry_set_text(GTK_ENTRY(ctx->entry), "");
@@ -1789,6 +1922,29 @@ static void on_conversation_send_clicked(GtkWidget *widget, gpointer data) {
   }
 }
 
+// Tell the peer we are typing (refreshed every 3s while the entry changes)
+// or stopped (entry cleared); TYPING has no response
+static void on_conversation_entry_changed(GtkEditable * /*editable*/,
+                                          gpointer data) {
+  ConversationContext *ctx = (ConversationContext *)data;
+  bool empty = gtk_entry_get_text_length(GTK_ENTRY(ctx->entry)) == 0;
+  gint64 now = g_get_monotonic_time();
+
+  std::string state;
+  if (!empty && now - ctx->typingSentAt >= 3 * G_USEC_PER_SEC) {
+    state = "typing";
+    ctx->typingSentAt = now;
+  } else if (empty && ctx->typingSentAt != 0) {
+    state = "stopped";
+    ctx->typingSentAt = 0;
+  } else {
+    return;
+  }
+  sendMessage("{\"messageType\":\"TYPING\", \"sessionToken\":\"" +
+              sessionToken + "\", \"payload\":{\"peerId\":\"" +
+              ctx->recipientId + "\", \"state\":\"" + state + "\"}}");
+}
+
 // Conversation popup handler (C-style callback)
 static void on_open_conversation_clicked(GtkWidget * /*widget*/,
                                          gpointer /*data*/) {
@@ -1804,36 +1960,12 @@ static void on_open_conversation_clicked(GtkWidget * /*widget*/,
   if (selText)
     g_free(selText);
 
-  // Request chat history
-  std::string req = std::string("{\"messageType\":\"GET_CHAT_HISTORY_"
-                                "REQUEST\", \"sessionToken\":\"") +
-                    sessionToken + "\", \"payload\":{\"recipientId\":\"" +
-                    recipientId + "\"}}";
-  if (!sendMessage(req))
+  // Request only the newest page; older pages load when scrolled to the top
+  std::string resp = fetch_chat_page(recipientId, "", 2000);
+  if (resp.empty())
     return;
-  std::string resp = waitForResponse(2000);
-
-  // Parse messages (senderId, content)
-  std::vector<std::pair<std::string, std::string>> msgs;
-  size_t p = 0;
-  while ((p = resp.find("\"senderId\"", p)) != std::string::npos) {
-    size_t sStart = resp.find('"', p + 10);
-    size_t sEnd = resp.find('"', sStart + 1);
-    std::string sid = resp.substr(sStart + 1, sEnd - sStart - 1);
-    size_t cPos = resp.find("\"content\"", p);
-    if (cPos == std::string::npos)
-      break;
-    size_t cStart = resp.find('"', cPos + 9);
-    size_t cEnd = resp.find('"', cStart + 1);
-    std::string cont = resp.substr(cStart + 1, cEnd - cStart - 1);
-    size_t np = 0;
-    while ((np = cont.find("\\n", np)) != std::string::npos) {
-      cont.replace(np, 2, "\n");
-      np++;
-    }
-    msgs.emplace_back(sid, cont);
-    p = cEnd + 1;
-  }
+  std::string olderCursor;
+  std::vector<ChatLine> msgs = parse_chat_page(resp, olderCursor);
 
   // Build conversation window
   GtkWidget *conv = gtk_dialog_new_with_buttons(
@@ -1857,8 +1989,8 @@ static void on_open_conversation_clicked(GtkWidget * /*widget*/,
   gtk_container_add(GTK_CONTAINER(scroll), box_msgs);
 
   for (auto &m : msgs) {
-    bool isMine = (m.first != recipientId);
-    add_chat_bubble(box_msgs, m.second, isMine,
+    bool isMine = (m.senderId != recipientId);
+    add_chat_bubble(box_msgs, m.content, isMine,
                     isMine ? "You" : recipientLabel);
   }
 
@@ -1886,6 +2018,8 @@ static void on_open_conversation_clicked(GtkWidget * /*widget*/,
   g_signal_connect(entry_msg, "activate",
                    G_CALLBACK(on_conversation_send_clicked),
                    &ctx); // Enter key to send
+  g_signal_connect(entry_msg, "changed",
+                   G_CALLBACK(on_conversation_entry_changed), &ctx);
 
   // Setup auto-refresh state
   if (g_conv_state) {
@@ -1899,7 +2033,17 @@ static void on_open_conversation_clicked(GtkWidget * /*widget*/,
   g_conv_state->scroll_window = scroll;
   g_conv_state->recipientId = recipientId;
   g_conv_state->recipientLabel = recipientLabel;
-  g_conv_state->messageCount = (int)msgs.size();
+  for (auto &m : msgs)
+    g_conv_state->seenIds.insert(m.messageId);
+  g_conv_state->olderCursor = olderCursor;
+  g_conv_state->loadingOlder = false;
+  g_conv_state->restoreFromBottom = 0; // open at the newest message
+  g_conv_state->restorePending = true;
+  g_signal_connect(scroll, "edge-reached",
+                   G_CALLBACK(on_conversation_edge_reached), NULL);
+  g_signal_connect(
+      gtk_scrolled_window_get_vadjustment(GTK_SCROLLED_WINDOW(scroll)),
+      "changed", G_CALLBACK(on_conversation_adjustment_changed), NULL);
   // Start auto-refresh every 3 seconds (3000 ms)
   g_conv_state->timeout_id = g_timeout_add(3000, refresh_conversation_messages, NULL);
 
@@ -3831,7 +3975,8 @@ static void on_login_clicked(GtkWidget *widget, gpointer data) {
 
   std::string jsonRequest =
       "{\"messageType\":\"LOGIN_REQUEST\", \"payload\":{\"email\":\"" +
-      std::string(email) + "\", \"password\":\"" + std::string(pass) + "\"}}";
+      std::string(email) + "\", \"password\":\"" + std::string(pass) + "\"" +
+      inboxResumeFields(email) + "}}";
 
   if (sendMessage(jsonRequest)) {
     std::string response = waitForResponse(3000);
@@ -7,11 +7,14 @@
  */
 
 #include "types.h"
+#include "symbol.h"
 #include "user.h"
 #include "session.h"
 #include "lesson.h"
 #include "test.h"
+#include "attachment.h"
 #include "chat_message.h"
+#include "channel.h"
 #include "exercise.h"
 #include "game.h"
 #include "voice_call.h"
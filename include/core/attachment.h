@@ -0,0 +1,30 @@
+#ifndef ENGLISH_LEARNING_CORE_ATTACHMENT_H
+#define ENGLISH_LEARNING_CORE_ATTACHMENT_H
+
+#include <cstdint>
+#include <string>
+
+namespace english_learning {
+namespace core {
+
+/**
+ * A file referenced by a chat message. The bytes live once in the
+ * attachment store under attachmentId, the hex SHA-256 of the content;
+ * name and type are whatever the sender supplied with this message.
+ */
+struct Attachment {
+    std::string attachmentId;
+    std::string mimeType;
+    std::string fileName;
+    uint64_t size;
+
+    Attachment() : size(0) {}
+
+    bool isImage() const { return mimeType.compare(0, 6, "image/") == 0; }
+    bool isAudio() const { return mimeType.compare(0, 6, "audio/") == 0; }
+};
+
+} // namespace core
+} // namespace english_learning
+
+#endif // ENGLISH_LEARNING_CORE_ATTACHMENT_H
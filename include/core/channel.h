@@ -0,0 +1,28 @@
+#ifndef ENGLISH_LEARNING_CORE_CHANNEL_H
+#define ENGLISH_LEARNING_CORE_CHANNEL_H
+
+#include <string>
+#include "types.h"
+
+namespace english_learning {
+namespace core {
+
+/**
+ * Channel entity representing a group chat (a class or a level group).
+ * Channel messages reuse ChatMessage with recipientId set to the channelId.
+ */
+struct Channel {
+    std::string channelId;
+    std::string name;
+    ChannelKind kind;
+    Level level;            // Level channels only
+    std::string ownerId;    // Class channels: the teacher who created it
+    Timestamp createdAt;
+
+    Channel() : kind(ChannelKind::Class), level(Level::Beginner), createdAt(0) {}
+};
+
+} // namespace core
+} // namespace english_learning
+
+#endif // ENGLISH_LEARNING_CORE_CHANNEL_H
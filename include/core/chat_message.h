@@ -2,14 +2,17 @@
 #define ENGLISH_LEARNING_CORE_CHAT_MESSAGE_H
 
 #include <string>
+#include <vector>
 #include "types.h"
+#include "attachment.h"
 
 namespace english_learning {
 namespace core {
 
 /**
  * ChatMessage entity representing a message between two users.
- * Messages track sender, recipient, content, timestamp, and read status.
+ * Messages track sender, recipient, content, timestamp, and read status,
+ * plus any files attached to them.
  */
 struct ChatMessage {
     std::string messageId;
@@ -18,6 +21,7 @@ struct ChatMessage {
     std::string content;
     Timestamp timestamp;
     bool read;
+    std::vector<Attachment> attachments;
 
     ChatMessage() : timestamp(0), read(false) {}
 
@@ -5,19 +5,11 @@
 #include <vector>
 #include <map>
 #include "types.h"
+#include "symbol.h"
 
 namespace english_learning {
 namespace core {
 
-/**
- * Exercise type constants
- */
-namespace ExerciseTypes {
-    constexpr const char* SENTENCE_REWRITE = "sentence_rewrite";
-    constexpr const char* PARAGRAPH_WRITING = "paragraph_writing";
-    constexpr const char* TOPIC_SPEAKING = "topic_speaking";
-}
-
 /**
  * Score breakdown for detailed feedback
  */
@@ -45,12 +37,12 @@ struct ScoreBreakdown {
  */
 struct Exercise {
     std::string exerciseId;
-    std::string exerciseType;       // sentence_rewrite, paragraph_writing, topic_speaking
+    ExerciseType exerciseType;
     std::string title;
     std::string description;
     std::string instructions;
-    std::string level;
-    std::string topic;
+    Level level;
+    Topic topic;
     std::vector<std::string> prompts;           // For sentence_rewrite: original sentences
     std::string topicDescription;               // For topic_speaking and paragraph_writing
     std::vector<std::string> requirements;      // For paragraph_writing: requirements list
@@ -60,26 +52,28 @@ struct Exercise {
     std::string rubric;                         // Grading rubric description
     std::string createdBy;                      // Teacher who created it
 
-    Exercise() : duration(0), minWordCount(0), maxWordCount(0) {}
+    Exercise()
+        : exerciseType(ExerciseType::SentenceRewrite), level(Level::Beginner), topic(Topic::Grammar),
+          duration(0), minWordCount(0), maxWordCount(0) {}
 
-    Exercise(const std::string& id, const std::string& type, const std::string& t,
-             const std::string& desc, const std::string& lvl, int dur)
+    Exercise(const std::string& id, ExerciseType type, const std::string& t,
+             const std::string& desc, Level lvl, int dur)
         : exerciseId(id), exerciseType(type), title(t), description(desc),
-          level(lvl), duration(dur), minWordCount(0), maxWordCount(0) {}
+          level(lvl), topic(Topic::Grammar), duration(dur), minWordCount(0), maxWordCount(0) {}
 
     // Check if this is a sentence rewrite exercise
     bool isSentenceRewrite() const {
-        return exerciseType == ExerciseTypes::SENTENCE_REWRITE;
+        return exerciseType == ExerciseType::SentenceRewrite;
     }
 
     // Check if this is a paragraph writing exercise
     bool isParagraphWriting() const {
-        return exerciseType == ExerciseTypes::PARAGRAPH_WRITING;
+        return exerciseType == ExerciseType::ParagraphWriting;
     }
 
     // Check if this is a topic speaking exercise
     bool isTopicSpeaking() const {
-        return exerciseType == ExerciseTypes::TOPIC_SPEAKING;
+        return exerciseType == ExerciseType::TopicSpeaking;
     }
 
     // Check if exercise requires audio submission
@@ -88,12 +82,12 @@ struct Exercise {
     }
 
     // Check if exercise matches given level
-    bool matchesLevel(const std::string& lvl) const {
+    bool matchesLevel(Level lvl) const {
         return level == lvl;
     }
 
     // Check if exercise matches given type
-    bool matchesType(const std::string& type) const {
+    bool matchesType(ExerciseType type) const {
         return exerciseType == type;
     }
 };
@@ -111,10 +105,10 @@ struct ExerciseSubmission {
     std::string submissionId;
     std::string exerciseId;
     std::string userId;
-    std::string exerciseType;
+    ExerciseType exerciseType;
     std::string content;            // Written text for writing exercises
     std::string audioUrl;           // Audio file path/URL for speaking exercises
-    std::string status;             // draft, pending_review, reviewed
+    SubmissionStatus status;
     Timestamp createdAt;            // When draft was first created
     Timestamp submittedAt;          // When submitted for review
     std::string teacherId;          // Who reviewed it
@@ -126,47 +120,48 @@ struct ExerciseSubmission {
     int attemptNumber;              // Which attempt this is (1, 2, 3...)
 
     ExerciseSubmission()
-        : createdAt(0), submittedAt(0), teacherScore(0), reviewedAt(0),
+        : exerciseType(ExerciseType::SentenceRewrite), status(SubmissionStatus::Pending),
+          createdAt(0), submittedAt(0), teacherScore(0), reviewedAt(0),
           wordCount(0), attemptNumber(1) {}
 
     ExerciseSubmission(const std::string& subId, const std::string& exId,
-                       const std::string& uid, const std::string& type,
+                       const std::string& uid, ExerciseType type,
                        const std::string& cont, Timestamp ts)
         : submissionId(subId), exerciseId(exId), userId(uid),
-          exerciseType(type), content(cont), status(SubmissionStatusStr::PENDING_REVIEW),
+          exerciseType(type), content(cont), status(SubmissionStatus::Pending),
           createdAt(ts), submittedAt(ts), teacherScore(0), reviewedAt(0),
           wordCount(0), attemptNumber(1) {}
 
     // Check if submission is a draft
     bool isDraft() const {
-        return status == SubmissionStatusStr::DRAFT;
+        return status == SubmissionStatus::Draft;
     }
 
     // Check if submission is pending review
     bool isPendingReview() const {
-        return status == SubmissionStatusStr::PENDING_REVIEW;
+        return status == SubmissionStatus::Pending;
     }
 
     // Check if submission has been reviewed
     bool isReviewed() const {
-        return status == SubmissionStatusStr::REVIEWED;
+        return status == SubmissionStatus::Reviewed;
     }
 
-    // Legacy compatibility
+    // Legacy compatibility ("pending" and "pending_review" both parse to Pending)
     bool isPending() const {
-        return isPendingReview() || status == "pending";
+        return isPendingReview();
     }
 
     // Submit draft for review
     void submit(Timestamp ts) {
-        status = SubmissionStatusStr::PENDING_REVIEW;
+        status = SubmissionStatus::Pending;
         submittedAt = ts;
     }
 
     // Save as draft
     void saveDraft(const std::string& newContent, Timestamp ts) {
         content = newContent;
-        status = SubmissionStatusStr::DRAFT;
+        status = SubmissionStatus::Draft;
         if (createdAt == 0) createdAt = ts;
     }
 
@@ -178,7 +173,7 @@ struct ExerciseSubmission {
         scores = scoreBreakdown;
         teacherScore = scoreBreakdown.overall;
         reviewedAt = ts;
-        status = SubmissionStatusStr::REVIEWED;
+        status = SubmissionStatus::Reviewed;
     }
 
     // Legacy setReview for compatibility
@@ -189,7 +184,7 @@ struct ExerciseSubmission {
         teacherScore = score;
         scores.overall = score;
         reviewedAt = ts;
-        status = SubmissionStatusStr::REVIEWED;
+        status = SubmissionStatus::Reviewed;
     }
 
     // Check if submission belongs to a specific user
@@ -199,15 +194,17 @@ struct ExerciseSubmission {
 
     // Check if this is a speaking submission
     bool isSpeakingSubmission() const {
-        return exerciseType == ExerciseTypes::TOPIC_SPEAKING;
+        return exerciseType == ExerciseType::TopicSpeaking;
     }
 
     // Get display status string
     std::string getDisplayStatus() const {
-        if (status == SubmissionStatusStr::DRAFT) return "Draft";
-        if (status == SubmissionStatusStr::PENDING_REVIEW || status == "pending") return "Under Review";
-        if (status == SubmissionStatusStr::REVIEWED || status == "reviewed") return "Feedback Received";
-        return status;
+        switch (status) {
+            case SubmissionStatus::Draft: return "Draft";
+            case SubmissionStatus::Pending: return "Under Review";
+            case SubmissionStatus::Reviewed: return "Feedback Received";
+        }
+        return "Under Review";
     }
 };
 
@@ -217,7 +214,7 @@ struct ExerciseSubmission {
 struct ExerciseNotification {
     std::string notificationId;
     std::string userId;             // Recipient
-    std::string type;               // new_submission, feedback_received
+    Symbol type;                    // new_submission, feedback_received
     std::string submissionId;
     std::string message;
     Timestamp createdAt;
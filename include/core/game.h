@@ -6,6 +6,7 @@
 #include <map>
 #include <utility>
 #include "types.h"
+#include "symbol.h"
 
 namespace english_learning {
 namespace core {
@@ -47,11 +48,11 @@ struct PicturePair {
  */
 struct Game {
     std::string gameId;
-    std::string gameType;       // word_match, sentence_match, picture_match
+    GameType gameType;
     std::string title;
     std::string description;
-    std::string level;
-    std::string topic;
+    Level level;
+    Symbol topic;               // free text set by admins
     std::vector<std::pair<std::string, std::string>> pairs;         // For word_match: (word, meaning)
     std::vector<std::pair<std::string, std::string>> sentencePairs; // For sentence_match
     std::vector<std::pair<std::string, std::string>> picturePairs;  // For picture_match: (word, imageUrl) - legacy
@@ -59,33 +60,33 @@ struct Game {
     int timeLimit;              // Time limit in seconds
     int maxScore;
 
-    Game() : timeLimit(60), maxScore(100) {}
+    Game() : gameType(GameType::WordMatch), level(Level::Beginner), timeLimit(60), maxScore(100) {}
 
-    Game(const std::string& id, const std::string& type, const std::string& t,
-         const std::string& desc, const std::string& lvl, int time, int max)
+    Game(const std::string& id, GameType type, const std::string& t,
+         const std::string& desc, Level lvl, int time, int max)
         : gameId(id), gameType(type), title(t), description(desc),
           level(lvl), timeLimit(time), maxScore(max) {}
 
     // Check if this is a word matching game
     bool isWordMatch() const {
-        return gameType == "word_match";
+        return gameType == GameType::WordMatch;
     }
 
     // Check if this is a sentence matching game
     bool isSentenceMatch() const {
-        return gameType == "sentence_match";
+        return gameType == GameType::SentenceMatch;
     }
 
     // Check if this is a picture matching game
     bool isPictureMatch() const {
-        return gameType == "picture_match";
+        return gameType == GameType::PictureMatch;
     }
 
     // Get the appropriate pairs based on game type
     const std::vector<std::pair<std::string, std::string>>& getActivePairs() const {
-        if (gameType == "sentence_match") {
+        if (gameType == GameType::SentenceMatch) {
             return sentencePairs;
-        } else if (gameType == "picture_match") {
+        } else if (gameType == GameType::PictureMatch) {
             return picturePairs;
         }
         return pairs;
@@ -97,7 +98,7 @@ struct Game {
     }
 
     // Check if game matches given level
-    bool matchesLevel(const std::string& lvl) const {
+    bool matchesLevel(Level lvl) const {
         return level == lvl;
     }
 };
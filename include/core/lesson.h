@@ -15,17 +15,17 @@ struct Lesson {
     std::string lessonId;
     std::string title;
     std::string description;
-    std::string topic;          // grammar, vocabulary, listening, speaking, reading, writing
-    std::string level;          // beginner, intermediate, advanced
+    Topic topic;
+    Level level;
     int duration;               // Duration in minutes
     std::string textContent;
     std::string videoUrl;
     std::string audioUrl;
 
-    Lesson() : duration(0) {}
+    Lesson() : topic(Topic::Grammar), level(Level::Beginner), duration(0) {}
 
     Lesson(const std::string& id, const std::string& t, const std::string& desc,
-           const std::string& top, const std::string& lvl, int dur)
+           Topic top, Level lvl, int dur)
         : lessonId(id), title(t), description(desc),
           topic(top), level(lvl), duration(dur) {}
 
@@ -40,13 +40,13 @@ struct Lesson {
     }
 
     // Check if lesson matches given level
-    bool matchesLevel(const std::string& lvl) const {
+    bool matchesLevel(Level lvl) const {
         return level == lvl;
     }
 
     // Check if lesson matches given topic
-    bool matchesTopic(const std::string& top) const {
-        return topic.empty() || top.empty() || topic == top;
+    bool matchesTopic(Topic top) const {
+        return topic == top;
     }
 };
 
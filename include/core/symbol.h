@@ -0,0 +1,73 @@
+#ifndef ENGLISH_LEARNING_CORE_SYMBOL_H
+#define ENGLISH_LEARNING_CORE_SYMBOL_H
+
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_set>
+
+namespace english_learning {
+namespace core {
+
+/**
+ * Interned string for free-text categories (test type, game topic, ...).
+ * Every distinct value is stored once in a process-wide pool; a Symbol is a
+ * pointer into that pool, so copies are free and equality is a pointer
+ * compare. Converts implicitly from and to std::string so it can stand in
+ * for the string fields it replaces. Interned values are never freed.
+ */
+class Symbol {
+public:
+    Symbol() : str_(&emptyString()) {}
+    Symbol(const std::string& str) : str_(intern(str)) {}
+    Symbol(const char* str) : str_(intern(str)) {}
+
+    const std::string& str() const { return *str_; }
+    operator const std::string&() const { return *str_; }
+    const char* c_str() const { return str_->c_str(); }
+    bool empty() const { return str_->empty(); }
+
+    bool operator==(const Symbol& other) const { return str_ == other.str_; }
+    bool operator!=(const Symbol& other) const { return str_ != other.str_; }
+
+    // Hash of the pooled address; only meaningful within one process
+    size_t hash() const { return std::hash<const std::string*>()(str_); }
+
+private:
+    static const std::string& emptyString() {
+        static const std::string value;
+        return value;
+    }
+
+    static const std::string* intern(const std::string& str) {
+        if (str.empty()) return &emptyString();
+        static std::mutex mutex;
+        static std::unordered_set<std::string> pool;  // node-based: addresses are stable
+        std::lock_guard<std::mutex> lock(mutex);
+        return &*pool.insert(str).first;
+    }
+
+    const std::string* str_;
+};
+
+inline bool operator==(const Symbol& lhs, const std::string& rhs) { return lhs.str() == rhs; }
+inline bool operator==(const std::string& lhs, const Symbol& rhs) { return lhs == rhs.str(); }
+inline bool operator!=(const Symbol& lhs, const std::string& rhs) { return lhs.str() != rhs; }
+inline bool operator!=(const std::string& lhs, const Symbol& rhs) { return lhs != rhs.str(); }
+inline bool operator==(const Symbol& lhs, const char* rhs) { return lhs.str() == rhs; }
+inline bool operator!=(const Symbol& lhs, const char* rhs) { return lhs.str() != rhs; }
+
+inline std::ostream& operator<<(std::ostream& os, const Symbol& sym) { return os << sym.str(); }
+
+} // namespace core
+} // namespace english_learning
+
+namespace std {
+template <>
+struct hash<english_learning::core::Symbol> {
+    size_t operator()(const english_learning::core::Symbol& sym) const { return sym.hash(); }
+};
+} // namespace std
+
+#endif // ENGLISH_LEARNING_CORE_SYMBOL_H
@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 #include "types.h"
+#include "symbol.h"
 
 namespace english_learning {
 namespace core {
@@ -14,31 +15,31 @@ namespace core {
  */
 struct TestQuestion {
     std::string questionId;
-    std::string type;           // multiple_choice, fill_blank, sentence_order
+    QuestionType type;
     std::string question;
     std::vector<std::string> options;
     std::string correctAnswer;
     std::vector<std::string> words;  // For sentence_order type
     int points;
 
-    TestQuestion() : points(10) {}
+    TestQuestion() : type(QuestionType::MultipleChoice), points(10) {}
 
-    TestQuestion(const std::string& id, const std::string& t, const std::string& q,
+    TestQuestion(const std::string& id, QuestionType t, const std::string& q,
                  const std::string& correct, int pts = 10)
         : questionId(id), type(t), question(q), correctAnswer(correct), points(pts) {}
 
     // Check if answer is correct
     bool checkAnswer(const std::string& answer) const {
-        if (type == "multiple_choice") {
+        if (type == QuestionType::MultipleChoice) {
             return answer == correctAnswer;
-        } else if (type == "fill_blank") {
+        } else if (type == QuestionType::FillBlank) {
             // Case-insensitive comparison for fill blank
             std::string lowerAnswer = answer;
             std::string lowerCorrect = correctAnswer;
             for (char& c : lowerAnswer) c = std::tolower(c);
             for (char& c : lowerCorrect) c = std::tolower(c);
             return lowerAnswer == lowerCorrect;
-        } else if (type == "sentence_order") {
+        } else if (type == QuestionType::SentenceOrder) {
             // For sentence order, compare the full sentence
             return answer == correctAnswer;
         }
@@ -47,17 +48,17 @@ struct TestQuestion {
 
     // Check if this is a multiple choice question
     bool isMultipleChoice() const {
-        return type == "multiple_choice";
+        return type == QuestionType::MultipleChoice;
     }
 
     // Check if this is a fill-in-the-blank question
     bool isFillBlank() const {
-        return type == "fill_blank";
+        return type == QuestionType::FillBlank;
     }
 
     // Check if this is a sentence ordering question
     bool isSentenceOrder() const {
-        return type == "sentence_order";
+        return type == QuestionType::SentenceOrder;
     }
 };
 
@@ -67,16 +68,16 @@ struct TestQuestion {
  */
 struct Test {
     std::string testId;
-    std::string testType;
-    std::string level;
-    std::string topic;
+    Symbol testType;            // free text, e.g. "mixed"
+    Level level;
+    Topic topic;
     std::string title;
     std::vector<TestQuestion> questions;
 
-    Test() = default;
+    Test() : level(Level::Beginner), topic(Topic::Grammar) {}
 
-    Test(const std::string& id, const std::string& type, const std::string& lvl,
-         const std::string& top, const std::string& t)
+    Test(const std::string& id, Symbol type, Level lvl,
+         Topic top, const std::string& t)
         : testId(id), testType(type), level(lvl), topic(top), title(t) {}
 
     // Add a question to the test
@@ -99,7 +100,7 @@ struct Test {
     }
 
     // Check if test matches given level
-    bool matchesLevel(const std::string& lvl) const {
+    bool matchesLevel(Level lvl) const {
         return level == lvl;
     }
 };
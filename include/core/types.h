@@ -52,13 +52,6 @@ enum class SubmissionStatus {
     Reviewed
 };
 
-// Submission status string constants (for string-based comparisons)
-namespace SubmissionStatusStr {
-    constexpr const char* DRAFT = "draft";
-    constexpr const char* PENDING_REVIEW = "pending_review";
-    constexpr const char* REVIEWED = "reviewed";
-}
-
 // Game types
 enum class GameType {
     WordMatch,
@@ -76,6 +69,12 @@ enum class VoiceCallStatus {
     Failed      // Call failed (technical error)
 };
 
+// Group chat channel kind
+enum class ChannelKind {
+    Class,      // Created by a teacher for a chosen set of students
+    Level       // One per level; students follow their current level
+};
+
 // Helper functions for string conversion
 inline std::string levelToString(Level level) {
     switch (level) {
@@ -92,6 +91,14 @@ inline Level stringToLevel(const std::string& str) {
     return Level::Beginner;
 }
 
+// Strict variants for request filters: false if str names no known value
+inline bool parseLevel(const std::string& str, Level& out) {
+    if (str == "beginner") { out = Level::Beginner; return true; }
+    if (str == "intermediate") { out = Level::Intermediate; return true; }
+    if (str == "advanced") { out = Level::Advanced; return true; }
+    return false;
+}
+
 inline std::string roleToString(UserRole role) {
     switch (role) {
         case UserRole::Student: return "student";
@@ -128,6 +135,15 @@ inline Topic stringToTopic(const std::string& str) {
     return Topic::Grammar;
 }
 
+inline bool parseTopic(const std::string& str, Topic& out) {
+    if (str != "grammar" && str != "vocabulary" && str != "listening" &&
+        str != "speaking" && str != "reading" && str != "writing") {
+        return false;
+    }
+    out = stringToTopic(str);
+    return true;
+}
+
 inline std::string questionTypeToString(QuestionType type) {
     switch (type) {
         case QuestionType::MultipleChoice: return "multiple_choice";
@@ -158,6 +174,14 @@ inline ExerciseType stringToExerciseType(const std::string& str) {
     return ExerciseType::SentenceRewrite;
 }
 
+inline bool parseExerciseType(const std::string& str, ExerciseType& out) {
+    if (str != "sentence_rewrite" && str != "paragraph_writing" && str != "topic_speaking") {
+        return false;
+    }
+    out = stringToExerciseType(str);
+    return true;
+}
+
 inline std::string gameTypeToString(GameType type) {
     switch (type) {
         case GameType::WordMatch: return "word_match";
@@ -173,6 +197,14 @@ inline GameType stringToGameType(const std::string& str) {
     return GameType::WordMatch;
 }
 
+inline bool parseGameType(const std::string& str, GameType& out) {
+    if (str != "word_match" && str != "sentence_match" && str != "picture_match") {
+        return false;
+    }
+    out = stringToGameType(str);
+    return true;
+}
+
 inline std::string submissionStatusToString(SubmissionStatus status) {
     switch (status) {
         case SubmissionStatus::Draft: return "draft";
@@ -211,6 +243,14 @@ inline VoiceCallStatus stringToVoiceCallStatus(const std::string& str) {
     return VoiceCallStatus::Pending;
 }
 
+inline std::string channelKindToString(ChannelKind kind) {
+    switch (kind) {
+        case ChannelKind::Class: return "class";
+        case ChannelKind::Level: return "level";
+    }
+    return "class";
+}
+
 // Timestamp type alias
 using Timestamp = int64_t;
 
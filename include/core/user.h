@@ -16,32 +16,33 @@ struct User {
     std::string fullname;
     std::string email;
     std::string password;       // TODO: Should be hashed in production
-    std::string level;          // beginner, intermediate, advanced
-    std::string role;           // student, teacher, admin
+    Level level;
+    UserRole role;
     Timestamp createdAt;
     bool online;
     int clientSocket;           // Active socket descriptor (-1 if not connected)
 
-    User() : createdAt(0), online(false), clientSocket(-1) {}
+    User() : level(Level::Beginner), role(UserRole::Student),
+             createdAt(0), online(false), clientSocket(-1) {}
 
     User(const std::string& id, const std::string& name, const std::string& mail,
-         const std::string& pwd, const std::string& lvl, const std::string& r)
+         const std::string& pwd, Level lvl, UserRole r)
         : userId(id), fullname(name), email(mail), password(pwd),
           level(lvl), role(r), createdAt(0), online(false), clientSocket(-1) {}
 
     // Check if user is a teacher
     bool isTeacher() const {
-        return role == "teacher" || role == "admin";
+        return role == UserRole::Teacher || role == UserRole::Admin;
     }
 
     // Check if user is an admin
     bool isAdmin() const {
-        return role == "admin";
+        return role == UserRole::Admin;
     }
 
     // Check if user is a student
     bool isStudent() const {
-        return role == "student";
+        return role == UserRole::Student;
     }
 };
 
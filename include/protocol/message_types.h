@@ -25,6 +25,11 @@ constexpr const char* GET_LESSONS_REQUEST = "GET_LESSONS_REQUEST";
 constexpr const char* GET_LESSONS_RESPONSE = "GET_LESSONS_RESPONSE";
 constexpr const char* GET_LESSON_DETAIL_REQUEST = "GET_LESSON_DETAIL_REQUEST";
 constexpr const char* GET_LESSON_DETAIL_RESPONSE = "GET_LESSON_DETAIL_RESPONSE";
+constexpr const char* SYNC_CATALOG_REQUEST = "SYNC_CATALOG_REQUEST";
+constexpr const char* SYNC_CATALOG_RESPONSE = "SYNC_CATALOG_RESPONSE";
+constexpr const char* LESSON_PROGRESS_UPDATE = "LESSON_PROGRESS_UPDATE";  // client -> server, no response
+constexpr const char* SEARCH_CONTENT_REQUEST = "SEARCH_CONTENT_REQUEST";
+constexpr const char* SEARCH_CONTENT_RESPONSE = "SEARCH_CONTENT_RESPONSE";
 
 // Tests
 constexpr const char* GET_TEST_REQUEST = "GET_TEST_REQUEST";
@@ -79,20 +84,51 @@ constexpr const char* DELETE_GAME_RESPONSE = "DELETE_GAME_RESPONSE";
 constexpr const char* GET_ADMIN_GAMES_REQUEST = "GET_ADMIN_GAMES_REQUEST";
 constexpr const char* GET_ADMIN_GAMES_RESPONSE = "GET_ADMIN_GAMES_RESPONSE";
 
+// Content Admin
+constexpr const char* RELOAD_CONTENT_REQUEST = "RELOAD_CONTENT_REQUEST";
+constexpr const char* RELOAD_CONTENT_RESPONSE = "RELOAD_CONTENT_RESPONSE";
+
 // Chat
 constexpr const char* GET_CONTACT_LIST_REQUEST = "GET_CONTACT_LIST_REQUEST";
 constexpr const char* GET_CONTACT_LIST_RESPONSE = "GET_CONTACT_LIST_RESPONSE";
+constexpr const char* SEARCH_CONTACTS_REQUEST = "SEARCH_CONTACTS_REQUEST";
+constexpr const char* SEARCH_CONTACTS_RESPONSE = "SEARCH_CONTACTS_RESPONSE";
 constexpr const char* SEND_MESSAGE_REQUEST = "SEND_MESSAGE_REQUEST";
 constexpr const char* SEND_MESSAGE_RESPONSE = "SEND_MESSAGE_RESPONSE";
 constexpr const char* GET_CHAT_HISTORY_REQUEST = "GET_CHAT_HISTORY_REQUEST";
 constexpr const char* GET_CHAT_HISTORY_RESPONSE = "GET_CHAT_HISTORY_RESPONSE";
 constexpr const char* MARK_MESSAGES_READ_REQUEST = "MARK_MESSAGES_READ_REQUEST";
 constexpr const char* MARK_MESSAGES_READ_RESPONSE = "MARK_MESSAGES_READ_RESPONSE";
+constexpr const char* SEARCH_CHAT_REQUEST = "SEARCH_CHAT_REQUEST";
+constexpr const char* SEARCH_CHAT_RESPONSE = "SEARCH_CHAT_RESPONSE";
+constexpr const char* INBOX_ACK = "INBOX_ACK";  // client -> server, no response
+constexpr const char* TYPING = "TYPING";        // both directions; no response
+
+// Chat attachments (chunked upload, ranged download)
+constexpr const char* START_UPLOAD_REQUEST = "START_UPLOAD_REQUEST";
+constexpr const char* START_UPLOAD_RESPONSE = "START_UPLOAD_RESPONSE";
+constexpr const char* UPLOAD_CHUNK_REQUEST = "UPLOAD_CHUNK_REQUEST";
+constexpr const char* UPLOAD_CHUNK_RESPONSE = "UPLOAD_CHUNK_RESPONSE";
+constexpr const char* GET_ATTACHMENT_REQUEST = "GET_ATTACHMENT_REQUEST";
+constexpr const char* GET_ATTACHMENT_RESPONSE = "GET_ATTACHMENT_RESPONSE";
+
+// Group channels
+constexpr const char* CREATE_CHANNEL_REQUEST = "CREATE_CHANNEL_REQUEST";
+constexpr const char* CREATE_CHANNEL_RESPONSE = "CREATE_CHANNEL_RESPONSE";
+constexpr const char* GET_CHANNELS_REQUEST = "GET_CHANNELS_REQUEST";
+constexpr const char* GET_CHANNELS_RESPONSE = "GET_CHANNELS_RESPONSE";
+constexpr const char* SEND_CHANNEL_MESSAGE_REQUEST = "SEND_CHANNEL_MESSAGE_REQUEST";
+constexpr const char* SEND_CHANNEL_MESSAGE_RESPONSE = "SEND_CHANNEL_MESSAGE_RESPONSE";
+constexpr const char* GET_CHANNEL_HISTORY_REQUEST = "GET_CHANNEL_HISTORY_REQUEST";
+constexpr const char* GET_CHANNEL_HISTORY_RESPONSE = "GET_CHANNEL_HISTORY_RESPONSE";
 
 // Push Notifications (server -> client)
 constexpr const char* RECEIVE_MESSAGE = "RECEIVE_MESSAGE";
 constexpr const char* UNREAD_MESSAGES_NOTIFICATION = "UNREAD_MESSAGES_NOTIFICATION";
 constexpr const char* EXERCISE_FEEDBACK_NOTIFICATION = "EXERCISE_FEEDBACK_NOTIFICATION";
+constexpr const char* PRESENCE_UPDATE = "PRESENCE_UPDATE";
+constexpr const char* CHANNEL_MESSAGE = "CHANNEL_MESSAGE";
+constexpr const char* READ_RECEIPT = "READ_RECEIPT";
 
 // Voice Call
 constexpr const char* VOICE_CALL_INITIATE_REQUEST = "VOICE_CALL_INITIATE_REQUEST";
@@ -114,6 +150,7 @@ constexpr const char* VOICE_CALL_ENDED = "VOICE_CALL_ENDED";
 
 // Error
 constexpr const char* ERROR_RESPONSE = "ERROR_RESPONSE";
+constexpr const char* RATE_LIMITED = "RATE_LIMITED";  // request refused; payload has retryAfterMs
 
 } // namespace MessageType
 
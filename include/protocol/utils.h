@@ -92,6 +92,62 @@ inline bool isSessionExpired(long long expiresAt) {
     return getCurrentTimestamp() > expiresAt;
 }
 
+/**
+ * Encode binary data as standard base64 with padding.
+ */
+inline std::string base64Encode(const std::string& data) {
+    static const char alphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    out.reserve((data.size() + 2) / 3 * 4);
+    size_t i = 0;
+    for (; i + 2 < data.size(); i += 3) {
+        unsigned v = (unsigned char)data[i] << 16 | (unsigned char)data[i + 1] << 8 | (unsigned char)data[i + 2];
+        out += alphabet[v >> 18];
+        out += alphabet[(v >> 12) & 63];
+        out += alphabet[(v >> 6) & 63];
+        out += alphabet[v & 63];
+    }
+    if (i < data.size()) {
+        unsigned v = (unsigned char)data[i] << 16;
+        if (i + 1 < data.size()) v |= (unsigned char)data[i + 1] << 8;
+        out += alphabet[v >> 18];
+        out += alphabet[(v >> 12) & 63];
+        out += i + 1 < data.size() ? alphabet[(v >> 6) & 63] : '=';
+        out += '=';
+    }
+    return out;
+}
+
+/**
+ * Decode standard base64 into out; returns false on malformed input.
+ */
+inline bool base64Decode(const std::string& text, std::string& out) {
+    out.clear();
+    out.reserve(text.size() / 4 * 3);
+    unsigned v = 0;
+    int bits = 0;
+    size_t padding = 0;
+    for (char c : text) {
+        int d;
+        if (c >= 'A' && c <= 'Z') d = c - 'A';
+        else if (c >= 'a' && c <= 'z') d = c - 'a' + 26;
+        else if (c >= '0' && c <= '9') d = c - '0' + 52;
+        else if (c == '+') d = 62;
+        else if (c == '/') d = 63;
+        else if (c == '=') { padding++; continue; }
+        else return false;
+        if (padding > 0) return false;  // data after padding
+        v = (v << 6) | static_cast<unsigned>(d);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            out += static_cast<char>((v >> bits) & 0xFF);
+        }
+    }
+    return padding <= 2 && bits < 6;
+}
+
 } // namespace utils
 } // namespace protocol
 } // namespace english_learning
@@ -26,6 +26,13 @@ public:
     virtual std::vector<core::ChatMessage> findByUser(const std::string& userId) const = 0;
     virtual std::vector<core::ChatMessage> findConversation(const std::string& user1,
                                                              const std::string& user2) const = 0;
+    // Up to limit messages (oldest first) preceding beforeMessageId, or sent
+    // before beforeTimestamp; both empty/0 returns the newest page
+    virtual std::vector<core::ChatMessage> findConversationPage(const std::string& user1,
+                                                                 const std::string& user2,
+                                                                 const std::string& beforeMessageId,
+                                                                 core::Timestamp beforeTimestamp,
+                                                                 size_t limit) const = 0;
     virtual std::vector<core::ChatMessage> findUnreadFor(const std::string& userId) const = 0;
     virtual size_t countUnreadFor(const std::string& userId) const = 0;
 
@@ -25,10 +25,11 @@ public:
     // Read
     virtual std::optional<core::Exercise> findExerciseById(const std::string& exerciseId) const = 0;
     virtual std::vector<core::Exercise> findAllExercises() const = 0;
-    virtual std::vector<core::Exercise> findExercisesByLevel(const std::string& level) const = 0;
-    virtual std::vector<core::Exercise> findExercisesByType(const std::string& type) const = 0;
+    virtual std::vector<core::Exercise> findExercisesByLevel(core::Level level) const = 0;
+    virtual std::vector<core::Exercise> findExercisesByType(core::ExerciseType type) const = 0;
+    // An empty level or type matches everything
     virtual std::vector<core::Exercise> findExercisesByLevelAndType(
-        const std::string& level, const std::string& type) const = 0;
+        std::optional<core::Level> level, std::optional<core::ExerciseType> type) const = 0;
     virtual bool exerciseExists(const std::string& exerciseId) const = 0;
 
     // Update
@@ -25,10 +25,11 @@ public:
     // Read
     virtual std::optional<core::Game> findGameById(const std::string& gameId) const = 0;
     virtual std::vector<core::Game> findAllGames() const = 0;
-    virtual std::vector<core::Game> findGamesByLevel(const std::string& level) const = 0;
-    virtual std::vector<core::Game> findGamesByType(const std::string& gameType) const = 0;
-    virtual std::vector<core::Game> findGamesByLevelAndType(const std::string& level,
-                                                             const std::string& gameType) const = 0;
+    virtual std::vector<core::Game> findGamesByLevel(core::Level level) const = 0;
+    virtual std::vector<core::Game> findGamesByType(core::GameType gameType) const = 0;
+    // An empty level or gameType matches everything
+    virtual std::vector<core::Game> findGamesByLevelAndType(std::optional<core::Level> level,
+                                                             std::optional<core::GameType> gameType) const = 0;
     virtual bool gameExists(const std::string& gameId) const = 0;
 
     // Update
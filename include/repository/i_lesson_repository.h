@@ -23,10 +23,11 @@ public:
     // Read
     virtual std::optional<core::Lesson> findById(const std::string& lessonId) const = 0;
     virtual std::vector<core::Lesson> findAll() const = 0;
-    virtual std::vector<core::Lesson> findByLevel(const std::string& level) const = 0;
-    virtual std::vector<core::Lesson> findByTopic(const std::string& topic) const = 0;
-    virtual std::vector<core::Lesson> findByLevelAndTopic(const std::string& level,
-                                                          const std::string& topic) const = 0;
+    virtual std::vector<core::Lesson> findByLevel(core::Level level) const = 0;
+    virtual std::vector<core::Lesson> findByTopic(core::Topic topic) const = 0;
+    // An empty topic matches every topic
+    virtual std::vector<core::Lesson> findByLevelAndTopic(core::Level level,
+                                                          std::optional<core::Topic> topic) const = 0;
     virtual bool exists(const std::string& lessonId) const = 0;
 
     // Update
@@ -37,7 +38,7 @@ public:
 
     // Utility
     virtual size_t count() const = 0;
-    virtual size_t countByLevel(const std::string& level) const = 0;
+    virtual size_t countByLevel(core::Level level) const = 0;
 };
 
 } // namespace repository
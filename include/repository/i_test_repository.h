@@ -23,10 +23,11 @@ public:
     // Read
     virtual std::optional<core::Test> findById(const std::string& testId) const = 0;
     virtual std::vector<core::Test> findAll() const = 0;
-    virtual std::vector<core::Test> findByLevel(const std::string& level) const = 0;
-    virtual std::vector<core::Test> findByType(const std::string& testType) const = 0;
-    virtual std::vector<core::Test> findByLevelAndType(const std::string& level,
-                                                        const std::string& testType) const = 0;
+    virtual std::vector<core::Test> findByLevel(core::Level level) const = 0;
+    virtual std::vector<core::Test> findByType(const core::Symbol& testType) const = 0;
+    // An empty testType matches every type
+    virtual std::vector<core::Test> findByLevelAndType(core::Level level,
+                                                        const core::Symbol& testType) const = 0;
     virtual bool exists(const std::string& testId) const = 0;
 
     // Update
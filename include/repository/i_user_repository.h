@@ -25,13 +25,15 @@ public:
     virtual std::optional<core::User> findById(const std::string& userId) const = 0;
     virtual std::vector<core::User> findAll() const = 0;
     virtual std::vector<core::User> findOnlineUsers() const = 0;
-    virtual std::vector<core::User> findByRole(const std::string& role) const = 0;
+    virtual std::vector<core::User> findByRole(core::UserRole role) const = 0;
+    // Name/email prefix search, online users first, at most limit results
+    virtual std::vector<core::User> searchContacts(const std::string& query, size_t limit) const = 0;
     virtual bool exists(const std::string& email) const = 0;
     virtual bool existsById(const std::string& userId) const = 0;
 
     // Update
     virtual bool update(const core::User& user) = 0;
-    virtual bool updateLevel(const std::string& userId, const std::string& level) = 0;
+    virtual bool updateLevel(const std::string& userId, core::Level level) = 0;
     virtual bool setOnlineStatus(const std::string& userId, bool online, int socket = -1) = 0;
 
     // Delete
@@ -16,6 +16,8 @@ struct ChatHistoryResult {
     std::vector<core::ChatMessage> messages;
     size_t total;
     size_t unreadCount;
+    bool hasMore = false;       // older messages exist before this page
+    std::string nextCursor;     // messageId to pass as beforeMessageId for the next page
 };
 
 /**
@@ -52,16 +54,20 @@ public:
         const std::string& content) = 0;
 
     /**
-     * Get chat history between two users.
+     * Get one page of chat history between two users, newest page first.
      * @param userId1 First user ID
      * @param userId2 Second user ID
      * @param limit Maximum messages to return (0 for all)
-     * @return List of messages between the users
+     * @param beforeMessageId Cursor: return messages sent before this one
+     * @param beforeTimestamp Cursor used when no messageId is given (0 = none)
+     * @return Messages oldest first, plus the cursor for the previous page
      */
     virtual ServiceResult<ChatHistoryResult> getChatHistory(
         const std::string& userId1,
         const std::string& userId2,
-        size_t limit = 50) = 0;
+        size_t limit = 50,
+        const std::string& beforeMessageId = "",
+        core::Timestamp beforeTimestamp = 0) = 0;
 
     /**
      * Get all messages for a user.
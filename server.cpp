@@ -25,6 +25,10 @@
 #include <ctime>
 #include <random>
 #include <unordered_map>
+#include <unordered_set>
+#include <set>
+#include <condition_variable>
+#include <cctype>
 
 // POSIX socket headers
 #include <sys/socket.h>
@@ -32,6 +36,9 @@
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <signal.h>
+#include <poll.h>
+#include <dirent.h>
+#include <sys/stat.h>
 
 // ============================================================================
 // CẤU HÌNH SERVER
@@ -39,6 +46,79 @@
 #define DEFAULT_PORT 8888
 #define BUFFER_SIZE 65536
 #define MAX_CLIENTS 100
+#define PRESENCE_BATCH_MS 250   // window over which presence changes are coalesced
+#define SEARCH_DEFAULT_LIMIT 20  // contact search results when no limit is given
+#define SEARCH_MAX_LIMIT 100
+#define CHAT_HISTORY_DEFAULT_LIMIT 50  // messages per history page
+#define CHAT_HISTORY_MAX_LIMIT 100
+#define CHAT_LOG_DIR "data/chat"     // write-ahead log segments for chat history
+#define CHAT_COMMIT_INTERVAL_MS 5      // group-commit window for chat log fsyncs
+#define CHAT_COMPACT_CHECK_SEC 60      // how often to consider compacting the chat log
+#define CHAT_COMPACT_SNAPSHOT 4096     // messages snapshotted per chatMutex hold when compacting
+#define CHAT_COLD_DIR "data/chat-cold" // compressed archive of old chat messages
+#define CHAT_HOT_RETENTION_DAYS 30     // read messages older than this move to the archive
+                                       // (override with the CHAT_HOT_RETENTION_DAYS env var)
+#define CHAT_ARCHIVE_CHECK_SEC 3600    // how often to look for messages to archive
+#define CHANNEL_HOT_MESSAGES 1000      // newest messages per channel kept in memory; older ones are archived
+#define INBOX_CAPACITY 1000            // unacknowledged chat pushes kept per user
+#define OUTBOX_CAPACITY 4096           // pushes waiting for a slow client before new ones are dropped
+#define CHAT_INDEX_BATCH_MS 100        // window over which new messages are folded into the search index
+#define CHAT_SEARCH_DEFAULT_LIMIT 20   // chat search results when no limit is given
+#define CHAT_SEARCH_MAX_LIMIT 50
+#define CHAT_SNIPPET_RADIUS 6          // words kept either side of the first match in a snippet
+#define SIGNAL_BATCH_MS 300            // window over which typing indicators and read receipts are coalesced
+#define TYPING_TTL_MS 6000             // clients hide a typing indicator not refreshed within this
+#define TYPING_REFRESH_MS 3000         // repeated "typing" for one conversation is dropped within this
+#define TYPING_RATE_PER_SEC 4          // typing events accepted per sender per second (and burst size)
+#define ATTACHMENT_DIR "data/attachments"        // content-addressed chat attachments
+#define ATTACHMENT_MAX_BYTES (20 * 1024 * 1024)  // largest file that can be attached
+#define ATTACHMENT_CHUNK_BYTES 32768             // bytes per upload/download frame (sent as base64)
+#define ATTACHMENT_UPLOAD_IDLE_SEC 600           // unfinished uploads are dropped after this long idle
+#define ATTACHMENTS_PER_MESSAGE 4
+#define ADMISSION_SLOTS_PER_CORE 2     // requests handled at once, per CPU core (at least 4 in total)
+#define ADMISSION_QUEUE_MS 2000        // longest wait for a slot before answering RATE_LIMITED
+#define CONTENT_PACK_DIR "data/content"  // *.pack catalogs built by content_packer, mapped at startup
+#define CONTENT_WATCH_SEC 2            // how often CONTENT_PACK_DIR is checked for changed packs
+#define CATALOG_PAGE_DEFAULT_LIMIT 100 // lessons, exercises or games per listing page
+#define CATALOG_PAGE_MAX_LIMIT 500
+#define CATALOG_SYNC_CHUNK_BYTES (256 * 1024)   // SYNC_CATALOG records per response, by size
+#define PROGRESS_DIR "data/progress"  // lesson progress, written behind in batches
+#define PROGRESS_FLUSH_MS 2000         // how often changed lesson progress is written to disk
+#define MEDIA_DIR "data/media"         // lesson video and audio files served over HTTP
+#define MEDIA_PORT_OFFSET 1            // the media server listens on the server port plus this
+#define MEDIA_MAX_STREAMS 32           // media connections served at once; more get 503
+#define MEDIA_IDLE_MS 15000            // media connections idle this long are closed
+#define CONTENT_SEARCH_DEFAULT_LIMIT 20  // lessons, exercises and games per content search
+#define CONTENT_SEARCH_MAX_LIMIT 50
+#define CONTENT_SNIPPET_RADIUS 8       // words kept either side of the first match in a content snippet
+
+// Request budgets per session (per connection before login), for each
+// message type: sustained requests per second and burst size. "*" matches
+// any role or any message type; role+type beats *+type beats role+* beats
+// *+*. Roles are student, teacher, admin, and guest for no session.
+const struct {
+    const char* role;
+    const char* messageType;
+    double perSecond;
+    double burst;
+} RATE_LIMITS[] = {
+    {"*",       "*",                             20,  40},
+    {"guest",   "*",                              2,   5},   // login and register attempts
+    {"admin",   "*",                            100, 200},
+    {"*",       "SEND_MESSAGE_REQUEST",           5,  10},
+    {"*",       "SEND_CHANNEL_MESSAGE_REQUEST",   2,   5},
+    {"teacher", "SEND_CHANNEL_MESSAGE_REQUEST",   5,  10},
+    {"*",       "GET_LESSON_DETAIL_REQUEST",      5,  15},
+    {"*",       "SEARCH_CONTACTS_REQUEST",        5,  10},
+    {"*",       "SEARCH_CHAT_REQUEST",            2,   5},
+    {"*",       "SEARCH_CONTENT_REQUEST",         5,  10},
+    {"*",       "START_UPLOAD_REQUEST",           1,   4},
+    {"*",       "UPLOAD_CHUNK_REQUEST",          64,  64},   // 2 MB/s of 32 KiB chunks
+    {"*",       "GET_ATTACHMENT_REQUEST",        64,  64},
+    {"*",       "SYNC_CATALOG_REQUEST",          16,  16},   // 4 MB/s of 256 KiB chunks
+    {"*",       "LESSON_PROGRESS_UPDATE",         4,   8},   // excess updates are dropped; the next one supersedes them
+    {"*",       "TYPING",                        10,  10},   // handleTyping applies its own finer limit
+};
 
 // ============================================================================
 // CORE DOMAIN MODELS (Refactored to include/core/)
@@ -52,10 +132,20 @@ using Lesson = english_learning::core::Lesson;
 using TestQuestion = english_learning::core::TestQuestion;
 using Test = english_learning::core::Test;
 using ChatMessage = english_learning::core::ChatMessage;
+using Attachment = english_learning::core::Attachment;
+using Channel = english_learning::core::Channel;
+using ChannelKind = english_learning::core::ChannelKind;
 using Exercise = english_learning::core::Exercise;
 using ExerciseSubmission = english_learning::core::ExerciseSubmission;
 using Game = english_learning::core::Game;
 using GameSession = english_learning::core::GameSession;
+using UserRole = english_learning::core::UserRole;
+using Level = english_learning::core::Level;
+using Topic = english_learning::core::Topic;
+using QuestionType = english_learning::core::QuestionType;
+using ExerciseType = english_learning::core::ExerciseType;
+using GameType = english_learning::core::GameType;
+using SubmissionStatus = english_learning::core::SubmissionStatus;
 
 // ============================================================================
 // PROTOCOL LAYER (Refactored to include/protocol/)
@@ -67,7 +157,46 @@ using GameSession = english_learning::core::GameSession;
 // ============================================================================
 #include "src/repository/bridge/bridge_repositories.h"
 #include "src/repository/bridge/bridge_repositories_ext.h"
+#include "src/repository/memory/inbox_store.h"
+#include "src/repository/memory/channel_store.h"
+#include "src/repository/memory/content_catalog.h"
+#include "src/repository/memory/progress_store.h"
+#include "src/net/outbox.h"
+#include "src/net/admission.h"
+#include "src/net/media_server.h"
 #include "src/service/all.h"
+#include "src/storage/chat_log.h"
+#include "src/storage/cold_store.h"
+#include "src/storage/attachment_store.h"
+#include "src/storage/progress_log.h"
+#include "src/search/chat_index.h"
+#include "src/search/content_index.h"
+#include "src/search/text.h"
+
+using UserTable = english_learning::repository::memory::UserTable;
+using ChatStore = english_learning::repository::memory::ChatStore;
+using InboxStore = english_learning::repository::memory::InboxStore;
+using ChannelStore = english_learning::repository::memory::ChannelStore;
+using Outbox = english_learning::net::Outbox;
+using RateLimiter = english_learning::net::RateLimiter;
+using FairScheduler = english_learning::net::FairScheduler;
+using Frame = english_learning::net::Frame;
+using english_learning::net::makeFrame;
+using UserHandle = english_learning::repository::memory::UserHandle;
+using ChatIndex = english_learning::search::ChatIndex;
+using ContentIndex = english_learning::search::ContentIndex;
+using ContentCatalog = english_learning::repository::memory::ContentCatalog;
+using english_learning::concurrency::RcuCell;
+using CatalogFilter = english_learning::repository::memory::CatalogFilter;
+using Fragments = english_learning::repository::memory::Fragments;
+using english_learning::repository::memory::catalogTag;
+using CatalogKind = english_learning::repository::memory::CatalogKind;
+using CatalogRecordId = english_learning::repository::memory::CatalogRecordId;
+using ProgressStore = english_learning::repository::memory::ProgressStore;
+using LessonProgress = english_learning::repository::memory::LessonProgress;
+using ChatLog = english_learning::storage::ChatLog;
+using ColdStore = english_learning::storage::ColdStore;
+using english_learning::concurrency::EpochGuard;
 
 // Using declarations for protocol utilities
 using english_learning::protocol::getJsonValue;
@@ -78,21 +207,31 @@ using english_learning::protocol::escapeJson;
 using english_learning::protocol::utils::getCurrentTimestamp;
 using english_learning::protocol::utils::generateId;
 using english_learning::protocol::utils::generateSessionToken;
+using english_learning::protocol::utils::base64Encode;
+using english_learning::protocol::utils::base64Decode;
 namespace MessageType = english_learning::protocol::MessageType;
+using english_learning::core::levelToString;
+using english_learning::core::roleToString;
+using english_learning::core::topicToString;
+using english_learning::core::questionTypeToString;
+using english_learning::core::exerciseTypeToString;
+using english_learning::core::gameTypeToString;
+using english_learning::core::submissionStatusToString;
+using english_learning::core::channelKindToString;
+using english_learning::core::parseLevel;
+using english_learning::core::parseTopic;
+using english_learning::core::parseExerciseType;
+using english_learning::core::parseGameType;
 
 // ============================================================================
 // BIẾN TOÀN CỤC VÀ MUTEX
 // ============================================================================
-std::map<std::string, User> users;              // email -> User (changed for easier lookup)
-std::map<std::string, User*> userById;          // userId -> User*
+UserTable users;                                // dense slot map, indexed by email and userId
 std::map<std::string, Session> sessions;        // sessionToken -> Session
-std::map<std::string, Lesson> lessons;          // lessonId -> Lesson
-std::map<std::string, Test> tests;              // testId -> Test
-std::map<std::string, Exercise> exercises;      // exerciseId -> Exercise
+RcuCell<ContentCatalog> catalog;                // lessons, tests, exercises, games (lock-free reads)
 std::vector<ExerciseSubmission> exerciseSubmissions;  // Danh sách bài nộp
-std::map<std::string, Game> games;              // gameId -> Game
 std::map<std::string, GameSession> gameSessions;  // sessionId -> GameSession
-std::vector<ChatMessage> chatMessages;          // Danh sách tin nhắn
+ChatStore chatStore;                            // tin nhắn, indexed by conversation (guarded by chatMutex)
 std::map<int, std::string> clientSessions;      // socket -> sessionToken
 
 // Voice Call type alias
@@ -103,10 +242,104 @@ std::mutex usersMutex;
 std::mutex sessionsMutex;
 std::mutex chatMutex;
 std::mutex logMutex;
-std::mutex exercisesMutex;
+std::mutex exercisesMutex;                      // exerciseSubmissions
 std::mutex gamesMutex;
 std::mutex voiceCallMutex;
 
+// Durable chat history; attached to chatStore as its journal in main().
+// Never destroyed: exit() from the signal handler may run while a sender holds
+// its lock, and every acknowledged message is already on disk.
+english_learning::storage::ChatLog* chatLog = nullptr;
+
+// Chat history past the retention window, read on demand (internally locked).
+// chatStore keeps only newer or still-unread messages; see archiveChat().
+english_learning::storage::ColdStore* coldStore = nullptr;
+int64_t chatRetentionMs = int64_t(CHAT_HOT_RETENTION_DAYS) * 24 * 3600 * 1000;
+
+// Files attached to chat messages, stored once per distinct content
+// (internally locked). An attachment id is the SHA-256 of the file, so it
+// cannot be guessed: any logged-in user who has been shown one may fetch it.
+english_learning::storage::AttachmentStore* attachmentStore = nullptr;
+
+// Lesson progress of every user, indexed by the catalog's lesson slots.
+// Updates stay in memory; progressFlusher writes them to progressLog in
+// batches, so a crash loses at most the last PROGRESS_FLUSH_MS of them.
+ProgressStore progressStore(ContentCatalog::Lessons::slot);
+std::mutex progressMutex;                       // guards progressStore
+english_learning::storage::ProgressLog* progressLog = nullptr;
+
+// Serializes catalog reloads; readers never take it
+std::mutex contentReloadMutex;
+
+// Admission control, applied by handleClient before a request's payload is
+// parsed: per-session budgets (RATE_LIMITS), then a fair turn at a handler slot
+RateLimiter rateLimiter;
+FairScheduler* admission = nullptr;
+
+// Chat deliveries awaiting client acknowledgement (see catchUpInbox). Pushes
+// to a user are queued under inboxMutex so they arrive in sequence order.
+InboxStore inbox(INBOX_CAPACITY);
+int64_t inboxEpoch = 0;                         // start time of this run; sequences are only valid within it
+int64_t catalogEpoch = 0;                       // start time of this run; catalog versions are only valid within it
+int mediaPort = 0;                              // port of the HTTP media server, 0 if it is not running
+std::mutex inboxMutex;
+
+// Group chat channels (guarded by channelMutex), journaled to chatLog like
+// direct messages; see archiveChat() for how their history is bounded
+ChannelStore channels;
+std::mutex channelMutex;
+
+// Outgoing push queues by socket; each is drained by its connection's thread
+std::unordered_map<int, std::shared_ptr<Outbox>> outboxes;
+std::mutex outboxesMutex;
+
+// Full-text chat search. Senders only queue stored messages; chatIndexer
+// folds them into the index in batches (guarded by chatIndexMutex)
+struct PendingIndex {
+    ChatMessage message;
+    ChatIndex::Scope scope;
+};
+ChatIndex chatIndex;
+std::mutex chatIndexMutex;
+std::vector<PendingIndex> pendingIndex;
+std::mutex indexQueueMutex;
+std::condition_variable indexCv;
+
+// Typing indicators and read receipts: only the latest signal per
+// (conversation, user) survives a SIGNAL_BATCH_MS window (see signalPublisher)
+struct PendingSignal {
+    std::shared_ptr<const std::vector<std::string>> recipients;
+    std::string skipUserId;
+    std::string message;
+};
+struct TypingState {
+    bool typing = false;
+    int64_t sentAt = 0;         // when the last accepted event was queued
+};
+struct RateBucket {
+    double tokens = TYPING_RATE_PER_SEC;
+    int64_t refilledAt = 0;
+};
+std::map<std::string, PendingSignal> pendingSignals;    // coalescing key -> latest signal
+std::unordered_map<std::string, TypingState> typingStates;  // typing key -> last accepted state
+std::unordered_map<std::string, RateBucket> typingRates;    // senderId -> typing budget
+std::mutex signalsMutex;
+std::condition_variable signalsCv;
+
+// Presence fan-out: online/offline flips queued by the UserTable listener and
+// pushed to subscribers in batches (see presencePublisher)
+struct PendingPresence {
+    bool before;  // status subscribers last saw
+    bool now;     // latest status in this window
+};
+std::unordered_map<std::string, PendingPresence> pendingPresence;  // userId -> change
+// Subscribers hear only about contacts GET_CONTACT_LIST returned to them
+std::set<std::string> presenceWatchAll;         // subscribers that fetched the whole list
+std::unordered_map<std::string, std::set<std::string>> presenceWatchers;   // userId -> subscribers shown it
+std::unordered_map<std::string, std::vector<std::string>> presenceWatching; // subscriber -> userIds shown
+std::mutex presenceMutex;
+std::condition_variable presenceCv;
+
 int serverSocket = -1;
 bool running = true;
 
@@ -170,13 +403,12 @@ void initSampleData() {
     teacher1.fullname = "Ms. Sarah Johnson";
     teacher1.email = "sarah@example.com";
     teacher1.password = "teacher123";
-    teacher1.role = "teacher";
-    teacher1.level = "advanced";
+    teacher1.role = UserRole::Teacher;
+    teacher1.level = Level::Advanced;
     teacher1.createdAt = getCurrentTimestamp();
     teacher1.online = false;
     teacher1.clientSocket = -1;
-    users[teacher1.email] = teacher1;
-    userById[teacher1.userId] = &users[teacher1.email];
+    users.insert(teacher1);
 
     // Teacher 2
     User teacher2;
@@ -184,13 +416,12 @@ void initSampleData() {
     teacher2.fullname = "Mr. John Smith";
     teacher2.email = "john@example.com";
     teacher2.password = "teacher123";
-    teacher2.role = "teacher";
-    teacher2.level = "advanced";
+    teacher2.role = UserRole::Teacher;
+    teacher2.level = Level::Advanced;
     teacher2.createdAt = getCurrentTimestamp();
     teacher2.online = false;
     teacher2.clientSocket = -1;
-    users[teacher2.email] = teacher2;
-    userById[teacher2.userId] = &users[teacher2.email];
+    users.insert(teacher2);
 
     // Student 1
     User student1;
@@ -198,13 +429,12 @@ void initSampleData() {
     student1.fullname = "Nguyen Van A";
     student1.email = "student@example.com";
     student1.password = "student123";
-    student1.role = "student";
-    student1.level = "beginner";
+    student1.role = UserRole::Student;
+    student1.level = Level::Beginner;
     student1.createdAt = getCurrentTimestamp();
     student1.online = false;
     student1.clientSocket = -1;
-    users[student1.email] = student1;
-    userById[student1.userId] = &users[student1.email];
+    users.insert(student1);
 
     // Student 2
     User student2;
@@ -212,13 +442,12 @@ void initSampleData() {
     student2.fullname = "Tran Thi B";
     student2.email = "student2@example.com";
     student2.password = "student123";
-    student2.role = "student";
-    student2.level = "intermediate";
+    student2.role = UserRole::Student;
+    student2.level = Level::Intermediate;
     student2.createdAt = getCurrentTimestamp();
     student2.online = false;
     student2.clientSocket = -1;
-    users[student2.email] = student2;
-    userById[student2.userId] = &users[student2.email];
+    users.insert(student2);
 
     // Student 3
     User student3;
@@ -226,13 +455,12 @@ void initSampleData() {
     student3.fullname = "Le Van C";
     student3.email = "student3@example.com";
     student3.password = "student123";
-    student3.role = "student";
-    student3.level = "advanced";
+    student3.role = UserRole::Student;
+    student3.level = Level::Advanced;
     student3.createdAt = getCurrentTimestamp();
     student3.online = false;
     student3.clientSocket = -1;
-    users[student3.email] = student3;
-    userById[student3.userId] = &users[student3.email];
+    users.insert(student3);
 
     // Admin user
     User admin;
@@ -240,1130 +468,327 @@ void initSampleData() {
     admin.fullname = "System Administrator";
     admin.email = "admin@example.com";
     admin.password = "admin123";
-    admin.role = "admin";
-    admin.level = "advanced";
+    admin.role = UserRole::Admin;
+    admin.level = Level::Advanced;
     admin.createdAt = getCurrentTimestamp();
     admin.online = false;
     admin.clientSocket = -1;
-    users[admin.email] = admin;
-    userById[admin.userId] = &users[admin.email];
-
-    // ========== TẠO BÀI HỌC - BEGINNER ==========
-
-    // Lesson 1: Present Simple
-    Lesson lesson1;
-    lesson1.lessonId = "lesson_001";
-    lesson1.title = "Present Simple Tense";
-    lesson1.description = "Learn how to use present simple tense in English";
-    lesson1.topic = "grammar";
-    lesson1.level = "beginner";
-    lesson1.duration = 30;
-    lesson1.videoUrl = "/mnt/c/Users/20225804/Videos/1.mp4";  // Sample video
-    lesson1.audioUrl = "/mnt/c/Users/20225804/Music/audio.mp3";  // Sample system audio
-    lesson1.textContent = R"(
-========================================
-        PRESENT SIMPLE TENSE
-========================================
-
-1. USAGE (Cách dùng)
---------------------
-The present simple tense is used to describe:
-- Habits and routines (Thói quen)
-- General truths and facts (Sự thật chung)
-- Fixed schedules (Lịch trình cố định)
-
-2. STRUCTURE (Cấu trúc)
------------------------
-(+) Affirmative: Subject + V(s/es)
-    - I/You/We/They + V
-    - He/She/It + V(s/es)
-
-(-) Negative: Subject + do/does + not + V
-    - I/You/We/They + do not (don't) + V
-    - He/She/It + does not (doesn't) + V
-
-(?) Question: Do/Does + Subject + V?
-    - Do + I/you/we/they + V?
-    - Does + he/she/it + V?
-
-3. EXAMPLES (Ví dụ)
--------------------
-(+) I work in an office.
-    He works in an office.
-    She plays tennis every Sunday.
-
-(-) I don't work on Sundays.
-    She doesn't like coffee.
-    They don't speak French.
-
-(?) Do you work here?
-    Does he play football?
-    Do they live in London?
-
-4. TIME EXPRESSIONS (Trạng từ thời gian)
-----------------------------------------
-- always (luôn luôn)
-- usually (thường)
-- often (thường xuyên)
-- sometimes (thỉnh thoảng)
-- rarely (hiếm khi)
-- never (không bao giờ)
-- every day/week/month/year
-
-5. SPELLING RULES (Quy tắc chính tả)
-------------------------------------
-For he/she/it:
-- Most verbs: add -s (work -> works)
-- Verbs ending in -s, -sh, -ch, -x, -o: add -es
-  (watch -> watches, go -> goes)
-- Verbs ending in consonant + y: change y to -ies
-  (study -> studies, fly -> flies)
-
-6. COMMON MISTAKES (Lỗi thường gặp)
------------------------------------
-X He don't like coffee.
-V He doesn't like coffee.
-
-X She work in a bank.
-V She works in a bank.
-
-X Do she speak English?
-V Does she speak English?
-)";
-    lessons[lesson1.lessonId] = lesson1;
-
-    // Lesson 2: Common Daily Vocabulary
-    Lesson lesson2;
-    lesson2.lessonId = "lesson_002";
-    lesson2.title = "Common Daily Vocabulary";
-    lesson2.description = "Essential vocabulary for daily conversation";
-    lesson2.topic = "vocabulary";
-    lesson2.level = "beginner";
-    lesson2.duration = 25;
-    lesson2.videoUrl = "/mnt/c/Users/20225804/Videos/2.mp4";  // Daily vocabulary video
-    lesson2.audioUrl = "/mnt/c/Users/20225804/Music/audio.mp3";   // Audio pronunciation
-    lesson2.textContent = R"(
-========================================
-     COMMON DAILY VOCABULARY
-========================================
-
-1. GREETINGS (Chào hỏi)
------------------------
-- Hello /həˈloʊ/ - Xin chào
-- Hi /haɪ/ - Chào (thân mật)
-- Good morning - Chào buổi sáng
-- Good afternoon - Chào buổi chiều
-- Good evening - Chào buổi tối
-- Goodbye /ˌɡʊdˈbaɪ/ - Tạm biệt
-- See you later - Hẹn gặp lại
-- Good night - Chúc ngủ ngon
-
-2. BASIC EXPRESSIONS (Câu giao tiếp cơ bản)
--------------------------------------------
-- Thank you / Thanks - Cảm ơn
-- You're welcome - Không có gì
-- Please - Làm ơn / Xin vui lòng
-- Sorry / Excuse me - Xin lỗi
-- Yes - Vâng / Có
-- No - Không
-
-3. QUESTIONS (Câu hỏi)
-----------------------
-- How are you? - Bạn khỏe không?
-- What's your name? - Tên bạn là gì?
-- Where are you from? - Bạn đến từ đâu?
-- What time is it? - Mấy giờ rồi?
-- How old are you? - Bạn bao nhiêu tuổi?
-- What do you do? - Bạn làm nghề gì?
-
-4. NUMBERS (Số đếm)
--------------------
-1 - one      6 - six
-2 - two      7 - seven
-3 - three    8 - eight
-4 - four     9 - nine
-5 - five     10 - ten
-
-11 - eleven       20 - twenty
-12 - twelve       30 - thirty
-13 - thirteen     40 - forty
-14 - fourteen     50 - fifty
-15 - fifteen      100 - one hundred
-
-5. COLORS (Màu sắc)
--------------------
-- Red /red/ - Đỏ
-- Blue /bluː/ - Xanh dương
-- Green /ɡriːn/ - Xanh lá
-- Yellow /ˈjeloʊ/ - Vàng
-- Orange /ˈɔːrɪndʒ/ - Cam
-- Purple /ˈpɜːrpl/ - Tím
-- Pink /pɪŋk/ - Hồng
-- White /waɪt/ - Trắng
-- Black /blæk/ - Đen
-- Brown /braʊn/ - Nâu
-- Gray /ɡreɪ/ - Xám
-
-6. DAYS OF THE WEEK (Các ngày trong tuần)
------------------------------------------
-- Monday - Thứ Hai
-- Tuesday - Thứ Ba
-- Wednesday - Thứ Tư
-- Thursday - Thứ Năm
-- Friday - Thứ Sáu
-- Saturday - Thứ Bảy
-- Sunday - Chủ Nhật
-
-7. FAMILY MEMBERS (Thành viên gia đình)
----------------------------------------
-- Father / Dad - Bố
-- Mother / Mom - Mẹ
-- Brother - Anh/Em trai
-- Sister - Chị/Em gái
-- Grandfather - Ông
-- Grandmother - Bà
-- Uncle - Chú/Bác/Cậu
-- Aunt - Cô/Dì/Thím
-)";
-    lessons[lesson2.lessonId] = lesson2;
-
-    // Lesson 3: Basic Listening Skills
-    Lesson lesson3;
-    lesson3.lessonId = "lesson_003";
-    lesson3.title = "Introduction to Listening";
-    lesson3.description = "Basic listening skills and strategies for beginners";
-    lesson3.topic = "listening";
-    lesson3.level = "beginner";
-    lesson3.duration = 20;
-    lesson3.videoUrl = "/mnt/c/Users/20225804/Videos/3.mp4";  // English listening practice
-    lesson3.audioUrl = "/mnt/c/Users/20225804/Music/audio.mp3"; 
-    lesson3.textContent = R"(
-========================================
-    INTRODUCTION TO LISTENING
-========================================
-
-1. WHY IS LISTENING IMPORTANT?
-------------------------------
-- Understanding native speakers
-- Improving pronunciation
-- Learning natural expressions
-- Building confidence in communication
-
-2. LISTENING STRATEGIES
------------------------
-a) Before listening:
-   - Read the questions first
-   - Predict what you might hear
-   - Focus on key words
-
-b) While listening:
-   - Don't panic if you miss something
-   - Focus on main ideas first
-   - Listen for key words
-   - Pay attention to intonation
-
-c) After listening:
-   - Check your answers
-   - Listen again if possible
-   - Note new vocabulary
-
-3. COMMON LISTENING SITUATIONS
-------------------------------
-- Introducing yourself
-- Asking for directions
-- Ordering food
-- Shopping
-- Making phone calls
-
-4. PRACTICE DIALOGUE
---------------------
-A: Hello! My name is Tom. What's your name?
-B: Hi Tom! I'm Lisa. Nice to meet you.
-A: Nice to meet you too. Where are you from?
-B: I'm from Vietnam. How about you?
-A: I'm from the USA. Do you like it here?
-B: Yes, I do. It's very nice!
-
-5. KEY PHRASES TO LISTEN FOR
-----------------------------
-- "My name is..." (Tên tôi là...)
-- "I'm from..." (Tôi đến từ...)
-- "Nice to meet you" (Rất vui được gặp bạn)
-- "How are you?" (Bạn khỏe không?)
-- "I'm fine, thank you" (Tôi khỏe, cảm ơn)
-
-6. TIPS FOR IMPROVEMENT
------------------------
-- Listen to English every day (5-10 minutes)
-- Watch English videos with subtitles
-- Listen to slow, clear recordings first
-- Repeat what you hear
-- Don't translate word by word
-)";
-    lessons[lesson3.lessonId] = lesson3;
-
-    // ========== TẠO BÀI HỌC - INTERMEDIATE ==========
-
-    // Lesson 4: Past Tenses
-    Lesson lesson4;
-    lesson4.lessonId = "lesson_004";
-    lesson4.title = "Past Tenses";
-    lesson4.description = "Master past simple and past continuous tenses";
-    lesson4.topic = "grammar";
-    lesson4.level = "intermediate";
-    lesson4.duration = 45;
-    lesson4.textContent = R"(
-========================================
-          PAST TENSES
-========================================
-
-1. PAST SIMPLE TENSE
---------------------
-Used for completed actions in the past.
-
-Structure:
-(+) Subject + V2 (past form)
-(-) Subject + did not (didn't) + V
-(?) Did + Subject + V?
-
-Regular verbs: add -ed
-- work -> worked
-- play -> played
-- study -> studied
-
-Irregular verbs (must memorize):
-- go -> went
-- see -> saw
-- eat -> ate
-- buy -> bought
-- come -> came
-- take -> took
-- make -> made
-- give -> gave
-- find -> found
-- know -> knew
-
-Examples:
-- I worked late yesterday.
-- She didn't go to the party.
-- Did you see the movie?
-
-2. PAST CONTINUOUS TENSE
-------------------------
-Used for ongoing actions in the past.
-
-Structure:
-(+) Subject + was/were + V-ing
-(-) Subject + was/were + not + V-ing
-(?) Was/Were + Subject + V-ing?
-
-Examples:
-- I was studying at 8 PM.
-- They were playing football.
-- Was she working when you called?
-
-3. PAST SIMPLE vs PAST CONTINUOUS
----------------------------------
-Use Past Continuous for longer/background actions
-Use Past Simple for shorter/interrupting actions
-
-Example:
-"I was cooking when the phone rang."
-- was cooking = longer action (past continuous)
-- rang = shorter, interrupting action (past simple)
-
-More examples:
-- While she was sleeping, someone knocked on the door.
-- They were watching TV when the power went out.
-- I met her while I was walking in the park.
-
-4. TIME EXPRESSIONS
--------------------
-Past Simple:
-- yesterday
-- last week/month/year
-- two days ago
-- in 2020
-
-Past Continuous:
-- at 8 o'clock yesterday
-- this time last week
-- while
-- when
-
-5. COMMON MISTAKES
-------------------
-X I was go to school yesterday.
-V I went to school yesterday.
-
-X She didn't went to the party.
-V She didn't go to the party.
-
-X When I was walking home, I was seeing a cat.
-V When I was walking home, I saw a cat.
-)";
-    lessons[lesson4.lessonId] = lesson4;
-
-    // Lesson 5: Business Vocabulary
-    Lesson lesson5;
-    lesson5.lessonId = "lesson_005";
-    lesson5.title = "Business English Vocabulary";
-    lesson5.description = "Essential vocabulary for the workplace";
-    lesson5.topic = "vocabulary";
-    lesson5.level = "intermediate";
-    lesson5.duration = 35;
-    lesson5.textContent = R"(
-========================================
-    BUSINESS ENGLISH VOCABULARY
-========================================
-
-1. OFFICE VOCABULARY
---------------------
-- Meeting - Cuộc họp
-- Deadline - Hạn chót
-- Report - Báo cáo
-- Presentation - Bài thuyết trình
-- Conference - Hội nghị
-- Department - Phòng ban
-- Manager - Quản lý
-- Employee - Nhân viên
-- Colleague - Đồng nghiệp
-- Client - Khách hàng
-
-2. EMAIL EXPRESSIONS
---------------------
-Opening:
-- Dear Mr./Ms. [Name],
-- Hello [Name],
-- Good morning/afternoon,
-
-Body:
-- I am writing to inform you...
-- Please find attached...
-- I would like to request...
-- Thank you for your email.
-- Regarding your inquiry...
-
-Closing:
-- Best regards,
-- Kind regards,
-- Sincerely,
-- Looking forward to hearing from you.
-
-3. MEETING PHRASES
-------------------
-Starting:
-- Let's get started.
-- The purpose of this meeting is...
-- Today we're going to discuss...
-
-Opinions:
-- In my opinion...
-- I think/believe that...
-- From my point of view...
-
-Agreeing:
-- I agree with you.
-- That's a good point.
-- Exactly!
-
-Disagreeing:
-- I see your point, but...
-- I'm not sure I agree.
-- I have a different opinion.
-
-Ending:
-- To summarize...
-- Let's wrap up.
-- Any final questions?
-
-4. PHONE CONVERSATIONS
-----------------------
-Answering:
-- Hello, [Company name], how may I help you?
-- [Name] speaking.
-
-Asking to speak:
-- May I speak to [Name], please?
-- Could you put me through to...?
-- Is [Name] available?
-
-Leaving a message:
-- Could you take a message?
-- Please tell him/her that...
-- Could you ask him/her to call me back?
-
-5. COMMON BUSINESS VERBS
-------------------------
-- negotiate - đàm phán
-- collaborate - hợp tác
-- implement - triển khai
-- analyze - phân tích
-- delegate - ủy quyền
-- prioritize - ưu tiên
-- schedule - lên lịch
-- confirm - xác nhận
-)";
-    lessons[lesson5.lessonId] = lesson5;
-
-    // ========== TẠO BÀI HỌC - ADVANCED ==========
-
-    // Lesson 6: Advanced Grammar - Conditionals
-    Lesson lesson6;
-    lesson6.lessonId = "lesson_006";
-    lesson6.title = "Conditional Sentences";
-    lesson6.description = "Master all types of conditional sentences";
-    lesson6.topic = "grammar";
-    lesson6.level = "advanced";
-    lesson6.duration = 50;
-    lesson6.textContent = R"(
-========================================
-      CONDITIONAL SENTENCES
-========================================
-
-1. ZERO CONDITIONAL (Type 0)
-----------------------------
-Use: General truths, scientific facts
-
-Structure: If + present simple, present simple
-
-Examples:
-- If you heat water to 100°C, it boils.
-- If it rains, the grass gets wet.
-- Plants die if they don't get water.
-
-2. FIRST CONDITIONAL (Type 1)
------------------------------
-Use: Real/possible situations in the future
-
-Structure: If + present simple, will + V
-
-Examples:
-- If it rains tomorrow, I will stay home.
-- If you study hard, you will pass the exam.
-- She will be angry if you don't call her.
-
-3. SECOND CONDITIONAL (Type 2)
-------------------------------
-Use: Unreal/hypothetical situations now
-
-Structure: If + past simple, would + V
-
-Examples:
-- If I won the lottery, I would buy a house.
-- If I were you, I would accept the job.
-- She would travel more if she had more money.
-
-Note: Use "were" for all subjects (formal)
-- If I were rich... (not "was")
-- If she were here...
-
-4. THIRD CONDITIONAL (Type 3)
------------------------------
-Use: Unreal situations in the past
-
-Structure: If + past perfect, would have + V3
-
-Examples:
-- If I had studied harder, I would have passed.
-- If she had left earlier, she wouldn't have missed the train.
-- They would have won if they had practiced more.
-
-5. MIXED CONDITIONALS
----------------------
-Type 3 + Type 2 (Past -> Present):
-If + past perfect, would + V
-- If I had taken that job, I would be rich now.
-
-Type 2 + Type 3 (Present -> Past):
-If + past simple, would have + V3
-- If I were braver, I would have asked her out.
-
-6. ALTERNATIVE STRUCTURES
--------------------------
-Unless = If...not
-- Unless you hurry, you'll be late.
-- (= If you don't hurry, you'll be late.)
-
-Provided that / As long as
-- I'll help you provided that you help me too.
-
-In case
-- Take an umbrella in case it rains.
-
-7. COMMON MISTAKES
-------------------
-X If I will see him, I will tell him.
-V If I see him, I will tell him.
-
-X If I would have money, I would buy it.
-V If I had money, I would buy it.
-
-X If I would have known, I would have helped.
-V If I had known, I would have helped.
-)";
-    lessons[lesson6.lessonId] = lesson6;
-
-    // Lesson 7: IELTS Speaking
-    Lesson lesson7;
-    lesson7.lessonId = "lesson_007";
-    lesson7.title = "IELTS Speaking Skills";
-    lesson7.description = "Advanced speaking techniques for IELTS exam";
-    lesson7.topic = "speaking";
-    lesson7.level = "advanced";
-    lesson7.duration = 60;
-    lesson7.textContent = R"(
-========================================
-      IELTS SPEAKING SKILLS
-========================================
-
-1. PART 1: INTRODUCTION (4-5 minutes)
--------------------------------------
-Topics: Home, work, studies, hobbies, etc.
-
-Tips:
-- Give extended answers (2-3 sentences)
-- Don't memorize scripts
-- Be natural and confident
-
-Example:
-Q: Do you work or study?
-A: I'm currently working as a software developer
-   at a tech company in Ho Chi Minh City. I've been
-   in this position for about two years, and I find
-   it quite challenging but rewarding.
-
-2. PART 2: LONG TURN (3-4 minutes)
-----------------------------------
-You get a cue card with a topic.
-1 minute to prepare, 2 minutes to speak.
-
-Structure:
-- Introduction: What it is
-- Description: Details
-- Explanation: Why/How
-- Conclusion: Your feelings/opinions
-
-Example topic: Describe a book you enjoyed reading.
-- What book it was
-- When you read it
-- What it was about
-- Why you enjoyed it
-
-3. PART 3: DISCUSSION (4-5 minutes)
------------------------------------
-Abstract questions related to Part 2.
-
-Tips:
-- Express and justify opinions
-- Give examples
-- Consider different perspectives
-- Use advanced vocabulary
-
-4. USEFUL PHRASES
------------------
-Giving opinions:
-- From my perspective...
-- As far as I'm concerned...
-- I would argue that...
-- In my view...
-
-Explaining:
-- The main reason is that...
-- This is primarily because...
-- What I mean by that is...
-
-Giving examples:
-- For instance...
-- A good example would be...
-- To illustrate this point...
-
-Contrasting:
-- On the other hand...
-- Having said that...
-- Nevertheless...
-
-5. FLUENCY TECHNIQUES
----------------------
-- Use fillers naturally: "Well...", "Let me think..."
-- Paraphrase if you forget a word
-- Self-correct naturally
-- Maintain eye contact
-- Speak at a natural pace
-
-6. VOCABULARY ENHANCEMENT
--------------------------
-Instead of "good" -> excellent, outstanding, remarkable
-Instead of "bad" -> terrible, dreadful, appalling
-Instead of "big" -> enormous, massive, substantial
-Instead of "small" -> tiny, minute, negligible
-Instead of "important" -> crucial, vital, significant
-)";
-    lessons[lesson7.lessonId] = lesson7;
-
-    // ========== TẠO BÀI TEST ==========
-
-    // Test 1: Beginner Grammar
-    Test test1;
-    test1.testId = "test_001";
-    test1.testType = "mixed";
-    test1.level = "beginner";
-    test1.topic = "grammar";
-    test1.title = "Present Simple Tense Test";
-
-    TestQuestion q1;
-    q1.questionId = "q_001";
-    q1.type = "multiple_choice";
-    q1.question = "She ____ to school every day.";
-    q1.options = {"go", "goes", "going", "went"};
-    q1.correctAnswer = "b";
-    q1.points = 10;
-    test1.questions.push_back(q1);
-
-    TestQuestion q2;
-    q2.questionId = "q_002";
-    q2.type = "multiple_choice";
-    q2.question = "They ____ like spicy food.";
-    q2.options = {"doesn't", "don't", "isn't", "aren't"};
-    q2.correctAnswer = "b";
-    q2.points = 10;
-    test1.questions.push_back(q2);
-
-    TestQuestion q3;
-    q3.questionId = "q_003";
-    q3.type = "fill_blank";
-    q3.question = "I ____ English every day. (study)";
-    q3.correctAnswer = "study";
-    q3.points = 10;
-    test1.questions.push_back(q3);
-
-    TestQuestion q4;
-    q4.questionId = "q_004";
-    q4.type = "multiple_choice";
-    q4.question = "Choose the correct sentence:";
-    q4.options = {"He don't like coffee", "He doesn't likes coffee", "He doesn't like coffee", "He not like coffee"};
-    q4.correctAnswer = "c";
-    q4.points = 10;
-    test1.questions.push_back(q4);
-
-    TestQuestion q5;
-    q5.questionId = "q_005";
-    q5.type = "fill_blank";
-    q5.question = "My mother ____ (cook) dinner every evening.";
-    q5.correctAnswer = "cooks";
-    q5.points = 10;
-    test1.questions.push_back(q5);
-
-    TestQuestion q6;
-    q6.questionId = "q_006";
-    q6.type = "multiple_choice";
-    q6.question = "____ your brother work here?";
-    q6.options = {"Do", "Does", "Is", "Are"};
-    q6.correctAnswer = "b";
-    q6.points = 10;
-    test1.questions.push_back(q6);
-
-    TestQuestion q7;
-    q7.questionId = "q_007";
-    q7.type = "multiple_choice";
-    q7.question = "Water ____ at 100 degrees Celsius.";
-    q7.options = {"boil", "boils", "boiling", "boiled"};
-    q7.correctAnswer = "b";
-    q7.points = 10;
-    test1.questions.push_back(q7);
-
-    TestQuestion q8;
-    q8.questionId = "q_008";
-    q8.type = "fill_blank";
-    q8.question = "She always ____ (arrive) on time.";
-    q8.correctAnswer = "arrives";
-    q8.points = 10;
-    test1.questions.push_back(q8);
-
-    TestQuestion q9;
-    q9.questionId = "q_009";
-    q9.type = "sentence_order";
-    q9.question = "Arrange the words to make a correct sentence:";
-    q9.words = {"goes", "to", "school", "every", "day", "She"};
-    q9.correctAnswer = "She goes to school every day";
-    q9.points = 15;
-    test1.questions.push_back(q9);
-
-    tests[test1.testId] = test1;
-
-    // Test 2: Intermediate Grammar
-    Test test2;
-    test2.testId = "test_002";
-    test2.testType = "mixed";
-    test2.level = "intermediate";
-    test2.topic = "grammar";
-    test2.title = "Past Tenses Test";
-
-    TestQuestion q2_1;
-    q2_1.questionId = "q2_001";
-    q2_1.type = "multiple_choice";
-    q2_1.question = "I ____ to the cinema yesterday.";
-    q2_1.options = {"go", "went", "gone", "going"};
-    q2_1.correctAnswer = "b";
-    q2_1.points = 10;
-    test2.questions.push_back(q2_1);
-
-    TestQuestion q2_2;
-    q2_2.questionId = "q2_002";
-    q2_2.type = "multiple_choice";
-    q2_2.question = "While I ____ TV, the phone rang.";
-    q2_2.options = {"watch", "watched", "was watching", "am watching"};
-    q2_2.correctAnswer = "c";
-    q2_2.points = 10;
-    test2.questions.push_back(q2_2);
-
-    TestQuestion q2_3;
-    q2_3.questionId = "q2_003";
-    q2_3.type = "fill_blank";
-    q2_3.question = "She ____ (not/come) to the party last night.";
-    q2_3.correctAnswer = "didn't come";
-    q2_3.points = 10;
-    test2.questions.push_back(q2_3);
-
-    TestQuestion q2_4;
-    q2_4.questionId = "q2_004";
-    q2_4.type = "multiple_choice";
-    q2_4.question = "They ____ football when it started to rain.";
-    q2_4.options = {"played", "play", "were playing", "are playing"};
-    q2_4.correctAnswer = "c";
-    q2_4.points = 10;
-    test2.questions.push_back(q2_4);
-
-    TestQuestion q2_5;
-    q2_5.questionId = "q2_005";
-    q2_5.type = "fill_blank";
-    q2_5.question = "What ____ you ____ (do) at 8pm yesterday?";
-    q2_5.correctAnswer = "were doing";
-    q2_5.points = 10;
-    test2.questions.push_back(q2_5);
-
-    TestQuestion q2_6;
-    q2_6.questionId = "q2_006";
-    q2_6.type = "sentence_order";
-    q2_6.question = "Arrange the words to make a correct sentence:";
-    q2_6.words = {"was", "I", "when", "cooking", "rang", "the", "phone"};
-    q2_6.correctAnswer = "I was cooking when the phone rang";
-    q2_6.points = 15;
-    test2.questions.push_back(q2_6);
-
-    tests[test2.testId] = test2;
-
-    // Test 3: Advanced Grammar - Conditionals
-    Test test3;
-    test3.testId = "test_003";
-    test3.testType = "mixed";
-    test3.level = "advanced";
-    test3.topic = "grammar";
-    test3.title = "Conditional Sentences Test";
-
-    TestQuestion q3_1;
-    q3_1.questionId = "q3_001";
-    q3_1.type = "multiple_choice";
-    q3_1.question = "If I ____ rich, I would buy a big house.";
-    q3_1.options = {"am", "was", "were", "will be"};
-    q3_1.correctAnswer = "c";
-    q3_1.points = 10;
-    test3.questions.push_back(q3_1);
-
-    TestQuestion q3_2;
-    q3_2.questionId = "q3_002";
-    q3_2.type = "multiple_choice";
-    q3_2.question = "If you heat ice, it ____.";
-    q3_2.options = {"melts", "will melt", "would melt", "melted"};
-    q3_2.correctAnswer = "a";
-    q3_2.points = 10;
-    test3.questions.push_back(q3_2);
-
-    TestQuestion q3_3;
-    q3_3.questionId = "q3_003";
-    q3_3.type = "fill_blank";
-    q3_3.question = "If I had studied harder, I ____ (pass) the exam.";
-    q3_3.correctAnswer = "would have passed";
-    q3_3.points = 15;
-    test3.questions.push_back(q3_3);
-
-    TestQuestion q3_4;
-    q3_4.questionId = "q3_004";
-    q3_4.type = "multiple_choice";
-    q3_4.question = "If it rains tomorrow, we ____ the picnic.";
-    q3_4.options = {"cancel", "will cancel", "would cancel", "cancelled"};
-    q3_4.correctAnswer = "b";
-    q3_4.points = 10;
-    test3.questions.push_back(q3_4);
-
-    TestQuestion q3_5;
-    q3_5.questionId = "q3_005";
-    q3_5.type = "fill_blank";
-    q3_5.question = "I wish I ____ (know) the answer.";
-    q3_5.correctAnswer = "knew";
-    q3_5.points = 15;
-    test3.questions.push_back(q3_5);
-
-    tests[test3.testId] = test3;
-
-    // ========== TẠO BÀI TẬP ==========
-
-    // Exercise 1: Sentence Rewrite - Passive Voice
-    Exercise ex1;
-    ex1.exerciseId = "ex_001";
-    ex1.exerciseType = "sentence_rewrite";
-    ex1.title = "Rewrite Sentences in Passive Voice";
-    ex1.description = "Practice converting active sentences to passive voice";
-    ex1.instructions = "Rewrite the following sentences in passive voice. Make sure to use the correct verb forms.";
-    ex1.level = "intermediate";
-    ex1.topic = "grammar";
-    ex1.prompts = {
-        "People speak English all over the world.",
-        "The teacher corrected the homework.",
-        "They built this house in 2020.",
-        "Someone stole my bicycle yesterday."
-    };
-    ex1.duration = 20;
-    exercises[ex1.exerciseId] = ex1;
-
-    // Exercise 2: Paragraph Writing
-    Exercise ex2;
-    ex2.exerciseId = "ex_002";
-    ex2.exerciseType = "paragraph_writing";
-    ex2.title = "Write About Your Daily Routine";
-    ex2.description = "Practice writing descriptive paragraphs";
-    ex2.instructions = "Write a paragraph (150-200 words) describing your daily routine. Include what you do from morning to evening.";
-    ex2.level = "beginner";
-    ex2.topic = "writing";
-    ex2.topicDescription = "Describe your typical day from when you wake up until you go to bed.";
-    ex2.requirements = {
-        "Use present simple tense",
-        "Include at least 5 activities",
-        "Use time expressions (in the morning, at noon, etc.)",
-        "Proper paragraph structure"
-    };
-    ex2.duration = 30;
-    exercises[ex2.exerciseId] = ex2;
-
-    // Exercise 3: Topic Speaking
-    Exercise ex3;
-    ex3.exerciseId = "ex_003";
-    ex3.exerciseType = "topic_speaking";
-    ex3.title = "Speak About Environmental Issues";
-    ex3.description = "Practice speaking on important topics";
-    ex3.instructions = "Record yourself speaking about environmental issues for 2-3 minutes. Discuss causes, effects, and solutions.";
-    ex3.level = "advanced";
-    ex3.topic = "speaking";
-    ex3.topicDescription = "Environmental issues are becoming more serious every day. Discuss:\n- Main environmental problems\n- Their causes\n- Possible solutions\n- What individuals can do";
-    ex3.duration = 5;
-    exercises[ex3.exerciseId] = ex3;
-
-    // Exercise 4: Sentence Rewrite - Reported Speech
-    Exercise ex4;
-    ex4.exerciseId = "ex_004";
-    ex4.exerciseType = "sentence_rewrite";
-    ex4.title = "Rewrite Sentences in Reported Speech";
-    ex4.description = "Practice converting direct speech to reported speech";
-    ex4.instructions = "Rewrite the following sentences in reported speech. Change pronouns and verb tenses appropriately.";
-    ex4.level = "intermediate";
-    ex4.topic = "grammar";
-    ex4.prompts = {
-        "She said: 'I am studying English.'",
-        "He asked: 'Where do you live?'",
-        "They told me: 'We will come tomorrow.'",
-        "I said: 'I have finished my homework.'"
-    };
-    ex4.duration = 25;
-    exercises[ex4.exerciseId] = ex4;
-
-    // Exercise 5: Beginner Speaking - Introduce Yourself
-    Exercise ex5;
-    ex5.exerciseId = "ex_005";
-    ex5.exerciseType = "topic_speaking";
-    ex5.title = "Introduce Yourself";
-    ex5.description = "Practice basic self-introduction in English";
-    ex5.instructions = "Record a 1-2 minute introduction about yourself. Include your name, age, hobbies, and what you do.";
-    ex5.level = "beginner";
-    ex5.topic = "speaking";
-    ex5.topicDescription = "Introduce yourself:\n- Your name and where you're from\n- Your hobbies and interests\n- What you do (student, worker, etc.)\n- Your goals for learning English";
-    ex5.duration = 3;
-    exercises[ex5.exerciseId] = ex5;
-
-    // Exercise 6: Intermediate Writing - Opinion Essay
-    Exercise ex6;
-    ex6.exerciseId = "ex_006";
-    ex6.exerciseType = "paragraph_writing";
-    ex6.title = "Write an Opinion Essay";
-    ex6.description = "Express your opinion on a topic";
-    ex6.instructions = "Write 200-250 words expressing your opinion on the given topic. Support your views with reasons and examples.";
-    ex6.level = "intermediate";
-    ex6.topic = "writing";
-    ex6.topicDescription = "Topic: Should students have homework every day?\n\nWrite your opinion with clear reasons and examples.";
-    ex6.requirements = {
-        "Clear thesis statement",
-        "At least 2 supporting arguments",
-        "Examples or evidence for each argument",
-        "A conclusion summarizing your view"
-    };
-    ex6.minWordCount = 200;
-    ex6.maxWordCount = 250;
-    ex6.duration = 30;
-    exercises[ex6.exerciseId] = ex6;
-
-    // Exercise 7: Advanced Writing - Formal Email
-    Exercise ex7;
-    ex7.exerciseId = "ex_007";
-    ex7.exerciseType = "paragraph_writing";
-    ex7.title = "Write a Formal Business Email";
-    ex7.description = "Practice professional email writing";
-    ex7.instructions = "Write a formal email to your manager requesting time off for a family event.";
-    ex7.level = "advanced";
-    ex7.topic = "writing";
-    ex7.topicDescription = "You need to request 3 days off next month for a family wedding. Write a professional email including:\n- Proper greeting\n- Clear request with dates\n- Reason for the request\n- Proposed solution for your work\n- Professional closing";
-    ex7.requirements = {
-        "Formal greeting and closing",
-        "Clear subject line",
-        "Specific dates mentioned",
-        "Professional tone throughout",
-        "Solution-oriented approach"
-    };
-    ex7.minWordCount = 150;
-    ex7.maxWordCount = 200;
-    ex7.duration = 25;
-    exercises[ex7.exerciseId] = ex7;
-
-    // Exercise 8: Beginner Sentence Rewrite
-    Exercise ex8;
-    ex8.exerciseId = "ex_008";
-    ex8.exerciseType = "sentence_rewrite";
-    ex8.title = "Make Negative Sentences";
-    ex8.description = "Practice converting positive sentences to negative";
-    ex8.instructions = "Rewrite these positive sentences as negative sentences using 'not' or contractions.";
-    ex8.level = "beginner";
-    ex8.topic = "grammar";
-    ex8.prompts = {
-        "I like coffee.",
-        "She is a student.",
-        "They have a car.",
-        "He can swim.",
-        "We are going to the park."
-    };
-    ex8.duration = 15;
-    exercises[ex8.exerciseId] = ex8;
-
-    // ========== TẠO TRÒ CHƠI ==========
-
-    // Game 1: Word Matching - Daily Vocabulary
-    Game game1;
-    game1.gameId = "game_001";
-    game1.gameType = "word_match";
-    game1.title = "Daily Vocabulary Matching";
-    game1.description = "Match English words with Vietnamese meanings";
-    game1.level = "beginner";
-    game1.topic = "vocabulary";
-    game1.pairs = {
-        {"Hello", "Xin chào"},
-        {"Thank you", "Cảm ơn"},
-        {"Good morning", "Chào buổi sáng"},
-        {"Please", "Làm ơn"},
-        {"Sorry", "Xin lỗi"},
-        {"Yes", "Vâng"},
-        {"No", "Không"},
-        {"Water", "Nước"}
-    };
-    game1.timeLimit = 120;
-    game1.maxScore = 100;
-    games[game1.gameId] = game1;
-
-    // Game 2: Word Matching - Intermediate
-    Game game2;
-    game2.gameId = "game_002";
-    game2.gameType = "word_match";
-    game2.title = "Business Vocabulary Matching";
-    game2.description = "Match business terms with definitions";
-    game2.level = "intermediate";
-    game2.topic = "vocabulary";
-    game2.pairs = {
-        {"Meeting", "Cuộc họp"},
-        {"Deadline", "Hạn chót"},
-        {"Report", "Báo cáo"},
-        {"Manager", "Quản lý"},
-        {"Employee", "Nhân viên"},
-        {"Client", "Khách hàng"},
-        {"Contract", "Hợp đồng"},
-        {"Budget", "Ngân sách"}
-    };
-    game2.timeLimit = 150;
-    game2.maxScore = 100;
-    games[game2.gameId] = game2;
-
-    // Game 3: Sentence Matching
-    Game game3;
-    game3.gameId = "game_003";
-    game3.gameType = "sentence_match";
-    game3.title = "Question-Answer Matching";
-    game3.description = "Match questions with correct answers";
-    game3.level = "beginner";
-    game3.topic = "grammar";
-    game3.sentencePairs = {
-        {"What's your name?", "My name is John."},
-        {"How are you?", "I'm fine, thank you."},
-        {"Where are you from?", "I'm from Vietnam."},
-        {"How old are you?", "I'm 25 years old."},
-        {"What do you do?", "I'm a student."},
-        {"Do you like coffee?", "Yes, I do."}
-    };
-    game3.timeLimit = 180;
-    game3.maxScore = 100;
-    games[game3.gameId] = game3;
-
-    // Game 4: Picture Matching (Fruits - beginner level)
-    // Using real image URLs from free image sources
-    Game game4;
-    game4.gameId = "game_004";
-    game4.gameType = "picture_match";
-    game4.title = "Fruit Pictures";
-    game4.description = "Match English words with fruit images";
-    game4.level = "beginner";
-    game4.topic = "vocabulary";
-    game4.picturePairs = {
-        {"Apple", "https://cdn-icons-png.flaticon.com/128/415/415682.png"},
-        {"Banana", "https://cdn-icons-png.flaticon.com/128/3143/3143643.png"},
-        {"Orange", "https://cdn-icons-png.flaticon.com/128/415/415733.png"},
-        {"Grapes", "https://cdn-icons-png.flaticon.com/128/765/765560.png"},
-        {"Watermelon", "https://cdn-icons-png.flaticon.com/128/1514/1514933.png"},
-        {"Strawberry", "https://cdn-icons-png.flaticon.com/128/590/590772.png"}
-    };
-    game4.timeLimit = 120;
-    game4.maxScore = 100;
-    games[game4.gameId] = game4;
-
-    // Game 5: Picture Matching (Animals - intermediate level)
-    Game game5;
-    game5.gameId = "game_005";
-    game5.gameType = "picture_match";
-    game5.title = "Animal Pictures";
-    game5.description = "Match English words with animal images";
-    game5.level = "intermediate";
-    game5.topic = "vocabulary";
-    game5.picturePairs = {
-        {"Cat", "https://cdn-icons-png.flaticon.com/128/1864/1864514.png"},
-        {"Dog", "https://cdn-icons-png.flaticon.com/128/1998/1998627.png"},
-        {"Bird", "https://cdn-icons-png.flaticon.com/128/3069/3069186.png"},
-        {"Fish", "https://cdn-icons-png.flaticon.com/128/2219/2219126.png"},
-        {"Elephant", "https://cdn-icons-png.flaticon.com/128/2395/2395841.png"},
-        {"Lion", "https://cdn-icons-png.flaticon.com/128/2395/2395816.png"}
-    };
-    game5.timeLimit = 100;
-    game5.maxScore = 100;
-    games[game5.gameId] = game5;
+    users.insert(admin);
+
+    std::cout << "[INFO] Sample data initialized: " << users.size() << " users" << std::endl;
+}
+
+// ============================================================================
+// NẠP NỘI DUNG TỪ CONTENT PACK
+// ============================================================================
+
+// Catalog records are serialized once, when they enter a catalog version,
+// and handlers only stitch the per-request envelope around these fragments.
+
+Fragments renderLesson(const Lesson& lesson) {
+    Fragments json;
+    json.list = R"("lessonId":")" + lesson.lessonId +
+                R"(","title":")" + escapeJson(lesson.title) +
+                R"(","description":")" + escapeJson(lesson.description) +
+                R"(","topic":")" + topicToString(lesson.topic) +
+                R"(","level":")" + levelToString(lesson.level) +
+                R"(","duration":)" + std::to_string(lesson.duration);
+    // The text is left to the handler: it stays in the pack until asked for.
+    // So are the media URLs, which depend on the address the client used.
+    json.detail = R"("lessonId":")" + lesson.lessonId +
+                  R"(","title":")" + escapeJson(lesson.title) +
+                  R"(","description":")" + escapeJson(lesson.description) +
+                  R"(","level":")" + levelToString(lesson.level) +
+                  R"(","topic":")" + topicToString(lesson.topic) +
+                  R"(","duration":)" + std::to_string(lesson.duration);
+    return json;
+}
+
+Fragments renderTest(const Test& test) {
+    std::stringstream questionsJson;
+    questionsJson << "[";
+    for (size_t i = 0; i < test.questions.size(); i++) {
+        const TestQuestion& q = test.questions[i];
+        if (i > 0) questionsJson << ",";
+
+        questionsJson << R"({"questionId":")" << q.questionId
+                      << R"(","type":")" << questionTypeToString(q.type)
+                      << R"(","order":)" << (i + 1)
+                      << R"(,"question":")" << escapeJson(q.question)
+                      << R"(","points":)" << q.points;
+
+        if (!q.options.empty()) {
+            questionsJson << R"(,"options":[)";
+            for (size_t j = 0; j < q.options.size(); j++) {
+                if (j > 0) questionsJson << ",";
+                char optionId = 'a' + j;
+                questionsJson << R"({"id":")" << optionId << R"(","text":")" << escapeJson(q.options[j]) << R"("})";
+            }
+            questionsJson << "]";
+        }
+
+        if (q.type == QuestionType::SentenceOrder && !q.words.empty()) {
+            questionsJson << R"(,"words":[)";
+            for (size_t j = 0; j < q.words.size(); j++) {
+                if (j > 0) questionsJson << ",";
+                questionsJson << R"(")" << escapeJson(q.words[j]) << R"(")";
+            }
+            questionsJson << "]";
+        }
+        questionsJson << "}";
+    }
+    questionsJson << "]";
+
+    Fragments json;
+    json.detail = R"("testId":")" + test.testId +
+                  R"(","testType":")" + test.testType.str() +
+                  R"(","level":")" + levelToString(test.level) +
+                  R"(","topic":")" + topicToString(test.topic) +
+                  R"(","title":")" + escapeJson(test.title) +
+                  R"(","duration":1800,"totalQuestions":)" + std::to_string(test.questions.size()) +
+                  R"(,"passingScore":60,"questions":)" + questionsJson.str() +
+                  R"(,"instructions":"Read each question carefully. Answer all questions.")";
+    return json;
+}
+
+Fragments renderExercise(const Exercise& ex) {
+    Fragments json;
+    json.list = R"("exerciseId":")" + ex.exerciseId +
+                R"(","exerciseType":")" + exerciseTypeToString(ex.exerciseType) +
+                R"(","title":")" + escapeJson(ex.title) +
+                R"(","description":")" + escapeJson(ex.description) +
+                R"(","level":")" + levelToString(ex.level) +
+                R"(","topic":")" + topicToString(ex.topic) +
+                R"(","duration":)" + std::to_string(ex.duration);
+
+    std::stringstream detail;
+    detail << R"("exerciseId":")" << ex.exerciseId
+           << R"(","exerciseType":")" << exerciseTypeToString(ex.exerciseType)
+           << R"(","title":")" << escapeJson(ex.title)
+           << R"(","description":")" << escapeJson(ex.description)
+           << R"(","instructions":")" << escapeJson(ex.instructions)
+           << R"(","level":")" << levelToString(ex.level)
+           << R"(","topic":")" << topicToString(ex.topic)
+           << R"(","duration":)" << ex.duration;
+
+    if (ex.exerciseType == ExerciseType::SentenceRewrite && !ex.prompts.empty()) {
+        detail << R"(,"prompts":[)";
+        for (size_t i = 0; i < ex.prompts.size(); i++) {
+            if (i > 0) detail << ",";
+            detail << R"(")" << escapeJson(ex.prompts[i]) << R"(")";
+        }
+        detail << "]";
+    } else if (ex.exerciseType == ExerciseType::ParagraphWriting) {
+        detail << R"(,"topicDescription":")" << escapeJson(ex.topicDescription) << R"(")";
+        if (!ex.requirements.empty()) {
+            detail << R"(,"requirements":[)";
+            for (size_t i = 0; i < ex.requirements.size(); i++) {
+                if (i > 0) detail << ",";
+                detail << R"(")" << escapeJson(ex.requirements[i]) << R"(")";
+            }
+            detail << "]";
+        }
+    } else if (ex.exerciseType == ExerciseType::TopicSpeaking) {
+        detail << R"(,"topicDescription":")" << escapeJson(ex.topicDescription) << R"(")";
+    }
+    json.detail = detail.str();
+    return json;
+}
+
+// detail is the list entry plus the pairs to match; START_GAME and the
+// admin game list both send it
+Fragments renderGame(const Game& game) {
+    Fragments json;
+    json.list = R"("gameId":")" + game.gameId +
+                R"(","gameType":")" + gameTypeToString(game.gameType) +
+                R"(","title":")" + escapeJson(game.title) +
+                R"(","description":")" + escapeJson(game.description) +
+                R"(","level":")" + levelToString(game.level) +
+                R"(","topic":")" + escapeJson(game.topic) +
+                R"(","timeLimit":)" + std::to_string(game.timeLimit) +
+                R"(,"maxScore":)" + std::to_string(game.maxScore);
+
+    std::stringstream pairs;
+    if (game.gameType == GameType::WordMatch) {
+        pairs << R"(,"pairs":[)";
+        for (size_t i = 0; i < game.pairs.size(); i++) {
+            if (i > 0) pairs << ",";
+            pairs << R"({"left":")" << escapeJson(game.pairs[i].first)
+                  << R"(","right":")" << escapeJson(game.pairs[i].second) << R"("})";
+        }
+        pairs << "]";
+    } else if (game.gameType == GameType::SentenceMatch) {
+        pairs << R"(,"pairs":[)";
+        for (size_t i = 0; i < game.sentencePairs.size(); i++) {
+            if (i > 0) pairs << ",";
+            pairs << R"({"left":")" << escapeJson(game.sentencePairs[i].first)
+                  << R"(","right":")" << escapeJson(game.sentencePairs[i].second) << R"("})";
+        }
+        pairs << "]";
+    } else if (game.gameType == GameType::PictureMatch) {
+        pairs << R"(,"pairs":[)";
+        for (size_t i = 0; i < game.picturePairs.size(); i++) {
+            if (i > 0) pairs << ",";
+            pairs << R"({"word":")" << escapeJson(game.picturePairs[i].first)
+                  << R"(","imageUrl":")" << escapeJson(game.picturePairs[i].second) << R"("})";
+        }
+        pairs << "]";
+    }
+    json.detail = json.list + pairs.str();
+    return json;
+}
+
+const ContentCatalog::Renderers catalogRenderers = {renderLesson, renderTest, renderExercise, renderGame};
+
+// What a reload did, for the log and for RELOAD_CONTENT_RESPONSE
+struct ContentReload {
+    bool published = false;
+    uint64_t version = 0;                   // catalog version now being served
+    size_t packs = 0, lessons = 0, tests = 0, exercises = 0, games = 0;
+    size_t terms = 0;                       // distinct words in the content search indexes, per kind
+    long long elapsedMs = 0;
+    std::vector<std::string> problems;      // packs or records that could not be loaded
+};
+
+// Build a new catalog from the packs in CONTENT_PACK_DIR and swap it in.
+// The catalog is built and validated off to the side; requests already
+// running finish against the version they started with. Edits made at
+// runtime (games added by admins, ...) are carried over. With strict, a
+// catalog with any unusable pack or record, or with no packs at all, is
+// rejected and the current one stays; at startup whatever loads is used.
+ContentReload reloadContent(bool strict) {
+    std::lock_guard<std::mutex> reloadLock(contentReloadMutex);
+    auto started = std::chrono::steady_clock::now();
+    ContentReload result;
+
+    ContentCatalog fresh;
+    fresh.setRenderers(catalogRenderers);
+    bool clean = ContentCatalog::load(CONTENT_PACK_DIR, fresh, result.problems);
+    if (strict && fresh.packs.empty()) {
+        result.problems.push_back(std::string("no content packs in ") + CONTENT_PACK_DIR);
+        clean = false;
+    }
+
+    if (clean || !strict) {
+        catalog.update([&](ContentCatalog& current) {
+            fresh.replayEdits(current);
+            fresh.advance(current);
+            fresh.indexText();   // the reloaded tables share nothing with current
+            current = std::move(fresh);
+            result.version = current.version;
+            result.packs = current.packs.size();
+            result.lessons = current.lessons.size();
+            result.tests = current.tests.size();
+            result.exercises = current.exercises.size();
+            result.games = current.games.size();
+            result.terms = current.lessonIndex->termCount() + current.exerciseIndex->termCount() +
+                           current.gameIndex->termCount();
+        });
+        result.published = true;
+    } else {
+        EpochGuard guard;
+        result.version = catalog.read().version;
+    }
+    result.elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - started).count();
+
+    for (const std::string& problem : result.problems) {
+        std::cerr << "[WARN] Content pack " << problem << std::endl;
+    }
+    if (!result.published) {
+        std::cerr << "[WARN] Content reload rejected; still serving version " << result.version << std::endl;
+        return result;
+    }
+    if (result.packs == 0) {
+        std::cerr << "[WARN] No content packs in " << CONTENT_PACK_DIR
+                  << "; the catalog is empty (build one with 'make content')" << std::endl;
+    }
+    std::cout << "[INFO] Content version " << result.version << " loaded from " << result.packs << " pack(s) in "
+              << result.elapsedMs << " ms: " << result.lessons << " lessons, " << result.tests << " tests, "
+              << result.exercises << " exercises, " << result.games << " games; "
+              << result.terms << " search terms" << std::endl;
+    return result;
+}
+
+// Publish a catalog version with fn's change to it. Changes made this way are
+// recorded as edits and survive reloads. fn returns false to change nothing.
+template <typename Fn>
+bool editCatalog(Fn&& fn) {
+    return catalog.update([&](ContentCatalog& current) {
+        if (!fn(current)) return false;
+        current.advance(catalog.read());   // still the published version here
+        current.indexText(&catalog.read());
+        return true;
+    });
+}
+
+// Name, size and modification time of every pack in CONTENT_PACK_DIR
+std::string contentPackSignature() {
+    std::vector<std::string> entries;
+    if (DIR* dir = opendir(CONTENT_PACK_DIR)) {
+        while (dirent* entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            if (name.size() <= 5 || name.compare(name.size() - 5, 5, ".pack") != 0) continue;
+            struct stat st;
+            if (stat((std::string(CONTENT_PACK_DIR) + "/" + name).c_str(), &st) != 0) continue;
+            entries.push_back(name + ":" + std::to_string(st.st_size) + ":" +
+                              std::to_string(st.st_mtim.tv_sec) + "." + std::to_string(st.st_mtim.tv_nsec));
+        }
+        closedir(dir);
+    }
+    std::sort(entries.begin(), entries.end());
+    std::string signature;
+    for (const std::string& entry : entries) signature += entry + "\n";
+    return signature;
+}
+
+// Background thread: reloads the catalog when the packs in CONTENT_PACK_DIR
+// change. A change is acted on once it has been stable for a whole
+// CONTENT_WATCH_SEC, so a pack still being copied in is not picked up.
+void contentWatcher() {
+    std::string loaded = contentPackSignature();
+    std::string seen = loaded;
+    while (running) {
+        std::this_thread::sleep_for(std::chrono::seconds(CONTENT_WATCH_SEC));
+        std::string now = contentPackSignature();
+        if (now != seen) {
+            seen = now;
+            continue;
+        }
+        if (now == loaded) continue;
+        std::cout << "[INFO] Content packs changed; reloading" << std::endl;
+        reloadContent(true);
+        loaded = now;   // a rejected set is not retried until it changes again
+    }
+}
+
+std::string levelChannelId(Level level) {
+    return "level_" + levelToString(level);
+}
 
-    std::cout << "[INFO] Sample data initialized: "
-              << users.size() << " users, "
-              << lessons.size() << " lessons, "
-              << tests.size() << " tests, "
-              << exercises.size() << " exercises, "
-              << games.size() << " games" << std::endl;
+// One channel per level: every student at that level plus all teachers and admins
+void initChannels() {
+    const Level levels[] = {Level::Beginner, Level::Intermediate, Level::Advanced};
+
+    std::lock_guard<std::mutex> lock(channelMutex);
+    for (Level level : levels) {
+        Channel channel;
+        channel.channelId = levelChannelId(level);
+        channel.name = levelToString(level) + " learners";
+        channel.name[0] = static_cast<char>(std::toupper(static_cast<unsigned char>(channel.name[0])));
+        channel.kind = ChannelKind::Level;
+        channel.level = level;
+        channel.createdAt = getCurrentTimestamp();
+        channels.create(channel);
+    }
+
+    users.forEach([&](UserHandle, const User& user) {
+        if (user.role == UserRole::Student) {
+            channels.addMember(levelChannelId(user.level), user.userId);
+            return;
+        }
+        for (Level level : levels) channels.addMember(levelChannelId(level), user.userId);
+    });
 }
 
 // ============================================================================
@@ -1387,7 +812,7 @@ std::string handleRegister(const std::string& json) {
 
     {
         std::lock_guard<std::mutex> lock(usersMutex);
-        if (users.find(email) != users.end()) {
+        if (users.findByEmail(email)) {
             return R"({"messageType":"REGISTER_RESPONSE","messageId":")" + messageId +
                    R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
                    R"(,"payload":{"status":"error","message":"Email already exists"}})";
@@ -1398,14 +823,17 @@ std::string handleRegister(const std::string& json) {
         newUser.fullname = fullname;
         newUser.email = email;
         newUser.password = password;
-        newUser.role = "student";
-        newUser.level = "beginner";
+        newUser.role = UserRole::Student;
+        newUser.level = Level::Beginner;
         newUser.createdAt = getCurrentTimestamp();
         newUser.online = false;
         newUser.clientSocket = -1;
 
-        users[email] = newUser;
-        userById[newUser.userId] = &users[email];
+        users.insert(newUser);
+        {
+            std::lock_guard<std::mutex> channelLock(channelMutex);
+            channels.addMember(levelChannelId(newUser.level), newUser.userId);
+        }
 
         return R"({"messageType":"REGISTER_RESPONSE","messageId":")" + messageId +
                R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
@@ -1415,19 +843,47 @@ std::string handleRegister(const std::string& json) {
     }
 }
 
-// Gửi thông báo tin nhắn chưa đọc khi user login
-void sendUnreadMessagesNotification(int clientSocket, const std::string& userId) {
-    std::vector<ChatMessage> unreadMessages;
-
-    {
-        std::lock_guard<std::mutex> lock(chatMutex);
-        for (auto& msg : chatMessages) {
-            if (msg.recipientId == userId && !msg.read) {
-                unreadMessages.push_back(msg);
-            }
-        }
+// Read the "attachments" array of a send request. Sizes come from the store
+// rather than the client. Returns an error message, or "" if all are valid.
+std::string parseAttachments(const std::string& payload, std::vector<Attachment>& attachments) {
+    std::string array = getJsonArray(payload, "attachments");
+    if (array.empty()) return "";
+    std::vector<std::string> items = parseJsonArray(array);
+    if (items.size() > ATTACHMENTS_PER_MESSAGE) {
+        return "At most " + std::to_string(ATTACHMENTS_PER_MESSAGE) + " attachments per message";
+    }
+    for (const std::string& item : items) {
+        Attachment attachment;
+        attachment.attachmentId = getJsonValue(item, "attachmentId");
+        attachment.mimeType = getJsonValue(item, "mimeType");
+        attachment.fileName = getJsonValue(item, "fileName");
+        if (!attachment.isImage() && !attachment.isAudio()) return "Only images and audio can be attached";
+        if (attachment.fileName.size() > 255) return "Attachment file name is too long";
+        auto size = attachmentStore->size(attachment.attachmentId);
+        if (!size) return "Attachment not found";
+        attachment.size = *size;
+        attachments.push_back(std::move(attachment));
     }
+    return "";
+}
 
+// ,"attachments":[...] for a message that has any, otherwise nothing
+std::string attachmentsField(const std::vector<Attachment>& attachments) {
+    if (attachments.empty()) return "";
+    std::string json = R"(,"attachments":[)";
+    for (size_t i = 0; i < attachments.size(); ++i) {
+        const Attachment& a = attachments[i];
+        if (i > 0) json += ",";
+        json += R"({"attachmentId":")" + a.attachmentId +
+                R"(","mimeType":")" + escapeJson(a.mimeType) +
+                R"(","fileName":")" + escapeJson(a.fileName) +
+                R"(","size":)" + std::to_string(a.size) + "}";
+    }
+    return json + "]";
+}
+
+// Gửi thông báo tin nhắn chưa đọc khi user login
+void sendUnreadMessagesNotification(int clientSocket, const std::vector<ChatMessage>& unreadMessages) {
     if (unreadMessages.empty()) return;
 
     // Tạo danh sách tin nhắn chưa đọc với tên người gửi
@@ -1435,12 +891,11 @@ void sendUnreadMessagesNotification(int clientSocket, const std::string& userId)
     messagesJson << "[";
     bool first = true;
 
-    std::lock_guard<std::mutex> userLock(usersMutex);
+    EpochGuard guard;
     for (const auto& msg : unreadMessages) {
         std::string senderName = "Unknown";
-        auto senderIt = userById.find(msg.senderId);
-        if (senderIt != userById.end()) {
-            senderName = senderIt->second->fullname;
+        if (const User* sender = users.getById(msg.senderId)) {
+            senderName = sender->fullname;
         }
 
         if (!first) messagesJson << ",";
@@ -1450,7 +905,8 @@ void sendUnreadMessagesNotification(int clientSocket, const std::string& userId)
                      << R"(","senderId":")" << msg.senderId
                      << R"(","senderName":")" << escapeJson(senderName)
                      << R"(","content":")" << escapeJson(msg.content)
-                     << R"(","timestamp":)" << msg.timestamp << "}";
+                     << R"(","timestamp":)" << msg.timestamp
+                     << attachmentsField(msg.attachments) << "}";
     }
     messagesJson << "]";
 
@@ -1467,6 +923,140 @@ void sendUnreadMessagesNotification(int clientSocket, const std::string& userId)
     logMessage("SEND", "Client:" + std::to_string(clientSocket), "UNREAD_MESSAGES_NOTIFICATION");
 }
 
+// RECEIVE_MESSAGE push; seq is the message's position in the recipient's inbox
+std::string buildReceiveMessage(const ChatMessage& msg, const std::string& senderName, uint64_t seq) {
+    return R"({"messageType":"RECEIVE_MESSAGE","messageId":")" + msg.messageId +
+           R"(","timestamp":)" + std::to_string(msg.timestamp) +
+           R"(,"payload":{"messageId":")" + msg.messageId +
+           R"(","senderId":")" + msg.senderId +
+           R"(","senderName":")" + escapeJson(senderName) +
+           R"(","messageContent":")" + escapeJson(msg.content) +
+           R"(","sentAt":)" + std::to_string(msg.timestamp) +
+           R"(,"seq":)" + std::to_string(seq) + attachmentsField(msg.attachments) + R"(}})";
+}
+
+// Queue a push for a connection; false if it is gone or its queue is full
+bool pushFrame(int socket, const Frame& frame) {
+    std::lock_guard<std::mutex> lock(outboxesMutex);
+    auto it = outboxes.find(socket);
+    return it != outboxes.end() && it->second->push(frame);
+}
+
+// Queue one shared frame to every online user in userIds except skipUserId;
+// returns the number of connections it was queued to
+size_t pushToUsers(const std::vector<std::string>& userIds, const std::string& skipUserId,
+                   const Frame& frame) {
+    size_t pushed = 0;
+    EpochGuard guard;
+    std::lock_guard<std::mutex> lock(outboxesMutex);
+    for (const std::string& id : userIds) {
+        if (id == skipUserId) continue;
+        const User* user = users.getById(id);
+        if (!user || !user->online) continue;
+        auto it = outboxes.find(user->clientSocket);
+        if (it != outboxes.end() && it->second->push(frame)) pushed++;
+    }
+    return pushed;
+}
+
+// Queue a signal on the signal lane of each online recipient's outbox
+size_t pushSignalToUsers(const std::vector<std::string>& userIds, const std::string& skipUserId,
+                         const std::string& key, const Frame& frame) {
+    size_t pushed = 0;
+    EpochGuard guard;
+    std::lock_guard<std::mutex> lock(outboxesMutex);
+    for (const std::string& id : userIds) {
+        if (id == skipUserId) continue;
+        const User* user = users.getById(id);
+        if (!user || !user->online) continue;
+        auto it = outboxes.find(user->clientSocket);
+        if (it != outboxes.end() && it->second->pushSignal(key, frame)) pushed++;
+    }
+    return pushed;
+}
+
+// Replace the waiting signal under key; signalPublisher delivers it
+void queueSignal(const std::string& key, std::shared_ptr<const std::vector<std::string>> recipients,
+                 const std::string& skipUserId, const std::string& message) {
+    {
+        std::lock_guard<std::mutex> lock(signalsMutex);
+        pendingSignals[key] = PendingSignal{std::move(recipients), skipUserId, message};
+    }
+    signalsCv.notify_one();
+}
+
+std::string typingKey(const std::string& conversationId, const std::string& userId) {
+    return "typing|" + conversationId + "|" + userId;
+}
+
+// A message ends its sender's typing: drop an undelivered indicator so it
+// cannot arrive after the message (clients clear the indicator on receipt)
+void clearTyping(const std::string& conversationId, const std::string& senderId) {
+    std::string key = typingKey(conversationId, senderId);
+    std::lock_guard<std::mutex> lock(signalsMutex);
+    auto it = typingStates.find(key);
+    if (it == typingStates.end()) return;
+    typingStates.erase(it);
+    pendingSignals.erase(key);
+}
+
+// Hand a stored message to chatIndexer; cheap enough for the send path
+void queueForIndex(const ChatMessage& msg, ChatIndex::Scope scope) {
+    {
+        std::lock_guard<std::mutex> lock(indexQueueMutex);
+        pendingIndex.push_back(PendingIndex{msg, scope});
+    }
+    indexCv.notify_one();
+}
+
+// Catch a client up on chat after login, then route live pushes to it.
+// A client that reports the inboxEpoch and lastSeq of an earlier connection
+// gets only the messages it missed, replayed in order. Any other login (or a
+// gap that overflowed the inbox) clears the inbox and gets the unread summary.
+void catchUpInbox(int clientSocket, const std::string& userId, const std::string& loginPayload) {
+    std::string epochStr = getJsonValue(loginPayload, "inboxEpoch");
+    std::string lastSeqStr = getJsonValue(loginPayload, "lastSeq");
+    bool resume = !epochStr.empty() && !lastSeqStr.empty() &&
+                  std::atoll(epochStr.c_str()) == inboxEpoch;
+    uint64_t lastSeq = std::strtoull(lastSeqStr.c_str(), nullptr, 10);
+
+    std::lock_guard<std::mutex> lock(inboxMutex);
+    std::vector<InboxStore::Entry> gap;
+    if (resume && inbox.since(userId, lastSeq, gap)) {
+        inbox.ack(userId, lastSeq);
+
+        std::vector<std::pair<uint64_t, ChatMessage>> missed;
+        {
+            std::lock_guard<std::mutex> chatLock(chatMutex);
+            for (const auto& entry : gap) {
+                // Skip messages deleted or read elsewhere in the meantime
+                const ChatMessage* msg = chatStore.findById(entry.messageId);
+                if (msg && !msg->read) missed.emplace_back(entry.seq, *msg);
+            }
+        }
+
+        EpochGuard guard;
+        for (const auto& item : missed) {
+            const User* sender = users.getById(item.second.senderId);
+            pushFrame(clientSocket, makeFrame(buildReceiveMessage(item.second,
+                                                                  sender ? sender->fullname : "Unknown",
+                                                                  item.first)));
+        }
+        logMessage("SEND", "Client:" + std::to_string(clientSocket),
+                   "RECEIVE_MESSAGE x" + std::to_string(missed.size()) + " (inbox resumed after seq " +
+                   std::to_string(lastSeq) + ")");
+    } else {
+        inbox.ackAll(userId);
+        std::vector<ChatMessage> unreadMessages;
+        {
+            std::lock_guard<std::mutex> chatLock(chatMutex);
+            unreadMessages = chatStore.unreadFor(userId);
+        }
+        sendUnreadMessagesNotification(clientSocket, unreadMessages);
+    }
+    inbox.attach(userId, clientSocket);
+}
+
 // Xử lý LOGIN_REQUEST
 std::string handleLogin(const std::string& json, int clientSocket) {
     std::string payload = getJsonObject(json, "payload");
@@ -1480,16 +1070,18 @@ std::string handleLogin(const std::string& json, int clientSocket) {
     {
         std::lock_guard<std::mutex> lock(usersMutex);
 
-        auto it = users.find(email);
-        if (it == users.end() || it->second.password != password) {
+        UserHandle handle = users.findByEmail(email);
+        const User* found = users.get(handle);
+        if (!found || found->password != password) {
             return R"({"messageType":"LOGIN_RESPONSE","messageId":")" + messageId +
                    R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
                    R"(,"payload":{"status":"error","message":"Invalid email or password"}})";
         }
 
-        User& user = it->second;
+        User user = *found;
         user.online = true;
         user.clientSocket = clientSocket;
+        users.update(handle, user);
         userId = user.userId;
 
         std::string sessionToken = generateSessionToken();
@@ -1508,8 +1100,10 @@ std::string handleLogin(const std::string& json, int clientSocket) {
                R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
                R"(,"payload":{"status":"success","message":"Login successfully","data":{"userId":")" +
                user.userId + R"(","fullname":")" + escapeJson(user.fullname) + R"(","email":")" +
-               user.email + R"(","level":")" + user.level + R"(","role":")" + user.role + R"(","sessionToken":")" +
-               sessionToken + R"(","expiresAt":)" + std::to_string(session.expiresAt) + R"(}}})";
+               user.email + R"(","level":")" + levelToString(user.level) +
+               R"(","role":")" + roleToString(user.role) + R"(","sessionToken":")" +
+               sessionToken + R"(","expiresAt":)" + std::to_string(session.expiresAt) +
+               R"(,"inboxEpoch":)" + std::to_string(inboxEpoch) + R"(}}})";
     }
 
     // Gửi response trước
@@ -1518,8 +1112,8 @@ std::string handleLogin(const std::string& json, int clientSocket) {
     send(clientSocket, response.c_str(), response.length(), 0);
     logMessage("SEND", "Client:" + std::to_string(clientSocket), response);
 
-    // Sau đó gửi thông báo tin nhắn chưa đọc (nếu có)
-    sendUnreadMessagesNotification(clientSocket, userId);
+    // Sau đó gửi tin nhắn bị lỡ (hoặc thông báo tin nhắn chưa đọc)
+    catchUpInbox(clientSocket, userId, payload);
 
     // Trả về chuỗi rỗng để báo hiệu đã xử lý response
     return "";
@@ -1560,7 +1154,8 @@ std::string handleLoginV2(const std::string& json, int clientSocket) {
                    R"(,"payload":{"status":"success","message":"Login successfully","data":{"userId":")" +
                    data.userId + R"(","fullname":")" + escapeJson(data.fullname) + R"(","email":")" +
                    data.email + R"(","level":")" + data.level + R"(","role":")" + data.role + R"(","sessionToken":")" +
-                   data.sessionToken + R"(","expiresAt":)" + std::to_string(data.expiresAt) + R"(}}})";
+                   data.sessionToken + R"(","expiresAt":)" + std::to_string(data.expiresAt) +
+                   R"(,"inboxEpoch":)" + std::to_string(inboxEpoch) + R"(}}})";
     }
 
     // Send response
@@ -1571,7 +1166,7 @@ std::string handleLoginV2(const std::string& json, int clientSocket) {
 
     // Send unread messages notification if login successful
     if (result.isSuccess()) {
-        sendUnreadMessagesNotification(clientSocket, result.getData().userId);
+        catchUpInbox(clientSocket, result.getData().userId, payload);
     }
 
     return "";  // Response already sent
@@ -1589,6 +1184,88 @@ std::string validateSession(const std::string& sessionToken) {
     return it->second.userId;
 }
 
+// Who a request counts against for admission control
+struct Requester {
+    std::string bucketKey;  // rate limit budget: the session, or the connection before login
+    std::string userKey;    // fair-share turn: the user across all their connections
+    std::string role;       // student / teacher / admin, or guest
+};
+
+Requester identifyRequester(const std::string& sessionToken, const std::string& clientInfo) {
+    std::string userId;
+    if (!sessionToken.empty()) {
+        std::lock_guard<std::mutex> lock(sessionsMutex);
+        auto it = sessions.find(sessionToken);
+        if (it != sessions.end() && it->second.expiresAt >= getCurrentTimestamp()) userId = it->second.userId;
+    }
+    if (userId.empty()) return {"conn:" + clientInfo, "conn:" + clientInfo, "guest"};
+
+    EpochGuard guard;
+    const User* user = users.getById(userId);
+    return {sessionToken, userId, user ? roleToString(user->role) : "student"};
+}
+
+// RATE_LIMITED response to a refused request; retryAfterMs is when to try again
+std::string buildRateLimited(const std::string& json, const std::string& messageType, int64_t retryAfterMs,
+                             bool busy) {
+    return R"({"messageType":"RATE_LIMITED","messageId":")" + getJsonValue(json, "messageId") +
+           R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+           R"(,"payload":{"status":"error","message":")" +
+           (busy ? "Server is busy, please try again" : "Too many requests, please slow down") +
+           R"(","requestType":")" + escapeJson(messageType) +
+           R"(","retryAfterMs":)" + std::to_string(retryAfterMs) + R"(}})";
+}
+
+// Narrow one field of a catalog filter to a request value. Empty or "all"
+// leaves it open; false if the value is unknown and so matches nothing.
+template <typename T, typename Parse>
+bool narrowFilter(const std::string& value, std::optional<T>& field, Parse parse) {
+    if (value.empty() || value == "all") return true;
+    T parsed;
+    if (!parse(value, parsed)) return false;
+    field = parsed;
+    return true;
+}
+
+// Page window of a catalog listing from the request's page (from 1) and limit
+struct CatalogPage {
+    size_t page;
+    size_t limit;
+
+    size_t offset() const { return (page - 1) * limit; }
+    size_t totalPages(size_t total) const { return std::max<size_t>(1, (total + limit - 1) / limit); }
+};
+
+CatalogPage parseCatalogPage(const std::string& payload) {
+    int page = std::atoi(getJsonValue(payload, "page").c_str());
+    int limit = std::atoi(getJsonValue(payload, "limit").c_str());
+    return {size_t(std::max(1, page)),
+            limit > 0 ? size_t(std::min(limit, CATALOG_PAGE_MAX_LIMIT)) : size_t(CATALOG_PAGE_DEFAULT_LIMIT)};
+}
+
+// ETag of a listing page: its entries as listed and where the page sits
+template <typename Page>
+uint64_t listingTag(const Page& page, const CatalogPage& window) {
+    uint64_t tag = catalogTag(page.total, catalogTag(window.page, catalogTag(window.limit, catalogTag(""))));
+    for (const Fragments* json : page.fragments) tag = catalogTag(json->listTag, tag);
+    return tag;
+}
+
+// The "version" clients send back as ifVersion
+std::string versionString(uint64_t tag) {
+    char hex[17];
+    snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)tag);
+    return hex;
+}
+
+// Answer to a catalog request whose ifVersion is still current
+std::string notModifiedResponse(const std::string& messageType, const std::string& messageId,
+                                const std::string& version) {
+    return R"({"messageType":")" + messageType + R"(","messageId":")" + messageId +
+           R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+           R"(,"payload":{"status":"not_modified","version":")" + version + R"("}})";
+}
+
 // Xử lý GET_LESSONS_REQUEST
 std::string handleGetLessons(const std::string& json) {
     std::string payload = getJsonObject(json, "payload");
@@ -1596,6 +1273,7 @@ std::string handleGetLessons(const std::string& json) {
     std::string sessionToken = getJsonValue(json, "sessionToken");
     std::string level = getJsonValue(payload, "level");
     std::string topic = getJsonValue(payload, "topic");
+    std::string ifVersion = getJsonValue(payload, "ifVersion");
 
     std::string userId = validateSession(sessionToken);
     if (userId.empty()) {
@@ -1604,46 +1282,215 @@ std::string handleGetLessons(const std::string& json) {
                R"(,"payload":{"status":"error","message":"Invalid or expired session"}})";
     }
 
-    std::stringstream lessonsJson;
-    lessonsJson << "[";
-    bool first = true;
-    int count = 0;
+    std::string lessonsJson = "[";
 
-    for (const auto& pair : lessons) {
-        const Lesson& lesson = pair.second;
+    // Lọc theo level và topic qua index; an unknown value matches no lessons
+    CatalogFilter filter;
+    bool matchable = narrowFilter(level, filter.level, parseLevel) && narrowFilter(topic, filter.topic, parseTopic);
+    CatalogPage window = parseCatalogPage(payload);
 
-        // Lọc theo topic nếu có
-        if (!topic.empty() && lesson.topic != topic) continue;
-        // Lọc theo level nếu có
-        if (!level.empty() && lesson.level != level) continue;
+    EpochGuard guard;
+    ContentCatalog::Lessons::Page page;
+    if (matchable) page = catalog.read().lessons.select(filter, window.offset(), window.limit);
 
-        if (!first) lessonsJson << ",";
-        first = false;
+    // The user's progress, picked from their row by each lesson's slot
+    std::vector<LessonProgress> progress(page.fragments.size());
+    {
+        std::lock_guard<std::mutex> lock(progressMutex);
+        if (const ProgressStore::Row* row = progressStore.row(userId)) {
+            for (size_t i = 0; i < page.fragments.size(); i++) {
+                uint32_t slot = page.fragments[i]->slot;
+                if (slot < row->size()) progress[i] = (*row)[slot];
+            }
+        }
+    }
+    uint64_t tag = listingTag(page, window);
+    for (const LessonProgress& p : progress) tag = catalogTag(p.percent | (p.completed() ? 0x100 : 0), tag);
+    std::string version = versionString(tag);
+    if (ifVersion == version) return notModifiedResponse("GET_LESSONS_RESPONSE", messageId, version);
 
-        lessonsJson << R"({"lessonId":")" << lesson.lessonId
-                    << R"(","title":")" << escapeJson(lesson.title)
-                    << R"(","description":")" << escapeJson(lesson.description)
-                    << R"(","topic":")" << lesson.topic
-                    << R"(","level":")" << lesson.level
-                    << R"(","duration":)" << lesson.duration
-                    << R"(,"completionStatus":false,"progress":0})";
-        count++;
+    for (size_t i = 0; i < page.fragments.size(); i++) {
+        if (i > 0) lessonsJson += ",";
+        lessonsJson += "{";
+        lessonsJson += page.fragments[i]->list;
+        lessonsJson += R"(,"completionStatus":)";
+        lessonsJson += progress[i].completed() ? "true" : "false";
+        lessonsJson += R"(,"progress":)";
+        lessonsJson += std::to_string(progress[i].percent);
+        lessonsJson += "}";
     }
-    lessonsJson << "]";
+    lessonsJson += "]";
 
     return R"({"messageType":"GET_LESSONS_RESPONSE","messageId":")" + messageId +
            R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
            R"(,"payload":{"status":"success","message":"Retrieved lessons successfully","data":{"lessons":)" +
-           lessonsJson.str() + R"(,"pagination":{"currentPage":1,"totalPages":1,"totalLessons":)" +
-           std::to_string(count) + R"(}}}})";
+           lessonsJson + R"(,"pagination":{"currentPage":)" + std::to_string(window.page) +
+           R"(,"totalPages":)" + std::to_string(window.totalPages(page.total)) +
+           R"(,"limit":)" + std::to_string(window.limit) +
+           R"(,"totalLessons":)" + std::to_string(page.total) +
+           R"(},"version":")" + version + R"("}}})";
+}
+
+// Xử lý LESSON_PROGRESS_UPDATE
+// Sent as the learner reads or plays a lesson, possibly several times a
+// second, so it only updates memory; progressFlusher persists it. Progress
+// for unknown lessons is ignored. No response.
+void handleLessonProgressUpdate(const std::string& json) {
+    std::string userId = validateSession(getJsonValue(json, "sessionToken"));
+    if (userId.empty()) return;
+
+    std::string payload = getJsonObject(json, "payload");
+    std::string lessonId = getJsonValue(payload, "lessonId");
+    int percent = std::atoi(getJsonValue(payload, "percent").c_str());
+    long long position = std::atoll(getJsonValue(payload, "position").c_str());
+    {
+        EpochGuard guard;
+        if (!catalog.read().lessons.find(lessonId)) return;
+    }
+
+    std::lock_guard<std::mutex> lock(progressMutex);
+    progressStore.update(userId, lessonId, percent,
+                         static_cast<uint32_t>(std::min<long long>(std::max(position, 0LL), UINT32_MAX)),
+                         getCurrentTimestamp());
+}
+
+// Write changed lesson progress to disk every PROGRESS_FLUSH_MS, one batch
+// and one fdatasync per round; rewrite the log instead once it is mostly
+// superseded records. A batch that fails to write goes back to the store's
+// dirty set and is retried with the next, as its entries stand by then.
+void progressFlusher() {
+    bool failing = false;
+    while (running) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(PROGRESS_FLUSH_MS));
+
+        std::vector<ProgressStore::Change> batch, all;
+        bool compact;
+        {
+            std::lock_guard<std::mutex> lock(progressMutex);
+            batch = progressStore.takeDirty();
+            compact = progressLog->needsCompaction(progressStore.size());
+            if (compact) all = progressStore.snapshot();
+        }
+
+        // A snapshot already holds this batch and anything requeued before
+        bool ok = compact ? progressLog->rewrite(all) : progressLog->append(batch);
+        if (!ok) {
+            std::lock_guard<std::mutex> lock(progressMutex);
+            progressStore.requeue(batch);
+        }
+        if (ok == failing) {
+            failing = !ok;
+            if (failing) {
+                std::cerr << "[ERROR] Lesson progress: cannot write to " << PROGRESS_DIR << "; "
+                          << batch.size() << " lessons waiting, will retry" << std::endl;
+            } else {
+                std::cout << "[INFO] Lesson progress: writing again" << std::endl;
+            }
+        }
+    }
+}
+
+// ============================================================================
+// MEDIA
+// ============================================================================
+
+// Lesson video and audio are served by the HTTP media server at
+// /media/<lessonId>/video and /media/<lessonId>/audio. A lesson names its
+// media by a local path (from whoever authored the pack) or a remote URL;
+// remote URLs are handed to clients unchanged, local ones are looked up by
+// file name as MEDIA_DIR/<lessonId>/<name>, then MEDIA_DIR/<name>.
+
+bool isRemoteMedia(const std::string& source) {
+    return source.compare(0, 7, "http://") == 0 || source.compare(0, 8, "https://") == 0;
+}
+
+std::string percentEncode(const std::string& s) {
+    static const char hex[] = "0123456789ABCDEF";
+    std::string out;
+    for (unsigned char c : s) {
+        if (std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+            out += static_cast<char>(c);
+        } else {
+            out += '%';
+            out += hex[c >> 4];
+            out += hex[c & 15];
+        }
+    }
+    return out;
+}
+
+std::string percentDecode(const std::string& s) {
+    std::string out;
+    for (size_t i = 0; i < s.size(); i++) {
+        if (s[i] == '%' && i + 2 < s.size() && std::isxdigit((unsigned char)s[i + 1]) &&
+            std::isxdigit((unsigned char)s[i + 2])) {
+            out += static_cast<char>(std::stoi(s.substr(i + 1, 2), nullptr, 16));
+            i += 2;
+        } else {
+            out += s[i];
+        }
+    }
+    return out;
+}
+
+// File for a media server request path, or "" if there is none
+std::string resolveMedia(const std::string& path) {
+    const std::string prefix = "/media/";
+    size_t slash = path.rfind('/');
+    if (path.compare(0, prefix.size(), prefix) != 0 || slash < prefix.size()) return "";
+    std::string lessonId = percentDecode(path.substr(prefix.size(), slash - prefix.size()));
+    std::string kind = path.substr(slash + 1);
+
+    std::string source;
+    {
+        EpochGuard guard;
+        const Lesson* lesson = catalog.read().lessons.find(lessonId);
+        if (!lesson) return "";
+        if (kind == "video") source = lesson->videoUrl;
+        else if (kind == "audio") source = lesson->audioUrl;
+    }
+    if (source.empty() || isRemoteMedia(source)) return "";
+
+    // Only the file name is used, so a source cannot reach outside MEDIA_DIR
+    std::string name = source.substr(source.find_last_of("/\\") + 1);
+    if (name.empty() || name == "." || name == "..") return "";
+    bool plainId = lessonId.find_first_of("/\\") == std::string::npos && lessonId != "." && lessonId != "..";
+    std::string own = std::string(MEDIA_DIR) + "/" + lessonId + "/" + name;
+    struct stat st;
+    if (plainId && stat(own.c_str(), &st) == 0) return own;
+    return std::string(MEDIA_DIR) + "/" + name;
+}
+
+// Host a client reached this server at, for URLs it can follow back
+std::string localHost(int clientSocket) {
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    char host[INET_ADDRSTRLEN];
+    if (getsockname(clientSocket, (struct sockaddr*)&addr, &len) != 0 || addr.sin_family != AF_INET ||
+        !inet_ntop(AF_INET, &addr.sin_addr, host, sizeof(host))) {
+        return "127.0.0.1";
+    }
+    return host;
+}
+
+// The lesson's "videoUrl" and "audioUrl" members, starting with a comma
+std::string lessonMediaJson(const Lesson& lesson, const std::string& host) {
+    auto url = [&](const std::string& source, const char* kind) {
+        if (source.empty() || isRemoteMedia(source) || mediaPort == 0) return source;
+        return "http://" + host + ":" + std::to_string(mediaPort) + "/media/" + percentEncode(lesson.lessonId) +
+               "/" + kind;
+    };
+    return R"(,"videoUrl":")" + escapeJson(url(lesson.videoUrl, "video")) +
+           R"(","audioUrl":")" + escapeJson(url(lesson.audioUrl, "audio")) + R"(")";
 }
 
 // Xử lý GET_LESSON_DETAIL_REQUEST
-std::string handleGetLessonDetail(const std::string& json) {
+std::string handleGetLessonDetail(const std::string& json, int clientSocket) {
     std::string payload = getJsonObject(json, "payload");
     std::string messageId = getJsonValue(json, "messageId");
     std::string sessionToken = getJsonValue(json, "sessionToken");
     std::string lessonId = getJsonValue(payload, "lessonId");
+    std::string ifVersion = getJsonValue(payload, "ifVersion");
 
     std::string userId = validateSession(sessionToken);
     if (userId.empty()) {
@@ -1652,107 +1499,356 @@ std::string handleGetLessonDetail(const std::string& json) {
                R"(,"payload":{"status":"error","message":"Invalid or expired session"}})";
     }
 
-    auto it = lessons.find(lessonId);
-    if (it == lessons.end()) {
+    EpochGuard guard;
+    const ContentCatalog& snapshot = catalog.read();
+    const Lesson* found = snapshot.lessons.find(lessonId);
+    if (!found) {
         return R"({"messageType":"GET_LESSON_DETAIL_RESPONSE","messageId":")" + messageId +
                R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
                R"(,"payload":{"status":"error","message":"Lesson not found"}})";
     }
 
-    const Lesson& lesson = it->second;
+    // The text, media and progress are not part of the cached fragment, so
+    // they are hashed here; that is still far cheaper than escaping and
+    // sending them. The text is stored compressed, so it goes in by its
+    // stamp and is only inflated when it is sent.
+    const Fragments& cached = *snapshot.lessons.fragments(*found);
+    std::string media = lessonMediaJson(*found, localHost(clientSocket));
+    LessonProgress progress;
+    {
+        std::lock_guard<std::mutex> lock(progressMutex);
+        const ProgressStore::Row* row = progressStore.row(userId);
+        if (row && cached.slot < row->size()) progress = (*row)[cached.slot];
+    }
+    media += R"(,"progress":)" + std::to_string(progress.percent) +
+             R"(,"position":)" + std::to_string(progress.position) +
+             R"(,"completionStatus":)" + (progress.completed() ? "true" : "false");
+    uint64_t tag = catalogTag(snapshot.lessonTextStamp(*found), cached.detailTag);
+    std::string version = versionString(catalogTag(media, tag));
+    if (ifVersion == version) return notModifiedResponse("GET_LESSON_DETAIL_RESPONSE", messageId, version);
+
+    std::string text = escapeJson(*snapshot.lessonText(*found));
 
-    return R"({"messageType":"GET_LESSON_DETAIL_RESPONSE","messageId":")" + messageId +
-           R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
-           R"(,"payload":{"status":"success","data":{"lessonId":")" + lesson.lessonId +
-           R"(","title":")" + escapeJson(lesson.title) +
-           R"(","description":")" + escapeJson(lesson.description) +
-           R"(","level":")" + lesson.level +
-           R"(","topic":")" + lesson.topic +
-           R"(","duration":)" + std::to_string(lesson.duration) +
-           R"(,"content":")" + escapeJson(lesson.textContent) +
-           R"(","textContent":")" + escapeJson(lesson.textContent) +
-           R"(","videoUrl":")" + escapeJson(lesson.videoUrl) +
-           R"(","audioUrl":")" + escapeJson(lesson.audioUrl) + R"("}}})";
+    std::string response = R"({"messageType":"GET_LESSON_DETAIL_RESPONSE","messageId":")" + messageId +
+                           R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+                           R"(,"payload":{"status":"success","data":{)";
+    response.reserve(response.size() + cached.detail.size() + media.size() + 2 * text.size() + 80);
+    response += cached.detail;
+    response += media;
+    response += R"(,"content":")";
+    response += text;
+    response += R"(","textContent":")";
+    response += text;
+    response += R"(","version":")";
+    response += version;
+    response += R"("}}})";
+    return response;
 }
 
-// Xử lý GET_TEST_REQUEST
-std::string handleGetTest(const std::string& json) {
+// Name of a record kind in SYNC_CATALOG; only these kinds are synced
+const char* syncKindName(CatalogKind kind) {
+    switch (kind) {
+        case CatalogKind::Lesson: return "lesson";
+        case CatalogKind::Exercise: return "exercise";
+        case CatalogKind::Game: return "game";
+        default: return nullptr;
+    }
+}
+
+// A SYNC_CATALOG cursor ("kind:id") back to a record id; false if malformed
+bool parseSyncCursor(const std::string& cursor, CatalogRecordId& out) {
+    size_t colon = cursor.find(':');
+    if (colon == std::string::npos) return false;
+    std::string kind = cursor.substr(0, colon);
+    for (CatalogKind k : {CatalogKind::Lesson, CatalogKind::Exercise, CatalogKind::Game}) {
+        if (kind == syncKindName(k)) {
+            out = {k, cursor.substr(colon + 1)};
+            return true;
+        }
+    }
+    return false;
+}
+
+// Append a SYNC_CATALOG change for one record: the record as it is in
+// snapshot, or a removal if snapshot no longer has it. Media URLs point at
+// host, as in GET_LESSON_DETAIL.
+void appendSyncChange(const ContentCatalog& snapshot, const CatalogRecordId& record, const std::string& host,
+                      std::string& out) {
+    out += R"({"kind":")";
+    out += syncKindName(record.kind);
+    out += R"(","id":")";
+    out += escapeJson(record.id);
+    const Fragments* json = nullptr;
+    const Lesson* lesson = nullptr;
+    if (record.kind == CatalogKind::Lesson) {
+        if ((lesson = snapshot.lessons.find(record.id))) json = snapshot.lessons.fragments(*lesson);
+    } else if (record.kind == CatalogKind::Exercise) {
+        if (const Exercise* found = snapshot.exercises.find(record.id)) json = snapshot.exercises.fragments(*found);
+    } else if (const Game* found = snapshot.games.find(record.id)) {
+        json = snapshot.games.fragments(*found);
+    }
+    if (!json) {
+        out += R"(","op":"remove"})";
+        return;
+    }
+    out += R"(","op":"upsert","data":{)";
+    out += json->detail;
+    if (lesson) {
+        out += lessonMediaJson(*lesson, host);
+        out += R"(,"textContent":")";
+        out += escapeJson(*snapshot.lessonText(*lesson, false));
+        out += R"(")";
+    }
+    out += "}}";
+}
+
+// Xử lý SYNC_CATALOG_REQUEST
+// Brings a client's offline copy of the lessons, exercises and games up to
+// date. With the epoch and seq of its last sync the client gets only the
+// records changed since, from the catalog's change log; otherwise (first
+// sync, server restarted, log no longer reaching back) it gets everything
+// with "full":true and replaces its copy. Either way records come in
+// (kind, id) order, CATALOG_SYNC_CHUNK_BYTES at a time: while "more" is
+// true the client repeats the request with the returned cursor.
+std::string handleSyncCatalog(const std::string& json, int clientSocket) {
     std::string payload = getJsonObject(json, "payload");
     std::string messageId = getJsonValue(json, "messageId");
     std::string sessionToken = getJsonValue(json, "sessionToken");
-    std::string level = getJsonValue(payload, "level");
+    std::string epochStr = getJsonValue(payload, "epoch");
+    uint64_t sinceSeq = std::strtoull(getJsonValue(payload, "sinceSeq").c_str(), nullptr, 10);
+    std::string cursorStr = getJsonValue(payload, "cursor");
 
     std::string userId = validateSession(sessionToken);
     if (userId.empty()) {
-        return R"({"messageType":"GET_TEST_RESPONSE","messageId":")" + messageId +
+        return R"({"messageType":"SYNC_CATALOG_RESPONSE","messageId":")" + messageId +
                R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
                R"(,"payload":{"status":"error","message":"Invalid or expired session"}})";
     }
 
-    // Tìm test phù hợp với level
-    const Test* selectedTest = nullptr;
-    for (const auto& pair : tests) {
-        if (pair.second.level == level) {
-            selectedTest = &pair.second;
-            break;
+    EpochGuard guard;
+    const ContentCatalog& snapshot = catalog.read();
+
+    std::vector<CatalogRecordId> changed;
+    bool full = sinceSeq == 0 || std::atoll(epochStr.c_str()) != catalogEpoch ||
+                !snapshot.changedSince(sinceSeq, changed);
+    CatalogRecordId cursor;
+    bool resume = !cursorStr.empty() && parseSyncCursor(cursorStr, cursor);
+    if (full && sinceSeq != 0) resume = false;   // the client's delta round cannot continue as a full one
+
+    std::string host = localHost(clientSocket);
+    std::string changes = "[";
+    bool more = false;
+    std::string last;
+    auto emit = [&](const CatalogRecordId& record) {
+        if (changes.size() >= CATALOG_SYNC_CHUNK_BYTES) {
+            more = true;
+            return false;
         }
-    }
+        if (changes.size() > 1) changes += ",";
+        appendSyncChange(snapshot, record, host, changes);
+        last = std::string(syncKindName(record.kind)) + ":" + record.id;
+        return true;
+    };
 
-    // Nếu không tìm thấy, lấy test đầu tiên
-    if (!selectedTest && !tests.empty()) {
-        selectedTest = &tests.begin()->second;
+    if (full) {
+        // Every record after the cursor, kind by kind
+        auto walk = [&](CatalogKind kind, const auto& records) {
+            if (more || (resume && kind < cursor.kind)) return;
+            auto it = resume && kind == cursor.kind ? records.upper_bound(cursor.id) : records.begin();
+            for (; it != records.end(); ++it) {
+                if (!emit({kind, it->first})) return;
+            }
+        };
+        walk(CatalogKind::Lesson, snapshot.lessons.all());
+        walk(CatalogKind::Exercise, snapshot.exercises.all());
+        walk(CatalogKind::Game, snapshot.games.all());
+    } else {
+        auto it = resume ? std::upper_bound(changed.begin(), changed.end(), cursor) : changed.begin();
+        for (; it != changed.end(); ++it) {
+            if (syncKindName(it->kind) && !emit(*it)) break;
+        }
     }
+    changes += "]";
 
-    if (!selectedTest) {
-        return R"({"messageType":"GET_TEST_RESPONSE","messageId":")" + messageId +
-               R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
-               R"(,"payload":{"status":"error","message":"No tests available"}})";
+    return R"({"messageType":"SYNC_CATALOG_RESPONSE","messageId":")" + messageId +
+           R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+           R"(,"payload":{"status":"success","data":{"epoch":)" + std::to_string(catalogEpoch) +
+           R"(,"seq":)" + std::to_string(snapshot.version) +
+           R"(,"full":)" + (full ? "true" : "false") +
+           R"(,"changes":)" + changes +
+           R"(,"more":)" + (more ? "true" : "false") +
+           R"(,"cursor":")" + escapeJson(last) + R"("}}})";
+}
+
+// Text of a search result to cut its snippet from: the description if the
+// query matches there, else the record's body
+std::string contentSnippetSource(const ContentCatalog& snapshot, const ContentCatalog::TextHit& hit,
+                                 const std::vector<std::string>& terms) {
+    std::string description, body;
+    if (hit.kind == CatalogKind::Lesson) {
+        if (const Lesson* lesson = snapshot.lessons.find(*hit.id)) {
+            description = lesson->description;
+            body = *snapshot.lessonText(*lesson, false);
+        }
+    } else if (hit.kind == CatalogKind::Exercise) {
+        if (const Exercise* exercise = snapshot.exercises.find(*hit.id)) {
+            description = exercise->description;
+            for (const std::string& prompt : exercise->prompts) body += prompt + "\n";
+        }
+    } else if (const Game* game = snapshot.games.find(*hit.id)) {
+        description = game->description;
+        for (const auto* list : {&game->pairs, &game->sentencePairs}) {
+            for (const auto& pair : *list) body += pair.first + " - " + pair.second + "\n";
+        }
+        for (const auto& pair : game->picturePairs) body += pair.first + "\n";
+    }
+    for (const english_learning::search::Token& token : english_learning::search::tokenize(description)) {
+        if (std::find(terms.begin(), terms.end(), token.term) != terms.end()) return description;
     }
+    return body.empty() ? description : body;
+}
 
-    std::stringstream questionsJson;
-    questionsJson << "[";
-    for (size_t i = 0; i < selectedTest->questions.size(); i++) {
-        const TestQuestion& q = selectedTest->questions[i];
-        if (i > 0) questionsJson << ",";
+// Xử lý SEARCH_CONTENT_REQUEST - tìm kiếm toàn văn trong bài học, bài tập và trò chơi
+// Served from the text indexes of the current catalog version, which are built
+// with the version, so a reload or an admin edit is searchable as soon as it
+// is published.
+std::string handleSearchContent(const std::string& json) {
+    std::string payload = getJsonObject(json, "payload");
+    std::string messageId = getJsonValue(json, "messageId");
+    std::string sessionToken = getJsonValue(json, "sessionToken");
+    std::string queryText = getJsonValue(payload, "query");
+    std::string kind = getJsonValue(payload, "kind");
+    std::string level = getJsonValue(payload, "level");
+    std::string limitStr = getJsonValue(payload, "limit");
 
-        questionsJson << R"({"questionId":")" << q.questionId
-                      << R"(","type":")" << q.type
-                      << R"(","order":)" << (i + 1)
-                      << R"(,"question":")" << escapeJson(q.question)
-                      << R"(","points":)" << q.points;
+    auto error = [&messageId](const std::string& message) {
+        return R"({"messageType":"SEARCH_CONTENT_RESPONSE","messageId":")" + messageId +
+               R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+               R"(,"payload":{"status":"error","message":")" + message + R"("}})";
+    };
 
-        if (!q.options.empty()) {
-            questionsJson << R"(,"options":[)";
-            for (size_t j = 0; j < q.options.size(); j++) {
-                if (j > 0) questionsJson << ",";
-                char optionId = 'a' + j;
-                questionsJson << R"({"id":")" << optionId << R"(","text":")" << escapeJson(q.options[j]) << R"("})";
+    std::string userId = validateSession(sessionToken);
+    if (userId.empty()) return error("Invalid or expired session");
+
+    ContentIndex::Query query = ContentIndex::parse(queryText);
+    if (query.empty()) return error("Query is required");
+
+    std::optional<CatalogKind> kindFilter;
+    if (!kind.empty()) {
+        for (CatalogKind k : {CatalogKind::Lesson, CatalogKind::Exercise, CatalogKind::Game}) {
+            if (kind == syncKindName(k)) kindFilter = k;
+        }
+        if (!kindFilter) return error("Invalid kind");
+    }
+    std::optional<english_learning::core::Level> levelFilter;
+    if (!level.empty()) {
+        english_learning::core::Level parsed;
+        if (!parseLevel(level, parsed)) return error("Invalid level");
+        levelFilter = parsed;
+    }
+
+    int requested = std::atoi(limitStr.c_str());
+    size_t limit = requested > 0 ? std::min(requested, CONTENT_SEARCH_MAX_LIMIT) : CONTENT_SEARCH_DEFAULT_LIMIT;
+
+    EpochGuard guard;
+    const ContentCatalog& snapshot = catalog.read();
+    size_t matchCount = 0;
+    std::vector<ContentCatalog::TextHit> hits = snapshot.searchText(query, kindFilter, levelFilter, limit, matchCount);
+
+    std::vector<std::string> terms = query.terms();
+    std::stringstream resultsJson;
+    resultsJson << "[";
+    for (size_t i = 0; i < hits.size(); ++i) {
+        const ContentCatalog::TextHit& hit = hits[i];
+        std::string title, level, topic;
+        if (hit.kind == CatalogKind::Lesson) {
+            if (const Lesson* lesson = snapshot.lessons.find(*hit.id)) {
+                title = lesson->title;
+                level = levelToString(lesson->level);
+                topic = topicToString(lesson->topic);
             }
-            questionsJson << "]";
+        } else if (hit.kind == CatalogKind::Exercise) {
+            if (const Exercise* exercise = snapshot.exercises.find(*hit.id)) {
+                title = exercise->title;
+                level = levelToString(exercise->level);
+                topic = topicToString(exercise->topic);
+            }
+        } else if (const Game* game = snapshot.games.find(*hit.id)) {
+            title = game->title;
+            level = levelToString(game->level);
+            topic = game->topic;
         }
 
-        if (q.type == "sentence_order" && !q.words.empty()) {
-            questionsJson << R"(,"words":[)";
-            for (size_t j = 0; j < q.words.size(); j++) {
-                if (j > 0) questionsJson << ",";
-                questionsJson << R"(")" << escapeJson(q.words[j]) << R"(")";
-            }
-            questionsJson << "]";
+        std::string source = contentSnippetSource(snapshot, hit, terms);
+        english_learning::search::Snippet snippet =
+            english_learning::search::makeSnippet(source, terms, false, CONTENT_SNIPPET_RADIUS);
+        std::stringstream highlightsJson;
+        highlightsJson << "[";
+        for (size_t h = 0; h < snippet.highlights.size(); ++h) {
+            if (h > 0) highlightsJson << ",";
+            highlightsJson << R"({"offset":)" << snippet.highlights[h].first
+                           << R"(,"length":)" << snippet.highlights[h].second << "}";
         }
-        questionsJson << "}";
+        highlightsJson << "]";
+
+        if (i > 0) resultsJson << ",";
+        resultsJson << R"({"kind":")" << syncKindName(hit.kind)
+                    << R"(","id":")" << escapeJson(*hit.id)
+                    << R"(","title":")" << escapeJson(title)
+                    << R"(","level":")" << level
+                    << R"(","topic":")" << escapeJson(topic)
+                    << R"(","score":)" << std::fixed << std::setprecision(3) << hit.score
+                    << R"(,"snippet":")" << escapeJson(snippet.text)
+                    << R"(","highlights":)" << highlightsJson.str() << "}";
+    }
+    resultsJson << "]";
+
+    return R"({"messageType":"SEARCH_CONTENT_RESPONSE","messageId":")" + messageId +
+           R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+           R"(,"payload":{"status":"success","data":{"results":)" + resultsJson.str() +
+           R"(,"matchCount":)" + std::to_string(matchCount) + R"(}}})";
+}
+
+// Xử lý GET_TEST_REQUEST
+std::string handleGetTest(const std::string& json) {
+    std::string payload = getJsonObject(json, "payload");
+    std::string messageId = getJsonValue(json, "messageId");
+    std::string sessionToken = getJsonValue(json, "sessionToken");
+    std::string level = getJsonValue(payload, "level");
+
+    std::string userId = validateSession(sessionToken);
+    if (userId.empty()) {
+        return R"({"messageType":"GET_TEST_RESPONSE","messageId":")" + messageId +
+               R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+               R"(,"payload":{"status":"error","message":"Invalid or expired session"}})";
+    }
+
+    // Tìm test phù hợp với level
+    EpochGuard guard;
+    const auto& tests = catalog.read().tests;
+    const Test* selectedTest = nullptr;
+    CatalogFilter filter;
+    Level wanted;
+    if (parseLevel(level, wanted)) {
+        filter.level = wanted;
+        auto page = tests.select(filter, 0, 1);
+        if (!page.records.empty()) selectedTest = page.records.front();
+    }
+
+    // Nếu không tìm thấy, lấy test đầu tiên
+    if (!selectedTest && tests.size() > 0) {
+        selectedTest = tests.all().begin()->second.get();
+    }
+
+    if (!selectedTest) {
+        return R"({"messageType":"GET_TEST_RESPONSE","messageId":")" + messageId +
+               R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+               R"(,"payload":{"status":"error","message":"No tests available"}})";
     }
-    questionsJson << "]";
 
     return R"({"messageType":"GET_TEST_RESPONSE","messageId":")" + messageId +
            R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
-           R"(,"payload":{"status":"success","data":{"testId":")" + selectedTest->testId +
-           R"(","testType":")" + selectedTest->testType +
-           R"(","level":")" + selectedTest->level +
-           R"(","topic":")" + selectedTest->topic +
-           R"(","title":")" + escapeJson(selectedTest->title) +
-           R"(","duration":1800,"totalQuestions":)" + std::to_string(selectedTest->questions.size()) +
-           R"(,"passingScore":60,"questions":)" + questionsJson.str() +
-           R"(,"instructions":"Read each question carefully. Answer all questions."}}})";
+           R"(,"payload":{"status":"success","data":{)" + tests.fragments(*selectedTest)->detail + R"(}}})";
 }
 
 // Xử lý SUBMIT_TEST_REQUEST
@@ -1769,14 +1865,15 @@ std::string handleSubmitTest(const std::string& json) {
                R"(,"payload":{"status":"error","message":"Invalid or expired session"}})";
     }
 
-    auto it = tests.find(testId);
-    if (it == tests.end()) {
+    EpochGuard guard;
+    const Test* found = catalog.read().tests.find(testId);
+    if (!found) {
         return R"({"messageType":"SUBMIT_TEST_RESPONSE","messageId":")" + messageId +
                R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
                R"(,"payload":{"status":"error","message":"Test not found"}})";
     }
 
-    const Test& test = it->second;
+    const Test& test = *found;
     std::string answersArray = getJsonArray(json, "answers");
 
     int totalPoints = 0;
@@ -1807,9 +1904,9 @@ std::string handleSubmitTest(const std::string& json) {
         }
 
         bool isCorrect = false;
-        if (q.type == "multiple_choice") {
+        if (q.type == QuestionType::MultipleChoice) {
             isCorrect = (userAnswer == q.correctAnswer);
-        } else if (q.type == "sentence_order") {
+        } else if (q.type == QuestionType::SentenceOrder) {
             // sentence_order: userAnswer is comma-separated word indices or sentence
             // For simplicity, compare the sentence directly (normalized)
             std::string lowerUser = userAnswer;
@@ -1899,10 +1996,43 @@ std::string handleSubmitTest(const std::string& json) {
            R"(","detailedResults":)" + detailedResults.str() + R"(}}})";
 }
 
+// Subscribe to status changes of the contacts in shown; everyone also covers
+// contacts registered later. Pages add to what the subscriber already watches.
+void watchPresence(const std::string& subscriber, const std::vector<std::string>& shown, bool everyone) {
+    std::lock_guard<std::mutex> lock(presenceMutex);
+    if (everyone) {
+        presenceWatchAll.insert(subscriber);
+        return;
+    }
+    for (const std::string& userId : shown) {
+        if (presenceWatchers[userId].insert(subscriber).second) {
+            presenceWatching[subscriber].push_back(userId);
+        }
+    }
+}
+
+// Drop every presence subscription of subscriber; caller holds presenceMutex
+void unwatchPresence(const std::string& subscriber) {
+    presenceWatchAll.erase(subscriber);
+    auto it = presenceWatching.find(subscriber);
+    if (it == presenceWatching.end()) return;
+    for (const std::string& userId : it->second) {
+        auto watchers = presenceWatchers.find(userId);
+        if (watchers == presenceWatchers.end()) continue;
+        watchers->second.erase(subscriber);
+        if (watchers->second.empty()) presenceWatchers.erase(watchers);
+    }
+    presenceWatching.erase(it);
+}
+
 // Xử lý GET_CONTACT_LIST_REQUEST
 std::string handleGetContactList(const std::string& json) {
+    std::string payload = getJsonObject(json, "payload");
     std::string messageId = getJsonValue(json, "messageId");
     std::string sessionToken = getJsonValue(json, "sessionToken");
+    std::string offsetStr = getJsonValue(payload, "offset");
+    std::string limitStr = getJsonValue(payload, "limit");
+    bool onlineOnly = getJsonValue(payload, "onlineOnly") == "true";
 
     std::string currentUserId = validateSession(sessionToken);
     if (currentUserId.empty()) {
@@ -1911,36 +2041,114 @@ std::string handleGetContactList(const std::string& json) {
                R"(,"payload":{"status":"error","message":"Invalid or expired session"}})";
     }
 
+    // Missing offset/limit returns the whole list, as older clients expect
+    size_t offset = static_cast<size_t>(std::max(0, std::atoi(offsetStr.c_str())));
+    size_t limit = static_cast<size_t>(std::max(0, std::atoi(limitStr.c_str())));
+
     std::stringstream contactsJson;
     contactsJson << "[";
     bool first = true;
-    int onlineCount = 0;
+    bool hasMore = false;
+    std::vector<std::string> shown;
+    size_t onlineCount = users.presence().onlineCount();
+    size_t totalContacts = users.presence().totalCount();
 
     {
-        std::lock_guard<std::mutex> lock(usersMutex);
-        for (const auto& pair : users) {
-            const User& user = pair.second;
-            if (user.userId == currentUserId) continue;
+        EpochGuard guard;
+        UserHandle self = users.findById(currentUserId);
+        if (const User* me = users.get(self)) {
+            totalContacts--;
+            if (me->online) onlineCount--;
+        }
+
+        // Fetch one extra entry to learn whether another page follows
+        std::vector<UserHandle> page = users.presence().page(
+            offset, limit > 0 ? limit + 1 : 0, self, onlineOnly);
+        if (limit > 0 && page.size() > limit) {
+            page.pop_back();
+            hasMore = true;
+        }
+
+        for (UserHandle handle : page) {
+            const User* user = users.get(handle);
+            if (!user) continue;  // erased since the page was taken
+            shown.push_back(user->userId);
 
             if (!first) contactsJson << ",";
             first = false;
 
-            contactsJson << R"({"userId":")" << user.userId
-                         << R"(","fullName":")" << escapeJson(user.fullname)
-                         << R"(","role":")" << user.role
-                         << R"(","status":")" << (user.online ? "online" : "offline")
-                         << R"(","level":")" << user.level << R"("})";
-
-            if (user.online) onlineCount++;
+            contactsJson << R"({"userId":")" << user->userId
+                         << R"(","fullName":")" << escapeJson(user->fullname)
+                         << R"(","role":")" << roleToString(user->role)
+                         << R"(","status":")" << (user->online ? "online" : "offline")
+                         << R"(","level":")" << levelToString(user->level) << R"("})";
         }
     }
     contactsJson << "]";
 
+    // The caller now wants to hear about status changes of these contacts
+    watchPresence(currentUserId, shown, offset == 0 && limit == 0 && !onlineOnly);
+
     return R"({"messageType":"GET_CONTACT_LIST_RESPONSE","messageId":")" + messageId +
            R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
            R"(,"payload":{"status":"success","data":{"contacts":)" + contactsJson.str() +
            R"(,"onlineCount":)" + std::to_string(onlineCount) +
-           R"(,"totalContacts":)" + std::to_string(users.size() - 1) + R"(}}})";
+           R"(,"totalContacts":)" + std::to_string(totalContacts) +
+           R"(,"offset":)" + std::to_string(offset) +
+           R"(,"hasMore":)" + (hasMore ? "true" : "false") + R"(}}})";
+}
+
+// Xử lý SEARCH_CONTACTS_REQUEST
+std::string handleSearchContacts(const std::string& json) {
+    std::string payload = getJsonObject(json, "payload");
+    std::string messageId = getJsonValue(json, "messageId");
+    std::string sessionToken = getJsonValue(json, "sessionToken");
+    std::string query = getJsonValue(payload, "query");
+    std::string limitStr = getJsonValue(payload, "limit");
+
+    std::string currentUserId = validateSession(sessionToken);
+    if (currentUserId.empty()) {
+        return R"({"messageType":"SEARCH_CONTACTS_RESPONSE","messageId":")" + messageId +
+               R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+               R"(,"payload":{"status":"error","message":"Invalid or expired session"}})";
+    }
+
+    if (query.empty()) {
+        return R"({"messageType":"SEARCH_CONTACTS_RESPONSE","messageId":")" + messageId +
+               R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+               R"(,"payload":{"status":"error","message":"Search query is required"}})";
+    }
+
+    int limit = limitStr.empty() ? SEARCH_DEFAULT_LIMIT : std::atoi(limitStr.c_str());
+    limit = std::max(1, std::min(limit, SEARCH_MAX_LIMIT));
+
+    std::stringstream contactsJson;
+    contactsJson << "[";
+    size_t count = 0;
+
+    {
+        EpochGuard guard;
+        UserHandle self = users.findById(currentUserId);
+        for (UserHandle handle : users.contacts().search(query, limit, self)) {
+            const User* user = users.get(handle);
+            if (!user) continue;
+
+            if (count++ > 0) contactsJson << ",";
+            contactsJson << R"({"userId":")" << user->userId
+                         << R"(","fullName":")" << escapeJson(user->fullname)
+                         << R"(","email":")" << escapeJson(user->email)
+                         << R"(","role":")" << roleToString(user->role)
+                         << R"(","status":")" << (user->online ? "online" : "offline")
+                         << R"(","level":")" << levelToString(user->level) << R"("})";
+        }
+    }
+    contactsJson << "]";
+
+    return R"({"messageType":"SEARCH_CONTACTS_RESPONSE","messageId":")" + messageId +
+           R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+           R"(,"payload":{"status":"success","data":{"query":")" + escapeJson(query) +
+           R"(","contacts":)" + contactsJson.str() +
+           R"(,"count":)" + std::to_string(count) + R"(}}})";
 }
 
 // Xử lý SEND_MESSAGE_REQUEST
@@ -1958,17 +2166,13 @@ std::string handleSendMessage(const std::string& json, int senderSocket) {
                R"(,"payload":{"status":"error","message":"Invalid or expired session"}})";
     }
 
-    User* recipient = nullptr;
+    UserHandle recipient;
     std::string senderName;
     {
-        std::lock_guard<std::mutex> lock(usersMutex);
-        auto it = userById.find(recipientId);
-        if (it != userById.end()) {
-            recipient = it->second;
-        }
-        auto senderIt = userById.find(senderId);
-        if (senderIt != userById.end()) {
-            senderName = senderIt->second->fullname;
+        EpochGuard guard;
+        recipient = users.findById(recipientId);
+        if (const User* sender = users.getById(senderId)) {
+            senderName = sender->fullname;
         }
     }
 
@@ -1979,6 +2183,12 @@ std::string handleSendMessage(const std::string& json, int senderSocket) {
     }
 
     ChatMessage msg;
+    std::string attachmentError = parseAttachments(payload, msg.attachments);
+    if (!attachmentError.empty()) {
+        return R"({"messageType":"SEND_MESSAGE_RESPONSE","messageId":")" + messageId +
+               R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+               R"(,"payload":{"status":"error","message":")" + escapeJson(attachmentError) + R"("}})";
+    }
     msg.messageId = generateId("chatmsg");
     msg.senderId = senderId;
     msg.recipientId = recipientId;
@@ -1988,24 +2198,37 @@ std::string handleSendMessage(const std::string& json, int senderSocket) {
 
     {
         std::lock_guard<std::mutex> lock(chatMutex);
-        chatMessages.push_back(msg);
+        // Ids are short random numbers; draw again on the rare collision
+        while (!chatStore.append(msg)) {
+            msg.messageId = generateId("chatmsg");
+        }
+    }
+    clearTyping(ChatStore::conversationKey(senderId, recipientId), senderId);
+    // Acknowledge only once the message is on disk (at most one group commit);
+    // one that could not be saved is withdrawn so the client can send it again
+    if (!chatLog->waitDurable()) {
+        {
+            std::lock_guard<std::mutex> lock(chatMutex);
+            chatStore.remove(msg.messageId);
+        }
+        return R"({"messageType":"SEND_MESSAGE_RESPONSE","messageId":")" + messageId +
+               R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+               R"(,"payload":{"status":"error","message":"Message could not be saved, please try again"}})";
     }
+    queueForIndex(msg, ChatIndex::Scope::Direct);
 
+    // Queue in the recipient's inbox; it stays there until acknowledged, so a
+    // push lost with the connection is replayed when the client resumes
     bool delivered = false;
-    if (recipient->online && recipient->clientSocket > 0) {
-        std::string notification = R"({"messageType":"RECEIVE_MESSAGE","messageId":")" + msg.messageId +
-                                   R"(","timestamp":)" + std::to_string(msg.timestamp) +
-                                   R"(,"payload":{"messageId":")" + msg.messageId +
-                                   R"(","senderId":")" + senderId +
-                                   R"(","senderName":")" + escapeJson(senderName) +
-                                   R"(","messageContent":")" + escapeJson(messageContent) +
-                                   R"(","sentAt":)" + std::to_string(msg.timestamp) + R"(}})";
-
-        uint32_t len = htonl(notification.length());
-        if (send(recipient->clientSocket, &len, sizeof(len), 0) > 0) {
-            if (send(recipient->clientSocket, notification.c_str(), notification.length(), 0) > 0) {
+    {
+        std::lock_guard<std::mutex> lock(inboxMutex);
+        uint64_t seq = inbox.push(recipientId, msg.messageId);
+        int recipientSocket = inbox.socketFor(recipientId);
+        if (recipientSocket >= 0) {
+            std::string notification = buildReceiveMessage(msg, senderName, seq);
+            if (pushFrame(recipientSocket, makeFrame(notification))) {
                 delivered = true;
-                logMessage("SEND", "Client:" + std::to_string(recipient->clientSocket), notification);
+                logMessage("SEND", "Client:" + std::to_string(recipientSocket), notification);
             }
         }
     }
@@ -2016,7 +2239,84 @@ std::string handleSendMessage(const std::string& json, int senderSocket) {
            R"(","recipientId":")" + recipientId +
            R"(","messageContent":")" + escapeJson(messageContent) +
            R"(","sentAt":)" + std::to_string(msg.timestamp) +
-           R"(,"delivered":)" + (delivered ? "true" : "false") + R"(}}})";
+           R"(,"delivered":)" + (delivered ? "true" : "false") +
+           attachmentsField(msg.attachments) + R"(}}})";
+}
+
+// Xử lý INBOX_ACK - client xác nhận đã nhận các tin nhắn tới seq (không có response)
+void handleInboxAck(const std::string& json) {
+    std::string userId = validateSession(getJsonValue(json, "sessionToken"));
+    if (userId.empty()) return;
+
+    std::string payload = getJsonObject(json, "payload");
+    uint64_t seq = std::strtoull(getJsonValue(payload, "seq").c_str(), nullptr, 10);
+
+    std::lock_guard<std::mutex> lock(inboxMutex);
+    inbox.ack(userId, seq);
+}
+
+// Xử lý TYPING - user đang gõ / ngừng gõ trong một cuộc trò chuyện (không có response)
+// Repeats and bursts are dropped here; what remains is coalesced per conversation
+void handleTyping(const std::string& json) {
+    std::string userId = validateSession(getJsonValue(json, "sessionToken"));
+    if (userId.empty()) return;
+
+    std::string payload = getJsonObject(json, "payload");
+    std::string peerId = getJsonValue(payload, "peerId");
+    bool typing = getJsonValue(payload, "state") != "stopped";
+
+    // A peer is either a channel the user belongs to or another user
+    std::shared_ptr<const std::vector<std::string>> recipients;
+    std::string conversationId;
+    bool channel = false;
+    {
+        std::lock_guard<std::mutex> lock(channelMutex);
+        if (channels.find(peerId)) {
+            if (!channels.isMember(peerId, userId)) return;
+            recipients = channels.members(peerId);
+            conversationId = peerId;
+            channel = true;
+        }
+    }
+
+    std::string userName;
+    {
+        EpochGuard guard;
+        if (!channel) {
+            if (peerId == userId || !users.findById(peerId)) return;
+            recipients = std::make_shared<const std::vector<std::string>>(1, peerId);
+            conversationId = ChatStore::conversationKey(userId, peerId);
+        }
+        if (const User* user = users.getById(userId)) userName = user->fullname;
+    }
+
+    std::string key = typingKey(conversationId, userId);
+    int64_t now = getCurrentTimestamp();
+    {
+        std::lock_guard<std::mutex> lock(signalsMutex);
+        TypingState& state = typingStates[key];
+        if (typing == state.typing && (!typing || now - state.sentAt < TYPING_REFRESH_MS)) return;
+
+        RateBucket& bucket = typingRates[userId];
+        bucket.tokens = std::min<double>(TYPING_RATE_PER_SEC,
+                                         bucket.tokens + (now - bucket.refilledAt) * TYPING_RATE_PER_SEC / 1000.0);
+        bucket.refilledAt = now;
+        if (bucket.tokens < 1.0) return;
+        bucket.tokens -= 1.0;
+
+        state.typing = typing;
+        state.sentAt = now;
+        // The recipient sees the conversation as the channel, or as this user
+        pendingSignals[key] = PendingSignal{recipients, userId,
+            R"({"messageType":"TYPING","timestamp":)" + std::to_string(now) +
+            R"(,"payload":{"conversationType":")" + (channel ? "channel" : "direct") +
+            R"(","conversationId":")" + (channel ? peerId : userId) +
+            R"(","userId":")" + userId +
+            R"(","userName":")" + escapeJson(userName) +
+            R"(","state":")" + (typing ? "typing" : "stopped") +
+            R"(","ttlMs":)" + std::to_string(TYPING_TTL_MS) + R"(}})"};
+    }
+    signalsCv.notify_one();
 }
 
 // Xử lý MARK_MESSAGES_READ_REQUEST - đánh dấu tin nhắn đã đọc
@@ -2033,60 +2333,689 @@ std::string handleMarkMessagesRead(const std::string& json) {
                R"(,"payload":{"status":"error","message":"Invalid or expired session"}})";
     }
 
-    int markedCount = 0;
+    size_t markedCount = 0;
+    std::string lastMessageId;
     {
         std::lock_guard<std::mutex> lock(chatMutex);
-        for (auto& msg : chatMessages) {
-            if (msg.recipientId == userId && msg.senderId == senderId && !msg.read) {
-                msg.read = true;
-                markedCount++;
+        markedCount = chatStore.markConversationAsRead(userId, senderId);
+        if (markedCount > 0) {
+            const std::vector<ChatMessage>& conversation = chatStore.conversation(userId, senderId);
+            for (auto it = conversation.rbegin(); it != conversation.rend(); ++it) {
+                if (it->senderId == senderId) {
+                    lastMessageId = it->messageId;
+                    break;
+                }
             }
         }
     }
 
+    // Tell the sender; a newer receipt for the same conversation replaces a waiting one
+    if (markedCount > 0) {
+        std::string readerName;
+        {
+            EpochGuard guard;
+            if (const User* reader = users.getById(userId)) readerName = reader->fullname;
+        }
+        queueSignal("read|" + ChatStore::conversationKey(userId, senderId) + "|" + userId,
+                    std::make_shared<const std::vector<std::string>>(1, senderId), "",
+                    R"({"messageType":"READ_RECEIPT","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+                    R"(,"payload":{"conversationId":")" + userId +
+                    R"(","readerId":")" + userId +
+                    R"(","readerName":")" + escapeJson(readerName) +
+                    R"(","lastMessageId":")" + lastMessageId +
+                    R"(","readAt":)" + std::to_string(getCurrentTimestamp()) + R"(}})");
+    }
+
     return R"({"messageType":"MARK_MESSAGES_READ_RESPONSE","messageId":")" + messageId +
            R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
-           R"(,"payload":{"status":"success","data":{"markedCount":)" + std::to_string(markedCount) + R"(}}})";
+           R"(,"payload":{"status":"success","data":{"markedCount":)" + std::to_string(markedCount) + R"(}}})";
+}
+
+// History cursors are "<messageId>@<timestamp>": the timestamp locates an
+// archived message's block without scanning the archive for its id
+std::string historyCursor(const ChatMessage& msg) {
+    return msg.messageId + "@" + std::to_string(msg.timestamp);
+}
+
+// Split a cursor into its message id and timestamp (0 if it has none)
+void parseHistoryCursor(const std::string& cursor, std::string& id, int64_t& timestamp) {
+    size_t at = cursor.rfind('@');
+    id = cursor.substr(0, at);
+    timestamp = at == std::string::npos ? 0 : std::atoll(cursor.c_str() + at + 1);
+}
+
+// Xử lý GET_CHAT_HISTORY_REQUEST
+std::string handleGetChatHistory(const std::string& json) {
+    std::string payload = getJsonObject(json, "payload");
+    std::string messageId = getJsonValue(json, "messageId");
+    std::string sessionToken = getJsonValue(json, "sessionToken");
+    std::string recipientId = getJsonValue(payload, "recipientId");
+    std::string before = getJsonValue(payload, "before");
+    std::string beforeTimestampStr = getJsonValue(payload, "beforeTimestamp");
+    std::string limitStr = getJsonValue(payload, "limit");
+
+    std::string userId = validateSession(sessionToken);
+    if (userId.empty()) {
+        return R"({"messageType":"GET_CHAT_HISTORY_RESPONSE","messageId":")" + messageId +
+               R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+               R"(,"payload":{"status":"error","message":"Invalid or expired session"}})";
+    }
+
+    // Newest page first; the client pages backwards with the returned cursor
+    int requested = std::atoi(limitStr.c_str());
+    size_t limit = requested > 0 ? std::min(requested, CHAT_HISTORY_MAX_LIMIT) : CHAT_HISTORY_DEFAULT_LIMIT;
+    int64_t beforeTimestamp = std::max<int64_t>(0, std::atoll(beforeTimestampStr.c_str()));
+
+    // Fetch one extra message to learn whether an older page exists
+    std::vector<ChatMessage> page;
+    std::string conversationKey = ChatStore::conversationKey(userId, recipientId);
+    std::string cursorId;
+    int64_t cursorTimestamp = 0;
+    parseHistoryCursor(before, cursorId, cursorTimestamp);
+    bool cursorInArchive = false;
+    bool foreignCursor = false;
+    {
+        std::lock_guard<std::mutex> lock(chatMutex);
+        const ChatMessage* cursor = cursorId.empty() ? nullptr : chatStore.findById(cursorId);
+        cursorInArchive = !cursorId.empty() && !cursor;
+        foreignCursor = cursor && ChatStore::conversationKey(cursor->senderId, cursor->recipientId) != conversationKey;
+        if (!cursorInArchive) page = chatStore.history(userId, recipientId, cursorId, beforeTimestamp, limit + 1);
+    }
+
+    // Archived messages are all older than the hot ones: a short page
+    // continues with the newest archived messages before the cursor. A
+    // cursor that is in neither tier yields an empty page.
+    if (page.size() < limit + 1 && !foreignCursor && !(cursorInArchive && cursorTimestamp <= 0)) {
+        std::vector<ChatMessage> older = coldStore->history(conversationKey,
+                                                            cursorInArchive ? cursorId : "",
+                                                            cursorInArchive ? cursorTimestamp
+                                                                            : (before.empty() ? beforeTimestamp : 0),
+                                                            limit + 1 - page.size());
+        if (!older.empty()) {
+            // Messages archived moments ago may not have left the hot store yet
+            std::lock_guard<std::mutex> lock(chatMutex);
+            older.erase(std::remove_if(older.begin(), older.end(),
+                                       [](const ChatMessage& m) { return chatStore.findById(m.messageId); }),
+                        older.end());
+        }
+        page.insert(page.begin(), older.begin(), older.end());
+    }
+    bool hasMore = page.size() > limit;
+    if (hasMore) page.erase(page.begin());
+
+    std::stringstream messagesJson;
+    messagesJson << "[";
+    bool first = true;
+    for (const auto& msg : page) {
+        if (!first) messagesJson << ",";
+        first = false;
+
+        messagesJson << R"({"messageId":")" << msg.messageId
+                     << R"(","senderId":")" << msg.senderId
+                     << R"(","content":")" << escapeJson(msg.content)
+                     << R"(","timestamp":)" << msg.timestamp
+                     << attachmentsField(msg.attachments) << "}";
+    }
+    messagesJson << "]";
+
+    std::string nextCursor = hasMore ? historyCursor(page.front()) : "";
+
+    return R"({"messageType":"GET_CHAT_HISTORY_RESPONSE","messageId":")" + messageId +
+           R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+           R"(,"payload":{"status":"success","data":{"messages":)" + messagesJson.str() +
+           R"(,"hasMore":)" + (hasMore ? "true" : "false") +
+           R"(,"nextCursor":")" + nextCursor + R"("}}})";
+}
+
+// Xử lý START_UPLOAD_REQUEST - bắt đầu (hoặc tiếp tục) tải lên một tệp đính kèm.
+// The client names the file by its SHA-256; content already stored completes
+// at once, so a file shared by many students is uploaded and kept only once.
+std::string handleStartUpload(const std::string& json) {
+    std::string payload = getJsonObject(json, "payload");
+    std::string messageId = getJsonValue(json, "messageId");
+    std::string sessionToken = getJsonValue(json, "sessionToken");
+    std::string attachmentId = getJsonValue(payload, "attachmentId");
+    uint64_t size = std::strtoull(getJsonValue(payload, "size").c_str(), nullptr, 10);
+
+    auto error = [&](const std::string& message) {
+        return R"({"messageType":"START_UPLOAD_RESPONSE","messageId":")" + messageId +
+               R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+               R"(,"payload":{"status":"error","message":")" + escapeJson(message) + R"("}})";
+    };
+
+    std::string userId = validateSession(sessionToken);
+    if (userId.empty()) return error("Invalid or expired session");
+    std::transform(attachmentId.begin(), attachmentId.end(), attachmentId.begin(), ::tolower);
+    if (!english_learning::storage::AttachmentStore::isValidId(attachmentId)) {
+        return error("attachmentId must be the file's SHA-256 in hex");
+    }
+    if (size == 0) return error("File is empty");
+
+    using Status = english_learning::storage::AttachmentStore::Status;
+    auto progress = attachmentStore->begin(userId, attachmentId, size);
+    switch (progress.status) {
+        case Status::Ok:
+        case Status::Complete:
+            break;
+        case Status::TooLarge:
+            return error("File is larger than " + std::to_string(ATTACHMENT_MAX_BYTES / (1024 * 1024)) + " MB");
+        case Status::Busy:
+            return error("Too many uploads in progress");
+        default:
+            return error("Upload could not be started");
+    }
+    bool complete = progress.status == Status::Complete;
+
+    return R"({"messageType":"START_UPLOAD_RESPONSE","messageId":")" + messageId +
+           R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+           R"(,"payload":{"status":"success","data":{"attachmentId":")" + attachmentId +
+           R"(","complete":)" + (complete ? "true" : "false") +
+           R"(,"uploadId":")" + progress.uploadId +
+           R"(","offset":)" + std::to_string(progress.received) +
+           R"(,"chunkSize":)" + std::to_string(ATTACHMENT_CHUNK_BYTES) + R"(}}})";
+}
+
+// Xử lý UPLOAD_CHUNK_REQUEST - nhận một đoạn dữ liệu (base64) của tệp đang tải lên.
+// Each chunk is its own request, so other requests interleave freely
+std::string handleUploadChunk(const std::string& json) {
+    std::string payload = getJsonObject(json, "payload");
+    std::string messageId = getJsonValue(json, "messageId");
+    std::string sessionToken = getJsonValue(json, "sessionToken");
+    std::string uploadId = getJsonValue(payload, "uploadId");
+    uint64_t offset = std::strtoull(getJsonValue(payload, "offset").c_str(), nullptr, 10);
+
+    auto error = [&](const std::string& message, uint64_t expected) {
+        return R"({"messageType":"UPLOAD_CHUNK_RESPONSE","messageId":")" + messageId +
+               R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+               R"(,"payload":{"status":"error","message":")" + escapeJson(message) +
+               R"(","offset":)" + std::to_string(expected) + R"(}})";
+    };
+
+    std::string userId = validateSession(sessionToken);
+    if (userId.empty()) return error("Invalid or expired session", 0);
+
+    std::string bytes;
+    if (!base64Decode(getJsonValue(payload, "data"), bytes)) return error("Chunk data is not valid base64", offset);
+    if (bytes.empty() || bytes.size() > ATTACHMENT_CHUNK_BYTES) {
+        return error("Chunk must be 1 to " + std::to_string(ATTACHMENT_CHUNK_BYTES) + " bytes", offset);
+    }
+
+    using Status = english_learning::storage::AttachmentStore::Status;
+    auto progress = attachmentStore->write(userId, uploadId, offset, bytes);
+    switch (progress.status) {
+        case Status::Ok:
+        case Status::Complete:
+            break;
+        case Status::NotFound:
+            return error("Upload not found", 0);
+        case Status::BadOffset:
+            return error("Expected the chunk at offset " + std::to_string(progress.received), progress.received);
+        case Status::TooLarge:
+            return error("Chunk goes past the declared size", progress.received);
+        case Status::HashMismatch:
+            return error("File does not match its attachmentId", 0);
+        default:
+            return error("Chunk could not be stored", progress.received);
+    }
+
+    return R"({"messageType":"UPLOAD_CHUNK_RESPONSE","messageId":")" + messageId +
+           R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+           R"(,"payload":{"status":"success","data":{"uploadId":")" + uploadId +
+           R"(","offset":)" + std::to_string(progress.received) +
+           R"(,"complete":)" + (progress.status == Status::Complete ? "true" : "false") + R"(}}})";
+}
+
+// Xử lý GET_ATTACHMENT_REQUEST - đọc một đoạn của tệp đính kèm (tải theo từng phần)
+std::string handleGetAttachment(const std::string& json) {
+    std::string payload = getJsonObject(json, "payload");
+    std::string messageId = getJsonValue(json, "messageId");
+    std::string sessionToken = getJsonValue(json, "sessionToken");
+    std::string attachmentId = getJsonValue(payload, "attachmentId");
+    uint64_t offset = std::strtoull(getJsonValue(payload, "offset").c_str(), nullptr, 10);
+    long long requested = std::atoll(getJsonValue(payload, "length").c_str());
+    size_t length = requested > 0 ? std::min<size_t>(requested, ATTACHMENT_CHUNK_BYTES) : ATTACHMENT_CHUNK_BYTES;
+
+    std::string userId = validateSession(sessionToken);
+    if (userId.empty()) {
+        return R"({"messageType":"GET_ATTACHMENT_RESPONSE","messageId":")" + messageId +
+               R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+               R"(,"payload":{"status":"error","message":"Invalid or expired session"}})";
+    }
+
+    auto size = attachmentStore->size(attachmentId);
+    std::string bytes;
+    if (!size || !attachmentStore->read(attachmentId, offset, length, bytes)) {
+        return R"({"messageType":"GET_ATTACHMENT_RESPONSE","messageId":")" + messageId +
+               R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+               R"(,"payload":{"status":"error","message":"Attachment not found"}})";
+    }
+
+    return R"({"messageType":"GET_ATTACHMENT_RESPONSE","messageId":")" + messageId +
+           R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+           R"(,"payload":{"status":"success","data":{"attachmentId":")" + attachmentId +
+           R"(","offset":)" + std::to_string(offset) +
+           R"(,"size":)" + std::to_string(*size) +
+           R"(,"data":")" + base64Encode(bytes) +
+           R"(","eof":)" + (offset + bytes.size() >= *size ? "true" : "false") + R"(}}})";
+}
+
+// Xử lý SEARCH_CHAT_REQUEST - tìm kiếm toàn văn trong các cuộc trò chuyện của user
+std::string handleSearchChat(const std::string& json) {
+    std::string payload = getJsonObject(json, "payload");
+    std::string messageId = getJsonValue(json, "messageId");
+    std::string sessionToken = getJsonValue(json, "sessionToken");
+    std::string query = getJsonValue(payload, "query");
+    std::string peerId = getJsonValue(payload, "peerId");
+    std::string limitStr = getJsonValue(payload, "limit");
+
+    std::string userId = validateSession(sessionToken);
+    if (userId.empty()) {
+        return R"({"messageType":"SEARCH_CHAT_RESPONSE","messageId":")" + messageId +
+               R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+               R"(,"payload":{"status":"error","message":"Invalid or expired session"}})";
+    }
+
+    // Every word must match; the last one also matches as a prefix unless the
+    // query ends in a space or punctuation (search-as-you-type)
+    std::vector<english_learning::search::Token> words = english_learning::search::tokenize(query);
+    std::vector<std::string> terms;
+    for (const auto& word : words) {
+        if (std::find(terms.begin(), terms.end(), word.term) == terms.end()) terms.push_back(word.term);
+    }
+    if (terms.empty()) {
+        return R"({"messageType":"SEARCH_CHAT_RESPONSE","messageId":")" + messageId +
+               R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+               R"(,"payload":{"status":"error","message":"Query is required"}})";
+    }
+    bool prefixLast = words.back().end == query.size() && words.back().term == terms.back();
+
+    int requested = std::atoi(limitStr.c_str());
+    size_t limit = requested > 0 ? std::min(requested, CHAT_SEARCH_MAX_LIMIT) : CHAT_SEARCH_DEFAULT_LIMIT;
+
+    std::unordered_map<std::string, std::string> channelNames;  // channels the user can search
+    std::unordered_set<std::string> channelIds;
+    {
+        std::lock_guard<std::mutex> lock(channelMutex);
+        for (const Channel* channel : channels.channelsFor(userId)) {
+            channelNames[channel->channelId] = channel->name;
+            channelIds.insert(channel->channelId);
+        }
+    }
+
+    struct Result {
+        ChatIndex::Doc doc;
+        double score;
+        std::string content;
+    };
+    std::vector<Result> candidates;
+    size_t matchCount = 0;
+    {
+        // Copy the best hits out; they are resolved below, without this lock
+        std::lock_guard<std::mutex> lock(chatIndexMutex);
+        for (const ChatIndex::Hit& hit : chatIndex.search(terms, prefixLast, userId, channelIds)) {
+            const ChatIndex::Doc& doc = chatIndex.doc(hit.doc);
+            if (!peerId.empty() && doc.targetId != peerId &&
+                !(doc.scope == ChatIndex::Scope::Direct && doc.senderId == peerId)) {
+                continue;
+            }
+            matchCount++;
+            if (candidates.size() < limit) candidates.push_back(Result{doc, hit.score, ""});
+        }
+    }
+
+    // Resolve against the stores: content lives there, and the message may
+    // have been removed or archived since it was found
+    std::vector<bool> resolved(candidates.size(), false);
+    {
+        std::lock_guard<std::mutex> lock(chatMutex);
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            if (candidates[i].doc.scope != ChatIndex::Scope::Direct) continue;
+            if (const ChatMessage* msg = chatStore.findById(candidates[i].doc.messageId)) {
+                candidates[i].content = msg->content;
+                resolved[i] = true;
+            }
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(channelMutex);
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            const ChatIndex::Doc& doc = candidates[i].doc;
+            if (doc.scope != ChatIndex::Scope::Channel) continue;
+            if (const ChatMessage* msg = channels.findMessage(doc.targetId, doc.messageId)) {
+                candidates[i].content = msg->content;
+                resolved[i] = true;
+            }
+        }
+    }
+    std::vector<Result> results;
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        if (resolved[i]) results.push_back(std::move(candidates[i]));
+    }
+
+    std::stringstream resultsJson;
+    resultsJson << "[";
+    EpochGuard guard;
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& result = results[i];
+        bool channel = result.doc.scope == ChatIndex::Scope::Channel;
+        std::string conversationId = channel || result.doc.senderId == userId ? result.doc.targetId
+                                                                              : result.doc.senderId;
+
+        std::string conversationName;
+        if (channel) {
+            conversationName = channelNames[conversationId];
+        } else if (const User* peer = users.getById(conversationId)) {
+            conversationName = peer->fullname;
+        }
+        const User* sender = users.getById(result.doc.senderId);
+
+        english_learning::search::Snippet snippet =
+            english_learning::search::makeSnippet(result.content, terms, prefixLast, CHAT_SNIPPET_RADIUS);
+        std::stringstream highlightsJson;
+        highlightsJson << "[";
+        for (size_t h = 0; h < snippet.highlights.size(); ++h) {
+            if (h > 0) highlightsJson << ",";
+            highlightsJson << R"({"offset":)" << snippet.highlights[h].first
+                           << R"(,"length":)" << snippet.highlights[h].second << "}";
+        }
+        highlightsJson << "]";
+
+        if (i > 0) resultsJson << ",";
+        resultsJson << R"({"messageId":")" << result.doc.messageId
+                    << R"(","conversationType":")" << (channel ? "channel" : "direct")
+                    << R"(","conversationId":")" << conversationId
+                    << R"(","conversationName":")" << escapeJson(conversationName)
+                    << R"(","senderId":")" << result.doc.senderId
+                    << R"(","senderName":")" << escapeJson(sender ? sender->fullname : "Unknown")
+                    << R"(","timestamp":)" << result.doc.timestamp
+                    << R"(,"score":)" << std::fixed << std::setprecision(3) << result.score
+                    << R"(,"snippet":")" << escapeJson(snippet.text)
+                    << R"(","highlights":)" << highlightsJson.str() << "}";
+    }
+    resultsJson << "]";
+
+    return R"({"messageType":"SEARCH_CHAT_RESPONSE","messageId":")" + messageId +
+           R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+           R"(,"payload":{"status":"success","data":{"results":)" + resultsJson.str() +
+           R"(,"matchCount":)" + std::to_string(matchCount) + R"(}}})";
+}
+
+// Xử lý CREATE_CHANNEL_REQUEST (Teacher/Admin) - tạo kênh chat cho lớp học
+std::string handleCreateChannel(const std::string& json) {
+    std::string payload = getJsonObject(json, "payload");
+    std::string messageId = getJsonValue(json, "messageId");
+    std::string sessionToken = getJsonValue(json, "sessionToken");
+    std::string name = getJsonValue(payload, "name");
+    std::vector<std::string> memberIds = parseJsonArray(getJsonArray(payload, "memberIds"));
+
+    std::string userId = validateSession(sessionToken);
+    if (userId.empty()) {
+        return R"({"messageType":"CREATE_CHANNEL_RESPONSE","messageId":")" + messageId +
+               R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+               R"(,"payload":{"status":"error","message":"Invalid or expired session"}})";
+    }
+
+    if (!isTeacher(userId) && !isAdmin(userId)) {
+        return R"({"messageType":"CREATE_CHANNEL_RESPONSE","messageId":")" + messageId +
+               R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+               R"(,"payload":{"status":"error","message":"Only teachers can create channels"}})";
+    }
+
+    if (name.empty()) {
+        return R"({"messageType":"CREATE_CHANNEL_RESPONSE","messageId":")" + messageId +
+               R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+               R"(,"payload":{"status":"error","message":"Channel name is required"}})";
+    }
+
+    // The creator is always a member; unknown ids are ignored
+    std::vector<std::string> members{userId};
+    {
+        EpochGuard guard;
+        for (const auto& id : memberIds) {
+            if (users.findById(id)) members.push_back(id);
+        }
+    }
+
+    Channel channel;
+    channel.channelId = generateId("channel");
+    channel.name = name;
+    channel.kind = ChannelKind::Class;
+    channel.ownerId = userId;
+    channel.createdAt = getCurrentTimestamp();
+
+    size_t memberCount = 0;
+    {
+        std::lock_guard<std::mutex> lock(channelMutex);
+        while (!channels.create(channel)) {
+            channel.channelId = generateId("channel");
+        }
+        for (const auto& id : members) channels.addMember(channel.channelId, id);
+        memberCount = channels.members(channel.channelId)->size();
+    }
+
+    return R"({"messageType":"CREATE_CHANNEL_RESPONSE","messageId":")" + messageId +
+           R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+           R"(,"payload":{"status":"success","message":"Channel created","data":{"channelId":")" +
+           channel.channelId + R"(","name":")" + escapeJson(channel.name) +
+           R"(","kind":")" + channelKindToString(channel.kind) +
+           R"(","memberCount":)" + std::to_string(memberCount) + R"(}}})";
+}
+
+// Xử lý GET_CHANNELS_REQUEST - danh sách kênh của user kèm số tin chưa đọc
+std::string handleGetChannels(const std::string& json) {
+    std::string messageId = getJsonValue(json, "messageId");
+    std::string sessionToken = getJsonValue(json, "sessionToken");
+
+    std::string userId = validateSession(sessionToken);
+    if (userId.empty()) {
+        return R"({"messageType":"GET_CHANNELS_RESPONSE","messageId":")" + messageId +
+               R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+               R"(,"payload":{"status":"error","message":"Invalid or expired session"}})";
+    }
+
+    std::stringstream channelsJson;
+    channelsJson << "[";
+    {
+        std::lock_guard<std::mutex> lock(channelMutex);
+        bool first = true;
+        for (const Channel* channel : channels.channelsFor(userId)) {
+            if (!first) channelsJson << ",";
+            first = false;
+
+            const ChatMessage* last = channels.lastMessage(channel->channelId);
+            channelsJson << R"({"channelId":")" << channel->channelId
+                         << R"(","name":")" << escapeJson(channel->name)
+                         << R"(","kind":")" << channelKindToString(channel->kind)
+                         << R"(","memberCount":)" << channels.members(channel->channelId)->size()
+                         << R"(,"unreadCount":)" << channels.unreadCount(channel->channelId, userId)
+                         << R"(,"lastMessageAt":)" << (last ? last->timestamp : 0) << "}";
+        }
+    }
+    channelsJson << "]";
+
+    return R"({"messageType":"GET_CHANNELS_RESPONSE","messageId":")" + messageId +
+           R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+           R"(,"payload":{"status":"success","data":{"channels":)" + channelsJson.str() + R"(}}})";
+}
+
+// Xử lý SEND_CHANNEL_MESSAGE_REQUEST - gửi tin nhắn tới mọi thành viên của kênh
+std::string handleSendChannelMessage(const std::string& json) {
+    std::string payload = getJsonObject(json, "payload");
+    std::string messageId = getJsonValue(json, "messageId");
+    std::string sessionToken = getJsonValue(json, "sessionToken");
+    std::string channelId = getJsonValue(payload, "channelId");
+    std::string messageContent = getJsonValue(payload, "messageContent");
+
+    std::string senderId = validateSession(sessionToken);
+    if (senderId.empty()) {
+        return R"({"messageType":"SEND_CHANNEL_MESSAGE_RESPONSE","messageId":")" + messageId +
+               R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+               R"(,"payload":{"status":"error","message":"Invalid or expired session"}})";
+    }
+
+    std::vector<Attachment> attachments;
+    std::string attachmentError = parseAttachments(payload, attachments);
+    if (!attachmentError.empty()) {
+        return R"({"messageType":"SEND_CHANNEL_MESSAGE_RESPONSE","messageId":")" + messageId +
+               R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+               R"(,"payload":{"status":"error","message":")" + escapeJson(attachmentError) + R"("}})";
+    }
+
+    if (messageContent.empty() && attachments.empty()) {
+        return R"({"messageType":"SEND_CHANNEL_MESSAGE_RESPONSE","messageId":")" + messageId +
+               R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+               R"(,"payload":{"status":"error","message":"Message content is required"}})";
+    }
+
+    std::string senderName = "Unknown";
+    {
+        EpochGuard guard;
+        if (const User* sender = users.getById(senderId)) senderName = sender->fullname;
+    }
+
+    ChatMessage msg;
+    msg.messageId = generateId("chanmsg");
+    msg.senderId = senderId;
+    msg.recipientId = channelId;
+    msg.content = messageContent;
+    msg.timestamp = getCurrentTimestamp();
+    msg.attachments = std::move(attachments);
+
+    // Offline members pick the message up through their unread count
+    ChannelStore::Members members;
+    std::string channelName;
+    {
+        std::lock_guard<std::mutex> lock(channelMutex);
+        const Channel* channel = channels.find(channelId);
+        if (!channel || !channels.isMember(channelId, senderId)) {
+            return R"({"messageType":"SEND_CHANNEL_MESSAGE_RESPONSE","messageId":")" + messageId +
+                   R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+                   R"(,"payload":{"status":"error","message":"Channel not found"}})";
+        }
+        while (!channels.append(msg)) {
+            msg.messageId = generateId("chanmsg");
+        }
+        members = channels.members(channelId);
+        channelName = channel->name;
+    }
+    // As with direct messages: acknowledge and fan out only once it is on disk
+    if (!chatLog->waitDurable()) {
+        {
+            std::lock_guard<std::mutex> lock(channelMutex);
+            channels.remove(channelId, msg.messageId);
+        }
+        return R"({"messageType":"SEND_CHANNEL_MESSAGE_RESPONSE","messageId":")" + messageId +
+               R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+               R"(,"payload":{"status":"error","message":"Message could not be saved, please try again"}})";
+    }
+    queueForIndex(msg, ChatIndex::Scope::Channel);
+    clearTyping(channelId, senderId);
+
+    // Serialized once; every online member's outbox shares the same frame
+    Frame frame = makeFrame(R"({"messageType":"CHANNEL_MESSAGE","messageId":")" + msg.messageId +
+                           R"(","timestamp":)" + std::to_string(msg.timestamp) +
+                           R"(,"payload":{"channelId":")" + channelId +
+                           R"(","channelName":")" + escapeJson(channelName) +
+                           R"(","messageId":")" + msg.messageId +
+                           R"(","senderId":")" + senderId +
+                           R"(","senderName":")" + escapeJson(senderName) +
+                           R"(","messageContent":")" + escapeJson(messageContent) +
+                           R"(","sentAt":)" + std::to_string(msg.timestamp) +
+                           attachmentsField(msg.attachments) + R"(}})");
+    size_t pushed = pushToUsers(*members, senderId, frame);
+    logMessage("SEND", "Channel:" + channelId,
+               "CHANNEL_MESSAGE " + msg.messageId + " to " + std::to_string(pushed) + " of " +
+               std::to_string(members->size()) + " members");
+
+    return R"({"messageType":"SEND_CHANNEL_MESSAGE_RESPONSE","messageId":")" + messageId +
+           R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+           R"(,"payload":{"status":"success","data":{"messageId":")" + msg.messageId +
+           R"(","channelId":")" + channelId +
+           R"(","sentAt":)" + std::to_string(msg.timestamp) +
+           R"(,"memberCount":)" + std::to_string(members->size()) +
+           R"(,"onlineCount":)" + std::to_string(pushed) +
+           attachmentsField(msg.attachments) + R"(}}})";
 }
 
-// Xử lý GET_CHAT_HISTORY_REQUEST
-std::string handleGetChatHistory(const std::string& json) {
+// Xử lý GET_CHANNEL_HISTORY_REQUEST - trang mới nhất cũng đánh dấu kênh đã đọc
+std::string handleGetChannelHistory(const std::string& json) {
     std::string payload = getJsonObject(json, "payload");
     std::string messageId = getJsonValue(json, "messageId");
     std::string sessionToken = getJsonValue(json, "sessionToken");
-    std::string recipientId = getJsonValue(payload, "recipientId");
+    std::string channelId = getJsonValue(payload, "channelId");
+    std::string before = getJsonValue(payload, "before");
+    std::string limitStr = getJsonValue(payload, "limit");
 
     std::string userId = validateSession(sessionToken);
     if (userId.empty()) {
-        return R"({"messageType":"GET_CHAT_HISTORY_RESPONSE","messageId":")" + messageId +
+        return R"({"messageType":"GET_CHANNEL_HISTORY_RESPONSE","messageId":")" + messageId +
                R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
                R"(,"payload":{"status":"error","message":"Invalid or expired session"}})";
     }
 
+    int requested = std::atoi(limitStr.c_str());
+    size_t limit = requested > 0 ? std::min(requested, CHAT_HISTORY_MAX_LIMIT) : CHAT_HISTORY_DEFAULT_LIMIT;
+
+    std::vector<ChatMessage> page;
+    std::string cursorId;
+    int64_t cursorTimestamp = 0;
+    parseHistoryCursor(before, cursorId, cursorTimestamp);
+    bool cursorInArchive = false;
+    {
+        std::lock_guard<std::mutex> lock(channelMutex);
+        if (!channels.isMember(channelId, userId)) {
+            return R"({"messageType":"GET_CHANNEL_HISTORY_RESPONSE","messageId":")" + messageId +
+                   R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+                   R"(,"payload":{"status":"error","message":"Channel not found"}})";
+        }
+        cursorInArchive = !cursorId.empty() && !channels.findMessage(channelId, cursorId);
+        if (!cursorInArchive) page = channels.history(channelId, cursorId, limit + 1);
+        if (before.empty()) channels.markRead(channelId, userId);
+    }
+
+    // Past the newest CHANNEL_HOT_MESSAGES, history continues in the archive
+    if (page.size() < limit + 1 && !(cursorInArchive && cursorTimestamp <= 0)) {
+        std::vector<ChatMessage> older = coldStore->history(ColdStore::channelKey(channelId),
+                                                            cursorInArchive ? cursorId : "",
+                                                            cursorInArchive ? cursorTimestamp : 0,
+                                                            limit + 1 - page.size());
+        if (!older.empty()) {
+            // Messages archived moments ago may not have left the channel yet
+            std::lock_guard<std::mutex> lock(channelMutex);
+            older.erase(std::remove_if(older.begin(), older.end(),
+                                       [&](const ChatMessage& m) { return channels.findMessage(channelId, m.messageId); }),
+                        older.end());
+        }
+        page.insert(page.begin(), older.begin(), older.end());
+    }
+    bool hasMore = page.size() > limit;
+    if (hasMore) page.erase(page.begin());
+
     std::stringstream messagesJson;
     messagesJson << "[";
     bool first = true;
+    EpochGuard guard;
+    for (const auto& msg : page) {
+        if (!first) messagesJson << ",";
+        first = false;
 
-    {
-        std::lock_guard<std::mutex> lock(chatMutex);
-        for (const auto& msg : chatMessages) {
-            if ((msg.senderId == userId && msg.recipientId == recipientId) ||
-                (msg.senderId == recipientId && msg.recipientId == userId)) {
-                if (!first) messagesJson << ",";
-                first = false;
-
-                messagesJson << R"({"messageId":")" << msg.messageId
-                             << R"(","senderId":")" << msg.senderId
-                             << R"(","content":")" << escapeJson(msg.content)
-                             << R"(","timestamp":)" << msg.timestamp << "}";
-            }
-        }
+        const User* sender = users.getById(msg.senderId);
+        messagesJson << R"({"messageId":")" << msg.messageId
+                     << R"(","senderId":")" << msg.senderId
+                     << R"(","senderName":")" << escapeJson(sender ? sender->fullname : "Unknown")
+                     << R"(","content":")" << escapeJson(msg.content)
+                     << R"(","timestamp":)" << msg.timestamp
+                     << attachmentsField(msg.attachments) << "}";
     }
     messagesJson << "]";
 
-    return R"({"messageType":"GET_CHAT_HISTORY_RESPONSE","messageId":")" + messageId +
+    std::string nextCursor = hasMore ? historyCursor(page.front()) : "";
+
+    return R"({"messageType":"GET_CHANNEL_HISTORY_RESPONSE","messageId":")" + messageId +
            R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
-           R"(,"payload":{"status":"success","data":{"messages":)" + messagesJson.str() + R"(}}})";
+           R"(,"payload":{"status":"success","data":{"messages":)" + messagesJson.str() +
+           R"(,"hasMore":)" + (hasMore ? "true" : "false") +
+           R"(,"nextCursor":")" + nextCursor + R"("}}})";
 }
 
 // Xử lý GET_EXERCISE_REQUEST
@@ -2105,22 +3034,23 @@ std::string handleGetExercise(const std::string& json) {
                R"(,"payload":{"status":"error","message":"Invalid or expired session"}})";
     }
 
-    // Tìm exercise phù hợp
+    // Tìm exercise phù hợp qua index; an unknown filter value matches nothing
+    CatalogFilter filter;
+    std::optional<ExerciseType> typeFilter;
+    bool matchable = narrowFilter(exerciseType, typeFilter, parseExerciseType) &&
+                     narrowFilter(level, filter.level, parseLevel) && narrowFilter(topic, filter.topic, parseTopic);
+    if (typeFilter) filter.kind = int(*typeFilter);
+
+    EpochGuard guard;
+    const auto& exercises = catalog.read().exercises;
     const Exercise* selectedExercise = nullptr;
-    for (const auto& pair : exercises) {
-        const Exercise& ex = pair.second;
-        bool typeMatch = exerciseType.empty() || ex.exerciseType == exerciseType;
-        bool levelMatch = level.empty() || ex.level == level;
-        bool topicMatch = topic.empty() || ex.topic == topic;
-
-        if (typeMatch && levelMatch && topicMatch) {
-            selectedExercise = &ex;
-            break;
-        }
+    if (matchable) {
+        auto page = exercises.select(filter, 0, 1);
+        if (!page.records.empty()) selectedExercise = page.records.front();
     }
 
-    if (!selectedExercise && !exercises.empty()) {
-        selectedExercise = &exercises.begin()->second;
+    if (!selectedExercise && exercises.size() > 0) {
+        selectedExercise = exercises.all().begin()->second.get();
     }
 
     if (!selectedExercise) {
@@ -2129,42 +3059,10 @@ std::string handleGetExercise(const std::string& json) {
                R"(,"payload":{"status":"error","message":"No exercises available"}})";
     }
 
-    const Exercise& ex = *selectedExercise;
-    std::stringstream responseJson;
-    responseJson << R"({"messageType":"GET_EXERCISE_RESPONSE","messageId":")" << messageId
-                 << R"(","timestamp":)" << getCurrentTimestamp()
-                 << R"(,"payload":{"status":"success","data":{"exerciseId":")" << ex.exerciseId
-                 << R"(","exerciseType":")" << ex.exerciseType
-                 << R"(","title":")" << escapeJson(ex.title)
-                 << R"(","description":")" << escapeJson(ex.description)
-                 << R"(","instructions":")" << escapeJson(ex.instructions)
-                 << R"(","level":")" << ex.level
-                 << R"(","topic":")" << ex.topic
-                 << R"(","duration":)" << ex.duration;
-
-    if (ex.exerciseType == "sentence_rewrite" && !ex.prompts.empty()) {
-        responseJson << R"(,"prompts":[)";
-        for (size_t i = 0; i < ex.prompts.size(); i++) {
-            if (i > 0) responseJson << ",";
-            responseJson << R"(")" << escapeJson(ex.prompts[i]) << R"(")";
-        }
-        responseJson << "]";
-    } else if (ex.exerciseType == "paragraph_writing") {
-        responseJson << R"(,"topicDescription":")" << escapeJson(ex.topicDescription) << R"(")";
-        if (!ex.requirements.empty()) {
-            responseJson << R"(,"requirements":[)";
-            for (size_t i = 0; i < ex.requirements.size(); i++) {
-                if (i > 0) responseJson << ",";
-                responseJson << R"(")" << escapeJson(ex.requirements[i]) << R"(")";
-            }
-            responseJson << "]";
-        }
-    } else if (ex.exerciseType == "topic_speaking") {
-        responseJson << R"(,"topicDescription":")" << escapeJson(ex.topicDescription) << R"(")";
-    }
-
-    responseJson << R"(}}})";
-    return responseJson.str();
+    return R"({"messageType":"GET_EXERCISE_RESPONSE","messageId":")" + messageId +
+           R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+           R"(,"payload":{"status":"success","data":{)" + exercises.fragments(*selectedExercise)->detail +
+           R"(}}})";
 }
 
 // Xử lý SUBMIT_EXERCISE_REQUEST
@@ -2183,8 +3081,9 @@ std::string handleSubmitExercise(const std::string& json) {
                R"(,"payload":{"status":"error","message":"Invalid or expired session"}})";
     }
 
-    auto it = exercises.find(exerciseId);
-    if (it == exercises.end()) {
+    EpochGuard guard;
+    const Exercise* exercise = catalog.read().exercises.find(exerciseId);
+    if (!exercise) {
         return R"({"messageType":"SUBMIT_EXERCISE_RESPONSE","messageId":")" + messageId +
                R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
                R"(,"payload":{"status":"error","message":"Exercise not found"}})";
@@ -2194,9 +3093,9 @@ std::string handleSubmitExercise(const std::string& json) {
     submission.submissionId = generateId("sub");
     submission.exerciseId = exerciseId;
     submission.userId = userId;
-    submission.exerciseType = exerciseType;
+    submission.exerciseType = exercise->exerciseType;
     submission.content = content;
-    submission.status = "pending";
+    submission.status = SubmissionStatus::Pending;
     submission.submittedAt = getCurrentTimestamp();
     submission.teacherId = "";
     submission.teacherFeedback = "";
@@ -2212,7 +3111,8 @@ std::string handleSubmitExercise(const std::string& json) {
            R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
            R"(,"payload":{"status":"success","message":"Exercise submitted successfully","data":{"submissionId":")" +
            submission.submissionId +
-           R"(","status":"pending","message":"Your submission will be reviewed by a teacher soon."}}})";
+           R"(","status":")" + submissionStatusToString(submission.status) +
+           R"(","message":"Your submission will be reviewed by a teacher soon."}}})";
 }
 
 // Xử lý GET_PENDING_SUBMISSIONS_REQUEST (Teacher only)
@@ -2235,16 +3135,16 @@ std::string handleGetPendingSubmissions(const std::string& json) {
     {
         std::lock_guard<std::mutex> lock(exercisesMutex);
         for (const auto& submission : exerciseSubmissions) {
-            if (submission.status == "pending") {
+            if (submission.status == SubmissionStatus::Pending) {
                 if (!first) submissionsJson << ",";
                 first = false;
 
                 std::string studentName = "Unknown";
                 {
-                    std::lock_guard<std::mutex> userLock(usersMutex);
-                    auto it = userById.find(submission.userId);
-                    if (it != userById.end()) {
-                        studentName = it->second->fullname;
+                    EpochGuard guard;
+                    const User* student = users.getById(submission.userId);
+                    if (student) {
+                        studentName = student->fullname;
                     }
                 }
 
@@ -2252,7 +3152,7 @@ std::string handleGetPendingSubmissions(const std::string& json) {
                                << R"(","exerciseId":")" << submission.exerciseId
                                << R"(","userId":")" << submission.userId
                                << R"(","studentName":")" << escapeJson(studentName)
-                               << R"(","exerciseType":")" << submission.exerciseType
+                               << R"(","exerciseType":")" << exerciseTypeToString(submission.exerciseType)
                                << R"(","content":")" << escapeJson(submission.content)
                                << R"(","submittedAt":)" << submission.submittedAt << "}";
                 count++;
@@ -2295,7 +3195,7 @@ std::string handleReviewExercise(const std::string& json) {
         std::lock_guard<std::mutex> lock(exercisesMutex);
         for (auto& submission : exerciseSubmissions) {
             if (submission.submissionId == submissionId) {
-                submission.status = "reviewed";
+                submission.status = SubmissionStatus::Reviewed;
                 submission.teacherId = userId;
                 submission.teacherFeedback = feedback;
                 submission.teacherScore = score;
@@ -2303,9 +3203,9 @@ std::string handleReviewExercise(const std::string& json) {
 
                 // Send notification to student if online
                 {
-                    std::lock_guard<std::mutex> userLock(usersMutex);
-                    auto it = userById.find(submission.userId);
-                    if (it != userById.end() && it->second->online && it->second->clientSocket > 0) {
+                    EpochGuard guard;
+                    const User* student = users.getById(submission.userId);
+                    if (student && student->online && student->clientSocket > 0) {
                         std::string notification = R"({"messageType":"EXERCISE_FEEDBACK_NOTIFICATION","messageId":")" +
                                                    generateId("notif") +
                                                    R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
@@ -2315,9 +3215,9 @@ std::string handleReviewExercise(const std::string& json) {
                                                    R"(","score":)" + std::to_string(score) + R"(}})";
 
                         uint32_t len = htonl(notification.length());
-                        send(it->second->clientSocket, &len, sizeof(len), 0);
-                        send(it->second->clientSocket, notification.c_str(), notification.length(), 0);
-                        logMessage("SEND", "Client:" + std::to_string(it->second->clientSocket), "EXERCISE_FEEDBACK_NOTIFICATION");
+                        send(student->clientSocket, &len, sizeof(len), 0);
+                        send(student->clientSocket, notification.c_str(), notification.length(), 0);
+                        logMessage("SEND", "Client:" + std::to_string(student->clientSocket), "EXERCISE_FEEDBACK_NOTIFICATION");
                     }
                 }
 
@@ -2353,18 +3253,19 @@ std::string handleGetFeedback(const std::string& json) {
         std::lock_guard<std::mutex> lock(exercisesMutex);
         for (const auto& submission : exerciseSubmissions) {
             if (submission.submissionId == submissionId && submission.userId == userId) {
-                if (submission.status == "pending") {
+                if (submission.status == SubmissionStatus::Pending) {
                     return R"({"messageType":"GET_FEEDBACK_RESPONSE","messageId":")" + messageId +
                            R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
-                           R"(,"payload":{"status":"success","data":{"status":"pending","message":"Your submission is still being reviewed"}}})";
+                           R"(,"payload":{"status":"success","data":{"status":")" + submissionStatusToString(submission.status) +
+                           R"(","message":"Your submission is still being reviewed"}}})";
                 }
 
                 std::string teacherName = "Unknown";
                 {
-                    std::lock_guard<std::mutex> userLock(usersMutex);
-                    auto it = userById.find(submission.teacherId);
-                    if (it != userById.end()) {
-                        teacherName = it->second->fullname;
+                    EpochGuard guard;
+                    const User* teacher = users.getById(submission.teacherId);
+                    if (teacher) {
+                        teacherName = teacher->fullname;
                     }
                 }
 
@@ -2393,6 +3294,7 @@ std::string handleGetGameList(const std::string& json) {
     std::string sessionToken = getJsonValue(json, "sessionToken");
     std::string gameType = getJsonValue(payload, "gameType");
     std::string level = getJsonValue(payload, "level");
+    std::string ifVersion = getJsonValue(payload, "ifVersion");
 
     std::string userId = validateSession(sessionToken);
     if (userId.empty()) {
@@ -2401,37 +3303,36 @@ std::string handleGetGameList(const std::string& json) {
                R"(,"payload":{"status":"error","message":"Invalid or expired session"}})";
     }
 
-    std::stringstream gamesJson;
-    gamesJson << "[";
-    bool first = true;
-    int count = 0;
+    std::string gamesJson = "[";
 
-    for (const auto& pair : games) {
-        const Game& game = pair.second;
-        bool typeMatch = gameType.empty() || gameType == "all" || game.gameType == gameType;
-        bool levelMatch = level.empty() || level == "all" || game.level == level;
+    // "all" or empty means no filter, an unknown value matches nothing
+    CatalogFilter filter;
+    std::optional<GameType> typeFilter;
+    bool matchable = narrowFilter(gameType, typeFilter, parseGameType) && narrowFilter(level, filter.level, parseLevel);
+    if (typeFilter) filter.kind = int(*typeFilter);
+    CatalogPage window = parseCatalogPage(payload);
 
-        if (typeMatch && levelMatch) {
-            if (!first) gamesJson << ",";
-            first = false;
+    EpochGuard guard;
+    ContentCatalog::Games::Page page;
+    if (matchable) page = catalog.read().games.select(filter, window.offset(), window.limit);
+    std::string version = versionString(listingTag(page, window));
+    if (ifVersion == version) return notModifiedResponse("GET_GAME_LIST_RESPONSE", messageId, version);
 
-            gamesJson << R"({"gameId":")" << game.gameId
-                      << R"(","gameType":")" << game.gameType
-                      << R"(","title":")" << escapeJson(game.title)
-                      << R"(","description":")" << escapeJson(game.description)
-                      << R"(","level":")" << game.level
-                      << R"(","topic":")" << game.topic
-                      << R"(","timeLimit":)" << game.timeLimit
-                      << R"(,"maxScore":)" << game.maxScore << "}";
-            count++;
-        }
+    for (size_t i = 0; i < page.fragments.size(); i++) {
+        if (i > 0) gamesJson += ",";
+        gamesJson += "{";
+        gamesJson += page.fragments[i]->list;
+        gamesJson += "}";
     }
-    gamesJson << "]";
+    gamesJson += "]";
 
     return R"({"messageType":"GET_GAME_LIST_RESPONSE","messageId":")" + messageId +
            R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
-           R"(,"payload":{"status":"success","data":{"games":)" + gamesJson.str() +
-           R"(,"totalGames":)" + std::to_string(count) + R"(}}})";
+           R"(,"payload":{"status":"success","data":{"games":)" + gamesJson +
+           R"(,"totalGames":)" + std::to_string(page.total) +
+           R"(,"page":)" + std::to_string(window.page) +
+           R"(,"totalPages":)" + std::to_string(window.totalPages(page.total)) +
+           R"(,"version":")" + version + R"("}}})";
 }
 
 // Xử lý START_GAME_REQUEST
@@ -2448,14 +3349,16 @@ std::string handleStartGame(const std::string& json) {
                R"(,"payload":{"status":"error","message":"Invalid or expired session"}})";
     }
 
-    auto it = games.find(gameId);
-    if (it == games.end()) {
+    EpochGuard guard;
+    const auto& games = catalog.read().games;
+    const Game* found = games.find(gameId);
+    if (!found) {
         return R"({"messageType":"START_GAME_RESPONSE","messageId":")" + messageId +
                R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
                R"(,"payload":{"status":"error","message":"Game not found"}})";
     }
 
-    const Game& game = it->second;
+    const Game& game = *found;
     std::string sessionId = generateId("gs");
 
     GameSession session;
@@ -2473,45 +3376,10 @@ std::string handleStartGame(const std::string& json) {
         gameSessions[sessionId] = session;
     }
 
-    std::stringstream gameDataJson;
-    gameDataJson << R"({"gameSessionId":")" << sessionId
-                 << R"(","gameId":")" << game.gameId
-                 << R"(","gameType":")" << game.gameType
-                 << R"(","title":")" << escapeJson(game.title)
-                 << R"(","timeLimit":)" << game.timeLimit
-                 << R"(","maxScore":)" << game.maxScore;
-
-    if (game.gameType == "word_match") {
-        gameDataJson << R"(,"pairs":[)";
-        for (size_t i = 0; i < game.pairs.size(); i++) {
-            if (i > 0) gameDataJson << ",";
-            gameDataJson << R"({"left":")" << escapeJson(game.pairs[i].first)
-                         << R"(","right":")" << escapeJson(game.pairs[i].second) << R"("})";
-        }
-        gameDataJson << "]";
-    } else if (game.gameType == "sentence_match") {
-        gameDataJson << R"(,"pairs":[)";
-        for (size_t i = 0; i < game.sentencePairs.size(); i++) {
-            if (i > 0) gameDataJson << ",";
-            gameDataJson << R"({"left":")" << escapeJson(game.sentencePairs[i].first)
-                         << R"(","right":")" << escapeJson(game.sentencePairs[i].second) << R"("})";
-        }
-        gameDataJson << "]";
-    } else if (game.gameType == "picture_match") {
-        gameDataJson << R"(,"pairs":[)";
-        for (size_t i = 0; i < game.picturePairs.size(); i++) {
-            if (i > 0) gameDataJson << ",";
-            gameDataJson << R"({"word":")" << escapeJson(game.picturePairs[i].first)
-                         << R"(","imageUrl":")" << escapeJson(game.picturePairs[i].second) << R"("})";
-        }
-        gameDataJson << "]";
-    }
-
-    gameDataJson << "}";
-
     return R"({"messageType":"START_GAME_RESPONSE","messageId":")" + messageId +
            R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
-           R"(,"payload":{"status":"success","data":)" + gameDataJson.str() + R"(}}})";
+           R"(,"payload":{"status":"success","data":{"gameSessionId":")" + sessionId + R"(",)" +
+           games.fragments(game)->detail + R"(}}})";
 }
 
 // Xử lý SUBMIT_GAME_RESULT_REQUEST
@@ -2537,21 +3405,22 @@ std::string handleSubmitGameResult(const std::string& json) {
                R"(,"payload":{"status":"error","message":"Game session not found"}})";
     }
 
-    auto gameIt = games.find(gameId);
-    if (gameIt == games.end()) {
+    EpochGuard guard;
+    const Game* foundGame = catalog.read().games.find(gameId);
+    if (!foundGame) {
         return R"({"messageType":"SUBMIT_GAME_RESULT_RESPONSE","messageId":")" + messageId +
                R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
                R"(,"payload":{"status":"error","message":"Game not found"}})";
     }
 
-    const Game& game = gameIt->second;
+    const Game& game = *foundGame;
     GameSession& session = sessionIt->second;
 
     // Parse matches and calculate score
     int correctMatches = 0;
     int totalPairs = 0;
 
-    if (game.gameType == "word_match") {
+    if (game.gameType == GameType::WordMatch) {
         totalPairs = game.pairs.size();
         std::vector<std::string> matches = parseJsonArray(matchesArray);
         for (const std::string& match : matches) {
@@ -2564,7 +3433,7 @@ std::string handleSubmitGameResult(const std::string& json) {
                 }
             }
         }
-    } else if (game.gameType == "sentence_match") {
+    } else if (game.gameType == GameType::SentenceMatch) {
         totalPairs = game.sentencePairs.size();
         std::vector<std::string> matches = parseJsonArray(matchesArray);
         for (const std::string& match : matches) {
@@ -2577,7 +3446,7 @@ std::string handleSubmitGameResult(const std::string& json) {
                 }
             }
         }
-    } else if (game.gameType == "picture_match") {
+    } else if (game.gameType == GameType::PictureMatch) {
         totalPairs = game.picturePairs.size();
         std::vector<std::string> matches = parseJsonArray(matchesArray);
         for (const std::string& match : matches) {
@@ -2620,20 +3489,20 @@ std::string handleSubmitGameResult(const std::string& json) {
 
 // Helper function to check if user is admin
 bool isAdmin(const std::string& userId) {
-    std::lock_guard<std::mutex> lock(usersMutex);
-    auto it = userById.find(userId);
-    if (it != userById.end()) {
-        return it->second->role == "admin";
+    EpochGuard guard;
+    const User* user = users.getById(userId);
+    if (user) {
+        return user->isAdmin();
     }
     return false;
 }
 
 // Helper function to check if user is teacher
 bool isTeacher(const std::string& userId) {
-    std::lock_guard<std::mutex> lock(usersMutex);
-    auto it = userById.find(userId);
-    if (it != userById.end()) {
-        return it->second->role == "teacher";
+    EpochGuard guard;
+    const User* user = users.getById(userId);
+    if (user) {
+        return user->role == UserRole::Teacher;
     }
     return false;
 }
@@ -2660,17 +3529,25 @@ std::string handleAddGame(const std::string& json) {
     std::string maxScoreStr = getJsonValue(payload, "maxScore");
 
     Game newGame;
+    if (!parseGameType(gameType, newGame.gameType)) {
+        return R"({"messageType":"ADD_GAME_RESPONSE","messageId":")" + messageId +
+               R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+               R"(,"payload":{"status":"error","message":"Invalid game type"}})";
+    }
+    if (!parseLevel(level, newGame.level)) {
+        return R"({"messageType":"ADD_GAME_RESPONSE","messageId":")" + messageId +
+               R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+               R"(,"payload":{"status":"error","message":"Invalid level"}})";
+    }
     newGame.gameId = generateId("game");
-    newGame.gameType = gameType;
     newGame.title = title;
     newGame.description = description;
-    newGame.level = level;
     newGame.topic = topic;
     newGame.timeLimit = timeLimitStr.empty() ? 120 : std::stoi(timeLimitStr);
     newGame.maxScore = maxScoreStr.empty() ? 100 : std::stoi(maxScoreStr);
 
     // Parse pairs based on game type
-    if (gameType == "word_match") {
+    if (newGame.gameType == GameType::WordMatch) {
         std::string pairsArray = getJsonArray(payload, "pairs");
         std::vector<std::string> pairs = parseJsonArray(pairsArray);
         for (const std::string& pair : pairs) {
@@ -2678,7 +3555,7 @@ std::string handleAddGame(const std::string& json) {
             std::string right = getJsonValue(pair, "right");
             newGame.pairs.push_back({left, right});
         }
-    } else if (gameType == "sentence_match") {
+    } else if (newGame.gameType == GameType::SentenceMatch) {
         std::string pairsArray = getJsonArray(payload, "pairs");
         std::vector<std::string> pairs = parseJsonArray(pairsArray);
         for (const std::string& pair : pairs) {
@@ -2686,7 +3563,7 @@ std::string handleAddGame(const std::string& json) {
             std::string right = getJsonValue(pair, "right");
             newGame.sentencePairs.push_back({left, right});
         }
-    } else if (gameType == "picture_match") {
+    } else if (newGame.gameType == GameType::PictureMatch) {
         std::string pairsArray = getJsonArray(payload, "pairs");
         std::vector<std::string> pairs = parseJsonArray(pairsArray);
         for (const std::string& pair : pairs) {
@@ -2696,10 +3573,10 @@ std::string handleAddGame(const std::string& json) {
         }
     }
 
-    {
-        std::lock_guard<std::mutex> lock(gamesMutex);
-        games[newGame.gameId] = newGame;
-    }
+    editCatalog([&](ContentCatalog& current) {
+        current.games.put(newGame.gameId, newGame);
+        return true;
+    });
 
     return R"({"messageType":"ADD_GAME_RESPONSE","messageId":")" + messageId +
            R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
@@ -2721,20 +3598,23 @@ std::string handleUpdateGame(const std::string& json) {
                R"(,"payload":{"status":"error","message":"Unauthorized: Admin access required"}})";
     }
 
-    {
-        std::lock_guard<std::mutex> lock(gamesMutex);
-        auto it = games.find(gameId);
-        if (it == games.end()) {
-            return R"({"messageType":"UPDATE_GAME_RESPONSE","messageId":")" + messageId +
-                   R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
-                   R"(,"payload":{"status":"error","message":"Game not found"}})";
-        }
+    std::string title = getJsonValue(payload, "title");
+    std::string description = getJsonValue(payload, "description");
 
-        Game& game = it->second;
-        std::string title = getJsonValue(payload, "title");
-        std::string description = getJsonValue(payload, "description");
+    // Publishes a new version of the game; readers keep the old one until done
+    bool updated = editCatalog([&](ContentCatalog& current) {
+        const Game* found = current.games.find(gameId);
+        if (!found) return false;
+        Game game = *found;
         if (!title.empty()) game.title = title;
         if (!description.empty()) game.description = description;
+        current.games.put(gameId, std::move(game));
+        return true;
+    });
+    if (!updated) {
+        return R"({"messageType":"UPDATE_GAME_RESPONSE","messageId":")" + messageId +
+               R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+               R"(,"payload":{"status":"error","message":"Game not found"}})";
     }
 
     return R"({"messageType":"UPDATE_GAME_RESPONSE","messageId":")" + messageId +
@@ -2756,15 +3636,11 @@ std::string handleDeleteGame(const std::string& json) {
                R"(,"payload":{"status":"error","message":"Unauthorized: Admin access required"}})";
     }
 
-    {
-        std::lock_guard<std::mutex> lock(gamesMutex);
-        auto it = games.find(gameId);
-        if (it == games.end()) {
-            return R"({"messageType":"DELETE_GAME_RESPONSE","messageId":")" + messageId +
-                   R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
-                   R"(,"payload":{"status":"error","message":"Game not found"}})";
-        }
-        games.erase(it);
+    bool deleted = editCatalog([&](ContentCatalog& current) { return current.games.erase(gameId); });
+    if (!deleted) {
+        return R"({"messageType":"DELETE_GAME_RESPONSE","messageId":")" + messageId +
+               R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+               R"(,"payload":{"status":"error","message":"Game not found"}})";
     }
 
     return R"({"messageType":"DELETE_GAME_RESPONSE","messageId":")" + messageId +
@@ -2784,60 +3660,62 @@ std::string handleGetAdminGames(const std::string& json) {
                R"(,"payload":{"status":"error","message":"Unauthorized: Admin access required"}})";
     }
 
-    std::stringstream gamesJson;
-    gamesJson << "[";
-    bool first = true;
-
+    std::string gamesJson = "[";
     {
-        std::lock_guard<std::mutex> lock(gamesMutex);
-        for (const auto& pair : games) {
-            const Game& game = pair.second;
-            if (!first) gamesJson << ",";
-            first = false;
+        EpochGuard guard;
+        const auto& games = catalog.read().games;
+        for (const auto& pair : games.all()) {
+            if (gamesJson.size() > 1) gamesJson += ",";
+            gamesJson += "{";
+            gamesJson += games.fragments(*pair.second)->detail;
+            gamesJson += "}";
+        }
+    }
+    gamesJson += "]";
 
-            gamesJson << R"({"gameId":")" << game.gameId
-                      << R"(","gameType":")" << game.gameType
-                      << R"(","title":")" << escapeJson(game.title)
-                      << R"(","description":")" << escapeJson(game.description)
-                      << R"(","level":")" << game.level
-                      << R"(","topic":")" << game.topic
-                      << R"(","timeLimit":)" << game.timeLimit
-                      << R"(,"maxScore":)" << game.maxScore;
-
-            if (game.gameType == "word_match") {
-                gamesJson << R"(,"pairs":[)";
-                for (size_t i = 0; i < game.pairs.size(); i++) {
-                    if (i > 0) gamesJson << ",";
-                    gamesJson << R"({"left":")" << escapeJson(game.pairs[i].first)
-                              << R"(","right":")" << escapeJson(game.pairs[i].second) << R"("})";
-                }
-                gamesJson << "]";
-            } else if (game.gameType == "sentence_match") {
-                gamesJson << R"(,"pairs":[)";
-                for (size_t i = 0; i < game.sentencePairs.size(); i++) {
-                    if (i > 0) gamesJson << ",";
-                    gamesJson << R"({"left":")" << escapeJson(game.sentencePairs[i].first)
-                              << R"(","right":")" << escapeJson(game.sentencePairs[i].second) << R"("})";
-                }
-                gamesJson << "]";
-            } else if (game.gameType == "picture_match") {
-                gamesJson << R"(,"pairs":[)";
-                for (size_t i = 0; i < game.picturePairs.size(); i++) {
-                    if (i > 0) gamesJson << ",";
-                    gamesJson << R"({"word":")" << escapeJson(game.picturePairs[i].first)
-                              << R"(","imageUrl":")" << escapeJson(game.picturePairs[i].second) << R"("})";
-                }
-                gamesJson << "]";
-            }
+    return R"({"messageType":"GET_ADMIN_GAMES_RESPONSE","messageId":")" + messageId +
+           R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+           R"(,"payload":{"status":"success","data":{"games":)" + gamesJson + R"(}}})";
+}
 
-            gamesJson << "}";
+// Xử lý RELOAD_CONTENT_REQUEST (Admin only)
+// Rebuilds the catalog from CONTENT_PACK_DIR and swaps it in; a catalog with
+// any unusable pack is rejected and the current one keeps being served.
+std::string handleReloadContent(const std::string& json) {
+    std::string messageId = getJsonValue(json, "messageId");
+    std::string sessionToken = getJsonValue(json, "sessionToken");
+
+    std::string userId = validateSession(sessionToken);
+    if (userId.empty() || !isAdmin(userId)) {
+        return R"({"messageType":"RELOAD_CONTENT_RESPONSE","messageId":")" + messageId +
+               R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+               R"(,"payload":{"status":"error","message":"Unauthorized: Admin access required"}})";
+    }
+
+    ContentReload result = reloadContent(true);
+    if (!result.published) {
+        std::string problems = "[";
+        for (size_t i = 0; i < result.problems.size(); i++) {
+            if (i > 0) problems += ",";
+            problems += "\"" + escapeJson(result.problems[i]) + "\"";
         }
+        problems += "]";
+        return R"({"messageType":"RELOAD_CONTENT_RESPONSE","messageId":")" + messageId +
+               R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
+               R"(,"payload":{"status":"error","message":"Content reload rejected","data":{"version":)" +
+               std::to_string(result.version) + R"(,"problems":)" + problems + R"(}}})";
     }
-    gamesJson << "]";
 
-    return R"({"messageType":"GET_ADMIN_GAMES_RESPONSE","messageId":")" + messageId +
+    return R"({"messageType":"RELOAD_CONTENT_RESPONSE","messageId":")" + messageId +
            R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
-           R"(,"payload":{"status":"success","data":{"games":)" + gamesJson.str() + R"(}}})";
+           R"(,"payload":{"status":"success","message":"Content reloaded","data":{"version":)" +
+           std::to_string(result.version) +
+           R"(,"packs":)" + std::to_string(result.packs) +
+           R"(,"lessons":)" + std::to_string(result.lessons) +
+           R"(,"tests":)" + std::to_string(result.tests) +
+           R"(,"exercises":)" + std::to_string(result.exercises) +
+           R"(,"games":)" + std::to_string(result.games) +
+           R"(,"elapsedMs":)" + std::to_string(result.elapsedMs) + R"(}}})";
 }
 
 
@@ -2868,7 +3746,7 @@ std::string handleReviewExercise(const std::string& json) {
         std::lock_guard<std::mutex> lock(exercisesMutex);
         for (auto& submission : exerciseSubmissions) {
             if (submission.submissionId == submissionId) {
-                submission.status = "reviewed";
+                submission.status = SubmissionStatus::Reviewed;
                 submission.teacherId = userId;
                 submission.teacherFeedback = feedback;
                 submission.teacherScore = score;
@@ -2876,9 +3754,9 @@ std::string handleReviewExercise(const std::string& json) {
 
                 // Send notification to student if online
                 {
-                    std::lock_guard<std::mutex> userLock(usersMutex);
-                    auto it = userById.find(submission.userId);
-                    if (it != userById.end() && it->second->online && it->second->clientSocket > 0) {
+                    EpochGuard guard;
+                    const User* student = users.getById(submission.userId);
+                    if (student && student->online && student->clientSocket > 0) {
                         std::string notification = R"({"messageType":"EXERCISE_FEEDBACK_NOTIFICATION","messageId":")" +
                                                    generateId("notif") +
                                                    R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
@@ -2888,9 +3766,9 @@ std::string handleReviewExercise(const std::string& json) {
                                                    R"(","score":)" + std::to_string(score) + R"(}})";
 
                         uint32_t len = htonl(notification.length());
-                        send(it->second->clientSocket, &len, sizeof(len), 0);
-                        send(it->second->clientSocket, notification.c_str(), notification.length(), 0);
-                        logMessage("SEND", "Client:" + std::to_string(it->second->clientSocket), "EXERCISE_FEEDBACK_NOTIFICATION");
+                        send(student->clientSocket, &len, sizeof(len), 0);
+                        send(student->clientSocket, notification.c_str(), notification.length(), 0);
+                        logMessage("SEND", "Client:" + std::to_string(student->clientSocket), "EXERCISE_FEEDBACK_NOTIFICATION");
                     }
                 }
 
@@ -2924,18 +3802,19 @@ std::string handleGetFeedback(const std::string& json) {
         std::lock_guard<std::mutex> lock(exercisesMutex);
         for (const auto& submission : exerciseSubmissions) {
             if (submission.submissionId == submissionId && submission.userId == userId) {
-                if (submission.status == "pending") {
+                if (submission.status == SubmissionStatus::Pending) {
                     return R"({"messageType":"GET_FEEDBACK_RESPONSE","messageId":")" + messageId +
                            R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
-                           R"(,"payload":{"status":"success","data":{"status":"pending","message":"Your submission is still being reviewed"}}})";
+                           R"(,"payload":{"status":"success","data":{"status":")" + submissionStatusToString(submission.status) +
+                           R"(","message":"Your submission is still being reviewed"}}})";
                 }
 
                 std::string teacherName = "Unknown";
                 {
-                    std::lock_guard<std::mutex> userLock(usersMutex);
-                    auto it = userById.find(submission.teacherId);
-                    if (it != userById.end()) {
-                        teacherName = it->second->fullname;
+                    EpochGuard guard;
+                    const User* teacher = users.getById(submission.teacherId);
+                    if (teacher) {
+                        teacherName = teacher->fullname;
                     }
                 }
 
@@ -2973,6 +3852,8 @@ std::string handleGetUserSubmissions(const std::string& json) {
 
     {
         std::lock_guard<std::mutex> lock(exercisesMutex);
+        EpochGuard guard;
+        const ContentCatalog& snapshot = catalog.read();
         for (const auto& submission : exerciseSubmissions) {
             if (submission.userId == userId) {
                 if (!first) submissionsJson += ",";
@@ -2980,29 +3861,28 @@ std::string handleGetUserSubmissions(const std::string& json) {
 
                 // Get exercise title
                 std::string exerciseTitle = "Unknown Exercise";
-                auto exIt = exercises.find(submission.exerciseId);
-                if (exIt != exercises.end()) {
-                    exerciseTitle = exIt->second.title;
+                if (const Exercise* exercise = snapshot.exercises.find(submission.exerciseId)) {
+                    exerciseTitle = exercise->title;
                 }
 
                 // Get teacher name if reviewed
                 std::string teacherName = "";
-                if (submission.status == "reviewed" && !submission.teacherId.empty()) {
-                    std::lock_guard<std::mutex> userLock(usersMutex);
-                    auto it = userById.find(submission.teacherId);
-                    if (it != userById.end()) {
-                        teacherName = it->second->fullname;
+                if (submission.status == SubmissionStatus::Reviewed && !submission.teacherId.empty()) {
+                    EpochGuard guard;
+                    const User* teacher = users.getById(submission.teacherId);
+                    if (teacher) {
+                        teacherName = teacher->fullname;
                     }
                 }
 
                 submissionsJson += R"({"submissionId":")" + submission.submissionId +
                                    R"(","exerciseId":")" + submission.exerciseId +
                                    R"(","exerciseTitle":")" + escapeJson(exerciseTitle) +
-                                   R"(","exerciseType":")" + submission.exerciseType +
-                                   R"(","status":")" + submission.status +
+                                   R"(","exerciseType":")" + exerciseTypeToString(submission.exerciseType) +
+                                   R"(","status":")" + submissionStatusToString(submission.status) +
                                    R"(","submittedAt":)" + std::to_string(submission.submittedAt);
 
-                if (submission.status == "reviewed") {
+                if (submission.status == SubmissionStatus::Reviewed) {
                     submissionsJson += R"(,"teacherId":")" + submission.teacherId +
                                        R"(","teacherName":")" + escapeJson(teacherName) +
                                        R"(","feedback":")" + escapeJson(submission.teacherFeedback) +
@@ -3037,32 +3917,33 @@ std::string handleGetPendingReviews(const std::string& json) {
 
     {
         std::lock_guard<std::mutex> lock(exercisesMutex);
+        EpochGuard guard;
+        const ContentCatalog& snapshot = catalog.read();
         for (const auto& submission : exerciseSubmissions) {
-            if (submission.status == "pending") {
+            if (submission.status == SubmissionStatus::Pending) {
                 if (!first) submissionsJson += ",";
                 first = false;
 
                 // Get exercise title
                 std::string exerciseTitle = "Unknown Exercise";
-                auto exIt = exercises.find(submission.exerciseId);
-                if (exIt != exercises.end()) {
-                    exerciseTitle = exIt->second.title;
+                if (const Exercise* exercise = snapshot.exercises.find(submission.exerciseId)) {
+                    exerciseTitle = exercise->title;
                 }
 
                 // Get student name
                 std::string studentName = "Unknown";
                 {
-                    std::lock_guard<std::mutex> userLock(usersMutex);
-                    auto it = userById.find(submission.userId);
-                    if (it != userById.end()) {
-                        studentName = it->second->fullname;
+                    EpochGuard guard;
+                    const User* student = users.getById(submission.userId);
+                    if (student) {
+                        studentName = student->fullname;
                     }
                 }
 
                 submissionsJson += R"({"submissionId":")" + submission.submissionId +
                                    R"(","exerciseId":")" + submission.exerciseId +
                                    R"(","exerciseTitle":")" + escapeJson(exerciseTitle) +
-                                   R"(","exerciseType":")" + submission.exerciseType +
+                                   R"(","exerciseType":")" + exerciseTypeToString(submission.exerciseType) +
                                    R"(","studentId":")" + submission.userId +
                                    R"(","studentName":")" + escapeJson(studentName) +
                                    R"(","content":")" + escapeJson(submission.content) +
@@ -3092,38 +3973,33 @@ std::string handleGetExerciseList(const std::string& json) {
                R"(,"payload":{"status":"error","message":"Invalid or expired session"}})";
     }
 
-    std::stringstream exerciseList;
-    exerciseList << "[";
-    bool first = true;
-    int count = 0;
-
-    for (const auto& pair : exercises) {
-        const Exercise& ex = pair.second;
+    std::string exerciseList = "[";
 
-        // Apply filters
-        bool levelMatch = level.empty() || ex.level == level;
-        bool typeMatch = exerciseType.empty() || ex.exerciseType == exerciseType;
-
-        if (levelMatch && typeMatch) {
-            if (!first) exerciseList << ",";
-            first = false;
+    // Apply filters through the index; an unknown value matches no exercises
+    CatalogFilter filter;
+    std::optional<ExerciseType> typeFilter;
+    bool matchable = narrowFilter(level, filter.level, parseLevel) &&
+                     narrowFilter(exerciseType, typeFilter, parseExerciseType);
+    if (typeFilter) filter.kind = int(*typeFilter);
+    CatalogPage window = parseCatalogPage(payload);
 
-            exerciseList << R"({"exerciseId":")" << ex.exerciseId
-                         << R"(","exerciseType":")" << ex.exerciseType
-                         << R"(","title":")" << escapeJson(ex.title)
-                         << R"(","description":")" << escapeJson(ex.description)
-                         << R"(","level":")" << ex.level
-                         << R"(","topic":")" << ex.topic
-                         << R"(","duration":)" << ex.duration << "}";
-            count++;
-        }
+    EpochGuard guard;
+    ContentCatalog::Exercises::Page page;
+    if (matchable) page = catalog.read().exercises.select(filter, window.offset(), window.limit);
+    for (size_t i = 0; i < page.fragments.size(); i++) {
+        if (i > 0) exerciseList += ",";
+        exerciseList += "{";
+        exerciseList += page.fragments[i]->list;
+        exerciseList += "}";
     }
-    exerciseList << "]";
+    exerciseList += "]";
 
     return R"({"messageType":"GET_EXERCISE_LIST_RESPONSE","messageId":")" + messageId +
            R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
-           R"(,"payload":{"status":"success","data":{"exercises":)" + exerciseList.str() +
-           R"(,"total":)" + std::to_string(count) +
+           R"(,"payload":{"status":"success","data":{"exercises":)" + exerciseList +
+           R"(,"total":)" + std::to_string(page.total) +
+           R"(,"page":)" + std::to_string(window.page) +
+           R"(,"totalPages":)" + std::to_string(window.totalPages(page.total)) +
            R"(,"filterLevel":")" + level +
            R"(","filterType":")" + exerciseType + R"("}}})";
 }
@@ -3144,8 +4020,9 @@ std::string handleSaveDraft(const std::string& json) {
                R"(,"payload":{"status":"error","message":"Invalid or expired session"}})";
     }
 
-    auto it = exercises.find(exerciseId);
-    if (it == exercises.end()) {
+    EpochGuard guard;
+    const Exercise* exercise = catalog.read().exercises.find(exerciseId);
+    if (!exercise) {
         return R"({"messageType":"SAVE_DRAFT_RESPONSE","messageId":")" + messageId +
                R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
                R"(,"payload":{"status":"error","message":"Exercise not found"}})";
@@ -3161,7 +4038,7 @@ std::string handleSaveDraft(const std::string& json) {
         for (auto& submission : exerciseSubmissions) {
             if (submission.userId == userId &&
                 submission.exerciseId == exerciseId &&
-                submission.status == "draft") {
+                submission.status == SubmissionStatus::Draft) {
                 // Update existing draft
                 submission.content = content;
                 submission.audioUrl = audioUrl;
@@ -3176,10 +4053,10 @@ std::string handleSaveDraft(const std::string& json) {
             draft.submissionId = generateId("draft");
             draft.exerciseId = exerciseId;
             draft.userId = userId;
-            draft.exerciseType = it->second.exerciseType;
+            draft.exerciseType = exercise->exerciseType;
             draft.content = content;
             draft.audioUrl = audioUrl;
-            draft.status = "draft";
+            draft.status = SubmissionStatus::Draft;
             draft.createdAt = getCurrentTimestamp();
             draft.submittedAt = 0;
             draft.teacherScore = 0;
@@ -3213,21 +4090,22 @@ std::string handleGetMyDrafts(const std::string& json) {
 
     {
         std::lock_guard<std::mutex> lock(exercisesMutex);
+        EpochGuard guard;
+        const ContentCatalog& snapshot = catalog.read();
         for (const auto& submission : exerciseSubmissions) {
-            if (submission.userId == userId && submission.status == "draft") {
+            if (submission.userId == userId && submission.status == SubmissionStatus::Draft) {
                 if (!first) draftsJson += ",";
                 first = false;
 
                 std::string exerciseTitle = "Unknown Exercise";
-                auto exIt = exercises.find(submission.exerciseId);
-                if (exIt != exercises.end()) {
-                    exerciseTitle = exIt->second.title;
+                if (const Exercise* exercise = snapshot.exercises.find(submission.exerciseId)) {
+                    exerciseTitle = exercise->title;
                 }
 
                 draftsJson += R"({"submissionId":")" + submission.submissionId +
                               R"(","exerciseId":")" + submission.exerciseId +
                               R"(","exerciseTitle":")" + escapeJson(exerciseTitle) +
-                              R"(","exerciseType":")" + submission.exerciseType +
+                              R"(","exerciseType":")" + exerciseTypeToString(submission.exerciseType) +
                               R"(","content":")" + escapeJson(submission.content) +
                               R"(","createdAt":)" + std::to_string(submission.createdAt) + "}";
             }
@@ -3256,30 +4134,31 @@ std::string handleGetSubmissionDetail(const std::string& json) {
 
     {
         std::lock_guard<std::mutex> lock(exercisesMutex);
+        EpochGuard guard;
+        const ContentCatalog& snapshot = catalog.read();
         for (const auto& submission : exerciseSubmissions) {
             if (submission.submissionId == submissionId) {
                 // Get exercise details
                 std::string exerciseTitle = "Unknown Exercise";
                 std::string exerciseInstructions = "";
-                std::string exerciseType = submission.exerciseType;
+                std::string exerciseType = exerciseTypeToString(submission.exerciseType);
                 int duration = 0;
 
-                auto exIt = exercises.find(submission.exerciseId);
-                if (exIt != exercises.end()) {
-                    exerciseTitle = exIt->second.title;
-                    exerciseInstructions = exIt->second.instructions;
-                    duration = exIt->second.duration;
+                if (const Exercise* exercise = snapshot.exercises.find(submission.exerciseId)) {
+                    exerciseTitle = exercise->title;
+                    exerciseInstructions = exercise->instructions;
+                    duration = exercise->duration;
                 }
 
                 // Get student details
                 std::string studentName = "Unknown";
                 std::string studentEmail = "";
                 {
-                    std::lock_guard<std::mutex> userLock(usersMutex);
-                    auto userIt = userById.find(submission.userId);
-                    if (userIt != userById.end()) {
-                        studentName = userIt->second->fullname;
-                        studentEmail = userIt->second->email;
+                    EpochGuard guard;
+                    const User* student = users.getById(submission.userId);
+                    if (student) {
+                        studentName = student->fullname;
+                        studentEmail = student->email;
                     }
                 }
 
@@ -3289,10 +4168,10 @@ std::string handleGetSubmissionDetail(const std::string& json) {
                          << R"(,"payload":{"status":"success","data":{"submission":{)"
                          << R"("submissionId":")" << submission.submissionId
                          << R"(","exerciseId":")" << submission.exerciseId
-                         << R"(","exerciseType":")" << submission.exerciseType
+                         << R"(","exerciseType":")" << exerciseTypeToString(submission.exerciseType)
                          << R"(","content":")" << escapeJson(submission.content)
                          << R"(","audioUrl":")" << escapeJson(submission.audioUrl)
-                         << R"(","status":")" << submission.status
+                         << R"(","status":")" << submissionStatusToString(submission.status)
                          << R"(","submittedAt":)" << submission.submittedAt
                          << R"(},"exercise":{"title":")" << escapeJson(exerciseTitle)
                          << R"(","instructions":")" << escapeJson(exerciseInstructions)
@@ -3338,12 +4217,10 @@ std::string handleGetReviewStatistics(const std::string& json) {
     {
         std::lock_guard<std::mutex> lock(exercisesMutex);
         for (const auto& submission : exerciseSubmissions) {
-            if (submission.status == english_learning::core::SubmissionStatusStr::PENDING_REVIEW ||
-                submission.status == "pending") {
+            if (submission.status == SubmissionStatus::Pending) {
                 totalPending++;
             }
-            else if (submission.status == english_learning::core::SubmissionStatusStr::REVIEWED ||
-                     submission.status == "reviewed") {
+            else if (submission.status == SubmissionStatus::Reviewed) {
                 totalReviewed++;
                 if (submission.teacherId == userId) {
                     if (submission.reviewedAt >= dayStart) {
@@ -3389,18 +4266,29 @@ std::string handleSetLevel(const std::string& json) {
                R"(,"payload":{"status":"error","message":"Invalid or expired session"}})";
     }
 
-    if (level != "beginner" && level != "intermediate" && level != "advanced") {
+    Level parsed;
+    if (!parseLevel(level, parsed)) {
         return R"({"messageType":"SET_LEVEL_RESPONSE","messageId":")" + messageId +
                R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
                R"(,"payload":{"status":"error","message":"Invalid level"}})";
     }
 
+    Level previous = Level::Beginner;
+    bool student = false;
     {
         std::lock_guard<std::mutex> lock(usersMutex);
-        auto it = userById.find(userId);
-        if (it != userById.end()) {
-            it->second->level = level;
-        }
+        users.modify(users.findById(userId), [&](User& user) {
+            previous = user.level;
+            student = user.role == UserRole::Student;
+            user.level = parsed;
+        });
+    }
+
+    // Students follow their level's channel; teachers and admins are in all of them
+    if (student && previous != parsed) {
+        std::lock_guard<std::mutex> lock(channelMutex);
+        channels.removeMember(levelChannelId(previous), userId);
+        channels.addMember(levelChannelId(parsed), userId);
     }
 
     return R"({"messageType":"SET_LEVEL_RESPONSE","messageId":")" + messageId +
@@ -3412,15 +4300,244 @@ std::string handleSetLevel(const std::string& json) {
 // VOICE CALL HANDLERS
 // ============================================================================
 
-// Helper: Send push notification to a user's socket
+// Helper: Queue a push notification for a user's connection
 void sendPushToUser(const std::string& userId, const std::string& message) {
-    std::lock_guard<std::mutex> userLock(usersMutex);
-    auto it = userById.find(userId);
-    if (it != userById.end() && it->second->online && it->second->clientSocket >= 0) {
-        int socket = it->second->clientSocket;
-        uint32_t len = htonl(message.length());
-        send(socket, &len, sizeof(len), 0);
-        send(socket, message.c_str(), message.length(), 0);
+    EpochGuard guard;
+    const User* user = users.getById(userId);
+    if (user && user->online && user->clientSocket >= 0) {
+        pushFrame(user->clientSocket, makeFrame(message));
+    }
+}
+
+// ============================================================================
+// PRESENCE FAN-OUT
+// ============================================================================
+
+// UserTable listener; runs on the writer thread with usersMutex held
+void queuePresenceChange(UserHandle, const User& user) {
+    {
+        std::lock_guard<std::mutex> lock(presenceMutex);
+        auto it = pendingPresence.find(user.userId);
+        if (it == pendingPresence.end()) {
+            pendingPresence[user.userId] = PendingPresence{!user.online, user.online};
+        } else {
+            it->second.now = user.online;
+        }
+    }
+    presenceCv.notify_one();
+}
+
+// PRESENCE_UPDATE push carrying the given change entries
+std::string presenceNotification(const std::vector<const std::string*>& changes, size_t onlineCount) {
+    std::string notification = R"({"messageType":"PRESENCE_UPDATE","timestamp":)" +
+        std::to_string(getCurrentTimestamp()) + R"(,"payload":{"changes":[)";
+    for (size_t i = 0; i < changes.size(); i++) {
+        if (i > 0) notification += ",";
+        notification += *changes[i];
+    }
+    return notification + R"(],"onlineCount":)" + std::to_string(onlineCount) + R"(}})";
+}
+
+// Background thread: collects changes for PRESENCE_BATCH_MS, drops users that
+// flapped back to their previous status, and pushes each subscriber one delta
+// holding the changes of the contacts it watches
+void presencePublisher() {
+    while (running) {
+        {
+            std::unique_lock<std::mutex> lock(presenceMutex);
+            presenceCv.wait(lock, [] { return !pendingPresence.empty() || !running; });
+            if (!running) return;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(PRESENCE_BATCH_MS));
+
+        std::unordered_map<std::string, PendingPresence> batch;
+        {
+            std::lock_guard<std::mutex> lock(presenceMutex);
+            batch.swap(pendingPresence);
+        }
+
+        std::vector<std::pair<std::string, std::string>> changes;  // userId -> JSON entry
+        for (const auto& pair : batch) {
+            if (pair.second.before == pair.second.now) continue;
+            changes.emplace_back(pair.first, R"({"userId":")" + pair.first + R"(","status":")" +
+                                 (pair.second.now ? "online" : "offline") + R"("})");
+        }
+        if (changes.empty()) continue;
+
+        std::vector<std::string> everyone;
+        std::map<std::string, std::vector<const std::string*>> watched;  // subscriber -> entries
+        {
+            std::lock_guard<std::mutex> lock(presenceMutex);
+            everyone.assign(presenceWatchAll.begin(), presenceWatchAll.end());
+            for (const auto& change : changes) {
+                auto it = presenceWatchers.find(change.first);
+                if (it == presenceWatchers.end()) continue;
+                for (const std::string& subscriber : it->second) {
+                    if (!presenceWatchAll.count(subscriber)) watched[subscriber].push_back(&change.second);
+                }
+            }
+        }
+        size_t onlineCount = users.presence().onlineCount();
+
+        if (!everyone.empty()) {
+            std::vector<const std::string*> all;
+            for (const auto& change : changes) all.push_back(&change.second);
+            // Nothing to tell a user whose own status is the only change
+            pushToUsers(everyone, changes.size() == 1 ? changes[0].first : "",
+                        makeFrame(presenceNotification(all, onlineCount)));
+        }
+        for (const auto& pair : watched) {
+            sendPushToUser(pair.first, presenceNotification(pair.second, onlineCount));
+        }
+    }
+}
+
+// Background thread: waits SIGNAL_BATCH_MS after the first signal so bursts
+// collapse to their latest state, then queues each on the outboxes' signal lane
+void signalPublisher() {
+    while (running) {
+        {
+            std::unique_lock<std::mutex> lock(signalsMutex);
+            signalsCv.wait(lock, [] { return !pendingSignals.empty() || !running; });
+            if (!running) return;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(SIGNAL_BATCH_MS));
+
+        std::map<std::string, PendingSignal> batch;
+        {
+            std::lock_guard<std::mutex> lock(signalsMutex);
+            batch.swap(pendingSignals);
+        }
+
+        for (const auto& pair : batch) {
+            pushSignalToUsers(*pair.second.recipients, pair.second.skipUserId, pair.first,
+                              makeFrame(pair.second.message));
+        }
+    }
+}
+
+// Seal the chat log for compaction and snapshot the read flags it needs,
+// and which channel messages are still held, taking chatMutex (channelMutex)
+// for about CHAT_COMPACT_SNAPSHOT messages at a time so senders never wait
+// on more than a short slice; false if a compaction is already running
+bool beginChatCompaction(ChatLog::Compaction& compaction) {
+    if (!chatLog->beginCompaction(compaction)) return false;
+    std::vector<std::string> keys;
+    {
+        std::lock_guard<std::mutex> lock(chatMutex);
+        keys = chatStore.conversationKeys();
+    }
+    for (size_t i = 0; i < keys.size();) {
+        std::lock_guard<std::mutex> lock(chatMutex);
+        for (size_t taken = 0; i < keys.size() && taken < CHAT_COMPACT_SNAPSHOT; ++i) {
+            taken += chatStore.readStates(keys[i], compaction.live);
+        }
+    }
+
+    std::vector<std::string> channelIds;
+    {
+        std::lock_guard<std::mutex> lock(channelMutex);
+        channelIds = channels.channelIds();
+    }
+    for (size_t i = 0; i < channelIds.size();) {
+        std::lock_guard<std::mutex> lock(channelMutex);
+        for (size_t taken = 0; i < channelIds.size() && taken < CHAT_COMPACT_SNAPSHOT; ++i) {
+            taken += channels.messageIds(channelIds[i], compaction.live);
+        }
+    }
+    return true;
+}
+
+// Periodically drop deleted messages and folded read markers from the chat log
+void chatLogCompactor() {
+    while (running) {
+        std::this_thread::sleep_for(std::chrono::seconds(CHAT_COMPACT_CHECK_SEC));
+        if (!chatLog->needsCompaction()) continue;
+
+        ChatLog::Compaction compaction;
+        if (!beginChatCompaction(compaction)) continue;
+        chatLog->compact(compaction);
+        std::cout << "[INFO] Chat log compacted" << std::endl;
+    }
+}
+
+// Move read messages older than the retention window, and channel messages
+// beyond each channel's newest CHANNEL_HOT_MESSAGES, to the cold store, then
+// compact the chat log so it stops carrying them. The archive is durable
+// before anything leaves chatStore or channels; returns the number moved.
+size_t archiveChat() {
+    std::vector<ChatMessage> batch;
+    {
+        std::lock_guard<std::mutex> lock(chatMutex);
+        batch = chatStore.archivable(getCurrentTimestamp() - chatRetentionMs);
+    }
+    std::vector<ChatMessage> channelBatch;
+    {
+        std::lock_guard<std::mutex> lock(channelMutex);
+        channelBatch = channels.archivable(CHANNEL_HOT_MESSAGES);
+    }
+    if (!coldStore->archive(batch)) batch.clear();
+    if (!coldStore->archive(channelBatch, &ColdStore::channelKey)) channelBatch.clear();
+    if (batch.empty() && channelBatch.empty()) return 0;
+
+    // Evict exactly what was archived, even if more became eligible meanwhile
+    std::unordered_map<std::string, std::string> newest;
+    for (const ChatMessage& msg : batch) {
+        newest[ChatStore::conversationKey(msg.senderId, msg.recipientId)] = msg.messageId;
+    }
+    std::unordered_map<std::string, std::string> newestInChannel;
+    for (const ChatMessage& msg : channelBatch) newestInChannel[msg.recipientId] = msg.messageId;
+    size_t evicted = 0;
+    {
+        std::lock_guard<std::mutex> lock(chatMutex);
+        for (const auto& pair : newest) evicted += chatStore.evictThrough(pair.first, pair.second);
+    }
+    {
+        std::lock_guard<std::mutex> lock(channelMutex);
+        for (const auto& pair : newestInChannel) evicted += channels.evictThrough(pair.first, pair.second);
+    }
+    // Search covers the hot tier only
+    std::vector<std::string> archivedIds;
+    for (const ChatMessage& msg : batch) archivedIds.push_back(msg.messageId);
+    for (const ChatMessage& msg : channelBatch) archivedIds.push_back(msg.messageId);
+    {
+        std::lock_guard<std::mutex> lock(chatIndexMutex);
+        chatIndex.remove(archivedIds);
+    }
+    // If a compaction is already running, the next one drops the evicted
+    // messages from the log
+    ChatLog::Compaction compaction;
+    if (beginChatCompaction(compaction)) chatLog->compact(compaction);
+    return evicted;
+}
+
+void chatArchiver() {
+    while (running) {
+        std::this_thread::sleep_for(std::chrono::seconds(CHAT_ARCHIVE_CHECK_SEC));
+        size_t moved = archiveChat();
+        if (moved > 0) std::cout << "[INFO] Chat archive: moved " << moved << " messages to cold storage" << std::endl;
+    }
+}
+
+// Background thread: folds queued messages into the search index every
+// CHAT_INDEX_BATCH_MS, so senders never tokenize or wait behind a search
+void chatIndexer() {
+    while (running) {
+        {
+            std::unique_lock<std::mutex> lock(indexQueueMutex);
+            indexCv.wait(lock, [] { return !pendingIndex.empty() || !running; });
+            if (!running) return;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(CHAT_INDEX_BATCH_MS));
+
+        std::vector<PendingIndex> batch;
+        {
+            std::lock_guard<std::mutex> lock(indexQueueMutex);
+            batch.swap(pendingIndex);
+        }
+
+        std::lock_guard<std::mutex> lock(chatIndexMutex);
+        for (const PendingIndex& pending : batch) chatIndex.add(pending.message, pending.scope);
     }
 }
 
@@ -3441,27 +4558,29 @@ std::string handleVoiceCallInitiate(const std::string& json) {
     }
 
     // Check if receiver exists and is online
-    User* receiver = nullptr;
+    bool receiverFound = false;
+    bool receiverOnline = false;
+    std::string receiverName;
     std::string callerName;
     {
-        std::lock_guard<std::mutex> lock(usersMutex);
-        auto it = userById.find(receiverId);
-        if (it != userById.end()) {
-            receiver = it->second;
+        EpochGuard guard;
+        if (const User* receiver = users.getById(receiverId)) {
+            receiverFound = true;
+            receiverOnline = receiver->online;
+            receiverName = receiver->fullname;
         }
-        auto callerIt = userById.find(callerId);
-        if (callerIt != userById.end()) {
-            callerName = callerIt->second->fullname;
+        if (const User* caller = users.getById(callerId)) {
+            callerName = caller->fullname;
         }
     }
 
-    if (!receiver) {
+    if (!receiverFound) {
         return R"({"messageType":"VOICE_CALL_INITIATE_RESPONSE","messageId":")" + messageId +
                R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
                R"(,"payload":{"status":"error","message":"Receiver not found"}})";
     }
 
-    if (!receiver->online) {
+    if (!receiverOnline) {
         return R"({"messageType":"VOICE_CALL_INITIATE_RESPONSE","messageId":")" + messageId +
                R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
                R"(,"payload":{"status":"error","message":"Receiver is offline"}})";
@@ -3512,7 +4631,7 @@ std::string handleVoiceCallInitiate(const std::string& json) {
            R"(","timestamp":)" + std::to_string(getCurrentTimestamp()) +
            R"(,"payload":{"status":"success","data":{"callId":")" + call.callId +
            R"(","receiverId":")" + receiverId +
-           R"(","receiverName":")" + escapeJson(receiver->fullname) +
+           R"(","receiverName":")" + escapeJson(receiverName) +
            R"(","callStatus":"pending"}}})";
 }
 
@@ -3566,11 +4685,11 @@ std::string handleVoiceCallAccept(const std::string& json) {
 
     // Get names
     {
-        std::lock_guard<std::mutex> lock(usersMutex);
-        auto callerIt = userById.find(call->callerId);
-        if (callerIt != userById.end()) callerName = callerIt->second->fullname;
-        auto receiverIt = userById.find(call->receiverId);
-        if (receiverIt != userById.end()) receiverName = receiverIt->second->fullname;
+        EpochGuard guard;
+        const User* caller = users.getById(call->callerId);
+        if (caller) callerName = caller->fullname;
+        const User* receiver = users.getById(call->receiverId);
+        if (receiver) receiverName = receiver->fullname;
     }
 
     // Notify caller
@@ -3638,9 +4757,9 @@ std::string handleVoiceCallReject(const std::string& json) {
 
     // Get caller name
     {
-        std::lock_guard<std::mutex> lock(usersMutex);
-        auto callerIt = userById.find(call->callerId);
-        if (callerIt != userById.end()) callerName = callerIt->second->fullname;
+        EpochGuard guard;
+        const User* caller = users.getById(call->callerId);
+        if (caller) callerName = caller->fullname;
     }
 
     // Notify caller
@@ -3754,11 +4873,11 @@ std::string handleVoiceCallGetStatus(const std::string& json) {
 
     std::string callerName, receiverName;
     {
-        std::lock_guard<std::mutex> lock(usersMutex);
-        auto callerIt = userById.find(call.callerId);
-        if (callerIt != userById.end()) callerName = callerIt->second->fullname;
-        auto receiverIt = userById.find(call.receiverId);
-        if (receiverIt != userById.end()) receiverName = receiverIt->second->fullname;
+        EpochGuard guard;
+        const User* caller = users.getById(call.callerId);
+        if (caller) callerName = caller->fullname;
+        const User* receiver = users.getById(call.receiverId);
+        if (receiver) receiverName = receiver->fullname;
     }
 
     std::string statusStr = english_learning::core::voiceCallStatusToString(call.status);
@@ -3788,9 +4907,27 @@ void handleClient(int clientSocket, struct sockaddr_in clientAddr) {
 
     std::cout << "[INFO] New connection from " << clientInfo << std::endl;
 
+    auto outbox = std::make_shared<Outbox>(clientSocket, OUTBOX_CAPACITY);
+    {
+        std::lock_guard<std::mutex> lock(outboxesMutex);
+        outboxes[clientSocket] = outbox;
+    }
+
     char buffer[BUFFER_SIZE];
 
     while (running) {
+        // Wait for the next request, writing out pushes queued meanwhile
+        struct pollfd fds[2] = {{clientSocket, POLLIN, 0}, {outbox->wakeFd(), POLLIN, 0}};
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if ((fds[1].revents & POLLIN) && !outbox->flush()) {
+            std::cout << "[INFO] Client " << clientInfo << " disconnected" << std::endl;
+            break;
+        }
+        if (!(fds[0].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+
         uint32_t msgLen = 0;
         ssize_t bytesRead = recv(clientSocket, &msgLen, sizeof(msgLen), MSG_WAITALL);
 
@@ -3819,7 +4956,26 @@ void handleClient(int clientSocket, struct sockaddr_in clientAddr) {
         std::string messageType = getJsonValue(message, "messageType");
         std::string response;
 
-        if (messageType == "REGISTER_REQUEST") {
+        // Admission control: refuse before any handler parses the payload.
+        // The slot is held only while the handler runs, not while sending
+        Requester requester = identifyRequester(getJsonValue(message, "sessionToken"), clientInfo);
+        FairScheduler::Slot slot;
+        bool busy = false;
+        int64_t retryAfterMs = rateLimiter.acquire(requester.bucketKey, requester.role, messageType,
+                                                   getCurrentTimestamp());
+        if (retryAfterMs == 0) {
+            slot = admission->admit(requester.userKey, std::chrono::milliseconds(ADMISSION_QUEUE_MS));
+            busy = !slot;
+            if (busy) retryAfterMs = ADMISSION_QUEUE_MS;
+        }
+        bool fireAndForget = messageType == "INBOX_ACK" || messageType == "TYPING" ||
+                             messageType == "LESSON_PROGRESS_UPDATE";
+        if (retryAfterMs > 0 && fireAndForget) continue;
+
+        if (retryAfterMs > 0) {
+            response = buildRateLimited(message, messageType, retryAfterMs, busy);
+        }
+        else if (messageType == "REGISTER_REQUEST") {
             response = handleRegister(message);
         }
         else if (messageType == "LOGIN_REQUEST") {
@@ -3832,8 +4988,18 @@ void handleClient(int clientSocket, struct sockaddr_in clientAddr) {
         else if (messageType == "GET_LESSONS_REQUEST") {
             response = handleGetLessons(message);
         }
+        else if (messageType == "SYNC_CATALOG_REQUEST") {
+            response = handleSyncCatalog(message, clientSocket);
+        }
         else if (messageType == "GET_LESSON_DETAIL_REQUEST") {
-            response = handleGetLessonDetail(message);
+            response = handleGetLessonDetail(message, clientSocket);
+        }
+        else if (messageType == "LESSON_PROGRESS_UPDATE") {
+            handleLessonProgressUpdate(message);
+            continue;  // fire-and-forget
+        }
+        else if (messageType == "SEARCH_CONTENT_REQUEST") {
+            response = handleSearchContent(message);
         }
         else if (messageType == "GET_TEST_REQUEST") {
             response = handleGetTest(message);
@@ -3887,6 +5053,9 @@ void handleClient(int clientSocket, struct sockaddr_in clientAddr) {
         else if (messageType == "GET_CONTACT_LIST_REQUEST") {
             response = handleGetContactList(message);
         }
+        else if (messageType == "SEARCH_CONTACTS_REQUEST") {
+            response = handleSearchContacts(message);
+        }
         else if (messageType == "SEND_MESSAGE_REQUEST") {
             response = handleSendMessage(message, clientSocket);
         }
@@ -3908,6 +5077,41 @@ void handleClient(int clientSocket, struct sockaddr_in clientAddr) {
         else if (messageType == "GET_ADMIN_GAMES_REQUEST") {
             response = handleGetAdminGames(message);
         }
+        else if (messageType == "RELOAD_CONTENT_REQUEST") {
+            response = handleReloadContent(message);
+        }
+        else if (messageType == "INBOX_ACK") {
+            handleInboxAck(message);
+            continue;  // acknowledgements get no response
+        }
+        else if (messageType == "TYPING") {
+            handleTyping(message);
+            continue;  // fire-and-forget
+        }
+        else if (messageType == "CREATE_CHANNEL_REQUEST") {
+            response = handleCreateChannel(message);
+        }
+        else if (messageType == "GET_CHANNELS_REQUEST") {
+            response = handleGetChannels(message);
+        }
+        else if (messageType == "SEND_CHANNEL_MESSAGE_REQUEST") {
+            response = handleSendChannelMessage(message);
+        }
+        else if (messageType == "GET_CHANNEL_HISTORY_REQUEST") {
+            response = handleGetChannelHistory(message);
+        }
+        else if (messageType == "SEARCH_CHAT_REQUEST") {
+            response = handleSearchChat(message);
+        }
+        else if (messageType == "START_UPLOAD_REQUEST") {
+            response = handleStartUpload(message);
+        }
+        else if (messageType == "UPLOAD_CHUNK_REQUEST") {
+            response = handleUploadChunk(message);
+        }
+        else if (messageType == "GET_ATTACHMENT_REQUEST") {
+            response = handleGetAttachment(message);
+        }
         else if (messageType == "MARK_MESSAGES_READ_REQUEST") {
             response = handleMarkMessagesRead(message);
         }
@@ -3932,6 +5136,7 @@ void handleClient(int clientSocket, struct sockaddr_in clientAddr) {
                        std::to_string(getCurrentTimestamp()) +
                        R"(,"payload":{"status":"error","message":"Unknown message type"}})";
         }
+        slot.release();
 
         uint32_t respLen = htonl(response.length());
         send(clientSocket, &respLen, sizeof(respLen), 0);
@@ -3941,6 +5146,7 @@ void handleClient(int clientSocket, struct sockaddr_in clientAddr) {
     }
 
     // Cleanup
+    std::string uid;
     {
         std::lock_guard<std::mutex> lock(sessionsMutex);
         auto it = clientSessions.find(clientSocket);
@@ -3948,17 +5154,28 @@ void handleClient(int clientSocket, struct sockaddr_in clientAddr) {
             std::string token = it->second;
             auto sessionIt = sessions.find(token);
             if (sessionIt != sessions.end()) {
-                std::string uid = sessionIt->second.userId;
+                uid = sessionIt->second.userId;
                 std::lock_guard<std::mutex> userLock(usersMutex);
-                auto userIt = userById.find(uid);
-                if (userIt != userById.end()) {
-                    userIt->second->online = false;
-                    userIt->second->clientSocket = -1;
-                }
+                users.modify(users.findById(uid), [](User& user) {
+                    user.online = false;
+                    user.clientSocket = -1;
+                });
+
+                std::lock_guard<std::mutex> presenceLock(presenceMutex);
+                unwatchPresence(uid);
             }
             clientSessions.erase(it);
         }
     }
+    if (!uid.empty()) {
+        // Later messages wait in the inbox until the user reconnects
+        std::lock_guard<std::mutex> lock(inboxMutex);
+        inbox.detach(uid, clientSocket);
+    }
+    {
+        std::lock_guard<std::mutex> lock(outboxesMutex);
+        outboxes.erase(clientSocket);
+    }
 
     close(clientSocket);
 }
@@ -3970,6 +5187,10 @@ void handleClient(int clientSocket, struct sockaddr_in clientAddr) {
 void signalHandler(int signal) {
     std::cout << "\n[INFO] Shutting down server..." << std::endl;
     running = false;
+    // Wake the batching threads so they see running and return
+    presenceCv.notify_all();
+    signalsCv.notify_all();
+    indexCv.notify_all();
     if (serverSocket >= 0) {
         close(serverSocket);
     }
@@ -3987,18 +5208,75 @@ int main(int argc, char* argv[]) {
     signal(SIGPIPE, SIG_IGN);
 
     initSampleData();
+    reloadContent(false);
+    std::thread(contentWatcher).detach();
+
+    for (const auto& limit : RATE_LIMITS) {
+        rateLimiter.setLimit(limit.role, limit.messageType, {limit.perSecond, limit.burst});
+    }
+    admission = new FairScheduler(std::max(4u, ADMISSION_SLOTS_PER_CORE * std::thread::hardware_concurrency()));
+
+    attachmentStore = new english_learning::storage::AttachmentStore(
+        ATTACHMENT_DIR, ATTACHMENT_MAX_BYTES, std::chrono::seconds(ATTACHMENT_UPLOAD_IDLE_SEC));
+    attachmentStore->open();
+
+    // Restore chat history from the write-ahead log before accepting clients
+    chatLog = new english_learning::storage::ChatLog(CHAT_LOG_DIR,
+                                                     std::chrono::milliseconds(CHAT_COMMIT_INTERVAL_MS));
+    size_t replayed = chatLog->open(chatStore, channels);
+
+    // Older history lives in the archive. A crash between archiving and
+    // evicting leaves messages in both tiers; the archive wins.
+    if (const char* days = std::getenv("CHAT_HOT_RETENTION_DAYS")) {
+        chatRetentionMs = static_cast<int64_t>(std::atof(days) * 24 * 3600 * 1000);
+    }
+    coldStore = new english_learning::storage::ColdStore(CHAT_COLD_DIR);
+    size_t archived = coldStore->open();
+    for (const auto& pair : coldStore->newestIds()) {
+        if (ColdStore::isChannelKey(pair.first)) {
+            channels.evictThrough(pair.first.substr(1), pair.second);
+        } else {
+            chatStore.evictThrough(pair.first, pair.second);
+        }
+    }
+
+    progressLog = new english_learning::storage::ProgressLog(PROGRESS_DIR);
+    size_t progressRecords = progressLog->open(progressStore);
+    std::thread(progressFlusher).detach();
+    std::cout << "[INFO] Lesson progress: replayed " << progressRecords << " records, "
+              << progressStore.size() << " lessons in progress" << std::endl;
+
+    inboxEpoch = getCurrentTimestamp();
+    catalogEpoch = inboxEpoch;
+    chatStore.setJournal(chatLog);
+    channels.setJournal(chatLog);
+    initChannels();   // level channels and members already replayed are kept as they are
+    size_t moved = archiveChat();   // catch up on whatever aged while the server was down
+    std::thread(chatLogCompactor).detach();
+    std::thread(chatArchiver).detach();
+    std::cout << "[INFO] Chat log: replayed " << replayed << " records, "
+              << chatStore.size() << " messages in memory, "
+              << archived + moved << " archived" << std::endl;
+
+    // Index recovered history up front (archived messages are not searched);
+    // new messages arrive through chatIndexer
+    for (const ChatMessage& msg : chatStore.all()) chatIndex.add(msg, ChatIndex::Scope::Direct);
+    for (const ChatMessage& msg : channels.all()) chatIndex.add(msg, ChatIndex::Scope::Channel);
+    std::thread(chatIndexer).detach();
+    std::cout << "[INFO] Chat search index: " << chatIndex.size() << " messages, "
+              << chatIndex.termCount() << " terms" << std::endl;
 
     // ========================================================================
     // INITIALIZE SERVICE LAYER
     // ========================================================================
     // Create bridge repositories that wrap the global data structures
-    static bridge::BridgeUserRepository userRepo(users, userById, usersMutex);
+    static bridge::BridgeUserRepository userRepo(users, usersMutex);
     static bridge::BridgeSessionRepository sessionRepo(sessions, clientSessions, sessionsMutex);
-    static bridge::BridgeLessonRepository lessonRepo(lessons);
-    static bridge::BridgeTestRepository testRepo(tests);
-    static bridge::BridgeChatRepository chatRepo(chatMessages, chatMutex);
-    static bridge::BridgeExerciseRepository exerciseRepo(exercises, exerciseSubmissions, exercisesMutex);
-    static bridge::BridgeGameRepository gameRepo(games, gameSessions, gamesMutex);
+    static bridge::BridgeLessonRepository lessonRepo(catalog);
+    static bridge::BridgeTestRepository testRepo(catalog);
+    static bridge::BridgeChatRepository chatRepo(chatStore, chatMutex);
+    static bridge::BridgeExerciseRepository exerciseRepo(catalog, exerciseSubmissions, exercisesMutex);
+    static bridge::BridgeGameRepository gameRepo(catalog, gameSessions, gamesMutex);
     static bridge::BridgeVoiceCallRepository voiceCallRepo(voiceCalls, voiceCallMutex);
 
     // Create service container with dependency injection
@@ -4006,6 +5284,23 @@ int main(int argc, char* argv[]) {
         userRepo, sessionRepo, lessonRepo, testRepo, chatRepo, exerciseRepo, gameRepo, voiceCallRepo);
 
     std::cout << "[INFO] Service layer initialized" << std::endl;
+
+    // Presence changes are batched and pushed from a background thread
+    users.setPresenceListener(queuePresenceChange);
+    std::thread(presencePublisher).detach();
+    std::thread(signalPublisher).detach();
+
+    // Lesson media is streamed over HTTP on a port of its own; without it
+    // lessons still work, with their media sources passed through as they are
+    static english_learning::net::MediaServer mediaServer(resolveMedia, MEDIA_MAX_STREAMS, MEDIA_IDLE_MS);
+    std::string mediaError;
+    if (mediaServer.start(port + MEDIA_PORT_OFFSET, mediaError)) {
+        mediaPort = mediaServer.port();
+        std::cout << "[INFO] Media server on port " << mediaPort << ", serving " << MEDIA_DIR << std::endl;
+    } else {
+        std::cerr << "[WARN] Media server disabled, cannot listen on port " << port + MEDIA_PORT_OFFSET << ": "
+                  << mediaError << std::endl;
+    }
     // ========================================================================
 
     serverSocket = socket(AF_INET, SOCK_STREAM, 0);
@@ -4046,7 +5341,11 @@ int main(int argc, char* argv[]) {
     std::cout << "  - student2@example.com / student123" << std::endl;
     std::cout << "  - sarah@example.com / teacher123" << std::endl;
     std::cout << "--------------------------------------------" << std::endl;
-    std::cout << "Lessons: " << lessons.size() << " | Tests: " << tests.size() << std::endl;
+    {
+        EpochGuard guard;
+        const ContentCatalog& snapshot = catalog.read();
+        std::cout << "Lessons: " << snapshot.lessons.size() << " | Tests: " << snapshot.tests.size() << std::endl;
+    }
     std::cout << "--------------------------------------------" << std::endl;
 
     while (running) {
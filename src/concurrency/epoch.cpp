@@ -0,0 +1,112 @@
+#include "epoch.h"
+
+#include <limits>
+#include <thread>
+
+namespace english_learning {
+namespace concurrency {
+
+/**
+ * Per-thread reader registration. A slot is claimed when the outermost read
+ * section starts and handed back when it ends; the thread tries the same
+ * slot first next time.
+ */
+struct EpochDomain::ThreadState {
+    ReaderSlot* slot = nullptr;     // held while depth > 0
+    ReaderSlot* last = nullptr;     // slot of the previous read section
+    int depth = 0;
+};
+
+EpochDomain& EpochDomain::global() {
+    static EpochDomain domain;
+    return domain;
+}
+
+EpochDomain::ThreadState& EpochDomain::threadState() {
+    static thread_local ThreadState state;
+    return state;
+}
+
+EpochDomain::ReaderSlot* EpochDomain::acquireSlot(ReaderSlot* hint) {
+    bool expected = false;
+    if (hint && hint->inUse.compare_exchange_strong(expected, true)) return hint;
+    while (true) {
+        for (auto& slot : readers_) {
+            bool expected = false;
+            if (!slot.inUse.load(std::memory_order_relaxed) &&
+                slot.inUse.compare_exchange_strong(expected, true)) {
+                return &slot;
+            }
+        }
+        // More threads inside read sections than slots: wait for one to leave
+        std::this_thread::yield();
+    }
+}
+
+void EpochDomain::enter() {
+    ThreadState& state = threadState();
+    if (state.depth++ > 0) return;
+    state.slot = acquireSlot(state.last);
+    // seq_cst store: a writer that does not see this store unlinked its
+    // object before we load any shared pointer
+    state.slot->epoch.store(globalEpoch_.load());
+}
+
+void EpochDomain::exit() {
+    ThreadState& state = threadState();
+    if (--state.depth > 0) return;
+    state.slot->epoch.store(0, std::memory_order_release);
+    state.slot->inUse.store(false, std::memory_order_release);
+    state.last = state.slot;
+    state.slot = nullptr;
+}
+
+void EpochDomain::retire(std::function<void()> deleter) {
+    {
+        std::lock_guard<std::mutex> lock(retireMutex_);
+        limbo_.push_back({globalEpoch_.load(), std::move(deleter)});
+    }
+    collect();
+}
+
+uint64_t EpochDomain::minActiveEpoch() const {
+    uint64_t minEpoch = std::numeric_limits<uint64_t>::max();
+    for (const auto& slot : readers_) {
+        uint64_t e = slot.epoch.load();
+        if (e != 0 && e < minEpoch) minEpoch = e;
+    }
+    return minEpoch;
+}
+
+void EpochDomain::collect() {
+    std::vector<Retired> ready;
+    {
+        std::lock_guard<std::mutex> lock(retireMutex_);
+        if (limbo_.empty()) return;
+
+        globalEpoch_.fetch_add(1);
+        uint64_t safe = minActiveEpoch();
+
+        auto keep = limbo_.begin();
+        for (auto it = limbo_.begin(); it != limbo_.end(); ++it) {
+            if (it->epoch < safe) {
+                ready.push_back(std::move(*it));
+            } else {
+                if (keep != it) *keep = std::move(*it);
+                ++keep;
+            }
+        }
+        limbo_.erase(keep, limbo_.end());
+    }
+
+    // Run destructors outside the lock; they may retire further objects
+    for (auto& r : ready) r.deleter();
+}
+
+size_t EpochDomain::pending() const {
+    std::lock_guard<std::mutex> lock(retireMutex_);
+    return limbo_.size();
+}
+
+} // namespace concurrency
+} // namespace english_learning
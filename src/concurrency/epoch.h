@@ -0,0 +1,97 @@
+#ifndef ENGLISH_LEARNING_CONCURRENCY_EPOCH_H
+#define ENGLISH_LEARNING_CONCURRENCY_EPOCH_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace english_learning {
+namespace concurrency {
+
+/**
+ * Epoch-based memory reclamation.
+ *
+ * Readers pin the current epoch with an EpochGuard while they dereference
+ * shared objects. Writers unlink an object, then retire() it; the object is
+ * destroyed only once every reader that was active at retire time has left.
+ * A reader holds one of MAX_READERS slots only while inside its outermost
+ * read section, so any number of threads may read, MAX_READERS at a time.
+ * Read side cost is a compare-and-swap on the slot the thread used last
+ * (uncontended in practice) and two stores, no locks.
+ */
+class EpochDomain {
+public:
+    static constexpr size_t MAX_READERS = 256;
+
+    // Process-wide domain shared by all RCU containers
+    static EpochDomain& global();
+
+    // Called by EpochGuard; nested calls on the same thread are counted
+    void enter();
+    void exit();
+
+    // Defer destruction until no reader can still observe the object
+    void retire(std::function<void()> deleter);
+
+    template <typename T>
+    void retire(const T* ptr) {
+        if (ptr) retire([ptr]() { delete ptr; });
+    }
+
+    // Advance the epoch and destroy everything no reader can reach
+    void collect();
+
+    // Number of retired objects waiting for readers to move on
+    size_t pending() const;
+
+    EpochDomain(const EpochDomain&) = delete;
+    EpochDomain& operator=(const EpochDomain&) = delete;
+
+private:
+    EpochDomain() = default;
+
+    struct alignas(64) ReaderSlot {
+        std::atomic<uint64_t> epoch{0};     // 0 = not inside a read section
+        std::atomic<bool> inUse{false};
+    };
+
+    struct Retired {
+        uint64_t epoch;
+        std::function<void()> deleter;
+    };
+
+    struct ThreadState;
+    static ThreadState& threadState();
+
+    ReaderSlot* acquireSlot(ReaderSlot* hint);
+    uint64_t minActiveEpoch() const;
+
+    std::atomic<uint64_t> globalEpoch_{1};
+    ReaderSlot readers_[MAX_READERS];
+
+    mutable std::mutex retireMutex_;
+    std::vector<Retired> limbo_;
+};
+
+/**
+ * RAII read-side critical section. Pointers obtained from RCU containers
+ * stay valid until the guard goes out of scope.
+ */
+class EpochGuard {
+public:
+    EpochGuard() : domain_(EpochDomain::global()) { domain_.enter(); }
+    ~EpochGuard() { domain_.exit(); }
+
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard& operator=(const EpochGuard&) = delete;
+
+private:
+    EpochDomain& domain_;
+};
+
+} // namespace concurrency
+} // namespace english_learning
+
+#endif // ENGLISH_LEARNING_CONCURRENCY_EPOCH_H
@@ -0,0 +1,282 @@
+#ifndef ENGLISH_LEARNING_CONCURRENCY_RCU_H
+#define ENGLISH_LEARNING_CONCURRENCY_RCU_H
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "epoch.h"
+
+namespace english_learning {
+namespace concurrency {
+
+/**
+ * Read-copy-update cell holding an immutable T.
+ * Readers call read() inside an EpochGuard; writers copy the current value,
+ * modify the copy and publish it. The previous version is retired to the
+ * epoch domain and freed once no reader can still see it.
+ */
+template <typename T>
+class RcuCell {
+public:
+    RcuCell() : current_(new T()) {}
+    explicit RcuCell(T initial) : current_(new T(std::move(initial))) {}
+    ~RcuCell() { delete current_.load(); }
+
+    RcuCell(const RcuCell&) = delete;
+    RcuCell& operator=(const RcuCell&) = delete;
+
+    // Caller must hold an EpochGuard while using the returned reference
+    const T& read() const { return *current_.load(std::memory_order_acquire); }
+
+    // Copy-on-write update; fn receives a private copy and may return a value
+    template <typename Fn>
+    auto update(Fn&& fn) {
+        std::lock_guard<std::mutex> lock(writeMutex_);
+        const T* old = current_.load(std::memory_order_relaxed);
+        T* next = new T(*old);
+        if constexpr (std::is_void_v<decltype(fn(*next))>) {
+            fn(*next);
+            publish(old, next);
+        } else {
+            auto result = fn(*next);
+            publish(old, next);
+            return result;
+        }
+    }
+
+    // Replace the whole value
+    void store(T value) {
+        std::lock_guard<std::mutex> lock(writeMutex_);
+        publish(current_.load(std::memory_order_relaxed), new T(std::move(value)));
+    }
+
+private:
+    void publish(const T* old, T* next) {
+        current_.store(next);
+        EpochDomain::global().retire(old);
+    }
+
+    std::atomic<const T*> current_;
+    std::mutex writeMutex_;
+};
+
+/**
+ * Catalog map with lock-free readers.
+ * Records are shared immutable objects, so publishing a new map version
+ * copies only pointers; unchanged records are shared between versions.
+ */
+template <typename K, typename V>
+class RcuMap {
+public:
+    using Map = std::map<K, std::shared_ptr<const V>>;
+
+    // Caller must hold an EpochGuard while using the returned reference
+    const Map& snapshot() const { return cell_.read(); }
+
+    // Caller must hold an EpochGuard; nullptr if absent
+    const V* find(const K& key) const {
+        const Map& m = cell_.read();
+        auto it = m.find(key);
+        return it != m.end() ? it->second.get() : nullptr;
+    }
+
+    // Self-guarded convenience reads
+    std::optional<V> get(const K& key) const {
+        EpochGuard guard;
+        if (const V* v = find(key)) return *v;
+        return std::nullopt;
+    }
+
+    bool contains(const K& key) const {
+        EpochGuard guard;
+        return cell_.read().count(key) > 0;
+    }
+
+    size_t size() const {
+        EpochGuard guard;
+        return cell_.read().size();
+    }
+
+    bool empty() const { return size() == 0; }
+
+    // Insert only if absent
+    bool insert(const K& key, V value) {
+        auto record = std::make_shared<const V>(std::move(value));
+        return cell_.update([&](Map& m) { return m.emplace(key, record).second; });
+    }
+
+    // Insert or overwrite
+    void put(const K& key, V value) {
+        auto record = std::make_shared<const V>(std::move(value));
+        cell_.update([&](Map& m) { m[key] = record; });
+    }
+
+    // Overwrite only if present
+    bool replace(const K& key, V value) {
+        auto record = std::make_shared<const V>(std::move(value));
+        return cell_.update([&](Map& m) {
+            auto it = m.find(key);
+            if (it == m.end()) return false;
+            it->second = record;
+            return true;
+        });
+    }
+
+    // Copy a record, let fn edit it and publish the new version
+    template <typename Fn>
+    bool modify(const K& key, Fn&& fn) {
+        return cell_.update([&](Map& m) {
+            auto it = m.find(key);
+            if (it == m.end()) return false;
+            V copy = *it->second;
+            fn(copy);
+            it->second = std::make_shared<const V>(std::move(copy));
+            return true;
+        });
+    }
+
+    bool erase(const K& key) {
+        return cell_.update([&](Map& m) { return m.erase(key) > 0; });
+    }
+
+    // Swap in an entirely new catalog
+    void assign(Map m) { cell_.store(std::move(m)); }
+
+private:
+    RcuCell<Map> cell_;
+};
+
+/**
+ * Hash map with lock-free readers and O(1) writes.
+ *
+ * Unlike RcuCell<std::unordered_map>, a write does not copy the map: each
+ * bucket is a chain of immutable nodes, and a writer links in a new head
+ * (or copies the few nodes ahead of the one it unlinks) and retires what it
+ * replaced. The bucket array doubles once there are more entries than
+ * buckets; that rebuild is the only O(N) step, so bulk loads stay linear.
+ */
+template <typename K, typename V, typename Hash = std::hash<K>>
+class RcuHashMap {
+public:
+    RcuHashMap() : table_(new Table(INITIAL_BUCKETS)) {}
+    ~RcuHashMap() { destroy(table_.load()); }
+
+    RcuHashMap(const RcuHashMap&) = delete;
+    RcuHashMap& operator=(const RcuHashMap&) = delete;
+
+    // Caller must hold an EpochGuard while using the returned pointer; nullptr if absent
+    const V* find(const K& key) const {
+        const Table* table = table_.load(std::memory_order_acquire);
+        const Node* node = table->buckets[Hash()(key) & table->mask].load(std::memory_order_acquire);
+        for (; node; node = node->next) {
+            if (node->key == key) return &node->value;
+        }
+        return nullptr;
+    }
+
+    // Insert or overwrite
+    void put(const K& key, V value) {
+        std::lock_guard<std::mutex> lock(writeMutex_);
+        unlink(key);
+        Table* table = table_.load(std::memory_order_relaxed);
+        if (count_ >= table->mask + 1) table = grow(table);
+        std::atomic<const Node*>& bucket = table->buckets[Hash()(key) & table->mask];
+        bucket.store(new Node{key, std::move(value), bucket.load(std::memory_order_relaxed)},
+                     std::memory_order_release);
+        count_++;
+    }
+
+    bool erase(const K& key) {
+        std::lock_guard<std::mutex> lock(writeMutex_);
+        return unlink(key);
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(writeMutex_);
+        return count_;
+    }
+
+private:
+    static constexpr size_t INITIAL_BUCKETS = 64;
+
+    struct Node {
+        K key;
+        V value;
+        const Node* next;
+    };
+
+    struct Table {
+        explicit Table(size_t buckets) : mask(buckets - 1), buckets(new std::atomic<const Node*>[buckets]) {
+            for (size_t i = 0; i < buckets; ++i) this->buckets[i].store(nullptr, std::memory_order_relaxed);
+        }
+        size_t mask;
+        std::unique_ptr<std::atomic<const Node*>[]> buckets;
+    };
+
+    // Unlink key's node, if any: the nodes ahead of it are copied onto the
+    // rest of the chain, so readers see the old chain or the new one
+    bool unlink(const K& key) {
+        Table* table = table_.load(std::memory_order_relaxed);
+        std::atomic<const Node*>& bucket = table->buckets[Hash()(key) & table->mask];
+        const Node* head = bucket.load(std::memory_order_relaxed);
+        const Node* target = head;
+        while (target && !(target->key == key)) target = target->next;
+        if (!target) return false;
+
+        std::vector<const Node*> ahead;
+        for (const Node* node = head; node != target; node = node->next) ahead.push_back(node);
+        const Node* chain = target->next;
+        for (auto it = ahead.rbegin(); it != ahead.rend(); ++it) chain = new Node{(*it)->key, (*it)->value, chain};
+        bucket.store(chain, std::memory_order_release);
+
+        ahead.push_back(target);
+        EpochDomain::global().retire([ahead]() {
+            for (const Node* node : ahead) delete node;
+        });
+        count_--;
+        return true;
+    }
+
+    // Publish a table with twice the buckets; the old one is retired whole
+    Table* grow(Table* old) {
+        Table* next = new Table((old->mask + 1) * 2);
+        for (size_t i = 0; i <= old->mask; ++i) {
+            for (const Node* node = old->buckets[i].load(std::memory_order_relaxed); node; node = node->next) {
+                std::atomic<const Node*>& bucket = next->buckets[Hash()(node->key) & next->mask];
+                bucket.store(new Node{node->key, node->value, bucket.load(std::memory_order_relaxed)},
+                             std::memory_order_relaxed);
+            }
+        }
+        table_.store(next, std::memory_order_release);
+        EpochDomain::global().retire([old]() { destroy(old); });
+        return next;
+    }
+
+    static void destroy(const Table* table) {
+        for (size_t i = 0; i <= table->mask; ++i) {
+            const Node* node = table->buckets[i].load(std::memory_order_relaxed);
+            while (node) {
+                const Node* next = node->next;
+                delete node;
+                node = next;
+            }
+        }
+        delete table;
+    }
+
+    std::atomic<Table*> table_;
+    size_t count_ = 0;
+    mutable std::mutex writeMutex_;
+};
+
+} // namespace concurrency
+} // namespace english_learning
+
+#endif // ENGLISH_LEARNING_CONCURRENCY_RCU_H
@@ -0,0 +1,134 @@
+#include "admission.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace english_learning {
+namespace net {
+
+namespace {
+
+constexpr int64_t SWEEP_INTERVAL_MS = 60 * 1000;
+
+} // namespace
+
+// ---- RateLimiter ----
+
+void RateLimiter::setLimit(const std::string& role, const std::string& messageType, Limit limit) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    limits_[{role, messageType}] = limit;
+}
+
+const RateLimiter::Limit* RateLimiter::limitFor(const std::string& role, const std::string& messageType) const {
+    const std::pair<std::string, std::string> candidates[] = {
+        {role, messageType}, {"*", messageType}, {role, "*"}, {"*", "*"}};
+    for (const auto& key : candidates) {
+        auto it = limits_.find(key);
+        if (it != limits_.end()) return &it->second;
+    }
+    return nullptr;
+}
+
+int64_t RateLimiter::acquire(const std::string& requester, const std::string& role,
+                             const std::string& messageType, int64_t nowMs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Limit* limit = limitFor(role, messageType);
+    if (!limit || limit->perSecond <= 0) return 0;
+
+    if (nowMs - sweptAt_ >= SWEEP_INTERVAL_MS) sweepLocked(nowMs);
+
+    auto inserted = buckets_.emplace(requester + "\n" + messageType, Bucket{limit->burst, nowMs});
+    Bucket& bucket = inserted.first->second;
+    bucket.tokens = std::min(limit->burst, bucket.tokens + (nowMs - bucket.refilledAt) * limit->perSecond / 1000.0);
+    bucket.refilledAt = nowMs;
+    if (bucket.tokens >= 1.0) {
+        bucket.tokens -= 1.0;
+        return 0;
+    }
+    return std::max<int64_t>(1, static_cast<int64_t>(std::ceil((1.0 - bucket.tokens) * 1000.0 / limit->perSecond)));
+}
+
+void RateLimiter::sweepLocked(int64_t nowMs) {
+    // A bucket idle long enough to refill completely is the same as a new one
+    for (auto it = buckets_.begin(); it != buckets_.end();) {
+        if (nowMs - it->second.refilledAt >= SWEEP_INTERVAL_MS) {
+            it = buckets_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    sweptAt_ = nowMs;
+}
+
+// ---- FairScheduler ----
+
+FairScheduler::Slot& FairScheduler::Slot::operator=(Slot&& other) noexcept {
+    if (this != &other) {
+        release();
+        owner_ = other.owner_;
+        other.owner_ = nullptr;
+    }
+    return *this;
+}
+
+void FairScheduler::Slot::release() {
+    if (owner_) {
+        owner_->release();
+        owner_ = nullptr;
+    }
+}
+
+FairScheduler::FairScheduler(size_t slots) : slots_(std::max<size_t>(1, slots)), free_(slots_) {}
+
+FairScheduler::Slot FairScheduler::admit(const std::string& requester, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (free_ > 0 && turns_.empty()) {
+        free_--;
+        return Slot(this);
+    }
+
+    uint64_t ticket = nextTicket_++;
+    std::deque<uint64_t>& queue = waiting_[requester];
+    if (queue.empty()) turns_.push_back(requester);
+    queue.push_back(ticket);
+    grants_[ticket] = false;
+
+    bool granted = granted_.wait_for(lock, timeout, [&] { return grants_[ticket]; });
+    grants_.erase(ticket);
+    if (granted) return Slot(this);
+
+    // Timed out: withdraw the ticket, and the requester's turn if it was the last one
+    auto it = waiting_.find(requester);
+    if (it != waiting_.end()) {
+        it->second.erase(std::remove(it->second.begin(), it->second.end(), ticket), it->second.end());
+        if (it->second.empty()) {
+            waiting_.erase(it);
+            turns_.erase(std::remove(turns_.begin(), turns_.end(), requester), turns_.end());
+        }
+    }
+    return Slot();
+}
+
+void FairScheduler::release() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (turns_.empty()) {
+        free_++;
+        return;
+    }
+
+    // Hand the slot straight to the oldest ticket of the requester whose turn it is
+    std::string requester = std::move(turns_.front());
+    turns_.pop_front();
+    std::deque<uint64_t>& queue = waiting_[requester];
+    grants_[queue.front()] = true;
+    queue.pop_front();
+    if (queue.empty()) {
+        waiting_.erase(requester);
+    } else {
+        turns_.push_back(std::move(requester));
+    }
+    granted_.notify_all();
+}
+
+} // namespace net
+} // namespace english_learning
@@ -0,0 +1,114 @@
+#ifndef ENGLISH_LEARNING_NET_ADMISSION_H
+#define ENGLISH_LEARNING_NET_ADMISSION_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace english_learning {
+namespace net {
+
+/**
+ * Token-bucket request budgets, one bucket per (requester, message type).
+ *
+ * Limits are configured per role and message type, with "*" as a wildcard
+ * for either. The most specific limit wins: role and type, then any role
+ * with that type, then that role with any type, then "*"/"*". A message
+ * type with no applicable limit is not limited. Thread-safe.
+ */
+class RateLimiter {
+public:
+    struct Limit {
+        double perSecond;   // sustained rate
+        double burst;       // bucket size
+    };
+
+    void setLimit(const std::string& role, const std::string& messageType, Limit limit);
+
+    /**
+     * Take one token from requester's bucket for messageType. Returns 0 if
+     * the request is admitted, otherwise the milliseconds until a token is
+     * available again (the request is not counted).
+     */
+    int64_t acquire(const std::string& requester, const std::string& role, const std::string& messageType,
+                    int64_t nowMs);
+
+private:
+    struct Bucket {
+        double tokens;
+        int64_t refilledAt;
+    };
+
+    const Limit* limitFor(const std::string& role, const std::string& messageType) const;
+
+    // Drop buckets that have been full for a while; caller holds mutex_
+    void sweepLocked(int64_t nowMs);
+
+    std::mutex mutex_;
+    std::map<std::pair<std::string, std::string>, Limit> limits_;   // (role, type) -> limit
+    std::unordered_map<std::string, Bucket> buckets_;               // requester \n type -> bucket
+    int64_t sweptAt_ = 0;
+};
+
+/**
+ * Hands out a fixed number of execution slots fairly between requesters.
+ *
+ * While slots are free, admit() returns at once. Once they are all taken,
+ * waiting requests queue per requester, and a freed slot goes to the next
+ * requester in round-robin order rather than to the oldest request. A user
+ * with a burst of requests on several connections therefore gets one slot
+ * per turn, like everyone else. Thread-safe.
+ */
+class FairScheduler {
+public:
+    // A held slot; released when destroyed or by release()
+    class Slot {
+    public:
+        Slot() = default;
+        Slot(Slot&& other) noexcept : owner_(other.owner_) { other.owner_ = nullptr; }
+        Slot& operator=(Slot&& other) noexcept;
+        ~Slot() { release(); }
+
+        Slot(const Slot&) = delete;
+        Slot& operator=(const Slot&) = delete;
+
+        explicit operator bool() const { return owner_ != nullptr; }
+        void release();
+
+    private:
+        friend class FairScheduler;
+        explicit Slot(FairScheduler* owner) : owner_(owner) {}
+        FairScheduler* owner_ = nullptr;
+    };
+
+    explicit FairScheduler(size_t slots);
+
+    // Wait up to timeout for a slot; an empty Slot if none came free in time
+    Slot admit(const std::string& requester, std::chrono::milliseconds timeout);
+
+    size_t slots() const { return slots_; }
+
+private:
+    void release();
+
+    const size_t slots_;
+    std::mutex mutex_;
+    std::condition_variable granted_;
+    size_t free_;
+    uint64_t nextTicket_ = 0;
+    std::unordered_map<std::string, std::deque<uint64_t>> waiting_;   // requester -> tickets, oldest first
+    std::deque<std::string> turns_;          // requesters with waiting tickets, next turn first
+    std::unordered_map<uint64_t, bool> grants_;   // ticket -> granted (present while waiting)
+};
+
+} // namespace net
+} // namespace english_learning
+
+#endif // ENGLISH_LEARNING_NET_ADMISSION_H
@@ -0,0 +1,358 @@
+#include "media_server.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <thread>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace english_learning {
+namespace net {
+
+namespace {
+
+constexpr size_t MAX_REQUEST_HEAD = 8192;       // larger request heads get 431
+constexpr size_t SENDFILE_CHUNK = 1024 * 1024;   // body bytes per connection per turn
+
+int64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::string lower(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return std::tolower(c); });
+    return s;
+}
+
+std::string trim(const std::string& s) {
+    size_t begin = s.find_first_not_of(" \t");
+    if (begin == std::string::npos) return "";
+    return s.substr(begin, s.find_last_not_of(" \t") - begin + 1);
+}
+
+const char* mimeType(const std::string& path) {
+    static const std::map<std::string, const char*> types = {
+        {"mp4", "video/mp4"},  {"m4v", "video/mp4"},   {"webm", "video/webm"}, {"mkv", "video/x-matroska"},
+        {"mov", "video/quicktime"}, {"mp3", "audio/mpeg"}, {"m4a", "audio/mp4"}, {"aac", "audio/aac"},
+        {"ogg", "audio/ogg"},  {"oga", "audio/ogg"},   {"wav", "audio/wav"},   {"flac", "audio/flac"},
+    };
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos) return "application/octet-stream";
+    auto it = types.find(lower(path.substr(dot + 1)));
+    return it == types.end() ? "application/octet-stream" : it->second;
+}
+
+// Parse a non-negative decimal; false if s is empty or not all digits
+bool parseOffset(const std::string& s, unsigned long long& out) {
+    if (s.empty() || s.size() > 19 || !std::all_of(s.begin(), s.end(), ::isdigit)) return false;
+    out = std::strtoull(s.c_str(), nullptr, 10);
+    return true;
+}
+
+enum class RangeResult { None, Satisfiable, Unsatisfiable };
+
+// The single byte range a Range header asks of a file of size bytes, as
+// [first, last]. Anything but one well-formed "bytes=" range is ignored and
+// the whole file is sent, as HTTP allows.
+RangeResult parseRange(const std::string& header, off_t size, off_t& first, off_t& last) {
+    if (header.compare(0, 6, "bytes=") != 0 || header.find(',') != std::string::npos) return RangeResult::None;
+    std::string spec = trim(header.substr(6));
+    size_t dash = spec.find('-');
+    if (dash == std::string::npos) return RangeResult::None;
+    std::string from = spec.substr(0, dash), to = spec.substr(dash + 1);
+    unsigned long long a = 0, b = 0;
+    if (from.empty()) {
+        // Suffix range: the last b bytes
+        if (!parseOffset(to, b)) return RangeResult::None;
+        if (b == 0 || size == 0) return RangeResult::Unsatisfiable;
+        first = b >= static_cast<unsigned long long>(size) ? 0 : size - static_cast<off_t>(b);
+        last = size - 1;
+        return RangeResult::Satisfiable;
+    }
+    if (!parseOffset(from, a) || (!to.empty() && (!parseOffset(to, b) || b < a))) return RangeResult::None;
+    if (a >= static_cast<unsigned long long>(size)) return RangeResult::Unsatisfiable;
+    first = static_cast<off_t>(a);
+    last = to.empty() || b >= static_cast<unsigned long long>(size) ? size - 1 : static_cast<off_t>(b);
+    return RangeResult::Satisfiable;
+}
+
+} // namespace
+
+MediaServer::MediaServer(Resolver resolve, size_t maxStreams, int idleMs)
+    : resolve_(std::move(resolve)), maxStreams_(maxStreams), idleMs_(idleMs) {}
+
+bool MediaServer::start(int port, std::string& error) {
+    listener_ = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listener_ < 0) {
+        error = std::strerror(errno);
+        return false;
+    }
+    int opt = 1;
+    ::setsockopt(listener_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = htons(port);
+    if (::bind(listener_, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        ::listen(listener_, 128) < 0) {
+        error = std::strerror(errno);
+        ::close(listener_);
+        listener_ = -1;
+        return false;
+    }
+    port_ = port;
+    std::thread(&MediaServer::run, this).detach();
+    return true;
+}
+
+void MediaServer::run() {
+    std::vector<struct pollfd> fds;
+    while (true) {
+        fds.clear();
+        fds.push_back({listener_, POLLIN, 0});
+        for (const Connection& c : connections_) {
+            bool sending = c.headSent < c.head.size() || c.file >= 0;
+            fds.push_back({c.socket, short(sending ? POLLOUT : POLLIN), 0});
+        }
+        // Wake at least once a second to close idle connections
+        if (::poll(fds.data(), fds.size(), 1000) < 0 && errno != EINTR) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            continue;
+        }
+
+        int64_t now = nowMs();
+        size_t kept = 0;
+        for (size_t i = 0; i < connections_.size(); ++i) {
+            Connection& c = connections_[i];
+            short revents = fds[i + 1].revents;
+            bool open = true;
+            if (revents & POLLOUT) {
+                open = writable(c);
+            } else if (revents & (POLLIN | POLLHUP | POLLERR)) {
+                open = readable(c);
+            } else if (now - c.activeAt > idleMs_) {
+                open = false;
+            }
+            if (!open) {
+                closeConnection(c);
+                continue;
+            }
+            if (kept != i) connections_[kept] = std::move(c);
+            kept++;
+        }
+        connections_.resize(kept);
+
+        if (fds[0].revents & POLLIN) acceptAll();
+        streams_.store(connections_.size(), std::memory_order_relaxed);
+    }
+}
+
+void MediaServer::acceptAll() {
+    while (true) {
+        int s = ::accept4(listener_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (s < 0) {
+            if (errno == EINTR) continue;
+            return;   // EAGAIN: no more waiting, or out of descriptors until some close
+        }
+        if (connections_.size() >= maxStreams_) {
+            static const char busy[] =
+                "HTTP/1.1 503 Service Unavailable\r\nRetry-After: 1\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+            ssize_t n = ::send(s, busy, sizeof(busy) - 1, MSG_NOSIGNAL | MSG_DONTWAIT);
+            (void)n;
+            ::close(s);
+            continue;
+        }
+        Connection c;
+        c.socket = s;
+        c.activeAt = nowMs();
+        connections_.push_back(std::move(c));
+    }
+}
+
+bool MediaServer::readable(Connection& c) {
+    char buffer[4096];
+    ssize_t n = ::recv(c.socket, buffer, sizeof(buffer), 0);
+    if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    if (n == 0) return false;
+    c.request.append(buffer, static_cast<size_t>(n));
+    c.activeAt = nowMs();
+
+    size_t end = c.request.find("\r\n\r\n");
+    if (end == std::string::npos) {
+        if (c.request.size() <= MAX_REQUEST_HEAD) return true;
+        c.head = "HTTP/1.1 431 Request Header Fields Too Large\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        c.headSent = 0;
+        c.keepAlive = false;
+        c.request.clear();
+        return writable(c);
+    }
+    std::string head = c.request.substr(0, end);
+    c.request.erase(0, end + 4);
+    respond(c, head);
+    return writable(c);
+}
+
+bool MediaServer::writable(Connection& c) {
+    while (true) {
+        while (c.headSent < c.head.size()) {
+            int flags = MSG_NOSIGNAL | (c.file >= 0 ? MSG_MORE : 0);
+            ssize_t n = ::send(c.socket, c.head.data() + c.headSent, c.head.size() - c.headSent, flags);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+            c.headSent += static_cast<size_t>(n);
+            c.activeAt = nowMs();
+        }
+
+        if (c.file >= 0) {
+            size_t chunk = static_cast<size_t>(std::min<off_t>(c.end - c.offset, SENDFILE_CHUNK));
+            ssize_t n = chunk > 0 ? ::sendfile(c.socket, c.file, &c.offset, chunk) : 0;
+            if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+            if (n == 0 && c.offset < c.end) return false;   // the file shrank under us
+            c.activeAt = nowMs();
+            if (c.offset < c.end) return true;   // the rest on a later turn
+            finishBody(c);
+        }
+
+        // Response complete: on to the next request if one is already here
+        if (!c.keepAlive) return false;
+        c.head.clear();
+        c.headSent = 0;
+        size_t end = c.request.find("\r\n\r\n");
+        if (end == std::string::npos) return true;
+        std::string head = c.request.substr(0, end);
+        c.request.erase(0, end + 4);
+        respond(c, head);
+    }
+}
+
+void MediaServer::respond(Connection& c, const std::string& head) {
+    std::string method, target, version;
+    std::map<std::string, std::string> headers;   // lowercased name -> value
+    size_t lineEnd = head.find("\r\n");
+    std::string requestLine = head.substr(0, lineEnd);
+    {
+        size_t a = requestLine.find(' ');
+        size_t b = a == std::string::npos ? a : requestLine.find(' ', a + 1);
+        if (b != std::string::npos) {
+            method = requestLine.substr(0, a);
+            target = requestLine.substr(a + 1, b - a - 1);
+            version = requestLine.substr(b + 1);
+        }
+    }
+    while (lineEnd != std::string::npos) {
+        size_t start = lineEnd + 2;
+        lineEnd = head.find("\r\n", start);
+        std::string line = head.substr(start, lineEnd == std::string::npos ? std::string::npos : lineEnd - start);
+        size_t colon = line.find(':');
+        if (colon != std::string::npos) headers[lower(trim(line.substr(0, colon)))] = trim(line.substr(colon + 1));
+    }
+
+    std::string connection = lower(headers["connection"]);
+    c.keepAlive = version == "HTTP/1.1" ? connection != "close" : connection == "keep-alive";
+    const char* keepAlive = c.keepAlive ? "keep-alive" : "close";
+    auto status = [&](const char* line, const std::string& extra) {
+        c.head = std::string("HTTP/1.1 ") + line + "\r\n" + extra + "Content-Length: 0\r\nConnection: " + keepAlive +
+                 "\r\n\r\n";
+        c.headSent = 0;
+    };
+
+    if (version.compare(0, 5, "HTTP/") != 0 || target.empty() || target[0] != '/') {
+        c.keepAlive = false;
+        keepAlive = "close";
+        status("400 Bad Request", "");
+        return;
+    }
+    if (method != "GET" && method != "HEAD") {
+        status("405 Method Not Allowed", "Allow: GET, HEAD\r\n");
+        return;
+    }
+
+    std::string path = resolve_(target.substr(0, target.find('?')));
+    int fd = path.empty() ? -1 : ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd >= 0 && (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))) {
+        ::close(fd);
+        fd = -1;
+    }
+    if (fd < 0) {
+        status("404 Not Found", "");
+        return;
+    }
+
+    // Strong validator: the same file, unchanged, has the same tag
+    char etag[80];
+    std::snprintf(etag, sizeof(etag), "\"%llx-%llx-%llx\"", (unsigned long long)st.st_ino,
+                  (unsigned long long)st.st_size,
+                  (unsigned long long)st.st_mtim.tv_sec * 1000000000ull + st.st_mtim.tv_nsec);
+    std::string validators = std::string("ETag: ") + etag + "\r\nAccept-Ranges: bytes\r\n";
+
+    const std::string& ifNoneMatch = headers["if-none-match"];
+    if (!ifNoneMatch.empty() && (ifNoneMatch == "*" || ifNoneMatch.find(etag) != std::string::npos)) {
+        ::close(fd);
+        status("304 Not Modified", validators);
+        return;
+    }
+
+    off_t size = st.st_size;
+    off_t first = 0, last = size - 1;
+    RangeResult range = RangeResult::None;
+    const std::string& ifRange = headers["if-range"];
+    if (headers.count("range") && (ifRange.empty() || ifRange == etag)) {
+        range = parseRange(headers["range"], size, first, last);
+    }
+    if (range == RangeResult::Unsatisfiable) {
+        ::close(fd);
+        status("416 Range Not Satisfiable", validators + "Content-Range: bytes */" + std::to_string(size) + "\r\n");
+        return;
+    }
+
+    off_t length = size == 0 ? 0 : last - first + 1;
+    c.head = range == RangeResult::Satisfiable ? "HTTP/1.1 206 Partial Content\r\n" : "HTTP/1.1 200 OK\r\n";
+    c.head += std::string("Content-Type: ") + mimeType(path) + "\r\n";
+    c.head += "Content-Length: " + std::to_string(length) + "\r\n";
+    if (range == RangeResult::Satisfiable) {
+        c.head += "Content-Range: bytes " + std::to_string(first) + "-" + std::to_string(last) + "/" +
+                  std::to_string(size) + "\r\n";
+    }
+    c.head += validators;
+    c.head += std::string("Connection: ") + keepAlive + "\r\n\r\n";
+    c.headSent = 0;
+
+    if (method == "HEAD" || length == 0) {
+        ::close(fd);
+        return;
+    }
+    c.file = fd;
+    c.offset = first;
+    c.end = first + length;
+}
+
+void MediaServer::finishBody(Connection& c) {
+    if (c.file >= 0) ::close(c.file);
+    c.file = -1;
+    c.offset = c.end = 0;
+}
+
+void MediaServer::closeConnection(Connection& c) {
+    finishBody(c);
+    if (c.socket >= 0) ::close(c.socket);
+    c.socket = -1;
+}
+
+} // namespace net
+} // namespace english_learning
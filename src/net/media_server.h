@@ -0,0 +1,85 @@
+#ifndef ENGLISH_LEARNING_NET_MEDIA_SERVER_H
+#define ENGLISH_LEARNING_NET_MEDIA_SERVER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+namespace english_learning {
+namespace net {
+
+/**
+ * Minimal HTTP/1.1 server for lesson video and audio.
+ *
+ * One thread runs a poll() loop over the listening socket and every open
+ * connection, all non-blocking. GET and HEAD are answered with the file the
+ * resolver maps the request path to; single byte ranges (Range, If-Range)
+ * give 206 responses so players can seek, and If-None-Match against the
+ * file's ETag gives 304. Bodies go out with sendfile(), a bounded chunk per
+ * connection per turn, so file data is never copied through user space and
+ * one large download cannot hold up the others. Connections are kept alive
+ * between requests and closed after idleMs without progress.
+ *
+ * At most maxStreams connections are served at once; one more is answered
+ * 503 with Retry-After and closed.
+ */
+class MediaServer {
+public:
+    // File to serve for a request path (query string removed), or "" for 404
+    using Resolver = std::function<std::string(const std::string& path)>;
+
+    MediaServer(Resolver resolve, size_t maxStreams, int idleMs);
+
+    MediaServer(const MediaServer&) = delete;
+    MediaServer& operator=(const MediaServer&) = delete;
+
+    // Listen on port and serve from a detached thread; false with a reason
+    // in error if the port cannot be bound
+    bool start(int port, std::string& error);
+
+    int port() const { return port_; }
+
+    // Connections open right now
+    size_t streams() const { return streams_.load(std::memory_order_relaxed); }
+
+private:
+    struct Connection {
+        int socket = -1;
+        std::string request;     // bytes read towards the next request head
+        std::string head;        // response head not yet sent
+        size_t headSent = 0;
+        int file = -1;           // body being sent, if any
+        off_t offset = 0;
+        off_t end = 0;           // one past the last body byte
+        bool keepAlive = false;
+        int64_t activeAt = 0;    // last progress, for the idle timeout
+    };
+
+    void run();
+    void acceptAll();
+    // Read and answer requests; false once the connection should close
+    bool readable(Connection& c);
+    // Send what the socket takes; false once the connection should close
+    bool writable(Connection& c);
+    // Parse one request head and set up c's response to it
+    void respond(Connection& c, const std::string& head);
+    static void finishBody(Connection& c);
+    static void closeConnection(Connection& c);
+
+    Resolver resolve_;
+    size_t maxStreams_;
+    int idleMs_;
+    int listener_ = -1;
+    int port_ = 0;
+    std::vector<Connection> connections_;   // owned by the serving thread
+    std::atomic<size_t> streams_{0};
+};
+
+} // namespace net
+} // namespace english_learning
+
+#endif // ENGLISH_LEARNING_NET_MEDIA_SERVER_H
@@ -0,0 +1,101 @@
+#include "outbox.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <arpa/inet.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace english_learning {
+namespace net {
+
+Frame makeFrame(const std::string& message) {
+    auto frame = std::make_shared<std::string>();
+    frame->reserve(sizeof(uint32_t) + message.size());
+    uint32_t len = htonl(static_cast<uint32_t>(message.size()));
+    frame->append(reinterpret_cast<const char*>(&len), sizeof(len));
+    frame->append(message);
+    return frame;
+}
+
+Outbox::Outbox(int socket, size_t capacity)
+    : socket_(socket), capacity_(capacity), wakeFd_(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {}
+
+Outbox::~Outbox() {
+    if (wakeFd_ >= 0) ::close(wakeFd_);
+}
+
+bool Outbox::push(const Frame& frame) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (queue_.size() >= capacity_) return false;
+        queue_.push_back(frame);
+        // Only the first frame of a batch needs to wake the writer
+        if (signalled_) return true;
+        signalled_ = true;
+    }
+    wakeWriter();
+    return true;
+}
+
+bool Outbox::pushSignal(const std::string& key, const Frame& frame) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = std::find_if(signals_.begin(), signals_.end(),
+                               [&key](const std::pair<std::string, Frame>& s) { return s.first == key; });
+        if (it != signals_.end()) {
+            it->second = frame;     // still waiting, so the writer is already woken
+            return true;
+        }
+        if (signals_.size() >= capacity_) return false;
+        signals_.emplace_back(key, frame);
+        if (signalled_) return true;
+        signalled_ = true;
+    }
+    wakeWriter();
+    return true;
+}
+
+void Outbox::wakeWriter() {
+    uint64_t one = 1;
+    ssize_t n = ::write(wakeFd_, &one, sizeof(one));
+    (void)n;
+}
+
+bool Outbox::flush() {
+    std::deque<Frame> batch;
+    std::vector<std::pair<std::string, Frame>> signals;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t count;
+        ssize_t n = ::read(wakeFd_, &count, sizeof(count));
+        (void)n;
+        signalled_ = false;
+        batch.swap(queue_);
+        signals.swap(signals_);
+    }
+
+    auto write = [this](const Frame& frame) {
+        size_t sent = 0;
+        while (sent < frame->size()) {
+            ssize_t n = ::send(socket_, frame->data() + sent, frame->size() - sent, 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            sent += static_cast<size_t>(n);
+        }
+        return true;
+    };
+
+    for (const Frame& frame : batch) {
+        if (!write(frame)) return false;
+    }
+    for (const auto& signal : signals) {
+        if (!write(signal.second)) return false;
+    }
+    return true;
+}
+
+} // namespace net
+} // namespace english_learning
@@ -0,0 +1,73 @@
+#ifndef ENGLISH_LEARNING_NET_OUTBOX_H
+#define ENGLISH_LEARNING_NET_OUTBOX_H
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace english_learning {
+namespace net {
+
+// A length-prefixed wire frame. Built once and shared by every queue it is
+// pushed to, so fanning a message out copies no bytes.
+using Frame = std::shared_ptr<const std::string>;
+
+Frame makeFrame(const std::string& message);
+
+/**
+ * Outgoing push queue of one client connection.
+ *
+ * Any thread may push(). The connection's own thread polls wakeFd() next to
+ * its socket and writes queued frames with flush(), so pushes never
+ * interleave with responses mid-frame and a slow reader only stalls its own
+ * connection. Once `capacity` frames are waiting, further pushes are dropped.
+ *
+ * Transient signals (typing indicators, read receipts) go through a separate
+ * lane: a waiting signal is replaced by a newer one with the same key, and
+ * signals are written only after every queued frame, so a chatty sender can
+ * neither grow the queue nor hold up messages.
+ */
+class Outbox {
+public:
+    Outbox(int socket, size_t capacity);
+    ~Outbox();
+
+    Outbox(const Outbox&) = delete;
+    Outbox& operator=(const Outbox&) = delete;
+
+    int socket() const { return socket_; }
+
+    // Readable while frames are waiting (an eventfd)
+    int wakeFd() const { return wakeFd_; }
+
+    // Queue a frame; false if the queue is full and the frame was dropped
+    bool push(const Frame& frame);
+
+    // Queue a signal, replacing any waiting signal with the same key; false if
+    // `capacity` distinct signals are already waiting
+    bool pushSignal(const std::string& key, const Frame& frame);
+
+    // Write every queued frame to the socket; false if the socket failed
+    bool flush();
+
+private:
+    void wakeWriter();
+
+    int socket_;
+    size_t capacity_;
+    int wakeFd_;
+
+    std::mutex mutex_;
+    std::deque<Frame> queue_;
+    std::vector<std::pair<std::string, Frame>> signals_;  // latest per key, first-arrival order
+    bool signalled_ = false;    // wakeFd_ is readable
+};
+
+} // namespace net
+} // namespace english_learning
+
+#endif // ENGLISH_LEARNING_NET_OUTBOX_H
@@ -21,158 +21,148 @@
 #include "include/repository/i_chat_repository.h"
 #include "include/repository/i_exercise_repository.h"
 #include "include/repository/i_game_repository.h"
+#include "src/repository/memory/user_table.h"
+#include "src/repository/memory/chat_store.h"
 
 namespace english_learning {
 namespace repository {
 namespace bridge {
 
 /**
- * Bridge user repository wrapping global user maps.
+ * Bridge user repository wrapping the global user table.
+ * Reads are lock-free; the shared users mutex only serializes writers.
  */
 class BridgeUserRepository : public IUserRepository {
 public:
-    BridgeUserRepository(
-        std::map<std::string, core::User>& users,
-        std::map<std::string, core::User*>& userById,
-        std::mutex& mutex)
-        : users_(users), userById_(userById), mutex_(mutex) {}
+    BridgeUserRepository(memory::UserTable& users, std::mutex& mutex)
+        : users_(users), mutex_(mutex) {}
 
     bool add(const core::User& user) override {
         std::lock_guard<std::mutex> lock(mutex_);
-        if (users_.find(user.email) != users_.end()) {
-            return false;
-        }
-        users_[user.email] = user;
-        userById_[user.userId] = &users_[user.email];
-        return true;
+        return users_.insert(user).valid();
     }
 
     std::optional<core::User> findByEmail(const std::string& email) const override {
-        std::lock_guard<std::mutex> lock(mutex_);
-        auto it = users_.find(email);
-        if (it != users_.end()) {
-            return it->second;
+        concurrency::EpochGuard guard;
+        if (const core::User* user = users_.getByEmail(email)) {
+            return *user;
         }
         return std::nullopt;
     }
 
     std::optional<core::User> findById(const std::string& userId) const override {
-        std::lock_guard<std::mutex> lock(mutex_);
-        auto it = userById_.find(userId);
-        if (it != userById_.end() && it->second != nullptr) {
-            return *(it->second);
+        concurrency::EpochGuard guard;
+        if (const core::User* user = users_.getById(userId)) {
+            return *user;
         }
         return std::nullopt;
     }
 
     std::vector<core::User> findAll() const override {
-        std::lock_guard<std::mutex> lock(mutex_);
         std::vector<core::User> result;
-        for (const auto& pair : users_) {
-            result.push_back(pair.second);
-        }
+        result.reserve(users_.size());
+        users_.forEach([&](memory::UserHandle, const core::User& user) {
+            result.push_back(user);
+        });
         return result;
     }
 
     std::vector<core::User> findOnlineUsers() const override {
-        std::lock_guard<std::mutex> lock(mutex_);
         std::vector<core::User> result;
-        for (const auto& pair : users_) {
-            if (pair.second.online) {
-                result.push_back(pair.second);
+        concurrency::EpochGuard guard;
+        for (memory::UserHandle handle : users_.presence().page(0, 0, memory::UserHandle(), true)) {
+            if (const core::User* user = users_.get(handle)) {
+                result.push_back(*user);
             }
         }
         return result;
     }
 
-    std::vector<core::User> findByRole(const std::string& role) const override {
-        std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<core::User> findByRole(core::UserRole role) const override {
+        std::vector<core::User> result;
+        users_.forEach([&](memory::UserHandle, const core::User& user) {
+            if (user.role == role) {
+                result.push_back(user);
+            }
+        });
+        return result;
+    }
+
+    std::vector<core::User> searchContacts(const std::string& query, size_t limit) const override {
         std::vector<core::User> result;
-        for (const auto& pair : users_) {
-            if (pair.second.role == role) {
-                result.push_back(pair.second);
+        concurrency::EpochGuard guard;
+        for (memory::UserHandle handle : users_.contacts().search(query, limit)) {
+            if (const core::User* user = users_.get(handle)) {
+                result.push_back(*user);
             }
         }
         return result;
     }
 
     bool exists(const std::string& email) const override {
-        std::lock_guard<std::mutex> lock(mutex_);
-        return users_.find(email) != users_.end();
+        return users_.findByEmail(email).valid();
     }
 
     bool existsById(const std::string& userId) const override {
-        std::lock_guard<std::mutex> lock(mutex_);
-        return userById_.find(userId) != userById_.end();
+        return users_.findById(userId).valid();
     }
 
     bool update(const core::User& user) override {
         std::lock_guard<std::mutex> lock(mutex_);
-        auto it = users_.find(user.email);
-        if (it != users_.end()) {
-            it->second = user;
-            return true;
-        }
-        return false;
+        return users_.update(users_.findByEmail(user.email), user);
     }
 
-    bool updateLevel(const std::string& userId, const std::string& level) override {
+    bool updateLevel(const std::string& userId, core::Level level) override {
         std::lock_guard<std::mutex> lock(mutex_);
-        auto it = userById_.find(userId);
-        if (it != userById_.end() && it->second != nullptr) {
-            it->second->level = level;
-            return true;
-        }
-        return false;
+        return users_.modify(users_.findById(userId), [&](core::User& user) {
+            user.level = level;
+        });
     }
 
     bool setOnlineStatus(const std::string& userId, bool online, int socket = -1) override {
         std::lock_guard<std::mutex> lock(mutex_);
-        auto it = userById_.find(userId);
-        if (it != userById_.end() && it->second != nullptr) {
-            it->second->online = online;
-            it->second->clientSocket = socket;
-            return true;
-        }
-        return false;
+        return users_.modify(users_.findById(userId), [&](core::User& user) {
+            user.online = online;
+            user.clientSocket = socket;
+        });
     }
 
     bool remove(const std::string& userId) override {
         std::lock_guard<std::mutex> lock(mutex_);
-        auto it = userById_.find(userId);
-        if (it != userById_.end() && it->second != nullptr) {
-            std::string email = it->second->email;
-            userById_.erase(it);
-            users_.erase(email);
-            return true;
-        }
-        return false;
+        return users_.erase(users_.findById(userId));
     }
 
     size_t count() const override {
-        std::lock_guard<std::mutex> lock(mutex_);
         return users_.size();
     }
 
     bool isTeacher(const std::string& userId) const override {
-        auto userOpt = findById(userId);
-        if (userOpt.has_value()) {
-            return userOpt.value().isTeacher();
-        }
-        return false;
+        concurrency::EpochGuard guard;
+        const core::User* user = users_.getById(userId);
+        return user && user->isTeacher();
     }
 
     bool isAdmin(const std::string& userId) const override {
-        auto userOpt = findById(userId);
-        if (userOpt.has_value()) {
-            return userOpt.value().isAdmin();
+        concurrency::EpochGuard guard;
+        const core::User* user = users_.getById(userId);
+        return user && user->isAdmin();
+    }
+
+    // Handle-based access for handlers that keep a reference across calls
+    memory::UserHandle findHandle(const std::string& userId) const {
+        return users_.findById(userId);
+    }
+
+    std::optional<core::User> get(memory::UserHandle handle) const {
+        concurrency::EpochGuard guard;
+        if (const core::User* user = users_.get(handle)) {
+            return *user;
         }
-        return false;
+        return std::nullopt;
     }
 
 private:
-    std::map<std::string, core::User>& users_;
-    std::map<std::string, core::User*>& userById_;
+    memory::UserTable& users_;
     std::mutex& mutex_;
 };
 
@@ -283,123 +273,95 @@ private:
 };
 
 /**
- * Bridge chat repository wrapping global chat messages.
+ * Bridge chat repository wrapping the global chat store.
  */
 class BridgeChatRepository : public IChatRepository {
 public:
-    BridgeChatRepository(
-        std::vector<core::ChatMessage>& messages,
-        std::mutex& mutex)
-        : messages_(messages), mutex_(mutex) {}
+    BridgeChatRepository(memory::ChatStore& store, std::mutex& mutex)
+        : store_(store), mutex_(mutex) {}
 
     bool add(const core::ChatMessage& message) override {
-        std::lock_guard<std::mutex> lock(mutex_);
-        messages_.push_back(message);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!store_.append(message)) return false;
+        }
+        // Return once the message is durable (at most one group commit); one
+        // the journal could not persist is withdrawn and reported as not added
+        memory::ChatJournal* journal = store_.journal();
+        if (journal && !journal->waitDurable()) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            store_.remove(message.messageId);
+            return false;
+        }
         return true;
     }
 
     std::optional<core::ChatMessage> findById(const std::string& messageId) const override {
         std::lock_guard<std::mutex> lock(mutex_);
-        for (const auto& msg : messages_) {
-            if (msg.messageId == messageId) {
-                return msg;
-            }
+        if (const core::ChatMessage* msg = store_.findById(messageId)) {
+            return *msg;
         }
         return std::nullopt;
     }
 
     std::vector<core::ChatMessage> findAll() const override {
         std::lock_guard<std::mutex> lock(mutex_);
-        return messages_;
+        return store_.all();
     }
 
     std::vector<core::ChatMessage> findByUser(const std::string& userId) const override {
         std::lock_guard<std::mutex> lock(mutex_);
-        std::vector<core::ChatMessage> result;
-        for (const auto& msg : messages_) {
-            if (msg.involvesUser(userId)) {
-                result.push_back(msg);
-            }
-        }
-        return result;
+        return store_.findByUser(userId);
     }
 
     std::vector<core::ChatMessage> findConversation(const std::string& user1,
                                                      const std::string& user2) const override {
         std::lock_guard<std::mutex> lock(mutex_);
-        std::vector<core::ChatMessage> result;
-        for (const auto& msg : messages_) {
-            if (msg.isBetween(user1, user2)) {
-                result.push_back(msg);
-            }
-        }
-        return result;
+        return store_.conversation(user1, user2);
+    }
+
+    std::vector<core::ChatMessage> findConversationPage(const std::string& user1,
+                                                         const std::string& user2,
+                                                         const std::string& beforeMessageId,
+                                                         core::Timestamp beforeTimestamp,
+                                                         size_t limit) const override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return store_.history(user1, user2, beforeMessageId, beforeTimestamp, limit);
     }
 
     std::vector<core::ChatMessage> findUnreadFor(const std::string& userId) const override {
         std::lock_guard<std::mutex> lock(mutex_);
-        std::vector<core::ChatMessage> result;
-        for (const auto& msg : messages_) {
-            if (msg.recipientId == userId && !msg.read) {
-                result.push_back(msg);
-            }
-        }
-        return result;
+        return store_.unreadFor(userId);
     }
 
     size_t countUnreadFor(const std::string& userId) const override {
         std::lock_guard<std::mutex> lock(mutex_);
-        size_t count = 0;
-        for (const auto& msg : messages_) {
-            if (msg.recipientId == userId && !msg.read) {
-                count++;
-            }
-        }
-        return count;
+        return store_.countUnreadFor(userId);
     }
 
     bool markAsRead(const std::string& messageId) override {
         std::lock_guard<std::mutex> lock(mutex_);
-        for (auto& msg : messages_) {
-            if (msg.messageId == messageId) {
-                msg.read = true;
-                return true;
-            }
-        }
-        return false;
+        return store_.markAsRead(messageId);
     }
 
     size_t markConversationAsRead(const std::string& recipientId,
                                    const std::string& senderId) override {
         std::lock_guard<std::mutex> lock(mutex_);
-        size_t count = 0;
-        for (auto& msg : messages_) {
-            if (msg.senderId == senderId && msg.recipientId == recipientId && !msg.read) {
-                msg.read = true;
-                count++;
-            }
-        }
-        return count;
+        return store_.markConversationAsRead(recipientId, senderId);
     }
 
     bool remove(const std::string& messageId) override {
         std::lock_guard<std::mutex> lock(mutex_);
-        for (auto it = messages_.begin(); it != messages_.end(); ++it) {
-            if (it->messageId == messageId) {
-                messages_.erase(it);
-                return true;
-            }
-        }
-        return false;
+        return store_.remove(messageId);
     }
 
     size_t count() const override {
         std::lock_guard<std::mutex> lock(mutex_);
-        return messages_.size();
+        return store_.size();
     }
 
 private:
-    std::vector<core::ChatMessage>& messages_;
+    memory::ChatStore& store_;
     std::mutex& mutex_;
 };
 
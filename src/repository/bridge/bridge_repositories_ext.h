@@ -7,187 +7,210 @@
 
 #include "bridge_repositories.h"
 #include "include/repository/i_voice_call_repository.h"
+#include "src/concurrency/rcu.h"
+#include "src/repository/memory/content_catalog.h"
 
 namespace english_learning {
 namespace repository {
 namespace bridge {
 
 /**
- * Bridge lesson repository wrapping global lessons map.
+ * One table of the published content catalog, seen as a map.
+ * Reads take the current catalog version, filtered ones through its
+ * (level, topic, kind) index; writes publish a new version with the record
+ * changed, recorded as an edit so that it survives a reload and logged in
+ * the catalog's change log.
+ */
+template <typename V>
+class CatalogRef {
+public:
+    using Table = memory::CatalogTable<V>;
+    using Catalog = concurrency::RcuCell<memory::ContentCatalog>;
+
+    CatalogRef(Catalog& catalog, Table memory::ContentCatalog::* table)
+        : catalog_(catalog), table_(table) {}
+
+    // Caller must hold an EpochGuard while using the returned reference
+    const typename Table::Map& snapshot() const { return (catalog_.read().*table_).all(); }
+
+    std::optional<V> get(const std::string& id) const {
+        concurrency::EpochGuard guard;
+        if (const V* v = (catalog_.read().*table_).find(id)) return *v;
+        return std::nullopt;
+    }
+
+    bool contains(const std::string& id) const {
+        concurrency::EpochGuard guard;
+        return (catalog_.read().*table_).find(id) != nullptr;
+    }
+
+    size_t size() const {
+        concurrency::EpochGuard guard;
+        return (catalog_.read().*table_).size();
+    }
+
+    size_t count(const memory::CatalogFilter& filter) const {
+        concurrency::EpochGuard guard;
+        return (catalog_.read().*table_).count(filter);
+    }
+
+    // Copies of the records the index finds for filter that also pass pred
+    template <typename Pred>
+    std::vector<V> select(const memory::CatalogFilter& filter, Pred pred) const {
+        concurrency::EpochGuard guard;
+        std::vector<V> result;
+        for (const V* record : (catalog_.read().*table_).select(filter).records) {
+            if (pred(*record)) result.push_back(*record);
+        }
+        return result;
+    }
+
+    std::vector<V> select(const memory::CatalogFilter& filter) const {
+        return select(filter, [](const V&) { return true; });
+    }
+
+    // Insert only if absent
+    bool insert(const std::string& id, const V& value) {
+        return edit([&](Table& t) {
+            if (t.find(id)) return false;
+            t.put(id, value);
+            return true;
+        });
+    }
+
+    // Overwrite only if present
+    bool replace(const std::string& id, const V& value) {
+        return edit([&](Table& t) {
+            if (!t.find(id)) return false;
+            t.put(id, value);
+            return true;
+        });
+    }
+
+    bool erase(const std::string& id) {
+        return edit([&](Table& t) { return t.erase(id); });
+    }
+
+private:
+    template <typename Fn>
+    bool edit(Fn&& fn) {
+        return catalog_.update([&](memory::ContentCatalog& c) {
+            if (!fn(c.*table_)) return false;
+            // read() is still the published version while the update runs
+            c.advance(catalog_.read());
+            c.indexText(&catalog_.read());
+            return true;
+        });
+    }
+
+    Catalog& catalog_;
+    Table memory::ContentCatalog::* table_;
+};
+
+/**
+ * Bridge lesson repository wrapping global lessons catalog.
+ * Reads are lock-free snapshots; writes publish a new catalog version.
  */
 class BridgeLessonRepository : public ILessonRepository {
 public:
-    BridgeLessonRepository(std::map<std::string, core::Lesson>& lessons)
-        : lessons_(lessons) {}
+    BridgeLessonRepository(concurrency::RcuCell<memory::ContentCatalog>& catalog)
+        : lessons_(catalog, &memory::ContentCatalog::lessons) {}
 
     bool add(const core::Lesson& lesson) override {
-        if (lessons_.find(lesson.lessonId) != lessons_.end()) {
-            return false;
-        }
-        lessons_[lesson.lessonId] = lesson;
-        return true;
+        return lessons_.insert(lesson.lessonId, lesson);
     }
 
     std::optional<core::Lesson> findById(const std::string& lessonId) const override {
-        auto it = lessons_.find(lessonId);
-        if (it != lessons_.end()) {
-            return it->second;
-        }
-        return std::nullopt;
+        return lessons_.get(lessonId);
     }
 
     std::vector<core::Lesson> findAll() const override {
-        std::vector<core::Lesson> result;
-        for (const auto& pair : lessons_) {
-            result.push_back(pair.second);
-        }
-        return result;
+        return lessons_.select({});
     }
 
-    std::vector<core::Lesson> findByLevel(const std::string& level) const override {
-        std::vector<core::Lesson> result;
-        for (const auto& pair : lessons_) {
-            if (pair.second.level == level) {
-                result.push_back(pair.second);
-            }
-        }
-        return result;
+    std::vector<core::Lesson> findByLevel(core::Level level) const override {
+        return lessons_.select({level});
     }
 
-    std::vector<core::Lesson> findByTopic(const std::string& topic) const override {
-        std::vector<core::Lesson> result;
-        for (const auto& pair : lessons_) {
-            if (pair.second.topic == topic) {
-                result.push_back(pair.second);
-            }
-        }
-        return result;
+    std::vector<core::Lesson> findByTopic(core::Topic topic) const override {
+        return lessons_.select({std::nullopt, topic});
     }
 
-    std::vector<core::Lesson> findByLevelAndTopic(const std::string& level,
-                                                   const std::string& topic) const override {
-        std::vector<core::Lesson> result;
-        for (const auto& pair : lessons_) {
-            if (pair.second.level == level && pair.second.topic == topic) {
-                result.push_back(pair.second);
-            }
-        }
-        return result;
+    std::vector<core::Lesson> findByLevelAndTopic(core::Level level,
+                                                   std::optional<core::Topic> topic) const override {
+        return lessons_.select({level, topic});
     }
 
     bool exists(const std::string& lessonId) const override {
-        return lessons_.find(lessonId) != lessons_.end();
+        return lessons_.contains(lessonId);
     }
 
     bool update(const core::Lesson& lesson) override {
-        auto it = lessons_.find(lesson.lessonId);
-        if (it != lessons_.end()) {
-            it->second = lesson;
-            return true;
-        }
-        return false;
+        return lessons_.replace(lesson.lessonId, lesson);
     }
 
     bool remove(const std::string& lessonId) override {
-        return lessons_.erase(lessonId) > 0;
+        return lessons_.erase(lessonId);
     }
 
     size_t count() const override {
         return lessons_.size();
     }
 
-    size_t countByLevel(const std::string& level) const override {
-        size_t cnt = 0;
-        for (const auto& pair : lessons_) {
-            if (pair.second.level == level) {
-                cnt++;
-            }
-        }
-        return cnt;
+    size_t countByLevel(core::Level level) const override {
+        return lessons_.count({level});
     }
 
 private:
-    std::map<std::string, core::Lesson>& lessons_;
+    CatalogRef<core::Lesson> lessons_;
 };
 
 /**
- * Bridge test repository wrapping global tests map.
+ * Bridge test repository wrapping global tests catalog.
+ * Reads are lock-free snapshots; writes publish a new catalog version.
  */
 class BridgeTestRepository : public ITestRepository {
 public:
-    BridgeTestRepository(std::map<std::string, core::Test>& tests)
-        : tests_(tests) {}
+    BridgeTestRepository(concurrency::RcuCell<memory::ContentCatalog>& catalog)
+        : tests_(catalog, &memory::ContentCatalog::tests) {}
 
     bool add(const core::Test& test) override {
-        if (tests_.find(test.testId) != tests_.end()) {
-            return false;
-        }
-        tests_[test.testId] = test;
-        return true;
+        return tests_.insert(test.testId, test);
     }
 
     std::optional<core::Test> findById(const std::string& testId) const override {
-        auto it = tests_.find(testId);
-        if (it != tests_.end()) {
-            return it->second;
-        }
-        return std::nullopt;
+        return tests_.get(testId);
     }
 
     std::vector<core::Test> findAll() const override {
-        std::vector<core::Test> result;
-        for (const auto& pair : tests_) {
-            result.push_back(pair.second);
-        }
-        return result;
+        return tests_.select({});
     }
 
-    std::vector<core::Test> findByLevel(const std::string& level) const override {
-        std::vector<core::Test> result;
-        for (const auto& pair : tests_) {
-            if (pair.second.level == level) {
-                result.push_back(pair.second);
-            }
-        }
-        return result;
+    std::vector<core::Test> findByLevel(core::Level level) const override {
+        return tests_.select({level});
     }
 
-    std::vector<core::Test> findByType(const std::string& testType) const override {
-        std::vector<core::Test> result;
-        for (const auto& pair : tests_) {
-            if (pair.second.testType == testType) {
-                result.push_back(pair.second);
-            }
-        }
-        return result;
+    std::vector<core::Test> findByType(const core::Symbol& testType) const override {
+        return tests_.select({}, [&](const core::Test& t) { return t.testType == testType; });
     }
 
-    std::vector<core::Test> findByLevelAndType(const std::string& level,
-                                                const std::string& testType) const override {
-        std::vector<core::Test> result;
-        for (const auto& pair : tests_) {
-            if (pair.second.level == level && pair.second.testType == testType) {
-                result.push_back(pair.second);
-            }
-        }
-        return result;
+    std::vector<core::Test> findByLevelAndType(core::Level level,
+                                                const core::Symbol& testType) const override {
+        return tests_.select({level}, [&](const core::Test& t) {
+            return testType.empty() || t.testType == testType;
+        });
     }
 
     bool exists(const std::string& testId) const override {
-        return tests_.find(testId) != tests_.end();
+        return tests_.contains(testId);
     }
 
     bool update(const core::Test& test) override {
-        auto it = tests_.find(test.testId);
-        if (it != tests_.end()) {
-            it->second = test;
-            return true;
-        }
-        return false;
+        return tests_.replace(test.testId, test);
     }
 
     bool remove(const std::string& testId) override {
-        return tests_.erase(testId) > 0;
+        return tests_.erase(testId);
     }
 
     size_t count() const override {
@@ -195,87 +218,51 @@ public:
     }
 
 private:
-    std::map<std::string, core::Test>& tests_;
+    CatalogRef<core::Test> tests_;
 };
 
 /**
- * Bridge exercise repository wrapping global exercises map and submissions.
+ * Bridge exercise repository wrapping global exercises catalog and submissions.
+ * Exercise reads are lock-free snapshots; the mutex guards submissions only.
  */
 class BridgeExerciseRepository : public IExerciseRepository {
 public:
     BridgeExerciseRepository(
-        std::map<std::string, core::Exercise>& exercises,
+        concurrency::RcuCell<memory::ContentCatalog>& catalog,
         std::vector<core::ExerciseSubmission>& submissions,
         std::mutex& mutex)
-        : exercises_(exercises), submissions_(submissions), mutex_(mutex) {}
+        : exercises_(catalog, &memory::ContentCatalog::exercises), submissions_(submissions), mutex_(mutex) {}
 
     bool addExercise(const core::Exercise& exercise) override {
-        std::lock_guard<std::mutex> lock(mutex_);
-        if (exercises_.find(exercise.exerciseId) != exercises_.end()) {
-            return false;
-        }
-        exercises_[exercise.exerciseId] = exercise;
-        return true;
+        return exercises_.insert(exercise.exerciseId, exercise);
     }
 
     std::optional<core::Exercise> findExerciseById(const std::string& exerciseId) const override {
-        std::lock_guard<std::mutex> lock(mutex_);
-        auto it = exercises_.find(exerciseId);
-        if (it != exercises_.end()) {
-            return it->second;
-        }
-        return std::nullopt;
+        return exercises_.get(exerciseId);
     }
 
     std::vector<core::Exercise> findAllExercises() const override {
-        std::lock_guard<std::mutex> lock(mutex_);
-        std::vector<core::Exercise> result;
-        for (const auto& pair : exercises_) {
-            result.push_back(pair.second);
-        }
-        return result;
+        return exercises_.select({});
     }
 
-    std::vector<core::Exercise> findExercisesByLevel(const std::string& level) const override {
-        std::lock_guard<std::mutex> lock(mutex_);
-        std::vector<core::Exercise> result;
-        for (const auto& pair : exercises_) {
-            if (pair.second.level == level) {
-                result.push_back(pair.second);
-            }
-        }
-        return result;
+    std::vector<core::Exercise> findExercisesByLevel(core::Level level) const override {
+        return exercises_.select({level});
     }
 
-    std::vector<core::Exercise> findExercisesByType(const std::string& type) const override {
-        std::lock_guard<std::mutex> lock(mutex_);
-        std::vector<core::Exercise> result;
-        for (const auto& pair : exercises_) {
-            if (pair.second.exerciseType == type) {
-                result.push_back(pair.second);
-            }
-        }
-        return result;
+    std::vector<core::Exercise> findExercisesByType(core::ExerciseType type) const override {
+        return exercises_.select({std::nullopt, std::nullopt, int(type)});
     }
 
     bool exerciseExists(const std::string& exerciseId) const override {
-        std::lock_guard<std::mutex> lock(mutex_);
-        return exercises_.find(exerciseId) != exercises_.end();
+        return exercises_.contains(exerciseId);
     }
 
     bool updateExercise(const core::Exercise& exercise) override {
-        std::lock_guard<std::mutex> lock(mutex_);
-        auto it = exercises_.find(exercise.exerciseId);
-        if (it != exercises_.end()) {
-            it->second = exercise;
-            return true;
-        }
-        return false;
+        return exercises_.replace(exercise.exerciseId, exercise);
     }
 
     bool removeExercise(const std::string& exerciseId) override {
-        std::lock_guard<std::mutex> lock(mutex_);
-        return exercises_.erase(exerciseId) > 0;
+        return exercises_.erase(exerciseId);
     }
 
     bool addSubmission(const core::ExerciseSubmission& submission) override {
@@ -374,7 +361,6 @@ public:
     }
 
     size_t countExercises() const override {
-        std::lock_guard<std::mutex> lock(mutex_);
         return exercises_.size();
     }
 
@@ -396,17 +382,10 @@ public:
 
     // New methods for homework/practice workflow
     std::vector<core::Exercise> findExercisesByLevelAndType(
-        const std::string& level, const std::string& type) const override {
-        std::lock_guard<std::mutex> lock(mutex_);
-        std::vector<core::Exercise> result;
-        for (const auto& pair : exercises_) {
-            bool matchLevel = level.empty() || pair.second.level == level;
-            bool matchType = type.empty() || pair.second.exerciseType == type;
-            if (matchLevel && matchType) {
-                result.push_back(pair.second);
-            }
-        }
-        return result;
+        std::optional<core::Level> level, std::optional<core::ExerciseType> type) const override {
+        memory::CatalogFilter filter{level};
+        if (type) filter.kind = int(*type);
+        return exercises_.select(filter);
     }
 
     std::vector<core::ExerciseSubmission> findDraftsByUser(
@@ -456,7 +435,7 @@ public:
             if (sub.submissionId == submissionId) {
                 sub.content = content;
                 sub.audioUrl = audioUrl;
-                sub.status = core::SubmissionStatusStr::DRAFT;
+                sub.status = core::SubmissionStatus::Draft;
                 return true;
             }
         }
@@ -510,101 +489,60 @@ public:
     }
 
 private:
-    std::map<std::string, core::Exercise>& exercises_;
+    CatalogRef<core::Exercise> exercises_;
     std::vector<core::ExerciseSubmission>& submissions_;
     std::mutex& mutex_;
 };
 
 /**
- * Bridge game repository wrapping global games map and sessions.
+ * Bridge game repository wrapping global games catalog and sessions.
+ * Game reads are lock-free snapshots; the mutex guards sessions only.
  */
 class BridgeGameRepository : public IGameRepository {
 public:
     BridgeGameRepository(
-        std::map<std::string, core::Game>& games,
+        concurrency::RcuCell<memory::ContentCatalog>& catalog,
         std::map<std::string, core::GameSession>& gameSessions,
         std::mutex& mutex)
-        : games_(games), sessions_(gameSessions), mutex_(mutex) {}
+        : games_(catalog, &memory::ContentCatalog::games), sessions_(gameSessions), mutex_(mutex) {}
 
     bool addGame(const core::Game& game) override {
-        std::lock_guard<std::mutex> lock(mutex_);
-        if (games_.find(game.gameId) != games_.end()) {
-            return false;
-        }
-        games_[game.gameId] = game;
-        return true;
+        return games_.insert(game.gameId, game);
     }
 
     std::optional<core::Game> findGameById(const std::string& gameId) const override {
-        std::lock_guard<std::mutex> lock(mutex_);
-        auto it = games_.find(gameId);
-        if (it != games_.end()) {
-            return it->second;
-        }
-        return std::nullopt;
+        return games_.get(gameId);
     }
 
     std::vector<core::Game> findAllGames() const override {
-        std::lock_guard<std::mutex> lock(mutex_);
-        std::vector<core::Game> result;
-        for (const auto& pair : games_) {
-            result.push_back(pair.second);
-        }
-        return result;
+        return games_.select({});
     }
 
-    std::vector<core::Game> findGamesByLevel(const std::string& level) const override {
-        std::lock_guard<std::mutex> lock(mutex_);
-        std::vector<core::Game> result;
-        for (const auto& pair : games_) {
-            if (pair.second.level == level) {
-                result.push_back(pair.second);
-            }
-        }
-        return result;
+    std::vector<core::Game> findGamesByLevel(core::Level level) const override {
+        return games_.select({level});
     }
 
-    std::vector<core::Game> findGamesByType(const std::string& gameType) const override {
-        std::lock_guard<std::mutex> lock(mutex_);
-        std::vector<core::Game> result;
-        for (const auto& pair : games_) {
-            if (pair.second.gameType == gameType) {
-                result.push_back(pair.second);
-            }
-        }
-        return result;
+    std::vector<core::Game> findGamesByType(core::GameType gameType) const override {
+        return games_.select({std::nullopt, std::nullopt, int(gameType)});
     }
 
-    std::vector<core::Game> findGamesByLevelAndType(const std::string& level,
-                                                     const std::string& gameType) const override {
-        std::lock_guard<std::mutex> lock(mutex_);
-        std::vector<core::Game> result;
-        for (const auto& pair : games_) {
-            if (pair.second.level == level && pair.second.gameType == gameType) {
-                result.push_back(pair.second);
-            }
-        }
-        return result;
+    std::vector<core::Game> findGamesByLevelAndType(std::optional<core::Level> level,
+                                                     std::optional<core::GameType> gameType) const override {
+        memory::CatalogFilter filter{level};
+        if (gameType) filter.kind = int(*gameType);
+        return games_.select(filter);
     }
 
     bool gameExists(const std::string& gameId) const override {
-        std::lock_guard<std::mutex> lock(mutex_);
-        return games_.find(gameId) != games_.end();
+        return games_.contains(gameId);
     }
 
     bool updateGame(const core::Game& game) override {
-        std::lock_guard<std::mutex> lock(mutex_);
-        auto it = games_.find(game.gameId);
-        if (it != games_.end()) {
-            it->second = game;
-            return true;
-        }
-        return false;
+        return games_.replace(game.gameId, game);
     }
 
     bool removeGame(const std::string& gameId) override {
-        std::lock_guard<std::mutex> lock(mutex_);
-        return games_.erase(gameId) > 0;
+        return games_.erase(gameId);
     }
 
     bool addSession(const core::GameSession& session) override {
@@ -685,7 +623,6 @@ public:
     }
 
     size_t countGames() const override {
-        std::lock_guard<std::mutex> lock(mutex_);
         return games_.size();
     }
 
@@ -695,7 +632,7 @@ public:
     }
 
 private:
-    std::map<std::string, core::Game>& games_;
+    CatalogRef<core::Game> games_;
     std::map<std::string, core::GameSession>& sessions_;
     std::mutex& mutex_;
 };
@@ -0,0 +1,227 @@
+#include "channel_store.h"
+
+#include <algorithm>
+
+namespace english_learning {
+namespace repository {
+namespace memory {
+
+bool ChannelStore::create(const core::Channel& channel) {
+    if (channels_.count(channel.channelId)) return false;
+    Entry& entry = channels_[channel.channelId];
+    entry.channel = channel;
+    entry.members = std::make_shared<const std::vector<std::string>>();
+    if (journal_) journal_->recordChannel(channel);
+    return true;
+}
+
+const core::Channel* ChannelStore::find(const std::string& channelId) const {
+    auto it = channels_.find(channelId);
+    return it != channels_.end() ? &it->second.channel : nullptr;
+}
+
+bool ChannelStore::addMember(const std::string& channelId, const std::string& userId) {
+    auto it = channels_.find(channelId);
+    if (it == channels_.end()) return false;
+    Entry& entry = it->second;
+    // New members start with nothing unread
+    if (!entry.seen.emplace(userId, entry.base + entry.messages.size()).second) return false;
+
+    auto members = std::make_shared<std::vector<std::string>>(*entry.members);
+    members->push_back(userId);
+    entry.members = members;
+    byUser_[userId].insert(channelId);
+    if (journal_) journal_->recordMember(channelId, userId, true);
+    return true;
+}
+
+bool ChannelStore::removeMember(const std::string& channelId, const std::string& userId) {
+    auto it = channels_.find(channelId);
+    if (it == channels_.end()) return false;
+    Entry& entry = it->second;
+    if (entry.seen.erase(userId) == 0) return false;
+
+    auto members = std::make_shared<std::vector<std::string>>(*entry.members);
+    members->erase(std::find(members->begin(), members->end(), userId));
+    entry.members = members;
+
+    auto channels = byUser_.find(userId);
+    channels->second.erase(channelId);
+    if (channels->second.empty()) byUser_.erase(channels);
+    if (journal_) journal_->recordMember(channelId, userId, false);
+    return true;
+}
+
+bool ChannelStore::isMember(const std::string& channelId, const std::string& userId) const {
+    auto it = channels_.find(channelId);
+    return it != channels_.end() && it->second.seen.count(userId) > 0;
+}
+
+ChannelStore::Members ChannelStore::members(const std::string& channelId) const {
+    auto it = channels_.find(channelId);
+    return it != channels_.end() ? it->second.members : Members();
+}
+
+std::vector<const core::Channel*> ChannelStore::channelsFor(const std::string& userId) const {
+    std::vector<const core::Channel*> result;
+    auto it = byUser_.find(userId);
+    if (it == byUser_.end()) return result;
+
+    for (const std::string& channelId : it->second) {
+        result.push_back(&channels_.at(channelId).channel);
+    }
+    std::sort(result.begin(), result.end(), [](const core::Channel* a, const core::Channel* b) {
+        return a->createdAt != b->createdAt ? a->createdAt < b->createdAt : a->channelId < b->channelId;
+    });
+    return result;
+}
+
+bool ChannelStore::append(const core::ChatMessage& message) {
+    auto it = channels_.find(message.recipientId);
+    if (it == channels_.end()) return false;
+    Entry& entry = it->second;
+    uint64_t seq = entry.base + entry.messages.size();
+    if (!entry.offsets.emplace(message.messageId, seq).second) return false;
+
+    entry.messages.push_back(message);
+    auto sender = entry.seen.find(message.senderId);
+    if (sender != entry.seen.end()) sender->second = seq + 1;
+    if (journal_) journal_->recordChannelMessage(message, seq);
+    return true;
+}
+
+bool ChannelStore::restore(const core::ChatMessage& message, uint64_t seq) {
+    auto it = channels_.find(message.recipientId);
+    if (it == channels_.end()) return false;
+    Entry& entry = it->second;
+    if (entry.messages.empty()) entry.base = seq;
+    return append(message);
+}
+
+bool ChannelStore::remove(const std::string& channelId, const std::string& messageId) {
+    auto it = channels_.find(channelId);
+    if (it == channels_.end()) return false;
+    Entry& entry = it->second;
+    auto offset = entry.offsets.find(messageId);
+    if (offset == entry.offsets.end()) return false;
+
+    // Later messages move down one, and so does whoever had seen this one
+    uint64_t seq = offset->second;
+    entry.offsets.erase(offset);
+    entry.messages.erase(entry.messages.begin() + (seq - entry.base));
+    for (size_t i = seq - entry.base; i < entry.messages.size(); ++i) {
+        entry.offsets[entry.messages[i].messageId] = entry.base + i;
+    }
+    for (auto& member : entry.seen) {
+        if (member.second > seq) member.second--;
+    }
+    if (journal_) journal_->recordChannelRemove(channelId, messageId);
+    return true;
+}
+
+std::vector<core::ChatMessage> ChannelStore::history(const std::string& channelId,
+                                                     const std::string& beforeId, size_t count) const {
+    auto it = channels_.find(channelId);
+    if (it == channels_.end()) return {};
+    const Entry& entry = it->second;
+
+    size_t end = entry.messages.size();
+    if (!beforeId.empty()) {
+        auto cursor = entry.offsets.find(beforeId);
+        if (cursor == entry.offsets.end()) return {};
+        end = cursor->second - entry.base;
+    }
+    size_t begin = (count > 0 && end > count) ? end - count : 0;
+    return std::vector<core::ChatMessage>(entry.messages.begin() + begin, entry.messages.begin() + end);
+}
+
+const core::ChatMessage* ChannelStore::lastMessage(const std::string& channelId) const {
+    auto it = channels_.find(channelId);
+    if (it == channels_.end() || it->second.messages.empty()) return nullptr;
+    return &it->second.messages.back();
+}
+
+const core::ChatMessage* ChannelStore::findMessage(const std::string& channelId,
+                                                 const std::string& messageId) const {
+    auto it = channels_.find(channelId);
+    if (it == channels_.end()) return nullptr;
+    auto offset = it->second.offsets.find(messageId);
+    if (offset == it->second.offsets.end()) return nullptr;
+    return &it->second.messages[offset->second - it->second.base];
+}
+
+size_t ChannelStore::unreadCount(const std::string& channelId, const std::string& userId) const {
+    auto it = channels_.find(channelId);
+    if (it == channels_.end()) return 0;
+    auto seen = it->second.seen.find(userId);
+    if (seen == it->second.seen.end()) return 0;
+    // A replayed count can run ahead where a message was withdrawn
+    uint64_t total = it->second.base + it->second.messages.size();
+    return total > seen->second ? static_cast<size_t>(total - seen->second) : 0;
+}
+
+void ChannelStore::markRead(const std::string& channelId, const std::string& userId) {
+    auto it = channels_.find(channelId);
+    if (it == channels_.end()) return;
+    auto seen = it->second.seen.find(userId);
+    uint64_t total = it->second.base + it->second.messages.size();
+    if (seen == it->second.seen.end() || seen->second == total) return;
+    seen->second = total;
+    if (journal_) journal_->recordSeen(channelId, userId, total);
+}
+
+void ChannelStore::restoreSeen(const std::string& channelId, const std::string& userId, uint64_t seen) {
+    auto it = channels_.find(channelId);
+    if (it == channels_.end()) return;
+    auto member = it->second.seen.find(userId);
+    if (member != it->second.seen.end()) member->second = seen;
+}
+
+std::vector<core::ChatMessage> ChannelStore::archivable(size_t keep) const {
+    std::vector<core::ChatMessage> result;
+    for (const auto& pair : channels_) {
+        const auto& messages = pair.second.messages;
+        if (messages.size() > keep) result.insert(result.end(), messages.begin(), messages.end() - keep);
+    }
+    return result;
+}
+
+size_t ChannelStore::evictThrough(const std::string& channelId, const std::string& messageId) {
+    auto it = channels_.find(channelId);
+    if (it == channels_.end()) return 0;
+    Entry& entry = it->second;
+    auto offset = entry.offsets.find(messageId);
+    if (offset == entry.offsets.end()) return 0;
+
+    size_t count = static_cast<size_t>(offset->second - entry.base) + 1;
+    for (size_t i = 0; i < count; ++i) entry.offsets.erase(entry.messages[i].messageId);
+    entry.messages.erase(entry.messages.begin(), entry.messages.begin() + count);
+    entry.base += count;
+    return count;
+}
+
+std::vector<std::string> ChannelStore::channelIds() const {
+    std::vector<std::string> ids;
+    ids.reserve(channels_.size());
+    for (const auto& pair : channels_) ids.push_back(pair.first);
+    return ids;
+}
+
+size_t ChannelStore::messageIds(const std::string& channelId, std::unordered_map<std::string, bool>& out) const {
+    auto it = channels_.find(channelId);
+    if (it == channels_.end()) return 0;
+    for (const core::ChatMessage& m : it->second.messages) out.emplace(m.messageId, false);
+    return it->second.messages.size();
+}
+
+std::vector<core::ChatMessage> ChannelStore::all() const {
+    std::vector<core::ChatMessage> result;
+    for (const auto& pair : channels_) {
+        result.insert(result.end(), pair.second.messages.begin(), pair.second.messages.end());
+    }
+    return result;
+}
+
+} // namespace memory
+} // namespace repository
+} // namespace english_learning
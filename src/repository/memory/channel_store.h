@@ -0,0 +1,150 @@
+#ifndef ENGLISH_LEARNING_REPOSITORY_MEMORY_CHANNEL_STORE_H
+#define ENGLISH_LEARNING_REPOSITORY_MEMORY_CHANNEL_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "include/core/channel.h"
+#include "include/core/chat_message.h"
+
+namespace english_learning {
+namespace repository {
+namespace memory {
+
+/**
+ * Receives every ChannelStore mutation, e.g. to persist it in a write-ahead
+ * log. Called under the store's serialization, so implementations only need
+ * to be cheap; see ChatJournal for waitDurable().
+ */
+class ChannelJournal {
+public:
+    virtual ~ChannelJournal() = default;
+
+    virtual void recordChannel(const core::Channel& channel) = 0;
+    virtual void recordMember(const std::string& channelId, const std::string& userId, bool joined) = 0;
+    // seq numbers the message within its channel, counting from 0
+    virtual void recordChannelMessage(const core::ChatMessage& message, uint64_t seq) = 0;
+    virtual void recordChannelRemove(const std::string& channelId, const std::string& messageId) = 0;
+    virtual void recordSeen(const std::string& channelId, const std::string& userId, uint64_t seen) = 0;
+
+    virtual bool waitDurable() = 0;
+};
+
+/**
+ * Group chat channels, their members and message history.
+ *
+ * Each channel numbers its messages in send order and keeps a per-member
+ * count of messages seen, so a member's unread count is a subtraction and
+ * offline members need no per-message bookkeeping. The member list is an
+ * immutable snapshot replaced on every membership change; fan-out takes a
+ * reference to it under the caller's lock and iterates it after releasing
+ * the lock.
+ *
+ * This is the hot tier: a channel's oldest messages can be moved out to an
+ * archive (see archivable() / evictThrough()). Numbering and seen counts
+ * carry on across the evicted ones.
+ *
+ * Not synchronized: callers serialize access (channelMutex on the server).
+ */
+class ChannelStore {
+public:
+    using Members = std::shared_ptr<const std::vector<std::string>>;
+
+    // Create a channel; false if its id is already taken
+    bool create(const core::Channel& channel);
+
+    const core::Channel* find(const std::string& channelId) const;
+
+    // Add or remove a member; false if nothing changed
+    bool addMember(const std::string& channelId, const std::string& userId);
+    bool removeMember(const std::string& channelId, const std::string& userId);
+
+    bool isMember(const std::string& channelId, const std::string& userId) const;
+
+    // Member ids in join order (null for an unknown channel)
+    Members members(const std::string& channelId) const;
+
+    // Channels userId belongs to, ordered by creation time
+    std::vector<const core::Channel*> channelsFor(const std::string& userId) const;
+
+    // Append a message addressed to channel message.recipientId; false if the
+    // channel is unknown or the messageId is already stored. The sender has
+    // seen everything up to and including its own message.
+    bool append(const core::ChatMessage& message);
+
+    // Replay an append: as append(), but a channel holding no messages
+    // resumes its numbering at seq (its older messages are archived)
+    bool restore(const core::ChatMessage& message, uint64_t seq);
+
+    // Withdraw a message, e.g. one that could not be persisted; false if it
+    // is not in the channel
+    bool remove(const std::string& channelId, const std::string& messageId);
+
+    /**
+     * Page backwards through a channel: up to count messages (0 = no limit),
+     * oldest first, preceding beforeId (empty = newest page). A beforeId that
+     * is not in this channel yields an empty page.
+     */
+    std::vector<core::ChatMessage> history(const std::string& channelId, const std::string& beforeId,
+                                           size_t count) const;
+
+    const core::ChatMessage* lastMessage(const std::string& channelId) const;
+
+    const core::ChatMessage* findMessage(const std::string& channelId, const std::string& messageId) const;
+
+    size_t unreadCount(const std::string& channelId, const std::string& userId) const;
+
+    // Mark every message in the channel as seen by userId
+    void markRead(const std::string& channelId, const std::string& userId);
+
+    // Replay a member's seen count; ignored unless userId is a member
+    void restoreSeen(const std::string& channelId, const std::string& userId, uint64_t seen);
+
+    /**
+     * Messages beyond the newest keep of each channel, grouped by channel,
+     * each group in send order: what can move to the archive.
+     */
+    std::vector<core::ChatMessage> archivable(size_t keep) const;
+
+    /**
+     * Drop a channel's messages up to and including messageId once they are
+     * archived elsewhere; returns the number dropped (0 if messageId is not
+     * held for that channel). Not journaled, as in ChatStore.
+     */
+    size_t evictThrough(const std::string& channelId, const std::string& messageId);
+
+    std::vector<std::string> channelIds() const;
+
+    // Add the ids of the channel's messages to out; returns how many
+    size_t messageIds(const std::string& channelId, std::unordered_map<std::string, bool>& out) const;
+
+    // Every held message of every channel, in no particular order
+    std::vector<core::ChatMessage> all() const;
+
+    // Attach after replaying existing channels so replayed records are not re-logged
+    void setJournal(ChannelJournal* journal) { journal_ = journal; }
+
+private:
+    struct Entry {
+        core::Channel channel;
+        std::vector<core::ChatMessage> messages;           // numbered base, base + 1, ...
+        uint64_t base = 0;                                 // messages evicted before these
+        std::unordered_map<std::string, uint64_t> offsets; // messageId -> number
+        Members members;                                   // snapshot, join order
+        std::unordered_map<std::string, uint64_t> seen;    // member -> messages seen
+    };
+
+    std::unordered_map<std::string, Entry> channels_;                          // channelId -> channel
+    std::unordered_map<std::string, std::unordered_set<std::string>> byUser_;  // userId -> channelIds
+    ChannelJournal* journal_ = nullptr;
+};
+
+} // namespace memory
+} // namespace repository
+} // namespace english_learning
+
+#endif // ENGLISH_LEARNING_REPOSITORY_MEMORY_CHANNEL_STORE_H
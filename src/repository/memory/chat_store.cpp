@@ -0,0 +1,250 @@
+#include "chat_store.h"
+
+#include <algorithm>
+
+namespace english_learning {
+namespace repository {
+namespace memory {
+
+namespace {
+
+void sortByTimestamp(std::vector<core::ChatMessage>& messages) {
+    std::stable_sort(messages.begin(), messages.end(),
+                     [](const core::ChatMessage& a, const core::ChatMessage& b) {
+                         return a.timestamp < b.timestamp;
+                     });
+}
+
+} // namespace
+
+std::string ChatStore::conversationKey(const std::string& user1, const std::string& user2) {
+    // '\x1f' (unit separator) never occurs in generated ids
+    return user1 < user2 ? user1 + '\x1f' + user2 : user2 + '\x1f' + user1;
+}
+
+bool ChatStore::append(const core::ChatMessage& message) {
+    if (byId_.count(message.messageId)) return false;
+
+    Segment& segment = segments_[conversationKey(message.senderId, message.recipientId)];
+    segment.push_back(message);
+    byId_[message.messageId] = Location{&segment, segment.size() - 1};
+
+    partners_[message.senderId].insert(message.recipientId);
+    partners_[message.recipientId].insert(message.senderId);
+    if (!message.read) addUnread(message.recipientId, message.senderId);
+    if (journal_) journal_->recordAppend(message);
+    return true;
+}
+
+const core::ChatMessage* ChatStore::findById(const std::string& messageId) const {
+    auto it = byId_.find(messageId);
+    if (it == byId_.end()) return nullptr;
+    return &(*it->second.segment)[it->second.offset];
+}
+
+const std::vector<core::ChatMessage>& ChatStore::conversation(const std::string& user1,
+                                                               const std::string& user2) const {
+    static const Segment none;
+    auto it = segments_.find(conversationKey(user1, user2));
+    return it != segments_.end() ? it->second : none;
+}
+
+std::vector<core::ChatMessage> ChatStore::history(const std::string& user1, const std::string& user2,
+                                                  const std::string& beforeId, core::Timestamp beforeTs,
+                                                  size_t count) const {
+    auto it = segments_.find(conversationKey(user1, user2));
+    if (it == segments_.end()) return {};
+    const Segment& segment = it->second;
+
+    size_t end = segment.size();
+    if (!beforeId.empty()) {
+        auto cursor = byId_.find(beforeId);
+        if (cursor == byId_.end() || cursor->second.segment != &segment) return {};
+        end = cursor->second.offset;
+    } else if (beforeTs > 0) {
+        auto pos = std::lower_bound(segment.begin(), segment.end(), beforeTs,
+                                    [](const core::ChatMessage& m, core::Timestamp ts) {
+                                        return m.timestamp < ts;
+                                    });
+        end = static_cast<size_t>(pos - segment.begin());
+    }
+
+    size_t begin = (count > 0 && end > count) ? end - count : 0;
+    return std::vector<core::ChatMessage>(segment.begin() + begin, segment.begin() + end);
+}
+
+std::vector<core::ChatMessage> ChatStore::findByUser(const std::string& userId) const {
+    std::vector<core::ChatMessage> result;
+    auto it = partners_.find(userId);
+    if (it == partners_.end()) return result;
+
+    for (const std::string& peer : it->second) {
+        const Segment& segment = conversation(userId, peer);
+        result.insert(result.end(), segment.begin(), segment.end());
+    }
+    sortByTimestamp(result);
+    return result;
+}
+
+std::vector<core::ChatMessage> ChatStore::unreadFor(const std::string& userId) const {
+    std::vector<core::ChatMessage> result;
+    auto it = unread_.find(userId);
+    if (it == unread_.end()) return result;
+
+    for (const auto& pair : it->second.bySender) {
+        // Unread messages cluster at the tail; stop once all are found
+        size_t remaining = pair.second;
+        const Segment& segment = conversation(userId, pair.first);
+        for (auto msg = segment.rbegin(); msg != segment.rend() && remaining > 0; ++msg) {
+            if (!msg->read && msg->recipientId == userId) {
+                result.push_back(*msg);
+                remaining--;
+            }
+        }
+    }
+    sortByTimestamp(result);
+    return result;
+}
+
+size_t ChatStore::countUnreadFor(const std::string& userId) const {
+    auto it = unread_.find(userId);
+    return it != unread_.end() ? it->second.total : 0;
+}
+
+bool ChatStore::markAsRead(const std::string& messageId) {
+    auto it = byId_.find(messageId);
+    if (it == byId_.end()) return false;
+
+    core::ChatMessage& msg = (*it->second.segment)[it->second.offset];
+    if (!msg.read) {
+        msg.read = true;
+        dropUnread(msg.recipientId, msg.senderId, 1);
+        if (journal_) journal_->recordRead(messageId);
+    }
+    return true;
+}
+
+size_t ChatStore::markConversationAsRead(const std::string& recipientId,
+                                         const std::string& senderId) {
+    auto counters = unread_.find(recipientId);
+    if (counters == unread_.end()) return 0;
+    auto pending = counters->second.bySender.find(senderId);
+    if (pending == counters->second.bySender.end()) return 0;
+
+    size_t remaining = pending->second;
+    auto segment = segments_.find(conversationKey(recipientId, senderId));
+    size_t marked = 0;
+    if (segment != segments_.end()) {
+        for (auto msg = segment->second.rbegin();
+             msg != segment->second.rend() && marked < remaining; ++msg) {
+            if (!msg->read && msg->senderId == senderId) {
+                msg->read = true;
+                marked++;
+            }
+        }
+    }
+    dropUnread(recipientId, senderId, remaining);
+    if (journal_ && marked > 0) journal_->recordConversationRead(recipientId, senderId);
+    return marked;
+}
+
+bool ChatStore::remove(const std::string& messageId) {
+    auto it = byId_.find(messageId);
+    if (it == byId_.end()) return false;
+
+    Segment& segment = *it->second.segment;
+    size_t offset = it->second.offset;
+    if (!segment[offset].read) {
+        dropUnread(segment[offset].recipientId, segment[offset].senderId, 1);
+    }
+    byId_.erase(it);
+
+    segment.erase(segment.begin() + offset);
+    for (size_t i = offset; i < segment.size(); ++i) {
+        byId_[segment[i].messageId].offset = i;
+    }
+    if (journal_) journal_->recordRemove(messageId);
+    return true;
+}
+
+std::vector<core::ChatMessage> ChatStore::all() const {
+    std::vector<core::ChatMessage> result;
+    result.reserve(byId_.size());
+    for (const auto& pair : segments_) {
+        result.insert(result.end(), pair.second.begin(), pair.second.end());
+    }
+    sortByTimestamp(result);
+    return result;
+}
+
+std::vector<std::string> ChatStore::conversationKeys() const {
+    std::vector<std::string> keys;
+    keys.reserve(segments_.size());
+    for (const auto& pair : segments_) {
+        if (!pair.second.empty()) keys.push_back(pair.first);
+    }
+    return keys;
+}
+
+size_t ChatStore::readStates(const std::string& conversationKey, std::unordered_map<std::string, bool>& out) const {
+    auto it = segments_.find(conversationKey);
+    if (it == segments_.end()) return 0;
+    for (const core::ChatMessage& msg : it->second) out.emplace(msg.messageId, msg.read);
+    return it->second.size();
+}
+
+std::vector<core::ChatMessage> ChatStore::archivable(core::Timestamp cutoff) const {
+    std::vector<core::ChatMessage> result;
+    for (const auto& pair : segments_) {
+        for (const core::ChatMessage& msg : pair.second) {
+            if (msg.timestamp >= cutoff || !msg.read) break;
+            result.push_back(msg);
+        }
+    }
+    return result;
+}
+
+size_t ChatStore::evictThrough(const std::string& conversationKey, const std::string& messageId) {
+    auto segment = segments_.find(conversationKey);
+    auto last = byId_.find(messageId);
+    if (segment == segments_.end() || last == byId_.end() || last->second.segment != &segment->second) {
+        return 0;
+    }
+
+    Segment& messages = segment->second;
+    size_t count = last->second.offset + 1;
+    for (size_t i = 0; i < count; ++i) {
+        if (!messages[i].read) dropUnread(messages[i].recipientId, messages[i].senderId, 1);
+        byId_.erase(messages[i].messageId);
+    }
+    messages.erase(messages.begin(), messages.begin() + count);
+    for (size_t i = 0; i < messages.size(); ++i) {
+        byId_[messages[i].messageId].offset = i;
+    }
+    // The peers stay partners; only the emptied segment goes
+    if (messages.empty()) segments_.erase(segment);
+    return count;
+}
+
+void ChatStore::addUnread(const std::string& recipientId, const std::string& senderId) {
+    UnreadCounters& counters = unread_[recipientId];
+    counters.total++;
+    counters.bySender[senderId]++;
+}
+
+void ChatStore::dropUnread(const std::string& recipientId, const std::string& senderId, size_t n) {
+    auto counters = unread_.find(recipientId);
+    if (counters == unread_.end()) return;
+    auto pending = counters->second.bySender.find(senderId);
+    if (pending == counters->second.bySender.end()) return;
+
+    n = std::min(n, pending->second);
+    pending->second -= n;
+    counters->second.total -= n;
+    if (pending->second == 0) counters->second.bySender.erase(pending);
+    if (counters->second.total == 0) unread_.erase(counters);
+}
+
+} // namespace memory
+} // namespace repository
+} // namespace english_learning
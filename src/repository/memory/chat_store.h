@@ -0,0 +1,150 @@
+#ifndef ENGLISH_LEARNING_REPOSITORY_MEMORY_CHAT_STORE_H
+#define ENGLISH_LEARNING_REPOSITORY_MEMORY_CHAT_STORE_H
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "include/core/chat_message.h"
+
+namespace english_learning {
+namespace repository {
+namespace memory {
+
+/**
+ * Receives every successful ChatStore mutation, in order, so it can be made
+ * durable (see storage::ChatLog). Called with the store's lock held.
+ */
+class ChatJournal {
+public:
+    virtual ~ChatJournal() = default;
+
+    virtual void recordAppend(const core::ChatMessage& message) = 0;
+    virtual void recordRead(const std::string& messageId) = 0;
+    virtual void recordConversationRead(const std::string& recipientId,
+                                        const std::string& senderId) = 0;
+    virtual void recordRemove(const std::string& messageId) = 0;
+
+    // Block until everything recorded so far is durable; call without the
+    // store's lock. Returns false if the journal failed to persist the last
+    // record the calling thread made.
+    virtual bool waitDurable() = 0;
+};
+
+/**
+ * Conversation-indexed storage for direct chat messages.
+ *
+ * This is the hot tier: old, read messages can be moved out to an archive
+ * (see archivable() / evictThrough()), after which lookups here miss them.
+ *
+ * Messages are appended to a per-conversation segment keyed by the ordered
+ * pair of participant ids, so history and mark-read touch only the
+ * conversation involved. A messageId -> (segment, offset) index resolves
+ * single messages, and per-(recipient, sender) unread counters answer unread
+ * queries without scanning history.
+ *
+ * Not synchronized: callers serialize access (chatMutex on the server, the
+ * repository mutex in MemoryChatRepository). When a journal is attached,
+ * mutations are forwarded to it under the same serialization.
+ */
+class ChatStore {
+public:
+    // Key of the conversation between two users; independent of argument order
+    static std::string conversationKey(const std::string& user1, const std::string& user2);
+
+    // Append a message; returns false if its messageId is already stored
+    bool append(const core::ChatMessage& message);
+
+    const core::ChatMessage* findById(const std::string& messageId) const;
+
+    // Messages between two users in send order (empty if they never chatted)
+    const std::vector<core::ChatMessage>& conversation(const std::string& user1,
+                                                        const std::string& user2) const;
+
+    /**
+     * Page backwards through a conversation.
+     * Returns up to count messages (0 = no limit), oldest first, that precede
+     * the cursor: the message beforeId if given, otherwise the first message
+     * sent at or after beforeTs (0 = newest page). A beforeId that is not part
+     * of this conversation yields an empty page.
+     */
+    std::vector<core::ChatMessage> history(const std::string& user1, const std::string& user2,
+                                           const std::string& beforeId, core::Timestamp beforeTs,
+                                           size_t count) const;
+
+    // Every message sent or received by userId, ordered by timestamp
+    std::vector<core::ChatMessage> findByUser(const std::string& userId) const;
+
+    // Unread messages addressed to userId, ordered by timestamp
+    std::vector<core::ChatMessage> unreadFor(const std::string& userId) const;
+    size_t countUnreadFor(const std::string& userId) const;
+
+    bool markAsRead(const std::string& messageId);
+
+    // Mark everything senderId sent to recipientId as read; returns the number marked
+    size_t markConversationAsRead(const std::string& recipientId, const std::string& senderId);
+
+    bool remove(const std::string& messageId);
+
+    // All messages, ordered by timestamp
+    std::vector<core::ChatMessage> all() const;
+
+    // Key of every conversation with messages stored here
+    std::vector<std::string> conversationKeys() const;
+
+    // Add the read flag of each of a conversation's messages to out, by
+    // messageId; returns how many it has
+    size_t readStates(const std::string& conversationKey, std::unordered_map<std::string, bool>& out) const;
+
+    /**
+     * Messages ready for cold storage: for each conversation, its oldest
+     * messages sent before cutoff, stopping at the first unread one (unread
+     * messages stay here for login notifications). Grouped by conversation,
+     * each group in conversation order.
+     */
+    std::vector<core::ChatMessage> archivable(core::Timestamp cutoff) const;
+
+    /**
+     * Drop a conversation's messages up to and including messageId once they
+     * are archived elsewhere; returns the number dropped (0 if messageId is
+     * not in that conversation). Not journaled: the messages still exist,
+     * just not in this store.
+     */
+    size_t evictThrough(const std::string& conversationKey, const std::string& messageId);
+
+    size_t size() const { return byId_.size(); }
+
+    // Attach after replaying existing history so replayed records are not re-logged
+    void setJournal(ChatJournal* journal) { journal_ = journal; }
+    ChatJournal* journal() const { return journal_; }
+
+private:
+    using Segment = std::vector<core::ChatMessage>;
+
+    struct Location {
+        Segment* segment;
+        size_t offset;
+    };
+
+    struct UnreadCounters {
+        size_t total = 0;
+        std::unordered_map<std::string, size_t> bySender;
+    };
+
+    void addUnread(const std::string& recipientId, const std::string& senderId);
+    void dropUnread(const std::string& recipientId, const std::string& senderId, size_t n);
+
+    std::unordered_map<std::string, Segment> segments_;  // conversation key -> messages
+    std::unordered_map<std::string, Location> byId_;     // messageId -> position
+    std::unordered_map<std::string, std::unordered_set<std::string>> partners_;  // userId -> peers
+    std::unordered_map<std::string, UnreadCounters> unread_;  // recipientId -> counters
+    ChatJournal* journal_ = nullptr;
+};
+
+} // namespace memory
+} // namespace repository
+} // namespace english_learning
+
+#endif // ENGLISH_LEARNING_REPOSITORY_MEMORY_CHAT_STORE_H
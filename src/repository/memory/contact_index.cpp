@@ -0,0 +1,90 @@
+#include "contact_index.h"
+#include <algorithm>
+#include <cctype>
+#include <unordered_set>
+
+namespace english_learning {
+namespace repository {
+namespace memory {
+
+std::string ContactIndex::normalize(const std::string& text) {
+    size_t begin = text.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) return "";
+    size_t end = text.find_last_not_of(" \t\r\n");
+
+    std::string result = text.substr(begin, end - begin + 1);
+    std::transform(result.begin(), result.end(), result.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return result;
+}
+
+std::vector<std::string> ContactIndex::keysFor(const std::string& fullname,
+                                               const std::string& email) {
+    std::vector<std::string> keys;
+    std::string name = normalize(fullname);
+    for (size_t i = 0; i < name.size(); ++i) {
+        if (name[i] != ' ' && (i == 0 || name[i - 1] == ' ')) {
+            keys.push_back(name.substr(i));
+        }
+    }
+    std::string mail = normalize(email);
+    if (!mail.empty()) keys.push_back(mail);
+    return keys;
+}
+
+void ContactIndex::add(UserHandle handle, const std::string& fullname,
+                       const std::string& email, bool online) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    KeySet& keys = online ? online_ : offline_;
+    for (auto& key : keysFor(fullname, email)) {
+        keys.emplace(std::move(key), handle.value());
+    }
+}
+
+void ContactIndex::remove(UserHandle handle, const std::string& fullname,
+                          const std::string& email, bool online) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    KeySet& keys = online ? online_ : offline_;
+    for (auto& key : keysFor(fullname, email)) {
+        keys.erase(Key(std::move(key), handle.value()));
+    }
+}
+
+void ContactIndex::setOnline(UserHandle handle, const std::string& fullname,
+                             const std::string& email, bool online) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    KeySet& from = online ? offline_ : online_;
+    KeySet& to = online ? online_ : offline_;
+    for (auto& key : keysFor(fullname, email)) {
+        auto node = from.extract(Key(std::move(key), handle.value()));
+        if (!node.empty()) to.insert(std::move(node));
+    }
+}
+
+std::vector<UserHandle> ContactIndex::search(const std::string& query, size_t limit,
+                                             UserHandle exclude) const {
+    std::vector<UserHandle> result;
+    std::string prefix = normalize(query);
+    if (prefix.empty() || limit == 0) return result;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::unordered_set<uint32_t> seen;  // a user can match through several keys
+
+    auto scan = [&](const KeySet& keys) {
+        for (auto it = keys.lower_bound(Key(prefix, 0)); it != keys.end(); ++it) {
+            if (result.size() >= limit) return;
+            if (it->first.compare(0, prefix.size(), prefix) != 0) return;
+            if (it->second == exclude.value() || !seen.insert(it->second).second) continue;
+            result.push_back(UserHandle::make(it->second & UserHandle::INDEX_MASK,
+                                              static_cast<uint8_t>(it->second >> UserHandle::INDEX_BITS)));
+        }
+    };
+
+    scan(online_);
+    scan(offline_);
+    return result;
+}
+
+} // namespace memory
+} // namespace repository
+} // namespace english_learning
@@ -0,0 +1,66 @@
+#ifndef ENGLISH_LEARNING_REPOSITORY_MEMORY_CONTACT_INDEX_H
+#define ENGLISH_LEARNING_REPOSITORY_MEMORY_CONTACT_INDEX_H
+
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+#include "user_handle.h"
+
+namespace english_learning {
+namespace repository {
+namespace memory {
+
+/**
+ * Sorted prefix index over user names and emails for contact search.
+ *
+ * Every user contributes the lowercased email plus each word-start suffix of
+ * the lowercased full name ("ms. sarah johnson", "sarah johnson", "johnson"),
+ * so a query matches any word of the name or a phrase starting at one.
+ * Online and offline users live in separate key sets; a search walks the
+ * online prefix range first, which makes top-k "online first" an
+ * O(log n + k) range scan regardless of how many users match.
+ * Maintained by UserTable on every publish.
+ */
+class ContactIndex {
+public:
+    void add(UserHandle handle, const std::string& fullname,
+             const std::string& email, bool online);
+
+    void remove(UserHandle handle, const std::string& fullname,
+                const std::string& email, bool online);
+
+    // Move a user's keys between the online and offline sets
+    void setOnline(UserHandle handle, const std::string& fullname,
+                   const std::string& email, bool online);
+
+    /**
+     * Find up to limit users with a key starting with query (case-insensitive).
+     * Online users come first; each section is in key order.
+     * @param exclude Handle to leave out (usually the requesting user)
+     */
+    std::vector<UserHandle> search(const std::string& query, size_t limit,
+                                   UserHandle exclude = UserHandle()) const;
+
+    // Lowercase and trim a query the same way keys are normalized
+    static std::string normalize(const std::string& text);
+
+private:
+    using Key = std::pair<std::string, uint32_t>;  // key text, handle value
+    using KeySet = std::set<Key>;
+
+    static std::vector<std::string> keysFor(const std::string& fullname,
+                                            const std::string& email);
+
+    mutable std::mutex mutex_;
+    KeySet online_;
+    KeySet offline_;
+};
+
+} // namespace memory
+} // namespace repository
+} // namespace english_learning
+
+#endif // ENGLISH_LEARNING_REPOSITORY_MEMORY_CONTACT_INDEX_H
@@ -0,0 +1,302 @@
+#include "content_catalog.h"
+
+#include <algorithm>
+#include <dirent.h>
+
+namespace english_learning {
+namespace repository {
+namespace memory {
+
+namespace {
+
+// Append to out the ids of records that differ between two versions of a
+// table; same(a, b) decides for two distinct records with the same id
+template <typename V, typename Same>
+void diffTable(const CatalogTable<V>& older, const CatalogTable<V>& newer, CatalogKind kind, Same same,
+               std::vector<CatalogRecordId>& out) {
+    if (newer.shares(older)) return;
+    auto a = older.all().begin(), aEnd = older.all().end();
+    auto b = newer.all().begin(), bEnd = newer.all().end();
+    while (a != aEnd || b != bEnd) {
+        if (b == bEnd || (a != aEnd && a->first < b->first)) {
+            out.push_back({kind, a->first});
+            ++a;
+        } else if (a == aEnd || b->first < a->first) {
+            out.push_back({kind, b->first});
+            ++b;
+        } else {
+            if (a->second != b->second && !same(*a->second, *b->second)) out.push_back({kind, a->first});
+            ++a;
+            ++b;
+        }
+    }
+}
+
+// Two records render alike in both versions of their table
+template <typename V>
+bool sameFragments(const CatalogTable<V>& older, const V& a, const CatalogTable<V>& newer, const V& b) {
+    const Fragments* x = older.fragments(a);
+    const Fragments* y = newer.fragments(b);
+    return x && y && x->listTag == y->listTag && x->detailTag == y->detailTag && x->detail == y->detail;
+}
+
+} // namespace
+
+bool ContentCatalog::load(const std::string& directory, ContentCatalog& out, std::vector<std::string>& problems) {
+    std::vector<std::string> paths;
+    if (DIR* dir = ::opendir(directory.c_str())) {
+        while (dirent* entry = ::readdir(dir)) {
+            std::string name = entry->d_name;
+            if (name.size() > 5 && name.compare(name.size() - 5, 5, ".pack") == 0) {
+                paths.push_back(directory + "/" + name);
+            }
+        }
+        ::closedir(dir);
+    }
+    std::sort(paths.begin(), paths.end());
+
+    // Built privately and assigned whole; records come sorted by id, so
+    // appending at end() is constant time
+    CatalogTable<core::Lesson>::Map lessonMap;
+    CatalogTable<core::Test>::Map testMap;
+    CatalogTable<core::Exercise>::Map exerciseMap;
+    CatalogTable<core::Game>::Map gameMap;
+    size_t problemsBefore = problems.size();
+    for (const std::string& path : paths) {
+        auto pack = std::make_shared<storage::ContentPack>();
+        std::string error;
+        if (!pack->open(path, error)) {
+            problems.push_back(path + ": " + error);
+            continue;
+        }
+
+        size_t corrupt = 0;
+        for (size_t i = 0; i < pack->lessonCount(); ++i) {
+            core::Lesson lesson = pack->lesson(i).metadata();
+            std::string lessonId = lesson.lessonId;
+            lessonMap.insert_or_assign(lessonMap.end(), lessonId,
+                                       std::make_shared<const core::Lesson>(std::move(lesson)));
+        }
+        for (size_t i = 0; i < pack->testCount(); ++i) {
+            if (auto test = pack->test(i)) {
+                std::string testId = test->testId;
+                testMap.insert_or_assign(testMap.end(), testId, std::make_shared<const core::Test>(std::move(*test)));
+            } else {
+                corrupt++;
+            }
+        }
+        for (size_t i = 0; i < pack->exerciseCount(); ++i) {
+            if (auto exercise = pack->exercise(i)) {
+                std::string exerciseId = exercise->exerciseId;
+                exerciseMap.insert_or_assign(exerciseMap.end(), exerciseId,
+                                             std::make_shared<const core::Exercise>(std::move(*exercise)));
+            } else {
+                corrupt++;
+            }
+        }
+        for (size_t i = 0; i < pack->gameCount(); ++i) {
+            if (auto game = pack->game(i)) {
+                std::string gameId = game->gameId;
+                gameMap.insert_or_assign(gameMap.end(), gameId, std::make_shared<const core::Game>(std::move(*game)));
+            } else {
+                corrupt++;
+            }
+        }
+        if (corrupt > 0) problems.push_back(path + ": " + std::to_string(corrupt) + " corrupt records skipped");
+        out.packs.push_back(std::move(pack));
+    }
+
+    out.lessons.assign(std::move(lessonMap));
+    out.tests.assign(std::move(testMap));
+    out.exercises.assign(std::move(exerciseMap));
+    out.games.assign(std::move(gameMap));
+    return problems.size() == problemsBefore;
+}
+
+storage::ContentPack::Text ContentCatalog::lessonText(const core::Lesson& lesson, bool cache) const {
+    if (lesson.textContent.empty()) {
+        for (auto it = packs.rbegin(); it != packs.rend(); ++it) {
+            if (auto view = (*it)->findLesson(lesson.lessonId)) {
+                if (auto text = (*it)->lessonText(*view, cache)) return text;
+                break;
+            }
+        }
+    }
+    return std::make_shared<const std::string>(lesson.textContent);
+}
+
+uint64_t ContentCatalog::lessonTextStamp(const core::Lesson& lesson) const {
+    if (lesson.textContent.empty()) {
+        for (auto it = packs.rbegin(); it != packs.rend(); ++it) {
+            if (auto view = (*it)->findLesson(lesson.lessonId)) return uint64_t(view->textBytes) << 32 | view->textCrc;
+        }
+    }
+    return uint64_t(lesson.textContent.size()) << 32 | storage::ContentPack::textCrc(lesson.textContent);
+}
+
+void ContentCatalog::setRenderers(const Renderers& renderers) {
+    lessons.setRenderer(renderers.lesson);
+    tests.setRenderer(renderers.test);
+    exercises.setRenderer(renderers.exercise);
+    games.setRenderer(renderers.game);
+}
+
+void ContentCatalog::replayEdits(const ContentCatalog& older) {
+    lessons.replay(older.lessons);
+    tests.replay(older.tests);
+    exercises.replay(older.exercises);
+    games.replay(older.games);
+}
+
+void ContentCatalog::advance(const ContentCatalog& older) {
+    version = older.version + 1;
+    // Continue older's log: this may be a freshly loaded catalog with none
+    changes = older.changes;
+    changesFrom = older.changesFrom;
+
+    std::vector<CatalogRecordId> changed;
+    diffTable(older.lessons, lessons, CatalogKind::Lesson, [&](const core::Lesson& a, const core::Lesson& b) {
+        // Media sources are turned into URLs per request, outside the fragments
+        return sameFragments(older.lessons, a, lessons, b) && older.lessonTextStamp(a) == lessonTextStamp(b) &&
+               a.videoUrl == b.videoUrl && a.audioUrl == b.audioUrl;
+    }, changed);
+    diffTable(older.tests, tests, CatalogKind::Test, [&](const core::Test& a, const core::Test& b) {
+        return sameFragments(older.tests, a, tests, b);
+    }, changed);
+    diffTable(older.exercises, exercises, CatalogKind::Exercise, [&](const core::Exercise& a, const core::Exercise& b) {
+        return sameFragments(older.exercises, a, exercises, b);
+    }, changed);
+    diffTable(older.games, games, CatalogKind::Game, [&](const core::Game& a, const core::Game& b) {
+        return sameFragments(older.games, a, games, b);
+    }, changed);
+    if (changed.empty()) return;
+
+    if (changed.size() > CHANGE_LOG_CAPACITY) {
+        changes = nullptr;
+        changesFrom = version;
+        return;
+    }
+
+    // Keep the newest steps that fit; the steps are shared with older
+    // versions, so the ones kept are copied rather than cut loose. Bounding
+    // the steps also bounds the recursion when a chain is finally freed.
+    std::vector<const CatalogChanges*> kept;
+    size_t total = changed.size();
+    bool cut = false;
+    for (const CatalogChanges* step = changes.get(); step; step = step->previous.get()) {
+        if (total + step->records.size() > CHANGE_LOG_CAPACITY || kept.size() + 1 == CHANGE_LOG_STEPS) {
+            changesFrom = step->version;
+            cut = true;
+            break;
+        }
+        total += step->records.size();
+        kept.push_back(step);
+    }
+    std::shared_ptr<const CatalogChanges> tail = changes;
+    if (cut) {
+        tail = nullptr;
+        for (auto it = kept.rbegin(); it != kept.rend(); ++it) {
+            auto copy = std::make_shared<CatalogChanges>();
+            copy->version = (*it)->version;
+            copy->records = (*it)->records;
+            copy->previous = tail;
+            tail = std::move(copy);
+        }
+    }
+
+    auto step = std::make_shared<CatalogChanges>();
+    step->version = version;
+    step->records = std::move(changed);
+    step->previous = std::move(tail);
+    changes = std::move(step);
+}
+
+bool ContentCatalog::changedSince(uint64_t after, std::vector<CatalogRecordId>& out) const {
+    if (after < changesFrom || after > version) return false;
+    for (const CatalogChanges* step = changes.get(); step && step->version > after; step = step->previous.get()) {
+        out.insert(out.end(), step->records.begin(), step->records.end());
+    }
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+    return true;
+}
+
+void ContentCatalog::indexText(const ContentCatalog* older) {
+    using Field = search::ContentIndex::Field;
+    if (older && lessons.shares(older->lessons) && older->lessonIndex) {
+        lessonIndex = older->lessonIndex;
+    } else {
+        search::ContentIndex::Builder builder;
+        for (const auto& pair : lessons.all()) {
+            const core::Lesson& lesson = *pair.second;
+            builder.begin(uint8_t(lesson.level), lesson.lessonId);
+            builder.add(Field::Title, lesson.title);
+            builder.add(Field::Description, lesson.description);
+            builder.add(Field::Body, *lessonText(lesson, false));
+        }
+        lessonIndex = std::make_shared<const search::ContentIndex>(builder.build());
+    }
+
+    if (older && exercises.shares(older->exercises) && older->exerciseIndex) {
+        exerciseIndex = older->exerciseIndex;
+    } else {
+        search::ContentIndex::Builder builder;
+        for (const auto& pair : exercises.all()) {
+            const core::Exercise& exercise = *pair.second;
+            builder.begin(uint8_t(exercise.level), exercise.exerciseId);
+            builder.add(Field::Title, exercise.title);
+            builder.add(Field::Description, exercise.description);
+            for (const std::string& prompt : exercise.prompts) builder.add(Field::Body, prompt);
+        }
+        exerciseIndex = std::make_shared<const search::ContentIndex>(builder.build());
+    }
+
+    if (older && games.shares(older->games) && older->gameIndex) {
+        gameIndex = older->gameIndex;
+    } else {
+        search::ContentIndex::Builder builder;
+        for (const auto& pair : games.all()) {
+            const core::Game& game = *pair.second;
+            builder.begin(uint8_t(game.level), game.gameId);
+            builder.add(Field::Title, game.title);
+            builder.add(Field::Description, game.description);
+            for (const auto* list : {&game.pairs, &game.sentencePairs}) {
+                for (const auto& p : *list) {
+                    builder.add(Field::Body, p.first);
+                    builder.add(Field::Body, p.second);
+                }
+            }
+            for (const auto& p : game.picturePairs) builder.add(Field::Body, p.first);   // second is an image
+        }
+        gameIndex = std::make_shared<const search::ContentIndex>(builder.build());
+    }
+}
+
+std::vector<ContentCatalog::TextHit> ContentCatalog::searchText(const search::ContentIndex::Query& query,
+                                                                std::optional<CatalogKind> kind,
+                                                                std::optional<core::Level> level, size_t limit,
+                                                                size_t& matches) const {
+    matches = 0;
+    std::vector<TextHit> hits;
+    const std::pair<CatalogKind, const search::ContentIndex*> indexes[] = {
+        {CatalogKind::Lesson, lessonIndex.get()},
+        {CatalogKind::Exercise, exerciseIndex.get()},
+        {CatalogKind::Game, gameIndex.get()},
+    };
+    for (const auto& entry : indexes) {
+        if (!entry.second || (kind && *kind != entry.first)) continue;
+        size_t found = 0;
+        for (const auto& hit : entry.second->search(query, level ? int(*level) : -1, limit, found)) {
+            hits.push_back({entry.first, &entry.second->doc(hit.doc).id, hit.score});
+        }
+        matches += found;
+    }
+    // Each list is already best first, so a stable sort keeps kind order on ties
+    std::stable_sort(hits.begin(), hits.end(), [](const TextHit& a, const TextHit& b) { return a.score > b.score; });
+    if (hits.size() > limit) hits.resize(limit);
+    return hits;
+}
+
+} // namespace memory
+} // namespace repository
+} // namespace english_learning
@@ -0,0 +1,534 @@
+#ifndef ENGLISH_LEARNING_REPOSITORY_MEMORY_CONTENT_CATALOG_H
+#define ENGLISH_LEARNING_REPOSITORY_MEMORY_CONTENT_CATALOG_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "include/core/lesson.h"
+#include "include/core/test.h"
+#include "include/core/exercise.h"
+#include "include/core/game.h"
+#include "src/storage/content_pack.h"
+#include "src/search/content_index.h"
+
+namespace english_learning {
+namespace repository {
+namespace memory {
+
+/**
+ * Where a record sits in a catalog's secondary index: its level, topic and
+ * kind (exercise or game type; 0 for lessons and tests). Records without a
+ * catalog topic, such as games with a free-text one, get NO_TOPIC.
+ */
+struct CatalogKey {
+    static constexpr uint8_t NO_TOPIC = 0xFF;
+
+    uint8_t level = 0;
+    uint8_t topic = NO_TOPIC;
+    uint8_t kind = 0;
+
+    bool operator<(const CatalogKey& other) const {
+        if (level != other.level) return level < other.level;
+        if (topic != other.topic) return topic < other.topic;
+        return kind < other.kind;
+    }
+};
+
+// Id and index key of each kind of catalog record
+template <typename V> struct CatalogTraits;
+
+template <> struct CatalogTraits<core::Lesson> {
+    static const std::string& id(const core::Lesson& l) { return l.lessonId; }
+    static CatalogKey key(const core::Lesson& l) { return {uint8_t(l.level), uint8_t(l.topic), 0}; }
+};
+
+template <> struct CatalogTraits<core::Test> {
+    static const std::string& id(const core::Test& t) { return t.testId; }
+    static CatalogKey key(const core::Test& t) { return {uint8_t(t.level), uint8_t(t.topic), 0}; }
+};
+
+template <> struct CatalogTraits<core::Exercise> {
+    static const std::string& id(const core::Exercise& e) { return e.exerciseId; }
+    static CatalogKey key(const core::Exercise& e) {
+        return {uint8_t(e.level), uint8_t(e.topic), uint8_t(e.exerciseType)};
+    }
+};
+
+template <> struct CatalogTraits<core::Game> {
+    static const std::string& id(const core::Game& g) { return g.gameId; }
+    static CatalogKey key(const core::Game& g) {
+        core::Topic topic;
+        return {uint8_t(g.level), core::parseTopic(g.topic, topic) ? uint8_t(topic) : CatalogKey::NO_TOPIC,
+                uint8_t(g.gameType)};
+    }
+};
+
+/**
+ * Query over a catalog's secondary index; an unset field matches any value.
+ * kind is the record's ExerciseType or GameType.
+ */
+struct CatalogFilter {
+    std::optional<core::Level> level;
+    std::optional<core::Topic> topic;
+    std::optional<int> kind;
+
+    CatalogFilter() = default;
+    CatalogFilter(std::optional<core::Level> level, std::optional<core::Topic> topic = std::nullopt,
+                  std::optional<int> kind = std::nullopt)
+        : level(level), topic(topic), kind(kind) {}
+
+    bool matches(const CatalogKey& key) const {
+        return (!level || key.level == uint8_t(*level)) && (!topic || key.topic == uint8_t(*topic)) &&
+               (!kind || key.kind == *kind);
+    }
+};
+
+// The kinds of record a catalog holds
+enum class CatalogKind : uint8_t { Lesson, Test, Exercise, Game };
+
+// A catalog record by kind and id, ordered by kind first
+struct CatalogRecordId {
+    CatalogKind kind;
+    std::string id;
+
+    bool operator<(const CatalogRecordId& other) const {
+        return kind != other.kind ? kind < other.kind : id < other.id;
+    }
+    bool operator==(const CatalogRecordId& other) const { return kind == other.kind && id == other.id; }
+};
+
+/**
+ * 64-bit FNV-1a of bytes (or of value's bytes), continuing from tag. Used as
+ * the ETag of catalog records and of the pages built from them: it depends on
+ * content only, so it survives reloads and restarts that change nothing.
+ */
+inline uint64_t catalogTag(std::string_view bytes, uint64_t tag = 14695981039346656037ull) {
+    for (unsigned char c : bytes) {
+        tag ^= c;
+        tag *= 1099511628211ull;
+    }
+    return tag;
+}
+
+inline uint64_t catalogTag(uint64_t value, uint64_t tag) {
+    for (int i = 0; i < 8; ++i) {
+        tag ^= (value >> (8 * i)) & 0xFF;
+        tag *= 1099511628211ull;
+    }
+    return tag;
+}
+
+/**
+ * A record's JSON, serialized once when the record enters a catalog version.
+ * Both are object members without the enclosing braces, so a handler can add
+ * per-request fields (a session id, the user's progress, ...) around them.
+ * list is the record as it appears in listings, detail as it is returned on
+ * its own; either may be empty for a kind that has no such view. The tags
+ * are their catalogTag()s and slot the record id's CatalogTable::slot(),
+ * all filled in by the table.
+ */
+struct Fragments {
+    std::string list;
+    std::string detail;
+    uint64_t listTag = 0;
+    uint64_t detailTag = 0;
+    uint32_t slot = 0;
+};
+
+/**
+ * One kind of catalog record, keyed by id, with a secondary index on
+ * (level, topic, kind).
+ *
+ * Records are shared immutable objects and the map itself is shared between
+ * catalog versions, so copying a table copies a few pointers. put() and
+ * erase() copy the map first. Changes made at runtime are also kept in edits
+ * (a null record marks a removal) so that they can be replayed over a
+ * reloaded table.
+ *
+ * The index holds, for every key in use, the records with that key sorted by
+ * id. put() and erase() copy only the postings of the keys they touch, so a
+ * query on a new version sees the change without a rebuild. select() walks
+ * only the postings that match its filter and merges them in id order.
+ *
+ * Given a renderer, the table also keeps every record's Fragments next to it
+ * in the postings. They are rendered as records are assigned or put and
+ * belong to the same immutable version as the record, so they never go
+ * stale; a record that is not replaced keeps its fragments across versions.
+ */
+template <typename V>
+class CatalogTable {
+public:
+    using Map = std::map<std::string, std::shared_ptr<const V>>;
+    using Render = Fragments (*)(const V&);
+
+    // A record and its fragments (null without a renderer)
+    struct Entry {
+        std::shared_ptr<const V> record;
+        std::shared_ptr<const Fragments> json;
+    };
+    using Postings = std::vector<Entry>;   // sorted by id
+
+    // A page of query results; the pointers live as long as this version.
+    // fragments[i] belongs to records[i].
+    struct Page {
+        std::vector<const V*> records;
+        std::vector<const Fragments*> fragments;
+        size_t total = 0;   // matches over all pages
+    };
+
+    const Map& all() const { return *records_; }
+    size_t size() const { return records_->size(); }
+
+    // True if other holds this very record map, so no record can differ
+    bool shares(const CatalogTable& other) const { return records_ == other.records_; }
+
+    // nullptr if absent
+    const V* find(const std::string& id) const {
+        auto it = records_->find(id);
+        return it != records_->end() ? it->second.get() : nullptr;
+    }
+
+    /**
+     * Dense number for a record id of this kind: ids are numbered 0, 1, ...
+     * as they are first seen and keep their number for the life of the
+     * process, whatever versions come and go. Per-user state about records
+     * (lesson progress) is kept in arrays indexed by it, and a listing finds
+     * a record's slot in its fragments rather than by id. Thread-safe.
+     */
+    static uint32_t slot(const std::string& id) {
+        static std::mutex mutex;
+        static std::unordered_map<std::string, uint32_t> slots;
+        std::lock_guard<std::mutex> lock(mutex);
+        return slots.emplace(id, static_cast<uint32_t>(slots.size())).first->second;
+    }
+
+    // The fragments of a record of this version; nullptr without a renderer
+    const Fragments* fragments(const V& record) const {
+        const Entry* entry = locate(*index_, record);
+        return entry ? entry->json.get() : nullptr;
+    }
+
+    // Number of records matching filter, from the posting sizes alone
+    size_t count(const CatalogFilter& filter) const {
+        size_t total = 0;
+        for (const auto& entry : *index_) {
+            if (filter.matches(entry.first)) total += entry.second->size();
+        }
+        return total;
+    }
+
+    // Records matching filter in id order, skipping offset and returning at
+    // most limit of them (0 means no limit)
+    Page select(const CatalogFilter& filter, size_t offset = 0, size_t limit = 0) const {
+        Page page;
+        std::vector<const Postings*> lists;
+        for (const auto& entry : *index_) {
+            if (!filter.matches(entry.first)) continue;
+            lists.push_back(entry.second.get());
+            page.total += entry.second->size();
+        }
+        if (offset >= page.total) return page;
+        size_t wanted = page.total - offset;
+        if (limit > 0 && limit < wanted) wanted = limit;
+        page.records.reserve(wanted);
+        page.fragments.reserve(wanted);
+        auto emit = [&page](const Entry& entry) {
+            page.records.push_back(entry.record.get());
+            page.fragments.push_back(entry.json.get());
+        };
+
+        if (lists.size() == 1) {
+            for (size_t i = offset; i < offset + wanted; ++i) emit((*lists[0])[i]);
+            return page;
+        }
+
+        // k-way merge of the matching postings; there are only a few dozen keys
+        std::vector<size_t> next(lists.size(), 0);
+        for (size_t produced = 0; produced < offset + wanted; ++produced) {
+            size_t best = lists.size();
+            for (size_t i = 0; i < lists.size(); ++i) {
+                if (next[i] == lists[i]->size()) continue;
+                if (best == lists.size() ||
+                    Traits::id(*(*lists[i])[next[i]].record) < Traits::id(*(*lists[best])[next[best]].record)) {
+                    best = i;
+                }
+            }
+            if (produced >= offset) emit((*lists[best])[next[best]]);
+            next[best]++;
+        }
+        return page;
+    }
+
+    // Render every record's fragments with render from now on, including
+    // those already in the table
+    void setRenderer(Render render) {
+        render_ = render;
+        index_ = std::make_shared<const Index>();
+        rebuildIndex();
+    }
+
+    // Replace the records wholesale, as loaded from packs (not an edit)
+    void assign(Map records) {
+        records_ = std::make_shared<const Map>(std::move(records));
+        rebuildIndex();
+    }
+
+    // Insert or overwrite a record at runtime
+    void put(const std::string& id, V value) {
+        auto record = std::make_shared<const V>(std::move(value));
+        Map records = *records_;
+        auto it = records.find(id);
+        Index index = *index_;
+        if (it != records.end()) {
+            unindex(index, it->second);
+            it->second = record;
+        } else {
+            records.emplace(id, record);
+        }
+        reindex(index, {record, rendered(*record)});
+        records_ = std::make_shared<const Map>(std::move(records));
+        index_ = std::make_shared<const Index>(std::move(index));
+        Map edits = *edits_;
+        edits[id] = record;
+        edits_ = std::make_shared<const Map>(std::move(edits));
+    }
+
+    // Remove a record at runtime; false if it was absent
+    bool erase(const std::string& id) {
+        auto it = records_->find(id);
+        if (it == records_->end()) return false;
+        Index index = *index_;
+        unindex(index, it->second);
+        Map records = *records_;
+        records.erase(id);
+        records_ = std::make_shared<const Map>(std::move(records));
+        index_ = std::make_shared<const Index>(std::move(index));
+        Map edits = *edits_;
+        edits[id] = nullptr;
+        edits_ = std::make_shared<const Map>(std::move(edits));
+        return true;
+    }
+
+    // Apply the runtime edits of an older version of this table on top of
+    // these records, and carry them forward
+    void replay(const CatalogTable& older) {
+        edits_ = older.edits_;
+        if (edits_->empty()) return;
+        Map records = *records_;
+        for (const auto& edit : *edits_) {
+            if (edit.second) {
+                records[edit.first] = edit.second;
+            } else {
+                records.erase(edit.first);
+            }
+        }
+        records_ = std::make_shared<const Map>(std::move(records));
+        rebuildIndex();
+    }
+
+private:
+    using Traits = CatalogTraits<V>;
+    using Index = std::map<CatalogKey, std::shared_ptr<const Postings>>;
+
+    static bool idLess(const Entry& entry, const std::string& id) { return Traits::id(*entry.record) < id; }
+
+    // record's entry in index; nullptr if index does not hold this very record
+    static const Entry* locate(const Index& index, const V& record) {
+        auto it = index.find(Traits::key(record));
+        if (it == index.end()) return nullptr;
+        const Postings& postings = *it->second;
+        auto pos = std::lower_bound(postings.begin(), postings.end(), Traits::id(record), idLess);
+        return pos != postings.end() && pos->record.get() == &record ? &*pos : nullptr;
+    }
+
+    std::shared_ptr<const Fragments> rendered(const V& record) const {
+        if (!render_) return nullptr;
+        Fragments json = render_(record);
+        json.listTag = catalogTag(json.list);
+        json.detailTag = catalogTag(json.detail);
+        json.slot = slot(Traits::id(record));
+        return std::make_shared<const Fragments>(std::move(json));
+    }
+
+    // Index every record, keeping the fragments of records already indexed
+    void rebuildIndex() {
+        std::map<CatalogKey, Postings> lists;
+        for (const auto& pair : *records_) {
+            const Entry* old = locate(*index_, *pair.second);
+            lists[Traits::key(*pair.second)].push_back({pair.second, old ? old->json : rendered(*pair.second)});
+        }
+        Index index;
+        for (auto& entry : lists) {
+            index.emplace(entry.first, std::make_shared<const Postings>(std::move(entry.second)));
+        }
+        index_ = std::make_shared<const Index>(std::move(index));
+    }
+
+    // Copy the postings of entry's key with entry added in id order
+    static void reindex(Index& index, Entry entry) {
+        auto& slot = index[Traits::key(*entry.record)];
+        Postings postings = slot ? *slot : Postings();
+        auto pos = std::lower_bound(postings.begin(), postings.end(), Traits::id(*entry.record), idLess);
+        postings.insert(pos, std::move(entry));
+        slot = std::make_shared<const Postings>(std::move(postings));
+    }
+
+    // Copy the postings of record's key without it
+    static void unindex(Index& index, const std::shared_ptr<const V>& record) {
+        auto it = index.find(Traits::key(*record));
+        if (it == index.end()) return;
+        Postings postings = *it->second;
+        auto pos = std::lower_bound(postings.begin(), postings.end(), Traits::id(*record), idLess);
+        if (pos == postings.end() || pos->record != record) return;
+        postings.erase(pos);
+        if (postings.empty()) {
+            index.erase(it);
+        } else {
+            it->second = std::make_shared<const Postings>(std::move(postings));
+        }
+    }
+
+    std::shared_ptr<const Map> records_ = std::make_shared<const Map>();
+    std::shared_ptr<const Map> edits_ = std::make_shared<const Map>();
+    std::shared_ptr<const Index> index_ = std::make_shared<const Index>();
+    Render render_ = nullptr;
+};
+
+/**
+ * One step of a catalog's change log: the records that the catalog version
+ * `version` added, changed or removed, in (kind, id) order. Steps are shared
+ * and immutable, linked from newest to oldest, so every catalog version
+ * carries its whole log for the price of one pointer.
+ */
+struct CatalogChanges {
+    uint64_t version = 0;
+    std::vector<CatalogRecordId> records;
+    std::shared_ptr<const CatalogChanges> previous;   // null where the log starts
+};
+
+/**
+ * One immutable version of the lesson, test, exercise and game catalog.
+ *
+ * The server publishes it through an RcuCell: readers take the current
+ * version inside an EpochGuard and use it without locks, and a reload builds
+ * a whole new version off to the side and swaps it in. Requests already
+ * running keep the version they started with; it is freed, together with
+ * any pack only it still maps, after the last of them finishes.
+ *
+ * Lessons loaded from packs carry metadata only; their text stays in the
+ * mapped pack, compressed, and is reached through lessonText(); listing
+ * lessons never touches it. Set the renderers before loading so that each
+ * record is serialized once, as it is loaded.
+ *
+ * Every published change goes through advance(), which bumps the version and
+ * logs which records differ from the version before, so a client holding a
+ * copy of some version can fetch only what changed since (changedSince()).
+ *
+ * Each version also carries full-text indexes of its lessons, exercises and
+ * games (indexText()), built before the version is published.
+ */
+struct ContentCatalog {
+    using Lessons = CatalogTable<core::Lesson>;
+    using Tests = CatalogTable<core::Test>;
+    using Exercises = CatalogTable<core::Exercise>;
+    using Games = CatalogTable<core::Game>;
+
+    // Most records, and most versions, the change log keeps; older steps are
+    // dropped past either
+    static constexpr size_t CHANGE_LOG_CAPACITY = 20000;
+    static constexpr size_t CHANGE_LOG_STEPS = 512;
+
+    uint64_t version = 0;                        // bumped on every published change
+    std::vector<std::shared_ptr<const storage::ContentPack>> packs;   // in load order
+    Lessons lessons;
+    Tests tests;
+    Exercises exercises;
+    Games games;
+    std::shared_ptr<const CatalogChanges> changes;   // newest step first
+    uint64_t changesFrom = 0;                    // the log covers every version after this one
+    // Full-text index of each searchable table; documents carry Level codes
+    std::shared_ptr<const search::ContentIndex> lessonIndex, exerciseIndex, gameIndex;
+
+    /**
+     * Map every *.pack in directory, in file name order, and build a catalog
+     * from them; a record replaces any earlier one with the same id. Returns
+     * false if any pack or record had to be skipped, with the reasons in
+     * problems; out then holds everything that could be loaded.
+     */
+    static bool load(const std::string& directory, ContentCatalog& out, std::vector<std::string>& problems);
+
+    // A lesson's own textContent if it has one, else its body in the newest
+    // pack that has the lesson, inflated (through the pack's cache unless
+    // cache is false). Never null; empty if the pack's copy is corrupt.
+    storage::ContentPack::Text lessonText(const core::Lesson& lesson, bool cache = true) const;
+    // Length and CRC-32 of lessonText() as one number, without inflating it
+    uint64_t lessonTextStamp(const core::Lesson& lesson) const;
+
+    // Fragment renderers of each kind; the server owns the wire format
+    struct Renderers {
+        Lessons::Render lesson = nullptr;
+        Tests::Render test = nullptr;
+        Exercises::Render exercise = nullptr;
+        Games::Render game = nullptr;
+    };
+
+    // Render fragments for every record from now on
+    void setRenderers(const Renderers& renderers);
+
+    // Carry the runtime edits of an older version over to this one
+    void replayEdits(const ContentCatalog& older);
+
+    /**
+     * Make this the version after older, logging every record that differs
+     * between the two. Records are compared by identity, then by their
+     * fragments (and a lesson's text), so a reload that brings back the same
+     * content logs nothing. The log carries on from older's, whatever this
+     * one held before. A change too large for the log restarts it.
+     */
+    void advance(const ContentCatalog& older);
+
+    /**
+     * Every record changed after version `after`, once each, in (kind, id)
+     * order; whether it was removed or still exists is read from this
+     * version. Returns false if the log no longer reaches back that far.
+     */
+    bool changedSince(uint64_t after, std::vector<CatalogRecordId>& out) const;
+
+    /**
+     * Index the text of this version's records: lesson titles, descriptions
+     * and text, exercise titles, descriptions and prompts, and game titles,
+     * descriptions and pairs (tests are not searchable). A table that still
+     * shares its records with older keeps older's index, so an edit to the
+     * games does not re-index every lesson.
+     */
+    void indexText(const ContentCatalog* older = nullptr);
+
+    // A search result; id lives as long as this version
+    struct TextHit {
+        CatalogKind kind;
+        const std::string* id;
+        float score;
+    };
+
+    /**
+     * The best `limit` records matching query, optionally only of one kind
+     * and level, best first; `matches` receives how many matched in all.
+     * Each kind is ranked within its own index, and the results merged.
+     */
+    std::vector<TextHit> searchText(const search::ContentIndex::Query& query, std::optional<CatalogKind> kind,
+                                    std::optional<core::Level> level, size_t limit, size_t& matches) const;
+};
+
+} // namespace memory
+} // namespace repository
+} // namespace english_learning
+
+#endif // ENGLISH_LEARNING_REPOSITORY_MEMORY_CONTENT_CATALOG_H
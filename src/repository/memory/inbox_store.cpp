@@ -0,0 +1,67 @@
+#include "inbox_store.h"
+
+namespace english_learning {
+namespace repository {
+namespace memory {
+
+uint64_t InboxStore::push(const std::string& userId, const std::string& messageId) {
+    Inbox& inbox = inboxes_[userId];
+    uint64_t seq = ++inbox.lastSeq;
+    inbox.entries.push_back(Entry{seq, messageId});
+    if (inbox.entries.size() > capacity_) {
+        inbox.dropped = inbox.entries.front().seq;
+        inbox.entries.pop_front();
+    }
+    return seq;
+}
+
+void InboxStore::ack(const std::string& userId, uint64_t seq) {
+    auto it = inboxes_.find(userId);
+    if (it == inboxes_.end()) return;
+    std::deque<Entry>& entries = it->second.entries;
+    while (!entries.empty() && entries.front().seq <= seq) entries.pop_front();
+}
+
+void InboxStore::ackAll(const std::string& userId) {
+    auto it = inboxes_.find(userId);
+    if (it == inboxes_.end()) return;
+    it->second.entries.clear();
+    it->second.dropped = 0;
+}
+
+bool InboxStore::since(const std::string& userId, uint64_t afterSeq, std::vector<Entry>& out) const {
+    auto it = inboxes_.find(userId);
+    if (it == inboxes_.end()) return afterSeq == 0;
+
+    const Inbox& inbox = it->second;
+    // A sequence from the future means the client is talking about another inbox
+    if (afterSeq > inbox.lastSeq || afterSeq < inbox.dropped) return false;
+
+    for (const Entry& entry : inbox.entries) {
+        if (entry.seq > afterSeq) out.push_back(entry);
+    }
+    return true;
+}
+
+void InboxStore::attach(const std::string& userId, int socket) {
+    inboxes_[userId].socket = socket;
+}
+
+void InboxStore::detach(const std::string& userId, int socket) {
+    auto it = inboxes_.find(userId);
+    if (it != inboxes_.end() && it->second.socket == socket) it->second.socket = -1;
+}
+
+int InboxStore::socketFor(const std::string& userId) const {
+    auto it = inboxes_.find(userId);
+    return it != inboxes_.end() ? it->second.socket : -1;
+}
+
+size_t InboxStore::pendingFor(const std::string& userId) const {
+    auto it = inboxes_.find(userId);
+    return it != inboxes_.end() ? it->second.entries.size() : 0;
+}
+
+} // namespace memory
+} // namespace repository
+} // namespace english_learning
@@ -0,0 +1,84 @@
+#ifndef ENGLISH_LEARNING_REPOSITORY_MEMORY_INBOX_STORE_H
+#define ENGLISH_LEARNING_REPOSITORY_MEMORY_INBOX_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace english_learning {
+namespace repository {
+namespace memory {
+
+/**
+ * Per-user queue of chat deliveries awaiting acknowledgement.
+ *
+ * Every message addressed to a user gets the next sequence number in that
+ * user's inbox and stays queued until the client acknowledges it (acks are
+ * cumulative). A reconnecting client reports the last sequence it saw and
+ * only the entries after it are replayed.
+ *
+ * The inbox also records which socket currently receives live pushes for a
+ * user; pushes and replays for one user are issued under the caller's lock,
+ * so a client always sees its sequence numbers in increasing order.
+ *
+ * Each inbox holds at most `capacity` entries; on overflow the oldest entry
+ * is dropped and a resume from before it is refused (see since()).
+ *
+ * Not synchronized: callers serialize access (inboxMutex on the server).
+ */
+class InboxStore {
+public:
+    struct Entry {
+        uint64_t seq;
+        std::string messageId;
+    };
+
+    explicit InboxStore(size_t capacity) : capacity_(capacity) {}
+
+    // Queue a delivery; returns its sequence number
+    uint64_t push(const std::string& userId, const std::string& messageId);
+
+    // Drop every entry up to and including seq
+    void ack(const std::string& userId, uint64_t seq);
+
+    // Acknowledge everything queued so far
+    void ackAll(const std::string& userId);
+
+    /**
+     * Entries queued after afterSeq, in sequence order. Returns false if some
+     * of them were dropped on overflow, in which case the gap cannot be
+     * replayed and the caller should fall back to a full resync.
+     */
+    bool since(const std::string& userId, uint64_t afterSeq, std::vector<Entry>& out) const;
+
+    // Route live pushes for userId to socket
+    void attach(const std::string& userId, int socket);
+
+    // Stop pushing to socket (ignored if the user has since attached another one)
+    void detach(const std::string& userId, int socket);
+
+    // Socket receiving live pushes, or -1 if the user has no attached client
+    int socketFor(const std::string& userId) const;
+
+    size_t pendingFor(const std::string& userId) const;
+
+private:
+    struct Inbox {
+        std::deque<Entry> entries;
+        uint64_t lastSeq = 0;    // last sequence handed out
+        uint64_t dropped = 0;    // highest sequence lost to overflow (never acked)
+        int socket = -1;
+    };
+
+    size_t capacity_;
+    std::unordered_map<std::string, Inbox> inboxes_;  // userId -> inbox
+};
+
+} // namespace memory
+} // namespace repository
+} // namespace english_learning
+
+#endif // ENGLISH_LEARNING_REPOSITORY_MEMORY_INBOX_STORE_H
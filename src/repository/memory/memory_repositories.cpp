@@ -28,7 +28,7 @@ std::vector<core::Lesson> MemoryLessonRepository::findAll() const {
     return result;
 }
 
-std::vector<core::Lesson> MemoryLessonRepository::findByLevel(const std::string& level) const {
+std::vector<core::Lesson> MemoryLessonRepository::findByLevel(core::Level level) const {
     std::lock_guard<std::mutex> lock(mutex_);
     std::vector<core::Lesson> result;
     for (const auto& p : lessons_) {
@@ -37,7 +37,7 @@ std::vector<core::Lesson> MemoryLessonRepository::findByLevel(const std::string&
     return result;
 }
 
-std::vector<core::Lesson> MemoryLessonRepository::findByTopic(const std::string& topic) const {
+std::vector<core::Lesson> MemoryLessonRepository::findByTopic(core::Topic topic) const {
     std::lock_guard<std::mutex> lock(mutex_);
     std::vector<core::Lesson> result;
     for (const auto& p : lessons_) {
@@ -47,11 +47,11 @@ std::vector<core::Lesson> MemoryLessonRepository::findByTopic(const std::string&
 }
 
 std::vector<core::Lesson> MemoryLessonRepository::findByLevelAndTopic(
-    const std::string& level, const std::string& topic) const {
+    core::Level level, std::optional<core::Topic> topic) const {
     std::lock_guard<std::mutex> lock(mutex_);
     std::vector<core::Lesson> result;
     for (const auto& p : lessons_) {
-        if (p.second.level == level && (topic.empty() || p.second.topic == topic)) {
+        if (p.second.level == level && (!topic || p.second.topic == *topic)) {
             result.push_back(p.second);
         }
     }
@@ -80,7 +80,7 @@ size_t MemoryLessonRepository::count() const {
     return lessons_.size();
 }
 
-size_t MemoryLessonRepository::countByLevel(const std::string& level) const {
+size_t MemoryLessonRepository::countByLevel(core::Level level) const {
     std::lock_guard<std::mutex> lock(mutex_);
     size_t c = 0;
     for (const auto& p : lessons_) if (p.second.level == level) ++c;
@@ -111,7 +111,7 @@ std::vector<core::Test> MemoryTestRepository::findAll() const {
     return result;
 }
 
-std::vector<core::Test> MemoryTestRepository::findByLevel(const std::string& level) const {
+std::vector<core::Test> MemoryTestRepository::findByLevel(core::Level level) const {
     std::lock_guard<std::mutex> lock(mutex_);
     std::vector<core::Test> result;
     for (const auto& p : tests_) {
@@ -120,7 +120,7 @@ std::vector<core::Test> MemoryTestRepository::findByLevel(const std::string& lev
     return result;
 }
 
-std::vector<core::Test> MemoryTestRepository::findByType(const std::string& testType) const {
+std::vector<core::Test> MemoryTestRepository::findByType(const core::Symbol& testType) const {
     std::lock_guard<std::mutex> lock(mutex_);
     std::vector<core::Test> result;
     for (const auto& p : tests_) {
@@ -130,7 +130,7 @@ std::vector<core::Test> MemoryTestRepository::findByType(const std::string& test
 }
 
 std::vector<core::Test> MemoryTestRepository::findByLevelAndType(
-    const std::string& level, const std::string& testType) const {
+    core::Level level, const core::Symbol& testType) const {
     std::lock_guard<std::mutex> lock(mutex_);
     std::vector<core::Test> result;
     for (const auto& p : tests_) {
@@ -169,98 +169,67 @@ size_t MemoryTestRepository::count() const {
 
 bool MemoryChatRepository::add(const core::ChatMessage& message) {
     std::lock_guard<std::mutex> lock(mutex_);
-    messages_.push_back(message);
-    return true;
+    return store_.append(message);
 }
 
 std::optional<core::ChatMessage> MemoryChatRepository::findById(const std::string& messageId) const {
     std::lock_guard<std::mutex> lock(mutex_);
-    for (const auto& m : messages_) {
-        if (m.messageId == messageId) return m;
-    }
+    if (const core::ChatMessage* m = store_.findById(messageId)) return *m;
     return std::nullopt;
 }
 
 std::vector<core::ChatMessage> MemoryChatRepository::findAll() const {
     std::lock_guard<std::mutex> lock(mutex_);
-    return messages_;
+    return store_.all();
 }
 
 std::vector<core::ChatMessage> MemoryChatRepository::findByUser(const std::string& userId) const {
     std::lock_guard<std::mutex> lock(mutex_);
-    std::vector<core::ChatMessage> result;
-    for (const auto& m : messages_) {
-        if (m.senderId == userId || m.recipientId == userId) {
-            result.push_back(m);
-        }
-    }
-    return result;
+    return store_.findByUser(userId);
 }
 
 std::vector<core::ChatMessage> MemoryChatRepository::findConversation(
     const std::string& user1, const std::string& user2) const {
     std::lock_guard<std::mutex> lock(mutex_);
-    std::vector<core::ChatMessage> result;
-    for (const auto& m : messages_) {
-        if ((m.senderId == user1 && m.recipientId == user2) ||
-            (m.senderId == user2 && m.recipientId == user1)) {
-            result.push_back(m);
-        }
-    }
-    return result;
+    return store_.conversation(user1, user2);
+}
+
+std::vector<core::ChatMessage> MemoryChatRepository::findConversationPage(
+    const std::string& user1, const std::string& user2,
+    const std::string& beforeMessageId, core::Timestamp beforeTimestamp, size_t limit) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return store_.history(user1, user2, beforeMessageId, beforeTimestamp, limit);
 }
 
 std::vector<core::ChatMessage> MemoryChatRepository::findUnreadFor(const std::string& userId) const {
     std::lock_guard<std::mutex> lock(mutex_);
-    std::vector<core::ChatMessage> result;
-    for (const auto& m : messages_) {
-        if (m.recipientId == userId && !m.read) {
-            result.push_back(m);
-        }
-    }
-    return result;
+    return store_.unreadFor(userId);
 }
 
 size_t MemoryChatRepository::countUnreadFor(const std::string& userId) const {
     std::lock_guard<std::mutex> lock(mutex_);
-    size_t c = 0;
-    for (const auto& m : messages_) {
-        if (m.recipientId == userId && !m.read) ++c;
-    }
-    return c;
+    return store_.countUnreadFor(userId);
 }
 
 bool MemoryChatRepository::markAsRead(const std::string& messageId) {
     std::lock_guard<std::mutex> lock(mutex_);
-    for (auto& m : messages_) {
-        if (m.messageId == messageId) { m.read = true; return true; }
-    }
-    return false;
+    return store_.markAsRead(messageId);
 }
 
 size_t MemoryChatRepository::markConversationAsRead(
     const std::string& recipientId, const std::string& senderId) {
     std::lock_guard<std::mutex> lock(mutex_);
-    size_t c = 0;
-    for (auto& m : messages_) {
-        if (m.recipientId == recipientId && m.senderId == senderId && !m.read) {
-            m.read = true; ++c;
-        }
-    }
-    return c;
+    return store_.markConversationAsRead(recipientId, senderId);
 }
 
 bool MemoryChatRepository::remove(const std::string& messageId) {
     std::lock_guard<std::mutex> lock(mutex_);
-    for (auto it = messages_.begin(); it != messages_.end(); ++it) {
-        if (it->messageId == messageId) { messages_.erase(it); return true; }
-    }
-    return false;
+    return store_.remove(messageId);
 }
 
 size_t MemoryChatRepository::count() const {
     std::lock_guard<std::mutex> lock(mutex_);
-    return messages_.size();
+    return store_.size();
 }
 
 // ============================================================================
@@ -289,7 +258,7 @@ std::vector<core::Exercise> MemoryExerciseRepository::findAllExercises() const {
 }
 
 std::vector<core::Exercise> MemoryExerciseRepository::findExercisesByLevel(
-    const std::string& level) const {
+    core::Level level) const {
     std::lock_guard<std::mutex> lock(mutex_);
     std::vector<core::Exercise> result;
     for (const auto& p : exercises_) {
@@ -299,7 +268,7 @@ std::vector<core::Exercise> MemoryExerciseRepository::findExercisesByLevel(
 }
 
 std::vector<core::Exercise> MemoryExerciseRepository::findExercisesByType(
-    const std::string& type) const {
+    core::ExerciseType type) const {
     std::lock_guard<std::mutex> lock(mutex_);
     std::vector<core::Exercise> result;
     for (const auto& p : exercises_) {
@@ -369,7 +338,7 @@ std::vector<core::ExerciseSubmission> MemoryExerciseRepository::findPendingSubmi
     std::lock_guard<std::mutex> lock(mutex_);
     std::vector<core::ExerciseSubmission> result;
     for (const auto& s : submissions_) {
-        if (s.status == "pending") result.push_back(s);
+        if (s.status == core::SubmissionStatus::Pending) result.push_back(s);
     }
     return result;
 }
@@ -379,7 +348,7 @@ std::vector<core::ExerciseSubmission> MemoryExerciseRepository::findReviewedSubm
     std::lock_guard<std::mutex> lock(mutex_);
     std::vector<core::ExerciseSubmission> result;
     for (const auto& s : submissions_) {
-        if (s.userId == userId && s.status == "reviewed") result.push_back(s);
+        if (s.userId == userId && s.status == core::SubmissionStatus::Reviewed) result.push_back(s);
     }
     return result;
 }
@@ -398,7 +367,7 @@ bool MemoryExerciseRepository::reviewSubmission(
     std::lock_guard<std::mutex> lock(mutex_);
     for (auto& s : submissions_) {
         if (s.submissionId == submissionId) {
-            s.status = "reviewed";
+            s.status = core::SubmissionStatus::Reviewed;
             s.teacherId = teacherId;
             s.teacherFeedback = feedback;
             s.teacherScore = score;
@@ -422,7 +391,7 @@ size_t MemoryExerciseRepository::countSubmissions() const {
 size_t MemoryExerciseRepository::countPendingSubmissions() const {
     std::lock_guard<std::mutex> lock(mutex_);
     size_t c = 0;
-    for (const auto& s : submissions_) if (s.status == "pending") ++c;
+    for (const auto& s : submissions_) if (s.status == core::SubmissionStatus::Pending) ++c;
     return c;
 }
 
@@ -450,7 +419,7 @@ std::vector<core::Game> MemoryGameRepository::findAllGames() const {
     return result;
 }
 
-std::vector<core::Game> MemoryGameRepository::findGamesByLevel(const std::string& level) const {
+std::vector<core::Game> MemoryGameRepository::findGamesByLevel(core::Level level) const {
     std::lock_guard<std::mutex> lock(mutex_);
     std::vector<core::Game> result;
     for (const auto& p : games_) {
@@ -459,7 +428,7 @@ std::vector<core::Game> MemoryGameRepository::findGamesByLevel(const std::string
     return result;
 }
 
-std::vector<core::Game> MemoryGameRepository::findGamesByType(const std::string& gameType) const {
+std::vector<core::Game> MemoryGameRepository::findGamesByType(core::GameType gameType) const {
     std::lock_guard<std::mutex> lock(mutex_);
     std::vector<core::Game> result;
     for (const auto& p : games_) {
@@ -469,12 +438,12 @@ std::vector<core::Game> MemoryGameRepository::findGamesByType(const std::string&
 }
 
 std::vector<core::Game> MemoryGameRepository::findGamesByLevelAndType(
-    const std::string& level, const std::string& gameType) const {
+    std::optional<core::Level> level, std::optional<core::GameType> gameType) const {
     std::lock_guard<std::mutex> lock(mutex_);
     std::vector<core::Game> result;
     for (const auto& p : games_) {
-        bool matchLevel = level.empty() || p.second.level == level;
-        bool matchType = gameType.empty() || gameType == "all" || p.second.gameType == gameType;
+        bool matchLevel = !level || p.second.level == *level;
+        bool matchType = !gameType || p.second.gameType == *gameType;
         if (matchLevel && matchType) result.push_back(p.second);
     }
     return result;
@@ -10,6 +10,7 @@
 #include "include/repository/i_exercise_repository.h"
 #include "include/repository/i_game_repository.h"
 #include "include/repository/i_voice_call_repository.h"
+#include "chat_store.h"
 
 namespace english_learning {
 namespace repository {
@@ -23,15 +24,15 @@ public:
     bool add(const core::Lesson& lesson) override;
     std::optional<core::Lesson> findById(const std::string& lessonId) const override;
     std::vector<core::Lesson> findAll() const override;
-    std::vector<core::Lesson> findByLevel(const std::string& level) const override;
-    std::vector<core::Lesson> findByTopic(const std::string& topic) const override;
-    std::vector<core::Lesson> findByLevelAndTopic(const std::string& level,
-                                                   const std::string& topic) const override;
+    std::vector<core::Lesson> findByLevel(core::Level level) const override;
+    std::vector<core::Lesson> findByTopic(core::Topic topic) const override;
+    std::vector<core::Lesson> findByLevelAndTopic(core::Level level,
+                                                   std::optional<core::Topic> topic) const override;
     bool exists(const std::string& lessonId) const override;
     bool update(const core::Lesson& lesson) override;
     bool remove(const std::string& lessonId) override;
     size_t count() const override;
-    size_t countByLevel(const std::string& level) const override;
+    size_t countByLevel(core::Level level) const override;
 
 private:
     mutable std::mutex mutex_;
@@ -46,10 +47,10 @@ public:
     bool add(const core::Test& test) override;
     std::optional<core::Test> findById(const std::string& testId) const override;
     std::vector<core::Test> findAll() const override;
-    std::vector<core::Test> findByLevel(const std::string& level) const override;
-    std::vector<core::Test> findByType(const std::string& testType) const override;
-    std::vector<core::Test> findByLevelAndType(const std::string& level,
-                                                const std::string& testType) const override;
+    std::vector<core::Test> findByLevel(core::Level level) const override;
+    std::vector<core::Test> findByType(const core::Symbol& testType) const override;
+    std::vector<core::Test> findByLevelAndType(core::Level level,
+                                                const core::Symbol& testType) const override;
     bool exists(const std::string& testId) const override;
     bool update(const core::Test& test) override;
     bool remove(const std::string& testId) override;
@@ -61,7 +62,7 @@ private:
 };
 
 /**
- * In-memory implementation of IChatRepository.
+ * In-memory implementation of IChatRepository backed by a ChatStore.
  */
 class MemoryChatRepository : public IChatRepository {
 public:
@@ -71,6 +72,11 @@ public:
     std::vector<core::ChatMessage> findByUser(const std::string& userId) const override;
     std::vector<core::ChatMessage> findConversation(const std::string& user1,
                                                      const std::string& user2) const override;
+    std::vector<core::ChatMessage> findConversationPage(const std::string& user1,
+                                                         const std::string& user2,
+                                                         const std::string& beforeMessageId,
+                                                         core::Timestamp beforeTimestamp,
+                                                         size_t limit) const override;
     std::vector<core::ChatMessage> findUnreadFor(const std::string& userId) const override;
     size_t countUnreadFor(const std::string& userId) const override;
     bool markAsRead(const std::string& messageId) override;
@@ -81,7 +87,7 @@ public:
 
 private:
     mutable std::mutex mutex_;
-    std::vector<core::ChatMessage> messages_;
+    ChatStore store_;
 };
 
 /**
@@ -93,8 +99,8 @@ public:
     bool addExercise(const core::Exercise& exercise) override;
     std::optional<core::Exercise> findExerciseById(const std::string& exerciseId) const override;
     std::vector<core::Exercise> findAllExercises() const override;
-    std::vector<core::Exercise> findExercisesByLevel(const std::string& level) const override;
-    std::vector<core::Exercise> findExercisesByType(const std::string& type) const override;
+    std::vector<core::Exercise> findExercisesByLevel(core::Level level) const override;
+    std::vector<core::Exercise> findExercisesByType(core::ExerciseType type) const override;
     bool exerciseExists(const std::string& exerciseId) const override;
     bool updateExercise(const core::Exercise& exercise) override;
     bool removeExercise(const std::string& exerciseId) override;
@@ -137,10 +143,10 @@ public:
     bool addGame(const core::Game& game) override;
     std::optional<core::Game> findGameById(const std::string& gameId) const override;
     std::vector<core::Game> findAllGames() const override;
-    std::vector<core::Game> findGamesByLevel(const std::string& level) const override;
-    std::vector<core::Game> findGamesByType(const std::string& gameType) const override;
-    std::vector<core::Game> findGamesByLevelAndType(const std::string& level,
-                                                     const std::string& gameType) const override;
+    std::vector<core::Game> findGamesByLevel(core::Level level) const override;
+    std::vector<core::Game> findGamesByType(core::GameType gameType) const override;
+    std::vector<core::Game> findGamesByLevelAndType(std::optional<core::Level> level,
+                                                     std::optional<core::GameType> gameType) const override;
     bool gameExists(const std::string& gameId) const override;
     bool updateGame(const core::Game& game) override;
     bool removeGame(const std::string& gameId) override;
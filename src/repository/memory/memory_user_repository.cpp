@@ -1,161 +1,128 @@
 #include "memory_user_repository.h"
 
+#include "src/concurrency/epoch.h"
+
 namespace english_learning {
 namespace repository {
 namespace memory {
 
+using concurrency::EpochGuard;
+
 bool MemoryUserRepository::add(const core::User& user) {
     std::lock_guard<std::mutex> lock(mutex_);
-    if (usersByEmail_.find(user.email) != usersByEmail_.end()) {
-        return false; // Email already exists
-    }
-    usersByEmail_[user.email] = user;
-    userIdToEmail_[user.userId] = user.email;
-    return true;
+    return table_.insert(user).valid(); // Fails if email or id already exists
 }
 
 std::optional<core::User> MemoryUserRepository::findByEmail(const std::string& email) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = usersByEmail_.find(email);
-    if (it != usersByEmail_.end()) {
-        return it->second;
+    EpochGuard guard;
+    if (const core::User* user = table_.getByEmail(email)) {
+        return *user;
     }
     return std::nullopt;
 }
 
 std::optional<core::User> MemoryUserRepository::findById(const std::string& userId) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto emailIt = userIdToEmail_.find(userId);
-    if (emailIt != userIdToEmail_.end()) {
-        auto userIt = usersByEmail_.find(emailIt->second);
-        if (userIt != usersByEmail_.end()) {
-            return userIt->second;
-        }
+    EpochGuard guard;
+    if (const core::User* user = table_.getById(userId)) {
+        return *user;
     }
     return std::nullopt;
 }
 
 std::vector<core::User> MemoryUserRepository::findAll() const {
-    std::lock_guard<std::mutex> lock(mutex_);
     std::vector<core::User> result;
-    result.reserve(usersByEmail_.size());
-    for (const auto& pair : usersByEmail_) {
-        result.push_back(pair.second);
-    }
+    result.reserve(table_.size());
+    table_.forEach([&](UserHandle, const core::User& user) {
+        result.push_back(user);
+    });
     return result;
 }
 
 std::vector<core::User> MemoryUserRepository::findOnlineUsers() const {
-    std::lock_guard<std::mutex> lock(mutex_);
     std::vector<core::User> result;
-    for (const auto& pair : usersByEmail_) {
-        if (pair.second.online) {
-            result.push_back(pair.second);
-        }
+    concurrency::EpochGuard guard;
+    for (UserHandle handle : table_.presence().page(0, 0, UserHandle(), true)) {
+        if (const core::User* user = table_.get(handle)) result.push_back(*user);
     }
     return result;
 }
 
-std::vector<core::User> MemoryUserRepository::findByRole(const std::string& role) const {
-    std::lock_guard<std::mutex> lock(mutex_);
+std::vector<core::User> MemoryUserRepository::findByRole(core::UserRole role) const {
+    std::vector<core::User> result;
+    table_.forEach([&](UserHandle, const core::User& user) {
+        if (user.role == role) result.push_back(user);
+    });
+    return result;
+}
+
+std::vector<core::User> MemoryUserRepository::searchContacts(const std::string& query, size_t limit) const {
     std::vector<core::User> result;
-    for (const auto& pair : usersByEmail_) {
-        if (pair.second.role == role) {
-            result.push_back(pair.second);
-        }
+    concurrency::EpochGuard guard;
+    for (UserHandle handle : table_.contacts().search(query, limit)) {
+        if (const core::User* user = table_.get(handle)) result.push_back(*user);
     }
     return result;
 }
 
 bool MemoryUserRepository::exists(const std::string& email) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return usersByEmail_.find(email) != usersByEmail_.end();
+    return table_.findByEmail(email).valid();
 }
 
 bool MemoryUserRepository::existsById(const std::string& userId) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return userIdToEmail_.find(userId) != userIdToEmail_.end();
+    return table_.findById(userId).valid();
 }
 
 bool MemoryUserRepository::update(const core::User& user) {
     std::lock_guard<std::mutex> lock(mutex_);
-    auto it = usersByEmail_.find(user.email);
-    if (it != usersByEmail_.end()) {
-        it->second = user;
-        return true;
-    }
-    return false;
+    return table_.update(table_.findByEmail(user.email), user);
 }
 
-bool MemoryUserRepository::updateLevel(const std::string& userId, const std::string& level) {
+bool MemoryUserRepository::updateLevel(const std::string& userId, core::Level level) {
     std::lock_guard<std::mutex> lock(mutex_);
-    auto emailIt = userIdToEmail_.find(userId);
-    if (emailIt != userIdToEmail_.end()) {
-        auto userIt = usersByEmail_.find(emailIt->second);
-        if (userIt != usersByEmail_.end()) {
-            userIt->second.level = level;
-            return true;
-        }
-    }
-    return false;
+    return table_.modify(table_.findById(userId), [&](core::User& user) {
+        user.level = level;
+    });
 }
 
 bool MemoryUserRepository::setOnlineStatus(const std::string& userId, bool online, int socket) {
     std::lock_guard<std::mutex> lock(mutex_);
-    auto emailIt = userIdToEmail_.find(userId);
-    if (emailIt != userIdToEmail_.end()) {
-        auto userIt = usersByEmail_.find(emailIt->second);
-        if (userIt != usersByEmail_.end()) {
-            userIt->second.online = online;
-            userIt->second.clientSocket = socket;
-            return true;
-        }
-    }
-    return false;
+    return table_.modify(table_.findById(userId), [&](core::User& user) {
+        user.online = online;
+        user.clientSocket = socket;
+    });
 }
 
 bool MemoryUserRepository::remove(const std::string& userId) {
     std::lock_guard<std::mutex> lock(mutex_);
-    auto emailIt = userIdToEmail_.find(userId);
-    if (emailIt != userIdToEmail_.end()) {
-        usersByEmail_.erase(emailIt->second);
-        userIdToEmail_.erase(emailIt);
-        return true;
-    }
-    return false;
+    return table_.erase(table_.findById(userId));
 }
 
 size_t MemoryUserRepository::count() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return usersByEmail_.size();
+    return table_.size();
 }
 
 bool MemoryUserRepository::isTeacher(const std::string& userId) const {
-    auto user = findById(userId);
-    if (user) {
-        return user->role == "teacher" || user->role == "admin";
-    }
-    return false;
+    EpochGuard guard;
+    const core::User* user = table_.getById(userId);
+    return user && user->isTeacher();
 }
 
 bool MemoryUserRepository::isAdmin(const std::string& userId) const {
-    auto user = findById(userId);
-    if (user) {
-        return user->role == "admin";
-    }
-    return false;
+    EpochGuard guard;
+    const core::User* user = table_.getById(userId);
+    return user && user->isAdmin();
 }
 
-core::User* MemoryUserRepository::getPointerById(const std::string& userId) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto emailIt = userIdToEmail_.find(userId);
-    if (emailIt != userIdToEmail_.end()) {
-        auto userIt = usersByEmail_.find(emailIt->second);
-        if (userIt != usersByEmail_.end()) {
-            return &userIt->second;
-        }
+UserHandle MemoryUserRepository::findHandle(const std::string& userId) const {
+    return table_.findById(userId);
+}
+
+std::optional<core::User> MemoryUserRepository::get(UserHandle handle) const {
+    EpochGuard guard;
+    if (const core::User* user = table_.get(handle)) {
+        return *user;
     }
-    return nullptr;
+    return std::nullopt;
 }
 
 } // namespace memory
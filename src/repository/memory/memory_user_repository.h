@@ -1,17 +1,18 @@
 #ifndef ENGLISH_LEARNING_REPOSITORY_MEMORY_USER_REPOSITORY_H
 #define ENGLISH_LEARNING_REPOSITORY_MEMORY_USER_REPOSITORY_H
 
-#include <map>
 #include <mutex>
 #include "include/repository/i_user_repository.h"
+#include "user_table.h"
 
 namespace english_learning {
 namespace repository {
 namespace memory {
 
 /**
- * In-memory implementation of IUserRepository.
- * Thread-safe with mutex protection.
+ * In-memory implementation of IUserRepository backed by a UserTable.
+ * Reads are lock-free through published user snapshots; the mutex only
+ * serializes writers.
  */
 class MemoryUserRepository : public IUserRepository {
 public:
@@ -26,13 +27,14 @@ public:
     std::optional<core::User> findById(const std::string& userId) const override;
     std::vector<core::User> findAll() const override;
     std::vector<core::User> findOnlineUsers() const override;
-    std::vector<core::User> findByRole(const std::string& role) const override;
+    std::vector<core::User> findByRole(core::UserRole role) const override;
+    std::vector<core::User> searchContacts(const std::string& query, size_t limit) const override;
     bool exists(const std::string& email) const override;
     bool existsById(const std::string& userId) const override;
 
     // Update
     bool update(const core::User& user) override;
-    bool updateLevel(const std::string& userId, const std::string& level) override;
+    bool updateLevel(const std::string& userId, core::Level level) override;
     bool setOnlineStatus(const std::string& userId, bool online, int socket = -1) override;
 
     // Delete
@@ -43,14 +45,13 @@ public:
     bool isTeacher(const std::string& userId) const override;
     bool isAdmin(const std::string& userId) const override;
 
-    // Direct access for backward compatibility (during migration)
-    core::User* getPointerById(const std::string& userId);
-    const std::map<std::string, core::User>& getUsersByEmail() const { return usersByEmail_; }
+    // Handle access for callers that hold on to users across calls
+    UserHandle findHandle(const std::string& userId) const;
+    std::optional<core::User> get(UserHandle handle) const;
 
 private:
-    mutable std::mutex mutex_;
-    std::map<std::string, core::User> usersByEmail_;  // email -> User
-    std::map<std::string, std::string> userIdToEmail_; // userId -> email (for fast lookup)
+    std::mutex mutex_;
+    UserTable table_;
 };
 
 } // namespace memory
@@ -0,0 +1,66 @@
+#include "presence_index.h"
+
+namespace english_learning {
+namespace repository {
+namespace memory {
+
+void PresenceIndex::track(UserHandle handle, bool online) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    (online ? online_ : offline_)[handle.index()] = handle;
+}
+
+bool PresenceIndex::setOnline(UserHandle handle, bool online) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& from = online ? offline_ : online_;
+    auto& to = online ? online_ : offline_;
+    auto it = from.find(handle.index());
+    if (it == from.end() || it->second != handle) {
+        return false;
+    }
+    from.erase(it);
+    to[handle.index()] = handle;
+    return true;
+}
+
+void PresenceIndex::untrack(UserHandle handle) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    online_.erase(handle.index());
+    offline_.erase(handle.index());
+}
+
+size_t PresenceIndex::onlineCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return online_.size();
+}
+
+size_t PresenceIndex::totalCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return online_.size() + offline_.size();
+}
+
+std::vector<UserHandle> PresenceIndex::page(size_t offset, size_t limit,
+                                            UserHandle exclude, bool onlineOnly) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<UserHandle> result;
+    if (limit > 0) result.reserve(limit);
+
+    auto take = [&](const std::map<uint32_t, UserHandle>& section) {
+        for (const auto& pair : section) {
+            if (limit > 0 && result.size() >= limit) return;
+            if (pair.second == exclude) continue;
+            if (offset > 0) {
+                offset--;
+                continue;
+            }
+            result.push_back(pair.second);
+        }
+    };
+
+    take(online_);
+    if (!onlineOnly) take(offline_);
+    return result;
+}
+
+} // namespace memory
+} // namespace repository
+} // namespace english_learning
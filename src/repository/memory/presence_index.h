@@ -0,0 +1,55 @@
+#ifndef ENGLISH_LEARNING_REPOSITORY_MEMORY_PRESENCE_INDEX_H
+#define ENGLISH_LEARNING_REPOSITORY_MEMORY_PRESENCE_INDEX_H
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "user_handle.h"
+
+namespace english_learning {
+namespace repository {
+namespace memory {
+
+/**
+ * Incrementally maintained online/offline partition of users.
+ * Both sets are ordered by slot index, so contact pages are stable:
+ * online users first, then offline users, each in registration order.
+ * Updated by UserTable whenever a published user flips its online flag.
+ */
+class PresenceIndex {
+public:
+    // Start tracking a user (called on insert)
+    void track(UserHandle handle, bool online);
+
+    // Move a user between sets; returns true if the status changed
+    bool setOnline(UserHandle handle, bool online);
+
+    // Stop tracking a user (called on erase)
+    void untrack(UserHandle handle);
+
+    size_t onlineCount() const;
+    size_t totalCount() const;
+
+    /**
+     * Page through users, online first.
+     * @param offset  Number of users to skip
+     * @param limit   Maximum users to return (0 = no limit)
+     * @param exclude Handle to leave out (usually the requesting user)
+     * @param onlineOnly Stop after the online section
+     */
+    std::vector<UserHandle> page(size_t offset, size_t limit,
+                                 UserHandle exclude = UserHandle(),
+                                 bool onlineOnly = false) const;
+
+private:
+    mutable std::mutex mutex_;
+    std::map<uint32_t, UserHandle> online_;   // slot index -> handle
+    std::map<uint32_t, UserHandle> offline_;  // slot index -> handle
+};
+
+} // namespace memory
+} // namespace repository
+} // namespace english_learning
+
+#endif // ENGLISH_LEARNING_REPOSITORY_MEMORY_PRESENCE_INDEX_H
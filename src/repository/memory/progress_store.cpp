@@ -0,0 +1,81 @@
+#include "progress_store.h"
+
+#include <algorithm>
+
+namespace english_learning {
+namespace repository {
+namespace memory {
+
+LessonProgress& ProgressStore::at(User& user, uint32_t slot, const std::string& lessonId) {
+    if (slot >= lessonIds_.size()) lessonIds_.resize(slot + 1);
+    if (lessonIds_[slot].empty()) lessonIds_[slot] = lessonId;
+    if (slot >= user.row.size()) user.row.resize(slot + 1);
+    return user.row[slot];
+}
+
+LessonProgress ProgressStore::update(const std::string& userId, const std::string& lessonId, int percent,
+                                     uint32_t position, int64_t now) {
+    uint32_t slot = slotOf_(lessonId);
+    User& user = users_[userId];
+    LessonProgress& progress = at(user, slot, lessonId);
+    if (!progress.started()) entries_++;
+
+    percent = std::max(0, std::min(100, percent));
+    progress.percent = std::max<uint8_t>(progress.percent, static_cast<uint8_t>(percent));
+    progress.position = position;
+    if (progress.percent == 100 && !progress.completed()) progress.completedAt = now;
+    progress.updatedAt = now;
+
+    if (user.dirty.empty()) dirtyUsers_.push_back(userId);
+    if (user.dirty.empty() || user.dirty.back() != slot) user.dirty.push_back(slot);
+    return progress;
+}
+
+void ProgressStore::restore(const std::string& userId, const std::string& lessonId,
+                            const LessonProgress& progress) {
+    LessonProgress& stored = at(users_[userId], slotOf_(lessonId), lessonId);
+    if (!stored.started()) entries_++;
+    stored = progress;
+}
+
+const ProgressStore::Row* ProgressStore::row(const std::string& userId) const {
+    auto it = users_.find(userId);
+    return it == users_.end() ? nullptr : &it->second.row;
+}
+
+std::vector<ProgressStore::Change> ProgressStore::takeDirty() {
+    std::vector<Change> changes;
+    for (const std::string& userId : dirtyUsers_) {
+        User& user = users_[userId];
+        std::sort(user.dirty.begin(), user.dirty.end());
+        user.dirty.erase(std::unique(user.dirty.begin(), user.dirty.end()), user.dirty.end());
+        for (uint32_t slot : user.dirty) changes.push_back({userId, lessonIds_[slot], user.row[slot]});
+        user.dirty.clear();
+    }
+    dirtyUsers_.clear();
+    return changes;
+}
+
+void ProgressStore::requeue(const std::vector<Change>& changes) {
+    for (const Change& change : changes) {
+        User& user = users_[change.userId];
+        if (user.dirty.empty()) dirtyUsers_.push_back(change.userId);
+        user.dirty.push_back(slotOf_(change.lessonId));
+    }
+}
+
+std::vector<ProgressStore::Change> ProgressStore::snapshot() const {
+    std::vector<Change> all;
+    all.reserve(entries_);
+    for (const auto& pair : users_) {
+        const Row& row = pair.second.row;
+        for (size_t slot = 0; slot < row.size(); ++slot) {
+            if (row[slot].started()) all.push_back({pair.first, lessonIds_[slot], row[slot]});
+        }
+    }
+    return all;
+}
+
+} // namespace memory
+} // namespace repository
+} // namespace english_learning
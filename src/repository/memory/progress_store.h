@@ -0,0 +1,100 @@
+#ifndef ENGLISH_LEARNING_REPOSITORY_MEMORY_PROGRESS_STORE_H
+#define ENGLISH_LEARNING_REPOSITORY_MEMORY_PROGRESS_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace english_learning {
+namespace repository {
+namespace memory {
+
+// How far a learner has got through one lesson
+struct LessonProgress {
+    uint8_t percent = 0;        // 0-100; never goes down
+    uint32_t position = 0;      // where the learner left off (seconds into the media, or scroll offset)
+    int64_t completedAt = 0;    // when percent first reached 100; 0 until then
+    int64_t updatedAt = 0;      // 0 if the lesson was never opened
+
+    bool started() const { return updatedAt != 0; }
+    bool completed() const { return completedAt != 0; }
+};
+
+/**
+ * Every user's lesson progress, kept for fast listing and written behind.
+ *
+ * A user's progress is one array indexed by lesson slot (see
+ * CatalogTable::slot()), so a lesson listing merges it by index, with no
+ * per-lesson lookup; lessons past the end of the array were never opened.
+ * The slot of a lesson id comes from the SlotOf given at construction.
+ *
+ * Updates only touch memory and remember which (user, lesson) pairs changed;
+ * a flusher collects those with takeDirty() and persists them in batches, so
+ * a client may report progress as often as it likes.
+ *
+ * Not synchronized: callers serialize access (progressMutex on the server).
+ */
+class ProgressStore {
+public:
+    using SlotOf = uint32_t (*)(const std::string& lessonId);
+    using Row = std::vector<LessonProgress>;   // indexed by lesson slot
+
+    // A change waiting to be persisted, as it stands now
+    struct Change {
+        std::string userId;
+        std::string lessonId;
+        LessonProgress progress;
+    };
+
+    explicit ProgressStore(SlotOf slotOf) : slotOf_(slotOf) {}
+
+    /**
+     * Record that userId is percent (clamped to 100) through lessonId, at
+     * position. The percentage only ever grows; reaching 100 stamps
+     * completedAt. Returns the progress as stored.
+     */
+    LessonProgress update(const std::string& userId, const std::string& lessonId, int percent,
+                          uint32_t position, int64_t now);
+
+    // Load progress read back from disk; it is not marked dirty
+    void restore(const std::string& userId, const std::string& lessonId, const LessonProgress& progress);
+
+    // userId's progress by lesson slot; nullptr if the user has none
+    const Row* row(const std::string& userId) const;
+
+    // Every change since the last call, once per (user, lesson)
+    std::vector<Change> takeDirty();
+
+    // Mark changes from takeDirty() dirty again, e.g. ones that could not be
+    // written; the next takeDirty() returns them as they stand by then, so a
+    // backlog never holds more than one entry per (user, lesson)
+    void requeue(const std::vector<Change>& changes);
+
+    // Every lesson each user has opened, for rewriting the log
+    std::vector<Change> snapshot() const;
+
+    // (user, lesson) pairs with progress
+    size_t size() const { return entries_; }
+
+private:
+    struct User {
+        Row row;
+        std::vector<uint32_t> dirty;   // slots changed since the last takeDirty()
+    };
+
+    LessonProgress& at(User& user, uint32_t slot, const std::string& lessonId);
+
+    SlotOf slotOf_;
+    std::unordered_map<std::string, User> users_;
+    std::vector<std::string> lessonIds_;   // slot -> lesson id, for the ids seen here
+    std::vector<std::string> dirtyUsers_;  // users with a non-empty dirty list
+    size_t entries_ = 0;
+};
+
+} // namespace memory
+} // namespace repository
+} // namespace english_learning
+
+#endif // ENGLISH_LEARNING_REPOSITORY_MEMORY_PROGRESS_STORE_H
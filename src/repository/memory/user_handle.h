@@ -0,0 +1,46 @@
+#ifndef ENGLISH_LEARNING_REPOSITORY_MEMORY_USER_HANDLE_H
+#define ENGLISH_LEARNING_REPOSITORY_MEMORY_USER_HANDLE_H
+
+#include <cstdint>
+
+namespace english_learning {
+namespace repository {
+namespace memory {
+
+/**
+ * 32-bit generation-checked reference to a slot in a UserTable.
+ * Low 24 bits hold the slot index, high 8 bits the slot generation.
+ * A handle to an erased user never resolves, even after the slot is reused.
+ */
+class UserHandle {
+public:
+    static constexpr uint32_t INDEX_BITS = 24;
+    static constexpr uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+
+    UserHandle() : value_(0) {}
+
+    static UserHandle make(uint32_t index, uint8_t generation) {
+        return UserHandle((static_cast<uint32_t>(generation) << INDEX_BITS) | (index & INDEX_MASK));
+    }
+
+    uint32_t index() const { return value_ & INDEX_MASK; }
+    uint8_t generation() const { return static_cast<uint8_t>(value_ >> INDEX_BITS); }
+    uint32_t value() const { return value_; }
+
+    // Generation 0 is never issued, so a zero handle is always invalid
+    bool valid() const { return generation() != 0; }
+    explicit operator bool() const { return valid(); }
+
+    bool operator==(const UserHandle& other) const { return value_ == other.value_; }
+    bool operator!=(const UserHandle& other) const { return value_ != other.value_; }
+
+private:
+    explicit UserHandle(uint32_t value) : value_(value) {}
+    uint32_t value_;
+};
+
+} // namespace memory
+} // namespace repository
+} // namespace english_learning
+
+#endif // ENGLISH_LEARNING_REPOSITORY_MEMORY_USER_HANDLE_H
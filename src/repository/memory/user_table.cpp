@@ -0,0 +1,171 @@
+#include "user_table.h"
+
+namespace english_learning {
+namespace repository {
+namespace memory {
+
+using concurrency::EpochDomain;
+using concurrency::EpochGuard;
+
+UserTable::UserTable() {
+    for (auto& chunk : chunks_) chunk.store(nullptr, std::memory_order_relaxed);
+}
+
+UserTable::~UserTable() {
+    for (auto& slot : chunks_) {
+        Chunk* chunk = slot.load();
+        if (!chunk) continue;
+        for (auto& rec : chunk->records) delete rec.load();
+        delete chunk;
+    }
+}
+
+const UserTable::Record* UserTable::recordAt(uint32_t index) const {
+    const Chunk* chunk = chunks_[index >> CHUNK_BITS].load(std::memory_order_acquire);
+    if (!chunk) return nullptr;
+    return chunk->records[index & (CHUNK_SIZE - 1)].load(std::memory_order_acquire);
+}
+
+std::atomic<const UserTable::Record*>& UserTable::slotRef(uint32_t index) {
+    std::atomic<Chunk*>& chunkSlot = chunks_[index >> CHUNK_BITS];
+    Chunk* chunk = chunkSlot.load(std::memory_order_relaxed);
+    if (!chunk) {
+        chunk = new Chunk();
+        chunkSlot.store(chunk, std::memory_order_release);
+    }
+    return chunk->records[index & (CHUNK_SIZE - 1)];
+}
+
+void UserTable::publish(UserHandle handle, core::User user) {
+    const Record* next = new Record{handle, std::move(user)};
+    const Record* old = slotRef(handle.index()).exchange(next, std::memory_order_acq_rel);
+
+    const core::User& now = next->user;
+    if (!old) {
+        presence_.track(handle, now.online);
+        contacts_.add(handle, now.fullname, now.email, now.online);
+    } else {
+        const core::User& was = old->user;
+        if (was.fullname != now.fullname || was.email != now.email) {
+            contacts_.remove(handle, was.fullname, was.email, was.online);
+            contacts_.add(handle, now.fullname, now.email, now.online);
+        } else if (was.online != now.online) {
+            contacts_.setOnline(handle, now.fullname, now.email, now.online);
+        }
+        if (was.online != now.online) {
+            presence_.setOnline(handle, now.online);
+            if (presenceListener_) presenceListener_(handle, now);
+        }
+    }
+
+    EpochDomain::global().retire(old);
+}
+
+UserHandle UserTable::insert(const core::User& user) {
+    if (findByEmail(user.email) || findById(user.userId)) {
+        return UserHandle(); // Email or id already registered
+    }
+
+    uint32_t index;
+    if (freeHead_ != NO_SLOT) {
+        index = freeHead_;
+        freeHead_ = meta_[index].nextFree;
+    } else {
+        if (meta_.size() >= NO_SLOT) {
+            return UserHandle(); // Index space exhausted
+        }
+        index = static_cast<uint32_t>(meta_.size());
+        meta_.emplace_back();
+    }
+
+    SlotMeta& meta = meta_[index];
+    meta.live = true;
+    meta.nextFree = NO_SLOT;
+
+    UserHandle handle = UserHandle::make(index, meta.generation);
+    publish(handle, user);
+    if (index >= highWater_.load(std::memory_order_relaxed)) {
+        highWater_.store(index + 1, std::memory_order_release);
+    }
+    size_.fetch_add(1, std::memory_order_relaxed);
+
+    byEmail_.put(user.email, handle);
+    byId_.put(user.userId, handle);
+    return handle;
+}
+
+UserHandle UserTable::findByEmail(const std::string& email) const {
+    EpochGuard guard;
+    const UserHandle* handle = byEmail_.find(email);
+    return handle ? *handle : UserHandle();
+}
+
+UserHandle UserTable::findById(const std::string& userId) const {
+    EpochGuard guard;
+    const UserHandle* handle = byId_.find(userId);
+    return handle ? *handle : UserHandle();
+}
+
+const core::User* UserTable::get(UserHandle handle) const {
+    if (!handle.valid()) return nullptr;
+    const Record* rec = recordAt(handle.index());
+    if (!rec || rec->handle != handle) return nullptr;
+    return &rec->user;
+}
+
+bool UserTable::update(UserHandle handle, const core::User& user) {
+    const core::User* current = get(handle);
+    if (!current) return false;
+
+    bool emailChanged = current->email != user.email;
+    bool idChanged = current->userId != user.userId;
+    if (emailChanged && findByEmail(user.email)) return false;
+    if (idChanged && findById(user.userId)) return false;
+
+    std::string oldEmail = current->email;
+    std::string oldId = current->userId;
+    publish(handle, user);
+
+    if (emailChanged) {
+        byEmail_.put(user.email, handle);
+        byEmail_.erase(oldEmail);
+    }
+    if (idChanged) {
+        byId_.put(user.userId, handle);
+        byId_.erase(oldId);
+    }
+    return true;
+}
+
+bool UserTable::erase(UserHandle handle) {
+    const core::User* user = get(handle);
+    if (!user) return false;
+
+    std::string email = user->email;
+    std::string userId = user->userId;
+    byEmail_.erase(email);
+    byId_.erase(userId);
+
+    const Record* old = slotRef(handle.index()).exchange(nullptr, std::memory_order_acq_rel);
+    presence_.untrack(handle);
+    contacts_.remove(handle, old->user.fullname, old->user.email, old->user.online);
+    if (old->user.online && presenceListener_) {
+        core::User gone = old->user;
+        gone.online = false;
+        presenceListener_(handle, gone);
+    }
+    EpochDomain::global().retire(old);
+
+    SlotMeta& meta = meta_[handle.index()];
+    meta.live = false;
+    // Skip generation 0 so a recycled slot never produces the invalid handle
+    if (++meta.generation == 0) meta.generation = 1;
+    meta.nextFree = freeHead_;
+    freeHead_ = handle.index();
+    size_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+} // namespace memory
+} // namespace repository
+} // namespace english_learning
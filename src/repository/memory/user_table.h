@@ -0,0 +1,155 @@
+#ifndef ENGLISH_LEARNING_REPOSITORY_MEMORY_USER_TABLE_H
+#define ENGLISH_LEARNING_REPOSITORY_MEMORY_USER_TABLE_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "include/core/user.h"
+#include "src/concurrency/rcu.h"
+#include "user_handle.h"
+#include "presence_index.h"
+#include "contact_index.h"
+
+namespace english_learning {
+namespace repository {
+namespace memory {
+
+/**
+ * Dense slot-map storage for users with lock-free readers.
+ *
+ * Each slot publishes an immutable User version; writers copy, modify and
+ * republish it, and the old version is reclaimed through the epoch domain.
+ * Freed slots are recycled through a free list and their generation is
+ * bumped so stale handles are rejected. Email and userId resolve to handles
+ * through RcuHashMap indexes, so a write republishes one bucket chain rather
+ * than the whole map. Online status is mirrored into a PresenceIndex, and
+ * names/emails into a ContactIndex for prefix search, on every publish.
+ *
+ * Writers (insert/update/modify/erase) must be serialized by the caller
+ * (usersMutex on the server, the repository mutex in MemoryUserRepository).
+ * Readers need no lock, but must hold a concurrency::EpochGuard for as long
+ * as they use a returned User pointer.
+ */
+class UserTable {
+public:
+    // Invoked by the writer after a user's online flag changes
+    using PresenceListener = std::function<void(UserHandle, const core::User&)>;
+
+    UserTable();
+    ~UserTable();
+
+    UserTable(const UserTable&) = delete;
+    UserTable& operator=(const UserTable&) = delete;
+
+    // ---- Writer side ----
+
+    // Insert a user; returns an invalid handle if email or userId is taken
+    UserHandle insert(const core::User& user);
+
+    // Replace the user stored at handle, re-indexing email/userId if changed.
+    // Fails if the handle is stale or the new email/userId belongs to another user.
+    bool update(UserHandle handle, const core::User& user);
+
+    // Copy the current version, apply fn to it and publish the result.
+    // fn must not change email or userId; use update() for that.
+    template <typename Fn>
+    bool modify(UserHandle handle, Fn&& fn) {
+        const core::User* current = get(handle);
+        if (!current) return false;
+        core::User next = *current;
+        fn(next);
+        publish(handle, std::move(next));
+        return true;
+    }
+
+    // Remove the user and invalidate every outstanding handle to it
+    bool erase(UserHandle handle);
+
+    // ---- Read side (lock-free) ----
+
+    UserHandle findByEmail(const std::string& email) const;
+    UserHandle findById(const std::string& userId) const;
+
+    // Resolve a handle; nullptr if the handle is stale or invalid
+    const core::User* get(UserHandle handle) const;
+    const core::User* getByEmail(const std::string& email) const { return get(findByEmail(email)); }
+    const core::User* getById(const std::string& userId) const { return get(findById(userId)); }
+
+    size_t size() const { return size_.load(std::memory_order_relaxed); }
+    bool empty() const { return size() == 0; }
+
+    // Online/offline partition, maintained on every publish
+    const PresenceIndex& presence() const { return presence_; }
+
+    // Name/email prefix index used by contact search
+    const ContactIndex& contacts() const { return contacts_; }
+
+    // Set before serving clients; called with the writer lock held
+    void setPresenceListener(PresenceListener listener) { presenceListener_ = std::move(listener); }
+
+    // Visit live users in slot order
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        concurrency::EpochGuard guard;
+        uint32_t end = highWater_.load(std::memory_order_acquire);
+        for (uint32_t i = 0; i < end; ++i) {
+            const Record* rec = recordAt(i);
+            if (rec) fn(rec->handle, rec->user);
+        }
+    }
+
+private:
+    static constexpr uint32_t NO_SLOT = UserHandle::INDEX_MASK;
+    static constexpr uint32_t CHUNK_BITS = 12;
+    static constexpr uint32_t CHUNK_SIZE = 1u << CHUNK_BITS;
+    static constexpr uint32_t MAX_CHUNKS = (UserHandle::INDEX_MASK + 1) / CHUNK_SIZE;
+
+    // Immutable published version of a slot
+    struct Record {
+        UserHandle handle;
+        core::User user;
+    };
+
+    // Fixed-size block of slots; never moves once allocated
+    struct Chunk {
+        std::atomic<const Record*> records[CHUNK_SIZE];
+        Chunk() {
+            for (auto& r : records) r.store(nullptr, std::memory_order_relaxed);
+        }
+    };
+
+    // Writer-only bookkeeping per slot
+    struct SlotMeta {
+        uint8_t generation = 1;
+        bool live = false;
+        uint32_t nextFree = NO_SLOT;
+    };
+
+    using Index = concurrency::RcuHashMap<std::string, UserHandle>;
+
+    const Record* recordAt(uint32_t index) const;
+    std::atomic<const Record*>& slotRef(uint32_t index);
+    void publish(UserHandle handle, core::User user);
+
+    std::atomic<Chunk*> chunks_[MAX_CHUNKS];
+    std::atomic<uint32_t> highWater_{0};
+    std::atomic<size_t> size_{0};
+
+    std::vector<SlotMeta> meta_;
+    uint32_t freeHead_ = NO_SLOT;
+
+    Index byEmail_;
+    Index byId_;
+
+    PresenceIndex presence_;
+    ContactIndex contacts_;
+    PresenceListener presenceListener_;
+};
+
+} // namespace memory
+} // namespace repository
+} // namespace english_learning
+
+#endif // ENGLISH_LEARNING_REPOSITORY_MEMORY_USER_TABLE_H
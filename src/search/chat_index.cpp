@@ -0,0 +1,176 @@
+#include "chat_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include "text.h"
+
+namespace english_learning {
+namespace search {
+
+std::string ChatIndex::conversationKey(const Doc& doc) {
+    // Same keys as the chat archive: '\x1f' never occurs in ids, and no
+    // user id starts with '#'
+    if (doc.scope == Scope::Channel) return '#' + doc.targetId;
+    return doc.senderId < doc.targetId ? doc.senderId + '\x1f' + doc.targetId
+                                       : doc.targetId + '\x1f' + doc.senderId;
+}
+
+void ChatIndex::add(const core::ChatMessage& message, Scope scope) {
+    uint32_t id = nextDoc_;
+    if (!byMessage_.emplace(message.messageId, id).second) return;   // already indexed
+    nextDoc_++;
+
+    Doc doc{message.messageId, scope, message.senderId, message.recipientId, message.timestamp};
+    std::string key = conversationKey(doc);
+    if (scope == Scope::Direct) {
+        directByUser_[doc.senderId].insert(key);
+        directByUser_[doc.targetId].insert(key);
+    }
+    docs_.emplace(id, std::move(doc));
+
+    std::unordered_map<std::string, uint32_t> counts;
+    for (const Token& token : tokenize(message.content)) ++counts[token.term];
+    Postings& postings = conversations_[key];
+    for (const auto& pair : counts) {
+        postings[pair.first].push_back(Posting{id, pair.second});
+        ++frequency_[pair.first];
+    }
+}
+
+void ChatIndex::remove(const std::vector<std::string>& messageIds) {
+    // Group the documents by conversation so each is walked once
+    std::unordered_map<std::string, std::unordered_set<uint32_t>> dead;
+    for (const std::string& messageId : messageIds) {
+        auto it = byMessage_.find(messageId);
+        if (it == byMessage_.end()) continue;
+        dead[conversationKey(docs_.at(it->second))].insert(it->second);
+        byMessage_.erase(it);
+    }
+
+    for (const auto& pair : dead) {
+        auto conversation = conversations_.find(pair.first);
+        if (conversation != conversations_.end()) {
+            Postings& postings = conversation->second;
+            for (auto term = postings.begin(); term != postings.end();) {
+                PostingList& list = term->second;
+                size_t before = list.size();
+                list.erase(std::remove_if(list.begin(), list.end(),
+                                          [&](const Posting& p) { return pair.second.count(p.doc) > 0; }),
+                           list.end());
+                if (list.size() != before) {
+                    auto frequency = frequency_.find(term->first);
+                    frequency->second -= static_cast<uint32_t>(before - list.size());
+                    if (frequency->second == 0) frequency_.erase(frequency);
+                }
+                term = list.empty() ? postings.erase(term) : std::next(term);
+            }
+
+            // A conversation with nothing left to match is no longer searched
+            if (postings.empty()) {
+                conversations_.erase(conversation);
+                const Doc& doc = docs_.at(*pair.second.begin());
+                if (doc.scope == Scope::Direct) {
+                    for (const std::string& userId : {doc.senderId, doc.targetId}) {
+                        auto user = directByUser_.find(userId);
+                        if (user == directByUser_.end()) continue;
+                        user->second.erase(pair.first);
+                        if (user->second.empty()) directByUser_.erase(user);
+                    }
+                }
+            }
+        }
+        for (uint32_t id : pair.second) docs_.erase(id);
+    }
+}
+
+std::vector<ChatIndex::Hit> ChatIndex::search(const std::vector<std::string>& terms, bool prefixLast,
+                                              const std::string& userId,
+                                              const std::unordered_set<std::string>& channelIds) const {
+    std::vector<Hit> hits;
+    if (terms.empty()) return hits;
+
+    // Inverse document frequency of each term over every conversation; a
+    // prefix term counts every word it starts
+    double n = static_cast<double>(docs_.size());
+    std::vector<double> idf;
+    for (size_t i = 0; i < terms.size(); ++i) {
+        const std::string& term = terms[i];
+        double frequency = 0;
+        if (prefixLast && i + 1 == terms.size() && term.size() >= MIN_PREFIX) {
+            for (auto it = frequency_.lower_bound(term);
+                 it != frequency_.end() && it->first.compare(0, term.size(), term) == 0; ++it) {
+                frequency += it->second;
+            }
+        } else {
+            auto it = frequency_.find(term);
+            if (it != frequency_.end()) frequency = it->second;
+        }
+        if (frequency == 0) return hits;   // every term must match
+        idf.push_back(std::log(1.0 + n / std::min(frequency, n)));
+    }
+
+    std::vector<std::string> keys;
+    auto direct = directByUser_.find(userId);
+    if (direct != directByUser_.end()) keys.assign(direct->second.begin(), direct->second.end());
+    for (const std::string& channelId : channelIds) keys.push_back('#' + channelId);
+
+    for (const std::string& key : keys) {
+        auto conversation = conversations_.find(key);
+        if (conversation == conversations_.end()) continue;
+        const Postings& postings = conversation->second;
+
+        // One posting list per term; a prefix term merges the lists of every word it starts
+        std::vector<std::pair<const PostingList*, double>> lists;
+        PostingList merged;
+        for (size_t i = 0; i < terms.size(); ++i) {
+            const std::string& term = terms[i];
+            if (prefixLast && i + 1 == terms.size() && term.size() >= MIN_PREFIX) {
+                std::unordered_map<uint32_t, uint32_t> tf;
+                for (auto it = postings.lower_bound(term);
+                     it != postings.end() && it->first.compare(0, term.size(), term) == 0; ++it) {
+                    for (const Posting& p : it->second) tf[p.doc] += p.tf;
+                }
+                if (tf.empty()) break;
+                for (const auto& pair : tf) merged.push_back(Posting{pair.first, pair.second});
+                std::sort(merged.begin(), merged.end(),
+                          [](const Posting& a, const Posting& b) { return a.doc < b.doc; });
+                lists.emplace_back(&merged, idf[i]);
+            } else {
+                auto it = postings.find(term);
+                if (it == postings.end()) break;
+                lists.emplace_back(&it->second, idf[i]);
+            }
+        }
+        if (lists.size() < terms.size()) continue;
+
+        // Rarest term first keeps the candidate set small
+        std::sort(lists.begin(), lists.end(),
+                  [](const auto& a, const auto& b) { return a.first->size() < b.first->size(); });
+        auto weight = [](uint32_t tf, double idf) { return (1.0 + std::log(static_cast<double>(tf))) * idf; };
+
+        size_t first = hits.size();
+        for (const Posting& p : *lists.front().first) hits.push_back(Hit{p.doc, weight(p.tf, lists.front().second)});
+        for (size_t i = 1; i < lists.size() && hits.size() > first; ++i) {
+            const PostingList& list = *lists[i].first;
+            size_t kept = first;
+            for (size_t h = first; h < hits.size(); ++h) {
+                auto it = std::lower_bound(list.begin(), list.end(), hits[h].doc,
+                                           [](const Posting& p, uint32_t doc) { return p.doc < doc; });
+                if (it != list.end() && it->doc == hits[h].doc) {
+                    hits[kept++] = Hit{hits[h].doc, hits[h].score + weight(it->tf, lists[i].second)};
+                }
+            }
+            hits.resize(kept);
+        }
+    }
+
+    std::sort(hits.begin(), hits.end(), [this](const Hit& a, const Hit& b) {
+        if (a.score != b.score) return a.score > b.score;
+        return docs_.at(a.doc).timestamp > docs_.at(b.doc).timestamp;
+    });
+    return hits;
+}
+
+} // namespace search
+} // namespace english_learning
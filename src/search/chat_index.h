@@ -0,0 +1,93 @@
+#ifndef ENGLISH_LEARNING_SEARCH_CHAT_INDEX_H
+#define ENGLISH_LEARNING_SEARCH_CHAT_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "include/core/chat_message.h"
+
+namespace english_learning {
+namespace search {
+
+/**
+ * Inverted index over chat message content, one per conversation.
+ *
+ * Each conversation (a pair of users, or a channel) has its own posting
+ * lists, so a search only walks the conversations the user belongs to.
+ * Messages are tokenized with tokenize() and get increasing document
+ * numbers, so every posting list is sorted by document and grows at the
+ * end. Document frequencies are kept across all conversations for ranking
+ * and prefix expansion.
+ *
+ * The index stores ids, not content: callers resolve hits against the
+ * chat/channel stores, and remove() messages that leave them.
+ *
+ * Not synchronized: callers serialize access (chatIndexMutex on the server).
+ */
+class ChatIndex {
+public:
+    enum class Scope : uint8_t { Direct, Channel };
+
+    struct Doc {
+        std::string messageId;
+        Scope scope;
+        std::string senderId;
+        std::string targetId;       // recipient user, or channelId
+        core::Timestamp timestamp;
+    };
+
+    struct Hit {
+        uint32_t doc;
+        double score;
+    };
+
+    // Query words shorter than this are never expanded as prefixes
+    static constexpr size_t MIN_PREFIX = 2;
+
+    void add(const core::ChatMessage& message, Scope scope);
+
+    // Drop messages, e.g. ones removed or archived; unknown ids are skipped.
+    // Costs one pass over each affected conversation's postings.
+    void remove(const std::vector<std::string>& messageIds);
+
+    /**
+     * Messages containing every term, best first (tf-idf, newest on ties).
+     * When prefixLast is set the last term also matches longer words, for
+     * search-as-you-type. Only userId's direct conversations and the
+     * channels in channelIds are searched.
+     */
+    std::vector<Hit> search(const std::vector<std::string>& terms, bool prefixLast,
+                            const std::string& userId,
+                            const std::unordered_set<std::string>& channelIds) const;
+
+    const Doc& doc(uint32_t id) const { return docs_.at(id); }
+
+    size_t size() const { return docs_.size(); }
+    size_t termCount() const { return frequency_.size(); }
+
+private:
+    struct Posting {
+        uint32_t doc;
+        uint32_t tf;
+    };
+    using PostingList = std::vector<Posting>;
+    using Postings = std::map<std::string, PostingList>;   // term -> documents; ordered for prefixes
+
+    static std::string conversationKey(const Doc& doc);
+
+    std::unordered_map<std::string, Postings> conversations_;   // conversation -> postings
+    std::unordered_map<uint32_t, Doc> docs_;
+    std::unordered_map<std::string, uint32_t> byMessage_;       // messageId -> doc
+    std::unordered_map<std::string, std::unordered_set<std::string>> directByUser_;  // user -> conversations
+    std::map<std::string, uint32_t> frequency_;   // term -> documents holding it, over all conversations
+    uint32_t nextDoc_ = 0;
+};
+
+} // namespace search
+} // namespace english_learning
+
+#endif // ENGLISH_LEARNING_SEARCH_CHAT_INDEX_H
@@ -0,0 +1,267 @@
+#include "content_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include "text.h"
+
+namespace english_learning {
+namespace search {
+
+namespace {
+
+float fieldWeight(ContentIndex::Field field) {
+    switch (field) {
+        case ContentIndex::Field::Title: return ContentIndex::TITLE_WEIGHT;
+        case ContentIndex::Field::Description: return ContentIndex::DESCRIPTION_WEIGHT;
+        default: return ContentIndex::BODY_WEIGHT;
+    }
+}
+
+// a ranks above b; as a heap order it keeps the worst hit on top
+bool betterHit(const ContentIndex::Hit& a, const ContentIndex::Hit& b) {
+    return a.score != b.score ? a.score > b.score : a.doc < b.doc;
+}
+
+} // namespace
+
+std::vector<std::string> ContentIndex::Query::terms() const {
+    std::vector<std::string> out = words;
+    for (const auto& phrase : phrases) {
+        for (const std::string& term : phrase) {
+            if (std::find(out.begin(), out.end(), term) == out.end()) out.push_back(term);
+        }
+    }
+    return out;
+}
+
+ContentIndex::Query ContentIndex::parse(const std::string& text) {
+    Query query;
+    auto addWord = [&query](const std::string& term) {
+        if (std::find(query.words.begin(), query.words.end(), term) == query.words.end()) {
+            query.words.push_back(term);
+        }
+    };
+
+    bool quoted = false;
+    size_t start = 0;
+    for (size_t i = 0; i <= text.size(); ++i) {
+        if (i < text.size() && text[i] != '"') continue;
+        std::vector<Token> tokens = tokenize(std::string_view(text).substr(start, i - start));
+        if (quoted && tokens.size() > 1) {
+            std::vector<std::string> phrase;
+            for (const Token& token : tokens) phrase.push_back(token.term);
+            if (std::find(query.phrases.begin(), query.phrases.end(), phrase) == query.phrases.end()) {
+                query.phrases.push_back(std::move(phrase));
+            }
+        } else {
+            for (const Token& token : tokens) addWord(token.term);
+        }
+        quoted = !quoted;
+        start = i + 1;
+    }
+    return query;
+}
+
+void ContentIndex::Builder::begin(uint8_t level, const std::string& id) {
+    docs_.push_back(Doc{level, id});
+    lengths_.push_back(0.0f);
+    position_ = 0;
+}
+
+void ContentIndex::Builder::add(Field field, std::string_view text) {
+    uint32_t doc = static_cast<uint32_t>(docs_.size() - 1);
+    float weight = fieldWeight(field);
+    for (const Token& token : tokenize(text)) {
+        auto it = terms_.find(token.term);   // emplace() would allocate a node for every token
+        if (it == terms_.end()) it = terms_.emplace(token.term, static_cast<uint32_t>(terms_.size())).first;
+        occurrences_.push_back(Occurrence{it->second, doc, position_++, field});
+        lengths_.back() += weight;
+    }
+    position_++;   // leave a hole so that no phrase spans two segments
+}
+
+ContentIndex ContentIndex::Builder::build() {
+    ContentIndex index;
+    size_t termCount = terms_.size();
+
+    // Bucket occurrences by term; within a term they stay in (doc, position)
+    // order because they were added that way
+    std::vector<uint32_t> start(termCount + 1, 0);
+    for (const Occurrence& o : occurrences_) start[o.term + 1]++;
+    for (size_t t = 0; t < termCount; ++t) start[t + 1] += start[t];
+    std::vector<Occurrence> sorted(occurrences_.size());
+    {
+        std::vector<uint32_t> next(start.begin(), start.end() - 1);
+        for (const Occurrence& o : occurrences_) sorted[next[o.term]++] = o;
+    }
+    occurrences_.clear();
+    occurrences_.shrink_to_fit();
+
+    float n = static_cast<float>(docs_.size());
+    float total = 0.0f;
+    for (float length : lengths_) total += length;
+    float avgLength = n > 0 && total > 0 ? total / n : 1.0f;
+
+    index.postingStart_.reserve(termCount + 1);
+    index.positions_.reserve(sorted.size());
+    for (size_t t = 0; t < termCount; ++t) {
+        uint32_t first = static_cast<uint32_t>(index.postingDoc_.size());
+        index.postingStart_.push_back(first);
+
+        // One posting per document, with its weighted term frequency
+        std::vector<float> tfs;
+        for (uint32_t i = start[t]; i < start[t + 1]; ++i) {
+            const Occurrence& o = sorted[i];
+            if (i == start[t] || sorted[i - 1].doc != o.doc) {
+                index.postingDoc_.push_back(o.doc);
+                index.positionStart_.push_back(static_cast<uint32_t>(index.positions_.size()));
+                tfs.push_back(0.0f);
+            }
+            index.positions_.push_back(o.position);
+            tfs.back() += fieldWeight(o.field);
+        }
+
+        float df = static_cast<float>(tfs.size());
+        float idf = std::log(1.0f + (n - df + 0.5f) / (df + 0.5f));
+        for (size_t k = 0; k < tfs.size(); ++k) {
+            float norm = K1 * (1.0f - B + B * lengths_[index.postingDoc_[first + k]] / avgLength);
+            index.postingWeight_.push_back(idf * tfs[k] * (K1 + 1.0f) / (tfs[k] + norm));
+        }
+    }
+    index.postingStart_.push_back(static_cast<uint32_t>(index.postingDoc_.size()));
+    index.positionStart_.push_back(static_cast<uint32_t>(index.positions_.size()));
+
+    index.termIds_ = std::move(terms_);
+    index.docs_ = std::move(docs_);
+    terms_.clear();
+    docs_.clear();
+    lengths_.clear();
+    return index;
+}
+
+uint32_t ContentIndex::seek(uint32_t term, uint32_t from, uint32_t doc) const {
+    uint32_t end = postingStart_[term + 1];
+    if (from >= end || postingDoc_[from] >= doc) return from;
+
+    // Gallop past smaller documents, then binary search the last step
+    uint32_t lo = from, step = 1;
+    while (lo + step < end && postingDoc_[lo + step] < doc) {
+        lo += step;
+        step *= 2;
+    }
+    uint32_t hi = std::min(end, lo + step);
+    return static_cast<uint32_t>(std::lower_bound(postingDoc_.begin() + lo, postingDoc_.begin() + hi, doc) -
+                                 postingDoc_.begin());
+}
+
+bool ContentIndex::hasPhrase(const std::vector<uint32_t>& postings, std::vector<uint32_t>& cursors) const {
+    // Merge the first two words' positions looking for x, x + 1 (without
+    // branching on which side advances: most documents hold neither), then
+    // check any further words at x + 2, ... with cursors that only move forward
+    cursors.resize(postings.size());
+    for (size_t i = 2; i < postings.size(); ++i) cursors[i] = positionStart_[postings[i]];
+    const uint32_t* pos = positions_.data();
+    uint32_t a = positionStart_[postings[0]], aEnd = positionStart_[postings[0] + 1];
+    uint32_t b = positionStart_[postings[1]], bEnd = positionStart_[postings[1] + 1];
+    while (a < aEnd && b < bEnd) {
+        uint32_t x = pos[a] + 1, y = pos[b];
+        if (x == y) {
+            size_t i = 2;
+            for (; i < postings.size(); ++i) {
+                uint32_t end = positionStart_[postings[i] + 1];
+                uint32_t& c = cursors[i];
+                while (c < end && pos[c] < y - 1 + i) ++c;
+                if (c == end) return false;
+                if (pos[c] != y - 1 + i) break;
+            }
+            if (i == postings.size()) return true;
+            ++a;
+            ++b;
+            continue;
+        }
+        a += x < y;
+        b += y < x;
+    }
+    return false;
+}
+
+std::vector<ContentIndex::Hit> ContentIndex::search(const Query& query, int level, size_t limit,
+                                                    size_t& matches) const {
+    matches = 0;
+    std::vector<Hit> hits;
+    if (query.empty() || limit == 0) return hits;
+
+    std::vector<std::string> terms = query.terms();
+    std::vector<uint32_t> ids;
+    for (const std::string& term : terms) {
+        auto it = termIds_.find(term);
+        if (it == termIds_.end()) return hits;   // every term must match
+        ids.push_back(it->second);
+    }
+    // Phrase words as indexes into ids
+    std::vector<std::vector<size_t>> phrases;
+    for (const auto& phrase : query.phrases) {
+        std::vector<size_t> words;
+        for (const std::string& term : phrase) {
+            words.push_back(std::find(terms.begin(), terms.end(), term) - terms.begin());
+        }
+        phrases.push_back(std::move(words));
+    }
+
+    // Drive the intersection from the rarest term
+    std::vector<size_t> order(ids.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    auto length = [this, &ids](size_t i) { return postingStart_[ids[i] + 1] - postingStart_[ids[i]]; };
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return length(a) < length(b); });
+
+    std::vector<uint32_t> cursor(ids.size());
+    for (size_t i = 0; i < ids.size(); ++i) cursor[i] = postingStart_[ids[i]];
+    std::vector<uint32_t> phrasePostings, phraseCursors;
+    size_t driver = order[0];
+    bool exhausted = false;   // some term has no documents left
+    for (uint32_t p = postingStart_[ids[driver]]; p < postingStart_[ids[driver] + 1]; ++p) {
+        uint32_t doc = postingDoc_[p];
+        if (level >= 0 && docs_[doc].level != level) continue;
+        cursor[driver] = p;
+
+        bool all = true;
+        for (size_t k = 1; k < order.size() && all; ++k) {
+            size_t i = order[k];
+            cursor[i] = seek(ids[i], cursor[i], doc);
+            if (cursor[i] == postingStart_[ids[i] + 1]) {
+                exhausted = true;
+                break;
+            }
+            all = postingDoc_[cursor[i]] == doc;
+        }
+        if (exhausted) break;
+        if (!all) continue;
+        for (const auto& phrase : phrases) {
+            phrasePostings.clear();
+            for (size_t i : phrase) phrasePostings.push_back(cursor[i]);
+            if (!hasPhrase(phrasePostings, phraseCursors)) {
+                all = false;
+                break;
+            }
+        }
+        if (!all) continue;
+
+        float score = 0.0f;
+        for (size_t i = 0; i < ids.size(); ++i) score += postingWeight_[cursor[i]];
+        matches++;
+        Hit hit{doc, score};
+        if (hits.size() < limit) {
+            hits.push_back(hit);
+            std::push_heap(hits.begin(), hits.end(), betterHit);
+        } else if (betterHit(hit, hits.front())) {
+            std::pop_heap(hits.begin(), hits.end(), betterHit);
+            hits.back() = hit;
+            std::push_heap(hits.begin(), hits.end(), betterHit);
+        }
+    }
+    std::sort_heap(hits.begin(), hits.end(), betterHit);
+    return hits;
+}
+
+} // namespace search
+} // namespace english_learning
@@ -0,0 +1,124 @@
+#ifndef ENGLISH_LEARNING_SEARCH_CONTENT_INDEX_H
+#define ENGLISH_LEARNING_SEARCH_CONTENT_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace english_learning {
+namespace search {
+
+/**
+ * Immutable inverted index over one kind of learning content (lessons,
+ * exercises or games), ranked with BM25.
+ *
+ * A document is a record with a few text fields; each field is
+ * given as one or more segments (a lesson body, each exercise prompt, each
+ * side of a game pair). Terms come from tokenize(), so English and
+ * Vietnamese match with or without diacritics. Positions are kept for phrase
+ * queries; a phrase never spans two segments.
+ *
+ * Built once per catalog version with a Builder and never changed, so any
+ * number of readers may search it without locks. Postings live in flat
+ * arrays sorted by document, and each posting carries its precomputed BM25
+ * term weight: a query only intersects lists and adds weights.
+ */
+class ContentIndex {
+public:
+    // Where a segment of text belongs; titles weigh most
+    enum class Field : uint8_t { Title, Description, Body };
+
+    struct Doc {
+        uint8_t level;      // the caller's level code, for filtering
+        std::string id;
+    };
+
+    struct Hit {
+        uint32_t doc;
+        float score;
+    };
+
+    /**
+     * A parsed query: words that must all occur, and phrases ("...") whose
+     * words must occur next to each other in order.
+     */
+    struct Query {
+        std::vector<std::string> words;                 // distinct, folded
+        std::vector<std::vector<std::string>> phrases;  // two or more folded words each
+
+        bool empty() const { return words.empty() && phrases.empty(); }
+        // Every distinct term of the query, words first
+        std::vector<std::string> terms() const;
+    };
+
+    // Split text into words and double-quoted phrases; a phrase of one word
+    // is a word, and an unterminated quote runs to the end
+    static Query parse(const std::string& text);
+
+    class Builder {
+    public:
+        // Start a new document; later segments belong to it
+        void begin(uint8_t level, const std::string& id);
+        void add(Field field, std::string_view text);
+        ContentIndex build();
+
+    private:
+        struct Occurrence {
+            uint32_t term;
+            uint32_t doc;
+            uint32_t position;
+            Field field;
+        };
+
+        std::vector<Doc> docs_;
+        std::vector<float> lengths_;                // weighted token count per document
+        std::unordered_map<std::string, uint32_t> terms_;
+        std::vector<Occurrence> occurrences_;
+        uint32_t position_ = 0;                     // next position in the current document
+    };
+
+    /**
+     * The best `limit` documents matching query, and of the given level
+     * unless it is negative, best first (ties by document order); `matches`
+     * receives how many matched in all.
+     */
+    std::vector<Hit> search(const Query& query, int level, size_t limit, size_t& matches) const;
+
+    const Doc& doc(uint32_t id) const { return docs_[id]; }
+
+    size_t size() const { return docs_.size(); }
+    size_t termCount() const { return termIds_.size(); }
+
+    // BM25 parameters and field weights
+    static constexpr float K1 = 1.2f;
+    static constexpr float B = 0.75f;
+    static constexpr float TITLE_WEIGHT = 3.0f;
+    static constexpr float DESCRIPTION_WEIGHT = 1.5f;
+    static constexpr float BODY_WEIGHT = 1.0f;
+
+private:
+    // Term t's postings are [postingStart_[t], postingStart_[t + 1]) in
+    // postingDoc_/postingWeight_, and posting p's positions are
+    // [positionStart_[p], positionStart_[p + 1]) in positions_
+    std::unordered_map<std::string, uint32_t> termIds_;
+    std::vector<uint32_t> postingStart_;
+    std::vector<uint32_t> postingDoc_;
+    std::vector<float> postingWeight_;     // idf * saturated tf, ready to add
+    std::vector<uint32_t> positionStart_;
+    std::vector<uint32_t> positions_;
+    std::vector<Doc> docs_;
+
+    // Posting of term in doc at or after `from`; end of the term's list if absent
+    uint32_t seek(uint32_t term, uint32_t from, uint32_t doc) const;
+    // Whether the words with these postings (of one document) occur in a row;
+    // cursors is scratch space
+    bool hasPhrase(const std::vector<uint32_t>& postings, std::vector<uint32_t>& cursors) const;
+};
+
+} // namespace search
+} // namespace english_learning
+
+#endif // ENGLISH_LEARNING_SEARCH_CONTENT_INDEX_H
@@ -0,0 +1,167 @@
+#include "text.h"
+
+#include <unordered_map>
+
+namespace english_learning {
+namespace search {
+
+namespace {
+
+// Decode one UTF-8 sequence at text[i]; returns its length, or 0 if malformed
+size_t decodeUtf8(std::string_view text, size_t i, char32_t& cp) {
+    unsigned char c = static_cast<unsigned char>(text[i]);
+    size_t len;
+    if (c < 0x80) { cp = c; return 1; }
+    else if ((c & 0xE0) == 0xC0) { cp = c & 0x1F; len = 2; }
+    else if ((c & 0xF0) == 0xE0) { cp = c & 0x0F; len = 3; }
+    else if ((c & 0xF8) == 0xF0) { cp = c & 0x07; len = 4; }
+    else return 0;
+
+    if (i + len > text.size()) return 0;
+    for (size_t k = 1; k < len; ++k) {
+        unsigned char cc = static_cast<unsigned char>(text[i + k]);
+        if ((cc & 0xC0) != 0x80) return 0;
+        cp = (cp << 6) | (cc & 0x3F);
+    }
+    return len;
+}
+
+// Vietnamese letter -> ASCII base letter, built once from the alphabet below
+const std::unordered_map<char32_t, char>& foldTable() {
+    static const std::unordered_map<char32_t, char> table = [] {
+        static const struct { char base; const char* variants; } alphabet[] = {
+            {'a', "àáảãạăằắẳẵặâầấẩẫậÀÁẢÃẠĂẰẮẲẴẶÂẦẤẨẪẬ"},
+            {'e', "èéẻẽẹêềếểễệÈÉẺẼẸÊỀẾỂỄỆ"},
+            {'i', "ìíỉĩịÌÍỈĨỊ"},
+            {'o', "òóỏõọôồốổỗộơờớởỡợÒÓỎÕỌÔỒỐỔỖỘƠỜỚỞỠỢ"},
+            {'u', "ùúủũụưừứửữựÙÚỦŨỤƯỪỨỬỮỰ"},
+            {'y', "ỳýỷỹỵỲÝỶỸỴ"},
+            {'d', "đĐ"},
+        };
+        std::unordered_map<char32_t, char> t;
+        for (const auto& letter : alphabet) {
+            std::string variants = letter.variants;
+            char32_t cp;
+            for (size_t i = 0; i < variants.size();) {
+                size_t len = decodeUtf8(variants, i, cp);
+                t[cp] = letter.base;
+                i += len;
+            }
+        }
+        return t;
+    }();
+    return table;
+}
+
+bool isCombiningMark(char32_t cp) {
+    return cp >= 0x0300 && cp <= 0x036F;
+}
+
+// Non-ASCII code points that separate words rather than belong to them
+bool isSeparator(char32_t cp) {
+    return (cp >= 0x0080 && cp <= 0x00BF) || cp == 0x00D7 || cp == 0x00F7 ||
+           (cp >= 0x2000 && cp <= 0x2BFF) ||      // punctuation, symbols, arrows
+           (cp >= 0x3000 && cp <= 0x303F) ||      // CJK punctuation
+           (cp >= 0xFE00 && cp <= 0xFE0F) ||      // variation selectors
+           cp == 0xFEFF || cp >= 0x1F000;         // BOM, emoji
+}
+
+bool matches(const std::string& term, const std::vector<std::string>& terms, bool prefixLast) {
+    for (const std::string& t : terms) {
+        if (term == t) return true;
+    }
+    return prefixLast && !terms.empty() && term.compare(0, terms.back().size(), terms.back()) == 0;
+}
+
+} // namespace
+
+std::vector<Token> tokenize(std::string_view text) {
+    const auto& table = foldTable();
+    std::vector<Token> tokens;
+    Token current{std::string(), 0, 0};
+    bool inWord = false;
+
+    auto finish = [&](size_t end) {
+        if (inWord && !current.term.empty() && current.term.size() <= MAX_TERM_BYTES) {
+            current.end = end;
+            tokens.push_back(current);
+        }
+        inWord = false;
+        current.term.clear();
+    };
+
+    for (size_t i = 0; i < text.size();) {
+        char32_t cp;
+        size_t len = decodeUtf8(text, i, cp);
+        if (len == 0) {             // malformed byte: treat as a separator
+            finish(i);
+            ++i;
+            continue;
+        }
+
+        bool word = false;
+        if (cp < 0x80) {
+            char c = static_cast<char>(cp);
+            if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+            if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9')) {
+                if (!inWord) { inWord = true; current.begin = i; }
+                current.term += c;
+                word = true;
+            }
+        } else if (isCombiningMark(cp)) {
+            word = inWord;          // decomposed diacritic: belongs to the word, adds nothing
+        } else if (!isSeparator(cp)) {
+            if (!inWord) { inWord = true; current.begin = i; }
+            auto it = table.find(cp);
+            if (it != table.end()) current.term += it->second;
+            else current.term.append(text.data() + i, len);
+            word = true;
+        }
+
+        if (!word) finish(i);
+        i += len;
+    }
+    finish(text.size());
+    return tokens;
+}
+
+std::string foldTerm(const std::string& word) {
+    std::vector<Token> tokens = tokenize(word);
+    return tokens.empty() ? std::string() : tokens.front().term;
+}
+
+Snippet makeSnippet(const std::string& text, const std::vector<std::string>& terms,
+                    bool prefixLast, size_t radius) {
+    Snippet snippet;
+    std::vector<Token> tokens = tokenize(text);
+    if (tokens.empty()) {
+        snippet.text = text;
+        return snippet;
+    }
+
+    size_t first = 0;
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        if (matches(tokens[i].term, terms, prefixLast)) { first = i; break; }
+    }
+
+    size_t lo = first > radius ? first - radius : 0;
+    size_t hi = first + radius < tokens.size() ? first + radius : tokens.size() - 1;
+    size_t begin = lo == 0 ? 0 : tokens[lo].begin;
+    size_t end = hi + 1 == tokens.size() ? text.size() : tokens[hi].end;
+
+    if (begin > 0) snippet.text = "...";
+    size_t offset = snippet.text.size();
+    snippet.text.append(text, begin, end - begin);
+    if (end < text.size()) snippet.text += "...";
+
+    for (size_t i = lo; i <= hi; ++i) {
+        if (matches(tokens[i].term, terms, prefixLast)) {
+            snippet.highlights.emplace_back(tokens[i].begin - begin + offset,
+                                            tokens[i].end - tokens[i].begin);
+        }
+    }
+    return snippet;
+}
+
+} // namespace search
+} // namespace english_learning
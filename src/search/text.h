@@ -0,0 +1,57 @@
+#ifndef ENGLISH_LEARNING_SEARCH_TEXT_H
+#define ENGLISH_LEARNING_SEARCH_TEXT_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace english_learning {
+namespace search {
+
+/**
+ * A search term and where it came from in the original UTF-8 text.
+ */
+struct Token {
+    std::string term;   // folded: lowercase ASCII, Vietnamese diacritics removed
+    size_t begin;       // byte range in the source text
+    size_t end;
+};
+
+/**
+ * Split UTF-8 text into search terms.
+ * Letters and digits form words; everything else separates them. ASCII is
+ * lowercased and Vietnamese letters are folded to their base letter
+ * ("Đường" -> "duong"), including decomposed combining marks, so queries
+ * match with or without diacritics. Other non-ASCII letters are kept as-is.
+ * Words longer than MAX_TERM_BYTES are skipped.
+ */
+std::vector<Token> tokenize(std::string_view text);
+
+// Fold a single query word the same way tokenize() folds text
+std::string foldTerm(const std::string& word);
+
+constexpr size_t MAX_TERM_BYTES = 64;
+
+/**
+ * A short excerpt of a text around its first matching term.
+ */
+struct Snippet {
+    std::string text;                                  // may start/end with "..."
+    std::vector<std::pair<size_t, size_t>> highlights; // (byte offset, length) in text
+};
+
+/**
+ * Cut a snippet of about `radius` words either side of the first token that
+ * matches one of `terms` (or starts with the last term when prefixLast is
+ * set). Every match inside the window is highlighted. Falls back to the
+ * start of the text when nothing matches.
+ */
+Snippet makeSnippet(const std::string& text, const std::vector<std::string>& terms,
+                    bool prefixLast, size_t radius);
+
+} // namespace search
+} // namespace english_learning
+
+#endif // ENGLISH_LEARNING_SEARCH_TEXT_H
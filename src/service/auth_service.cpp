@@ -40,8 +40,8 @@ ServiceResult<RegisterResult> AuthService::registerUser(
     user.fullname = fullname;
     user.email = email;
     user.password = password;  // TODO: Hash password in production
-    user.role = role.empty() ? "student" : role;
-    user.level = "beginner";
+    user.role = core::stringToRole(role);
+    user.level = core::Level::Beginner;
     user.createdAt = protocol::utils::getCurrentTimestamp();
     user.online = false;
     user.clientSocket = -1;
@@ -103,8 +103,8 @@ ServiceResult<LoginResult> AuthService::login(
     result.userId = user.userId;
     result.fullname = user.fullname;
     result.email = user.email;
-    result.level = user.level;
-    result.role = user.role;
+    result.level = core::levelToString(user.level);
+    result.role = core::roleToString(user.role);
     result.expiresAt = session.expiresAt;
     result.unreadMessages = unreadCount;
 
@@ -151,7 +151,12 @@ VoidResult AuthService::setUserLevel(const std::string& userId, const std::strin
         return VoidResult::error("User not found");
     }
 
-    if (!userRepo_.updateLevel(userId, level)) {
+    core::Level parsed;
+    if (!core::parseLevel(level, parsed)) {
+        return VoidResult::error("Invalid level");
+    }
+
+    if (!userRepo_.updateLevel(userId, parsed)) {
         return VoidResult::error("Failed to update user level");
     }
 
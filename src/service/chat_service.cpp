@@ -50,13 +50,16 @@ ServiceResult<core::ChatMessage> ChatService::sendMessage(
 ServiceResult<ChatHistoryResult> ChatService::getChatHistory(
     const std::string& userId1,
     const std::string& userId2,
-    size_t limit) {
-
-    auto messages = chatRepo_.findConversation(userId1, userId2);
-
-    // Apply limit if specified
-    if (limit > 0 && messages.size() > limit) {
-        messages.resize(limit);
+    size_t limit,
+    const std::string& beforeMessageId,
+    core::Timestamp beforeTimestamp) {
+
+    // Fetch one extra message to learn whether an older page exists
+    auto messages = chatRepo_.findConversationPage(userId1, userId2, beforeMessageId,
+                                                   beforeTimestamp, limit > 0 ? limit + 1 : 0);
+    bool hasMore = limit > 0 && messages.size() > limit;
+    if (hasMore) {
+        messages.erase(messages.begin());
     }
 
     // Count unread for userId1
@@ -71,6 +74,10 @@ ServiceResult<ChatHistoryResult> ChatService::getChatHistory(
     result.messages = messages;
     result.total = messages.size();
     result.unreadCount = unreadCount;
+    result.hasMore = hasMore;
+    if (hasMore) {
+        result.nextCursor = messages.front().messageId;
+    }
 
     return ServiceResult<ChatHistoryResult>::success(result);
 }
@@ -114,7 +121,7 @@ ServiceResult<OnlineUsersResult> ChatService::getOnlineUsers(
             info.userId = user.userId;
             info.fullname = user.fullname;
             info.email = user.email;
-            info.role = user.role;
+            info.role = core::roleToString(user.role);
             result.users.push_back(info);
         }
     }
@@ -27,7 +27,9 @@ public:
     ServiceResult<ChatHistoryResult> getChatHistory(
         const std::string& userId1,
         const std::string& userId2,
-        size_t limit = 50) override;
+        size_t limit = 50,
+        const std::string& beforeMessageId = "",
+        core::Timestamp beforeTimestamp = 0) override;
 
     ServiceResult<ChatHistoryResult> getMessagesForUser(
         const std::string& userId) override;
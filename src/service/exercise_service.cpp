@@ -15,18 +15,25 @@ ServiceResult<ExerciseListResult> ExerciseService::getExercises(
     const std::string& type) {
 
     std::vector<core::Exercise> exercises;
-
-    if (level.empty() && type.empty()) {
+    core::Level lvl;
+    core::ExerciseType exType;
+    bool levelKnown = core::parseLevel(level, lvl);
+    bool typeKnown = core::parseExerciseType(type, exType);
+
+    // An unrecognized filter value matches no exercises
+    if ((!level.empty() && !levelKnown) || (!type.empty() && !typeKnown)) {
+        // leave exercises empty
+    } else if (level.empty() && type.empty()) {
         exercises = exerciseRepo_.findAllExercises();
     } else if (!level.empty() && type.empty()) {
-        exercises = exerciseRepo_.findExercisesByLevel(level);
+        exercises = exerciseRepo_.findExercisesByLevel(lvl);
     } else if (level.empty() && !type.empty()) {
-        exercises = exerciseRepo_.findExercisesByType(type);
+        exercises = exerciseRepo_.findExercisesByType(exType);
     } else {
         // Filter by both level and type
-        auto byLevel = exerciseRepo_.findExercisesByLevel(level);
+        auto byLevel = exerciseRepo_.findExercisesByLevel(lvl);
         for (const auto& ex : byLevel) {
-            if (ex.exerciseType == type) {
+            if (ex.exerciseType == exType) {
                 exercises.push_back(ex);
             }
         }
@@ -106,7 +113,7 @@ ServiceResult<core::ExerciseSubmission> ExerciseService::saveDraft(
     submission.exerciseType = exercise.exerciseType;
     submission.content = content;
     submission.audioUrl = audioUrl;
-    submission.status = core::SubmissionStatusStr::DRAFT;
+    submission.status = core::SubmissionStatus::Draft;
     submission.createdAt = now;
     submission.submittedAt = 0;
     submission.teacherScore = 0;
@@ -155,7 +162,7 @@ ServiceResult<core::ExerciseSubmission> ExerciseService::submitExercise(
     submission.exerciseType = exercise.exerciseType;
     submission.content = content;
     submission.audioUrl = audioUrl;
-    submission.status = core::SubmissionStatusStr::PENDING_REVIEW;
+    submission.status = core::SubmissionStatus::Pending;
     submission.createdAt = now;
     submission.submittedAt = now;
     submission.teacherScore = 0;
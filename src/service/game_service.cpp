@@ -14,10 +14,11 @@ GameService::GameService(
 ServiceResult<GameListResult> GameService::getGames(const std::string& level) {
     std::vector<core::Game> games;
 
+    core::Level lvl;
     if (level.empty()) {
         games = gameRepo_.findAllGames();
-    } else {
-        games = gameRepo_.findGamesByLevel(level);
+    } else if (core::parseLevel(level, lvl)) {
+        games = gameRepo_.findGamesByLevel(lvl);
     }
 
     GameListResult result;
@@ -64,7 +65,7 @@ ServiceResult<GameStartResult> GameService::startGame(
     GameStartResult result;
     result.sessionId = session.sessionId;
     result.gameId = gameId;
-    result.gameType = game.gameType;
+    result.gameType = core::gameTypeToString(game.gameType);
     result.pairs = game.getActivePairs();
     result.timeLimit = game.timeLimit;
     result.maxScore = game.maxScore;
@@ -15,15 +15,22 @@ ServiceResult<LessonListResult> LessonService::getLessons(
     const std::string& topic) {
 
     std::vector<core::Lesson> lessons;
-
-    if (level.empty() && topic.empty()) {
+    core::Level lvl;
+    core::Topic top;
+    bool levelKnown = core::parseLevel(level, lvl);
+    bool topicKnown = core::parseTopic(topic, top);
+
+    // An unrecognized filter value matches no lessons
+    if ((!level.empty() && !levelKnown) || (!topic.empty() && !topicKnown)) {
+        // leave lessons empty
+    } else if (level.empty() && topic.empty()) {
         lessons = lessonRepo_.findAll();
     } else if (!level.empty() && topic.empty()) {
-        lessons = lessonRepo_.findByLevel(level);
+        lessons = lessonRepo_.findByLevel(lvl);
     } else if (level.empty() && !topic.empty()) {
-        lessons = lessonRepo_.findByTopic(topic);
+        lessons = lessonRepo_.findByTopic(top);
     } else {
-        lessons = lessonRepo_.findByLevelAndTopic(level, topic);
+        lessons = lessonRepo_.findByLevelAndTopic(lvl, top);
     }
 
     LessonListResult result;
@@ -63,12 +70,16 @@ ServiceResult<core::Lesson> LessonService::createLesson(
     }
 
     core::Lesson lesson;
+    if (!core::parseLevel(level, lesson.level)) {
+        return ServiceResult<core::Lesson>::error("Invalid level");
+    }
+    if (!core::parseTopic(topic, lesson.topic)) {
+        return ServiceResult<core::Lesson>::error("Invalid topic");
+    }
     lesson.lessonId = protocol::utils::generateId("lesson");
     lesson.title = title;
     lesson.description = description;
     lesson.textContent = textContent;
-    lesson.level = level;
-    lesson.topic = topic;
     lesson.duration = duration;
     lesson.videoUrl = videoUrl;
     lesson.audioUrl = audioUrl;
@@ -103,11 +114,15 @@ ServiceResult<core::Lesson> LessonService::updateLesson(
     }
 
     core::Lesson lesson = lessonOpt.value();
+    if (!core::parseLevel(level, lesson.level)) {
+        return ServiceResult<core::Lesson>::error("Invalid level");
+    }
+    if (!core::parseTopic(topic, lesson.topic)) {
+        return ServiceResult<core::Lesson>::error("Invalid topic");
+    }
     lesson.title = title;
     lesson.description = description;
     lesson.textContent = textContent;
-    lesson.level = level;
-    lesson.topic = topic;
     lesson.duration = duration;
     lesson.videoUrl = videoUrl;
     lesson.audioUrl = audioUrl;
@@ -138,7 +153,8 @@ VoidResult LessonService::deleteLesson(
 ServiceResult<size_t> LessonService::getLessonCountByLevel(
     const std::string& level) {
 
-    size_t count = lessonRepo_.countByLevel(level);
+    core::Level lvl;
+    size_t count = core::parseLevel(level, lvl) ? lessonRepo_.countByLevel(lvl) : 0;
     return ServiceResult<size_t>::success(count);
 }
 
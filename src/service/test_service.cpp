@@ -13,10 +13,11 @@ TestService::TestService(
 ServiceResult<TestListResult> TestService::getTests(const std::string& level) {
     std::vector<core::Test> tests;
 
+    core::Level lvl;
     if (level.empty()) {
         tests = testRepo_.findAll();
-    } else {
-        tests = testRepo_.findByLevel(level);
+    } else if (core::parseLevel(level, lvl)) {
+        tests = testRepo_.findByLevel(lvl);
     }
 
     TestListResult result;
@@ -55,11 +56,15 @@ ServiceResult<core::Test> TestService::createTest(
     }
 
     core::Test test;
+    if (!core::parseLevel(level, test.level)) {
+        return ServiceResult<core::Test>::error("Invalid level");
+    }
+    if (!core::parseTopic(topic, test.topic)) {
+        return ServiceResult<core::Test>::error("Invalid topic");
+    }
     test.testId = protocol::utils::generateId("test");
     test.title = title;
     test.testType = testType;
-    test.level = level;
-    test.topic = topic;
     test.questions = questions;
 
     if (!testRepo_.add(test)) {
@@ -137,10 +142,14 @@ ServiceResult<core::Test> TestService::updateTest(
     }
 
     core::Test test = testOpt.value();
+    if (!core::parseLevel(level, test.level)) {
+        return ServiceResult<core::Test>::error("Invalid level");
+    }
+    if (!core::parseTopic(topic, test.topic)) {
+        return ServiceResult<core::Test>::error("Invalid topic");
+    }
     test.title = title;
     test.testType = testType;
-    test.level = level;
-    test.topic = topic;
     test.questions = questions;
 
     if (!testRepo_.update(test)) {
@@ -0,0 +1,266 @@
+#include "attachment_store.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <random>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <openssl/evp.h>
+#include "codec.h"
+
+namespace english_learning {
+namespace storage {
+
+struct AttachmentStore::Upload {
+    std::mutex mutex;
+    std::string ownerId;
+    std::string attachmentId;
+    std::string path;
+    uint64_t size = 0;
+    uint64_t received = 0;
+    int fd = -1;
+    EVP_MD_CTX* hash = nullptr;
+    std::chrono::steady_clock::time_point touched;
+    bool closed = false;   // finished, failed or expired: no more writes
+
+    ~Upload() {
+        if (fd >= 0) ::close(fd);
+        if (hash) EVP_MD_CTX_free(hash);
+    }
+};
+
+namespace {
+
+std::string toHex(const unsigned char* data, size_t size) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(size * 2);
+    for (size_t i = 0; i < size; ++i) {
+        hex += digits[data[i] >> 4];
+        hex += digits[data[i] & 15];
+    }
+    return hex;
+}
+
+std::string randomId() {
+    static std::mt19937_64 gen{std::random_device{}()};
+    unsigned char bytes[16];
+    for (size_t i = 0; i < sizeof(bytes); i += 8) {
+        uint64_t v = gen();
+        for (size_t k = 0; k < 8; ++k) bytes[i + k] = static_cast<unsigned char>(v >> (8 * k));
+    }
+    return toHex(bytes, sizeof(bytes));
+}
+
+bool writeAt(int fd, uint64_t offset, const std::string& data) {
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t n = ::pwrite(fd, data.data() + done, data.size() - done, static_cast<off_t>(offset + done));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+AttachmentStore::AttachmentStore(std::string directory, uint64_t maxBytes, std::chrono::seconds idleTimeout)
+    : directory_(std::move(directory)), maxBytes_(maxBytes), idleTimeout_(idleTimeout) {}
+
+AttachmentStore::~AttachmentStore() = default;
+
+void AttachmentStore::open() {
+    makeDirectories(directory_ + "/objects");
+    makeDirectories(directory_ + "/uploads");
+
+    // Staging files of a previous run cannot be resumed: their hash state is gone
+    std::string uploads = directory_ + "/uploads";
+    if (DIR* dir = ::opendir(uploads.c_str())) {
+        while (dirent* entry = ::readdir(dir)) {
+            if (entry->d_name[0] != '.') ::unlink((uploads + "/" + entry->d_name).c_str());
+        }
+        ::closedir(dir);
+    }
+}
+
+bool AttachmentStore::isValidId(const std::string& attachmentId) {
+    if (attachmentId.size() != 64) return false;
+    for (char c : attachmentId) {
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) return false;
+    }
+    return true;
+}
+
+std::string AttachmentStore::objectPath(const std::string& attachmentId) const {
+    return directory_ + "/objects/" + attachmentId.substr(0, 2) + "/" + attachmentId.substr(2);
+}
+
+std::optional<uint64_t> AttachmentStore::size(const std::string& attachmentId) const {
+    if (!isValidId(attachmentId)) return std::nullopt;
+    struct stat st;
+    if (::stat(objectPath(attachmentId).c_str(), &st) != 0) return std::nullopt;
+    return static_cast<uint64_t>(st.st_size);
+}
+
+void AttachmentStore::expireLocked(std::chrono::steady_clock::time_point now) {
+    for (auto it = uploads_.begin(); it != uploads_.end();) {
+        Upload& upload = *it->second;
+        // A locked upload is being written to right now, so it is not idle
+        std::unique_lock<std::mutex> lock(upload.mutex, std::try_to_lock);
+        if (lock.owns_lock() && now - upload.touched > idleTimeout_) {
+            upload.closed = true;
+            ::unlink(upload.path.c_str());
+            it = uploads_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+AttachmentStore::Progress AttachmentStore::begin(const std::string& ownerId, const std::string& attachmentId,
+                                                 uint64_t size) {
+    if (!isValidId(attachmentId)) return {Status::NotFound, "", 0};
+    if (size > maxBytes_) return {Status::TooLarge, "", 0};
+    if (this->size(attachmentId)) return {Status::Complete, "", size};
+
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    expireLocked(now);
+
+    size_t pending = 0;
+    for (const auto& pair : uploads_) {
+        Upload& upload = *pair.second;
+        if (upload.ownerId != ownerId) continue;
+        if (upload.attachmentId == attachmentId && upload.size == size) {
+            std::lock_guard<std::mutex> uploadLock(upload.mutex);
+            upload.touched = now;
+            return {Status::Ok, pair.first, upload.received};
+        }
+        pending++;
+    }
+    if (pending >= MAX_UPLOADS_PER_OWNER) return {Status::Busy, "", 0};
+
+    auto upload = std::make_shared<Upload>();
+    std::string uploadId = randomId();
+    upload->ownerId = ownerId;
+    upload->attachmentId = attachmentId;
+    upload->path = directory_ + "/uploads/" + uploadId + ".part";
+    upload->size = size;
+    upload->touched = now;
+    upload->fd = ::open(upload->path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    upload->hash = EVP_MD_CTX_new();
+    if (upload->fd < 0 || !upload->hash || EVP_DigestInit_ex(upload->hash, EVP_sha256(), nullptr) != 1) {
+        if (upload->fd >= 0) ::unlink(upload->path.c_str());
+        return {Status::IoError, "", 0};
+    }
+    uploads_[uploadId] = upload;
+    return {Status::Ok, uploadId, 0};
+}
+
+AttachmentStore::Progress AttachmentStore::write(const std::string& ownerId, const std::string& uploadId,
+                                                 uint64_t offset, const std::string& bytes) {
+    std::shared_ptr<Upload> upload;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = uploads_.find(uploadId);
+        if (it == uploads_.end() || it->second->ownerId != ownerId) return {Status::NotFound, "", 0};
+        upload = it->second;
+    }
+
+    Progress progress{Status::Ok, uploadId, 0};
+    {
+        std::lock_guard<std::mutex> lock(upload->mutex);
+        if (upload->closed) return {Status::NotFound, "", 0};
+        upload->touched = std::chrono::steady_clock::now();
+        progress.received = upload->received;
+
+        if (offset != upload->received) {
+            progress.status = Status::BadOffset;
+            return progress;
+        }
+        if (bytes.size() > upload->size - upload->received) {
+            progress.status = Status::TooLarge;
+            return progress;
+        }
+        if (!writeAt(upload->fd, offset, bytes) ||
+            EVP_DigestUpdate(upload->hash, bytes.data(), bytes.size()) != 1) {
+            // Nothing past received is trusted, so the client may simply retry
+            progress.status = Status::IoError;
+            return progress;
+        }
+        upload->received += bytes.size();
+        progress.received = upload->received;
+        if (upload->received < upload->size) return progress;
+
+        progress.status = finish(*upload);
+        progress.uploadId.clear();
+        upload->closed = true;
+    }
+
+    // Taken after the upload's lock is released: begin() and expireLocked()
+    // lock mutex_ first
+    std::lock_guard<std::mutex> lock(mutex_);
+    uploads_.erase(uploadId);
+    return progress;
+}
+
+AttachmentStore::Status AttachmentStore::finish(Upload& upload) {
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int length = 0;
+    bool hashed = EVP_DigestFinal_ex(upload.hash, digest, &length) == 1;
+    if (!hashed || toHex(digest, length) != upload.attachmentId) {
+        ::unlink(upload.path.c_str());
+        return Status::HashMismatch;
+    }
+
+    bool ok = ::fdatasync(upload.fd) == 0;
+    ::close(upload.fd);
+    upload.fd = -1;
+
+    // Identical content finishing twice just replaces the object with itself
+    std::string target = objectPath(upload.attachmentId);
+    std::string shard = target.substr(0, target.rfind('/'));
+    makeDirectories(shard);
+    if (!ok || ::rename(upload.path.c_str(), target.c_str()) != 0) {
+        ::unlink(upload.path.c_str());
+        return Status::IoError;
+    }
+    syncDirectory(shard);
+    return Status::Complete;
+}
+
+bool AttachmentStore::read(const std::string& attachmentId, uint64_t offset, size_t length,
+                           std::string& out) const {
+    out.clear();
+    if (!isValidId(attachmentId)) return false;
+    int fd = ::open(objectPath(attachmentId).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    struct stat st;
+    bool ok = ::fstat(fd, &st) == 0;
+    uint64_t size = ok ? static_cast<uint64_t>(st.st_size) : 0;
+    if (ok && offset < size) {
+        out.resize(static_cast<size_t>(std::min<uint64_t>(length, size - offset)));
+        size_t done = 0;
+        while (done < out.size()) {
+            ssize_t n = ::pread(fd, &out[done], out.size() - done, static_cast<off_t>(offset + done));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                ok = false;
+                break;
+            }
+            done += static_cast<size_t>(n);
+        }
+    }
+    ::close(fd);
+    return ok;
+}
+
+} // namespace storage
+} // namespace english_learning
@@ -0,0 +1,103 @@
+#ifndef ENGLISH_LEARNING_STORAGE_ATTACHMENT_STORE_H
+#define ENGLISH_LEARNING_STORAGE_ATTACHMENT_STORE_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace english_learning {
+namespace storage {
+
+/**
+ * Content-addressed store for chat attachments.
+ *
+ * A file is stored once, as objects/ab/cdef... where abcdef... is the hex
+ * SHA-256 of its bytes; that hash is the attachment id. An upload declares
+ * the hash and size up front, so content that is already stored completes
+ * immediately without any bytes being sent. Otherwise the bytes arrive as
+ * chunks in order, are staged under uploads/ and hashed as they come in;
+ * the last chunk verifies the hash, fsyncs and renames the file into place.
+ *
+ * Uploads are keyed by a random id and owned by the user that began them.
+ * Beginning the same content again resumes the owner's pending upload.
+ * Uploads idle for longer than the timeout are dropped. Thread-safe; a
+ * chunk locks only its own upload while it is written.
+ */
+class AttachmentStore {
+public:
+    static constexpr size_t MAX_UPLOADS_PER_OWNER = 4;
+
+    enum class Status {
+        Ok,             // chunk staged, more expected
+        Complete,       // content stored under its attachment id
+        NotFound,       // no such upload (finished, expired or another owner's)
+        BadOffset,      // chunk does not start where the upload left off
+        TooLarge,       // beyond the declared or maximum size
+        HashMismatch,   // bytes did not hash to the declared id; upload dropped
+        Busy,           // owner has too many uploads in progress
+        IoError
+    };
+
+    struct Progress {
+        Status status;
+        std::string uploadId;   // empty once Complete
+        uint64_t received;      // bytes staged so far; the next chunk's offset
+    };
+
+    AttachmentStore(std::string directory, uint64_t maxBytes, std::chrono::seconds idleTimeout);
+    ~AttachmentStore();
+
+    AttachmentStore(const AttachmentStore&) = delete;
+    AttachmentStore& operator=(const AttachmentStore&) = delete;
+
+    // Create the directories and discard staging files of a previous run
+    void open();
+
+    // Lowercase 64-digit hex, i.e. something that can name an object
+    static bool isValidId(const std::string& attachmentId);
+
+    // Size of a stored attachment, or nullopt if it is not stored
+    std::optional<uint64_t> size(const std::string& attachmentId) const;
+
+    /**
+     * Start (or resume) uploading size bytes whose SHA-256 is attachmentId.
+     * Complete when the content is already stored; otherwise Ok with the
+     * upload id and the offset to continue from.
+     */
+    Progress begin(const std::string& ownerId, const std::string& attachmentId, uint64_t size);
+
+    // Append the bytes at offset, which must equal the bytes received so far
+    Progress write(const std::string& ownerId, const std::string& uploadId, uint64_t offset,
+                   const std::string& bytes);
+
+    // Up to length bytes of a stored attachment from offset; false if not stored
+    bool read(const std::string& attachmentId, uint64_t offset, size_t length, std::string& out) const;
+
+private:
+    struct Upload;
+
+    std::string objectPath(const std::string& attachmentId) const;
+
+    // Drop uploads idle past the timeout; caller holds mutex_
+    void expireLocked(std::chrono::steady_clock::time_point now);
+
+    // Verify and move a fully received upload into objects/
+    Status finish(Upload& upload);
+
+    std::string directory_;
+    uint64_t maxBytes_;
+    std::chrono::seconds idleTimeout_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<Upload>> uploads_;   // uploadId -> upload
+};
+
+} // namespace storage
+} // namespace english_learning
+
+#endif // ENGLISH_LEARNING_STORAGE_ATTACHMENT_STORE_H
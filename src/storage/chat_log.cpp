@@ -0,0 +1,533 @@
+#include "chat_log.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "codec.h"
+
+namespace english_learning {
+namespace storage {
+
+using repository::memory::ChannelStore;
+using repository::memory::ChatStore;
+
+namespace {
+
+constexpr size_t HEADER_BYTES = 8;              // payload length + CRC
+constexpr size_t COMPACT_MIN_OBSOLETE = 1024;   // don't bother below this
+constexpr size_t LOST_RANGES = 64;              // failed batches remembered for waitDurable()
+
+// Number of the last record this thread queued, and to which log
+thread_local std::pair<const void*, uint64_t> lastQueued{nullptr, 0};
+
+std::string encodeAppend(const core::ChatMessage& m) {
+    std::string payload(1, static_cast<char>(1));  // APPEND
+    putMessage(payload, m);
+    return payload;
+}
+
+std::string encodeChannelMessage(const core::ChatMessage& m, uint64_t seq) {
+    std::string payload(1, static_cast<char>(7));  // CHANNEL_MESSAGE
+    putU64(payload, seq);
+    putMessage(payload, m);
+    return payload;
+}
+
+std::string frame(const std::string& payload) {
+    std::string rec;
+    rec.reserve(HEADER_BYTES + payload.size());
+    putU32(rec, static_cast<uint32_t>(payload.size()));
+    putU32(rec, crc32(reinterpret_cast<const uint8_t*>(payload.data()), payload.size()));
+    rec += payload;
+    return rec;
+}
+
+// Walk the valid records of a mapped segment; returns the offset where the
+// valid prefix ends (== size for an intact segment)
+template <typename Fn>
+size_t scanRecords(const uint8_t* data, size_t size, Fn&& fn) {
+    size_t offset = 0;
+    while (offset + HEADER_BYTES <= size) {
+        uint32_t length = readU32(data + offset);
+        uint32_t crc = readU32(data + offset + 4);
+        if (length == 0 || length > size - offset - HEADER_BYTES) break;
+        const uint8_t* payload = data + offset + HEADER_BYTES;
+        if (crc32(payload, length) != crc) break;
+        fn(payload, static_cast<size_t>(length));
+        offset += HEADER_BYTES + length;
+    }
+    return offset;
+}
+
+// Map a segment read-only and scan it; returns the valid prefix length
+template <typename Fn>
+size_t mapAndScan(int fd, size_t size, Fn&& fn) {
+    if (size == 0) return 0;
+    void* map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) return 0;
+    size_t valid = scanRecords(static_cast<const uint8_t*>(map), size, fn);
+    ::munmap(map, size);
+    return valid;
+}
+
+} // namespace
+
+ChatLog::ChatLog(std::string directory, std::chrono::milliseconds commitInterval)
+    : directory_(std::move(directory)), commitInterval_(commitInterval) {}
+
+ChatLog::~ChatLog() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    flushCv_.notify_all();
+    if (flusher_.joinable()) flusher_.join();
+}
+
+std::string ChatLog::segmentPath(uint32_t number) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "chat-%08u.log", number);
+    return directory_ + "/" + name;
+}
+
+std::vector<uint32_t> ChatLog::listSegments() const {
+    std::vector<uint32_t> numbers;
+    DIR* dir = ::opendir(directory_.c_str());
+    if (!dir) return numbers;
+    while (dirent* entry = ::readdir(dir)) {
+        unsigned number = 0;
+        char tail = 0;
+        if (std::sscanf(entry->d_name, "chat-%8u.lo%c", &number, &tail) == 2 && tail == 'g' &&
+            std::strlen(entry->d_name) == 17 && number > 0) {
+            numbers.push_back(number);
+        }
+    }
+    ::closedir(dir);
+    std::sort(numbers.begin(), numbers.end());
+    return numbers;
+}
+
+size_t ChatLog::open(ChatStore& store, ChannelStore& channels) {
+    makeDirectories(directory_);
+
+    size_t applied = 0;
+    std::vector<uint32_t> segments = listSegments();
+    for (size_t i = 0; i < segments.size(); ++i) {
+        std::string path = segmentPath(segments[i]);
+        int fd = ::open(path.c_str(), O_RDWR);
+        if (fd < 0) continue;
+        struct stat st;
+        size_t size = ::fstat(fd, &st) == 0 ? static_cast<size_t>(st.st_size) : 0;
+
+        size_t valid = mapAndScan(fd, size, [&](const uint8_t* payload, size_t length) {
+            Reader in{payload, length};
+            uint8_t type = in.u8();
+            switch (type) {
+                case APPEND: {
+                    core::ChatMessage m = in.message();
+                    if (in.ok) store.append(m);
+                    break;
+                }
+                case READ: {
+                    std::string id = in.str();
+                    if (in.ok) store.markAsRead(id);
+                    obsoleteRecords_++;
+                    break;
+                }
+                case CONVERSATION_READ: {
+                    std::string recipient = in.str();
+                    std::string sender = in.str();
+                    if (in.ok) store.markConversationAsRead(recipient, sender);
+                    obsoleteRecords_++;
+                    break;
+                }
+                case REMOVE: {
+                    std::string id = in.str();
+                    if (in.ok) store.remove(id);
+                    obsoleteRecords_ += 2;
+                    break;
+                }
+                case CHANNEL: {
+                    core::Channel channel;
+                    channel.channelId = in.str();
+                    channel.name = in.str();
+                    channel.kind = static_cast<core::ChannelKind>(in.u8());
+                    channel.level = static_cast<core::Level>(in.u8());
+                    channel.ownerId = in.str();
+                    channel.createdAt = static_cast<core::Timestamp>(in.u64());
+                    if (in.ok) channels.create(channel);
+                    break;
+                }
+                case MEMBER: {
+                    std::string channelId = in.str();
+                    std::string userId = in.str();
+                    bool joined = in.u8() != 0;
+                    if (!in.ok) break;
+                    if (joined) {
+                        channels.addMember(channelId, userId);
+                    } else {
+                        channels.removeMember(channelId, userId);
+                    }
+                    break;
+                }
+                case CHANNEL_MESSAGE: {
+                    uint64_t seq = in.u64();
+                    core::ChatMessage m = in.message();
+                    if (in.ok) channels.restore(m, seq);
+                    break;
+                }
+                case CHANNEL_REMOVE: {
+                    std::string channelId = in.str();
+                    std::string id = in.str();
+                    if (in.ok) channels.remove(channelId, id);
+                    obsoleteRecords_ += 2;
+                    break;
+                }
+                case SEEN: {
+                    std::string channelId = in.str();
+                    std::string userId = in.str();
+                    uint64_t seen = in.u64();
+                    if (in.ok) channels.restoreSeen(channelId, userId, seen);
+                    obsoleteRecords_++;
+                    break;
+                }
+                default:
+                    break;
+            }
+            totalRecords_++;
+            applied++;
+        });
+
+        bool last = i + 1 == segments.size();
+        if (valid < size) {
+            if (last) {
+                // Torn tail from a crash mid-write: drop it so appends resume cleanly
+                std::cerr << "[WARN] Chat log: discarding " << (size - valid)
+                          << " bytes of incomplete records in " << path << std::endl;
+                if (::ftruncate(fd, static_cast<off_t>(valid)) != 0) {
+                    std::cerr << "[WARN] Chat log: cannot truncate " << path << std::endl;
+                }
+            } else {
+                std::cerr << "[WARN] Chat log: corrupt record in " << path << " at offset "
+                          << valid << "; skipping the rest of this segment" << std::endl;
+            }
+        }
+        if (last) {
+            activeSegment_ = segments[i];
+            activeBytes_ = valid;
+        }
+        ::close(fd);
+    }
+
+    flusher_ = std::thread(&ChatLog::flusherLoop, this);
+    return applied;
+}
+
+void ChatLog::recordAppend(const core::ChatMessage& message) {
+    enqueue(encodeAppend(message), false);
+}
+
+void ChatLog::recordRead(const std::string& messageId) {
+    std::string payload(1, static_cast<char>(READ));
+    putString(payload, messageId);
+    enqueue(payload, true);
+}
+
+void ChatLog::recordConversationRead(const std::string& recipientId, const std::string& senderId) {
+    std::string payload(1, static_cast<char>(CONVERSATION_READ));
+    putString(payload, recipientId);
+    putString(payload, senderId);
+    enqueue(payload, true);
+}
+
+void ChatLog::recordRemove(const std::string& messageId) {
+    std::string payload(1, static_cast<char>(REMOVE));
+    putString(payload, messageId);
+    enqueue(payload, true);
+}
+
+void ChatLog::recordChannel(const core::Channel& channel) {
+    std::string payload(1, static_cast<char>(CHANNEL));
+    putString(payload, channel.channelId);
+    putString(payload, channel.name);
+    payload += static_cast<char>(channel.kind);
+    payload += static_cast<char>(channel.level);
+    putString(payload, channel.ownerId);
+    putU64(payload, static_cast<uint64_t>(channel.createdAt));
+    enqueue(payload, false);
+}
+
+void ChatLog::recordMember(const std::string& channelId, const std::string& userId, bool joined) {
+    std::string payload(1, static_cast<char>(MEMBER));
+    putString(payload, channelId);
+    putString(payload, userId);
+    payload += static_cast<char>(joined ? 1 : 0);
+    enqueue(payload, false);
+}
+
+void ChatLog::recordChannelMessage(const core::ChatMessage& message, uint64_t seq) {
+    enqueue(encodeChannelMessage(message, seq), false);
+}
+
+void ChatLog::recordChannelRemove(const std::string& channelId, const std::string& messageId) {
+    std::string payload(1, static_cast<char>(CHANNEL_REMOVE));
+    putString(payload, channelId);
+    putString(payload, messageId);
+    enqueue(payload, true);
+}
+
+void ChatLog::recordSeen(const std::string& channelId, const std::string& userId, uint64_t seen) {
+    std::string payload(1, static_cast<char>(SEEN));
+    putString(payload, channelId);
+    putString(payload, userId);
+    putU64(payload, seen);
+    enqueue(payload, true);
+}
+
+void ChatLog::enqueue(const std::string& payload, bool obsoletes) {
+    std::string rec = frame(payload);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (activeBytes_ > 0 && activeBytes_ + rec.size() > SEGMENT_BYTES) {
+            activeSegment_++;
+            activeBytes_ = 0;
+        }
+        if (pending_.empty() || pending_.back().first != activeSegment_) {
+            pending_.emplace_back(activeSegment_, std::string());
+        }
+        pending_.back().second += rec;
+        activeBytes_ += rec.size();
+        queuedSeq_++;
+        lastQueued = {this, queuedSeq_};
+        totalRecords_++;
+        if (obsoletes) obsoleteRecords_ += (payload[0] == REMOVE || payload[0] == CHANNEL_REMOVE) ? 2 : 1;
+    }
+    flushCv_.notify_one();
+}
+
+bool ChatLog::waitDurable() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!flusher_.joinable()) return false;
+    uint64_t target = queuedSeq_;
+    durableCv_.wait(lock, [&] { return durableSeq_ >= target || stop_; });
+    uint64_t mine = lastQueued.first == this ? lastQueued.second : 0;
+    return durableSeq_ >= target && (mine == 0 || !lost(mine));
+}
+
+bool ChatLog::lost(uint64_t seq) const {
+    for (const auto& range : lost_) {
+        if (seq >= range.first && seq <= range.second) return true;
+    }
+    return false;
+}
+
+void ChatLog::flusherLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        flushCv_.wait(lock, [this] { return stop_ || !pending_.empty(); });
+        if (pending_.empty()) break;  // stopping with nothing left to write
+
+        // Let concurrent senders join the batch, but hold the first one at
+        // most one commit interval
+        if (!stop_) flushCv_.wait_for(lock, commitInterval_, [this] { return stop_; });
+
+        std::vector<std::pair<uint32_t, std::string>> batch;
+        batch.swap(pending_);
+        uint64_t first = durableSeq_ + 1;
+        uint64_t seq = queuedSeq_;
+
+        lock.unlock();
+        bool ok = writeBatch(batch);
+        int error = errno;
+        lock.lock();
+
+        if (!ok) {
+            std::cerr << "[ERROR] Chat log: write to " << directory_ << " failed: " << std::strerror(error)
+                      << "; " << (seq - first + 1) << " records not saved" << std::endl;
+            if (lost_.size() == LOST_RANGES) lost_.erase(lost_.begin());
+            lost_.emplace_back(first, seq);
+        }
+        durableSeq_ = seq;
+        durableCv_.notify_all();
+    }
+    if (fd_ >= 0) {
+        ::fdatasync(fd_);
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+bool ChatLog::writeBatch(std::vector<std::pair<uint32_t, std::string>>& batch) {
+    // Where the current chunk starts, to cut it off again if it fails:
+    // records appended after a torn one would never be replayed
+    off_t start = -1;
+    auto fail = [&]() {
+        int error = errno;
+        if (fd_ >= 0 && start >= 0 && ::ftruncate(fd_, start) != 0) {
+            std::cerr << "[ERROR] Chat log: cannot cut a failed write off " << segmentPath(fdSegment_) << std::endl;
+        }
+        errno = error;
+        return false;
+    };
+    for (auto& chunk : batch) {
+        if (chunk.second.empty()) continue;
+        if (fd_ < 0 || fdSegment_ != chunk.first) {
+            // Seal the previous segment before starting the next one
+            if (fd_ >= 0) {
+                bool synced = ::fdatasync(fd_) == 0;
+                if (!synced) return fail();
+                ::close(fd_);
+                fd_ = -1;
+            }
+            fd_ = ::open(segmentPath(chunk.first).c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+            if (fd_ < 0) return false;
+            fdSegment_ = chunk.first;
+            syncDirectory(directory_);
+        }
+        start = ::lseek(fd_, 0, SEEK_END);
+        if (!writeAll(fd_, chunk.second)) return fail();
+    }
+    return fd_ < 0 || ::fdatasync(fd_) == 0 || fail();
+}
+
+bool ChatLog::needsCompaction() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return obsoleteRecords_ >= COMPACT_MIN_OBSOLETE && obsoleteRecords_ * 2 >= totalRecords_;
+}
+
+bool ChatLog::beginCompaction(Compaction& out) {
+    // Seal the active segment so every existing record can be rewritten
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (compacting_) return false;
+    compacting_ = true;
+    if (activeBytes_ > 0) {
+        activeSegment_++;
+        activeBytes_ = 0;
+    }
+    out.sealedEnd = activeSegment_;
+    out.totalAtSeal = totalRecords_;
+    out.obsoleteAtSeal = obsoleteRecords_;
+    out.live.clear();
+    return true;
+}
+
+void ChatLog::compact(const Compaction& compaction) {
+    if (!waitDurable()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        compacting_ = false;
+        return;
+    }
+
+    std::vector<uint32_t> sealed;
+    for (uint32_t number : listSegments()) {
+        if (number < compaction.sealedEnd) sealed.push_back(number);
+    }
+
+    // Only each member's last seen count survives; find where it is
+    // (segment, record) so it stays in place after the joins it follows
+    std::unordered_map<std::string, std::pair<uint32_t, size_t>> lastSeen;
+    for (uint32_t number : sealed) {
+        int fd = ::open(segmentPath(number).c_str(), O_RDONLY);
+        if (fd < 0) continue;
+        struct stat st;
+        size_t size = ::fstat(fd, &st) == 0 ? static_cast<size_t>(st.st_size) : 0;
+        size_t index = 0;
+        mapAndScan(fd, size, [&](const uint8_t* payload, size_t length) {
+            Reader in{payload, length};
+            if (in.u8() == SEEN) {
+                std::string channelId = in.str();
+                std::string userId = in.str();
+                if (in.ok) lastSeen[channelId + '\x1f' + userId] = {number, index};
+            }
+            index++;
+        });
+        ::close(fd);
+    }
+
+    // What the sealed segments hold afterwards; a segment that cannot be
+    // rewritten keeps all of its records, obsolete ones included
+    size_t kept = 0, obsolete = 0;
+    for (uint32_t number : sealed) {
+        std::string path = segmentPath(number);
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) continue;
+        struct stat st;
+        size_t size = ::fstat(fd, &st) == 0 ? static_cast<size_t>(st.st_size) : 0;
+
+        // Keep messages that still exist, carrying their read flag; read and
+        // remove records are folded in and dropped. Channel and membership
+        // records are kept as they are.
+        std::string out;
+        size_t records = 0, scanned = 0;
+        mapAndScan(fd, size, [&](const uint8_t* payload, size_t length) {
+            size_t index = scanned++;
+            Reader in{payload, length};
+            switch (in.u8()) {
+                case APPEND: {
+                    core::ChatMessage m = in.message();
+                    if (!in.ok) return;
+                    auto live = compaction.live.find(m.messageId);
+                    if (live == compaction.live.end()) return;
+                    m.read = live->second;
+                    out += frame(encodeAppend(m));
+                    break;
+                }
+                case CHANNEL_MESSAGE: {
+                    in.u64();
+                    core::ChatMessage m = in.message();
+                    if (!in.ok || !compaction.live.count(m.messageId)) return;
+                    out += frame(std::string(reinterpret_cast<const char*>(payload), length));
+                    break;
+                }
+                case SEEN: {
+                    std::string channelId = in.str();
+                    std::string userId = in.str();
+                    auto last = lastSeen.find(channelId + '\x1f' + userId);
+                    if (!in.ok || last == lastSeen.end() || last->second != std::make_pair(number, index)) return;
+                    out += frame(std::string(reinterpret_cast<const char*>(payload), length));
+                    break;
+                }
+                case CHANNEL:
+                case MEMBER:
+                    out += frame(std::string(reinterpret_cast<const char*>(payload), length));
+                    break;
+                default:
+                    return;
+            }
+            records++;
+        });
+        ::close(fd);
+
+        if (records == 0 && ::unlink(path.c_str()) == 0) continue;
+        std::string tmp = path + ".tmp";
+        int outFd = records == 0 ? -1 : ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        bool ok = outFd >= 0 && writeAll(outFd, out) && ::fdatasync(outFd) == 0;
+        if (outFd >= 0) ::close(outFd);
+        if (ok && ::rename(tmp.c_str(), path.c_str()) == 0) {
+            kept += records;
+        } else {
+            // The original segment is still in place
+            if (outFd >= 0) ::unlink(tmp.c_str());
+            std::cerr << "[WARN] Chat log: cannot compact " << path << "; keeping it as is" << std::endl;
+            kept += scanned;
+            obsolete += scanned - records;
+        }
+    }
+    syncDirectory(directory_);
+
+    // Records queued since the seal are in later segments and still count
+    std::lock_guard<std::mutex> lock(mutex_);
+    totalRecords_ = totalRecords_ - compaction.totalAtSeal + kept;
+    obsoleteRecords_ = obsoleteRecords_ - compaction.obsoleteAtSeal + obsolete;
+    compacting_ = false;
+}
+
+} // namespace storage
+} // namespace english_learning
@@ -0,0 +1,142 @@
+#ifndef ENGLISH_LEARNING_STORAGE_CHAT_LOG_H
+#define ENGLISH_LEARNING_STORAGE_CHAT_LOG_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "src/repository/memory/channel_store.h"
+#include "src/repository/memory/chat_store.h"
+
+namespace english_learning {
+namespace storage {
+
+/**
+ * Write-ahead log for chat messages, direct and in channels.
+ *
+ * Every ChatStore and ChannelStore mutation is encoded as a record
+ *   [u32 payload length][u32 CRC-32 of payload][payload]
+ * and appended to numbered segment files (chat-00000001.log, ...) that are
+ * rolled at SEGMENT_BYTES. A background flusher writes queued records and
+ * issues one fdatasync per batch (group commit); a batch closes at most one
+ * commit interval after its first record was queued. A batch that cannot be
+ * written is cut back off its segment and its records reported as failed to
+ * their writers; the log carries on with the next batch.
+ *
+ * On startup open() maps each segment and re-applies its records to the
+ * stores, stopping at the first torn or corrupt record. Compaction rewrites
+ * sealed segments so they hold only live messages with their read state,
+ * the channels with their membership changes, and each member's latest
+ * seen count.
+ * beginCompaction() seals the active segment; the caller then snapshots the
+ * store's read flags, a few conversations per lock, and compact() rewrites
+ * without the store's lock. The snapshot need not be atomic: any state a
+ * message had after the seal will do, since every later change is in the
+ * segments written since, which replay after the rewritten ones.
+ */
+class ChatLog : public repository::memory::ChatJournal, public repository::memory::ChannelJournal {
+public:
+    static constexpr size_t SEGMENT_BYTES = 4 * 1024 * 1024;
+
+    ChatLog(std::string directory, std::chrono::milliseconds commitInterval);
+    ~ChatLog() override;
+
+    ChatLog(const ChatLog&) = delete;
+    ChatLog& operator=(const ChatLog&) = delete;
+
+    // Rebuild the stores from disk, then start the flusher. Call once, before
+    // attaching the log to the stores. Returns the number of records applied.
+    size_t open(repository::memory::ChatStore& store, repository::memory::ChannelStore& channels);
+
+    // ChatJournal
+    void recordAppend(const core::ChatMessage& message) override;
+    void recordRead(const std::string& messageId) override;
+    void recordConversationRead(const std::string& recipientId,
+                                const std::string& senderId) override;
+    void recordRemove(const std::string& messageId) override;
+    bool waitDurable() override;
+
+    // ChannelJournal
+    void recordChannel(const core::Channel& channel) override;
+    void recordMember(const std::string& channelId, const std::string& userId, bool joined) override;
+    void recordChannelMessage(const core::ChatMessage& message, uint64_t seq) override;
+    void recordChannelRemove(const std::string& channelId, const std::string& messageId) override;
+    void recordSeen(const std::string& channelId, const std::string& userId, uint64_t seen) override;
+
+    // True once enough records in sealed segments are obsolete
+    bool needsCompaction() const;
+
+    struct Compaction {
+        uint32_t sealedEnd = 0;                       // segments before this are rewritten
+        size_t totalAtSeal = 0;                       // record counts when sealed
+        size_t obsoleteAtSeal = 0;
+        std::unordered_map<std::string, bool> live;   // messageId -> read, filled by the caller
+                                                      // (channel messages too; their flag is unused)
+    };
+
+    // Seal the active segment; false if another compaction is still running
+    bool beginCompaction(Compaction& out);
+
+    // Rewrite the sealed segments, keeping the messages in compaction.live
+    // (snapshotted after beginCompaction()) with their read flag from there,
+    // and the channel records that still matter
+    void compact(const Compaction& compaction);
+
+private:
+    enum RecordType : uint8_t {
+        APPEND = 1,
+        READ = 2,
+        CONVERSATION_READ = 3,
+        REMOVE = 4,
+        CHANNEL = 5,
+        MEMBER = 6,
+        CHANNEL_MESSAGE = 7,
+        CHANNEL_REMOVE = 8,
+        SEEN = 9
+    };
+
+    std::string segmentPath(uint32_t number) const;
+    std::vector<uint32_t> listSegments() const;
+
+    // Queue one encoded record, rolling to a new segment if it does not fit
+    void enqueue(const std::string& payload, bool obsoletes);
+
+    void flusherLoop();
+    bool writeBatch(std::vector<std::pair<uint32_t, std::string>>& batch);
+    // Whether the record numbered seq was in a batch that failed
+    bool lost(uint64_t seq) const;
+
+    std::string directory_;
+    std::chrono::milliseconds commitInterval_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable flushCv_;     // wakes the flusher
+    std::condition_variable durableCv_;   // wakes senders waiting for a commit
+    std::vector<std::pair<uint32_t, std::string>> pending_;  // segment -> bytes
+    uint32_t activeSegment_ = 1;
+    size_t activeBytes_ = 0;              // size of the active segment incl. pending
+    uint64_t queuedSeq_ = 0;              // records queued
+    uint64_t durableSeq_ = 0;             // records the flusher is done with
+    std::vector<std::pair<uint64_t, uint64_t>> lost_;   // records [first, last] of recent failed batches
+    bool stop_ = false;
+    bool compacting_ = false;
+
+    size_t totalRecords_ = 0;             // records in all segments
+    size_t obsoleteRecords_ = 0;          // records compaction would drop
+
+    // Owned by the flusher thread
+    int fd_ = -1;
+    uint32_t fdSegment_ = 0;
+
+    std::thread flusher_;
+};
+
+} // namespace storage
+} // namespace english_learning
+
+#endif // ENGLISH_LEARNING_STORAGE_CHAT_LOG_H
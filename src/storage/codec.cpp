@@ -0,0 +1,151 @@
+#include "codec.h"
+
+#include <cerrno>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace english_learning {
+namespace storage {
+
+namespace {
+
+// Bits of the byte that follows a message's timestamp
+constexpr uint8_t READ_FLAG = 0x01;
+constexpr uint8_t HAS_ATTACHMENTS = 0x02;
+
+} // namespace
+
+uint32_t crc32(const uint8_t* data, size_t size) {
+    static const auto table = [] {
+        std::vector<uint32_t> t(256);
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+
+// ---- Little-endian encoding ----
+
+void putU32(std::string& out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+}
+
+void putU64(std::string& out, uint64_t v) {
+    for (int i = 0; i < 8; ++i) out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+}
+
+void putString(std::string& out, const std::string& s) {
+    putU32(out, static_cast<uint32_t>(s.size()));
+    out += s;
+}
+
+void putMessage(std::string& out, const core::ChatMessage& m) {
+    putString(out, m.messageId);
+    putString(out, m.senderId);
+    putString(out, m.recipientId);
+    putString(out, m.content);
+    putU64(out, static_cast<uint64_t>(m.timestamp));
+    uint8_t flags = (m.read ? READ_FLAG : 0) | (m.attachments.empty() ? 0 : HAS_ATTACHMENTS);
+    out.push_back(static_cast<char>(flags));
+    if (m.attachments.empty()) return;
+    putU32(out, static_cast<uint32_t>(m.attachments.size()));
+    for (const core::Attachment& a : m.attachments) {
+        putString(out, a.attachmentId);
+        putString(out, a.mimeType);
+        putString(out, a.fileName);
+        putU64(out, a.size);
+    }
+}
+
+uint32_t readU32(const uint8_t* p) {
+    return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+}
+
+uint8_t Reader::u8() {
+    if (left < 1) { ok = false; return 0; }
+    left--;
+    return *p++;
+}
+
+uint32_t Reader::u32() {
+    if (left < 4) { ok = false; return 0; }
+    uint32_t v = readU32(p);
+    p += 4; left -= 4;
+    return v;
+}
+
+uint64_t Reader::u64() {
+    uint64_t lo = u32();
+    uint64_t hi = u32();
+    return lo | hi << 32;
+}
+
+std::string Reader::str() {
+    uint32_t n = u32();
+    if (!ok || left < n) { ok = false; return ""; }
+    std::string s(reinterpret_cast<const char*>(p), n);
+    p += n; left -= n;
+    return s;
+}
+
+core::ChatMessage Reader::message() {
+    core::ChatMessage m;
+    m.messageId = str();
+    m.senderId = str();
+    m.recipientId = str();
+    m.content = str();
+    m.timestamp = static_cast<core::Timestamp>(u64());
+    uint8_t flags = u8();
+    m.read = (flags & READ_FLAG) != 0;
+    if (flags & HAS_ATTACHMENTS) {
+        uint32_t count = u32();
+        for (uint32_t i = 0; i < count && ok; ++i) {
+            core::Attachment a;
+            a.attachmentId = str();
+            a.mimeType = str();
+            a.fileName = str();
+            a.size = u64();
+            m.attachments.push_back(std::move(a));
+        }
+    }
+    return m;
+}
+
+bool writeAll(int fd, const std::string& data) {
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t n = ::write(fd, data.data() + done, data.size() - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+void syncDirectory(const std::string& dir) {
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd >= 0) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+}
+
+void makeDirectories(const std::string& path) {
+    for (size_t pos = path.find('/', 1); ; pos = path.find('/', pos + 1)) {
+        ::mkdir(path.substr(0, pos).c_str(), 0755);
+        if (pos == std::string::npos) break;
+    }
+}
+
+} // namespace storage
+} // namespace english_learning
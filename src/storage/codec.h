@@ -0,0 +1,49 @@
+#ifndef ENGLISH_LEARNING_STORAGE_CODEC_H
+#define ENGLISH_LEARNING_STORAGE_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "include/core/chat_message.h"
+
+namespace english_learning {
+namespace storage {
+
+// Helpers shared by the on-disk formats in this directory: little-endian
+// integers, length-prefixed strings and a bounds-checked reader.
+
+uint32_t crc32(const uint8_t* data, size_t size);
+
+void putU32(std::string& out, uint32_t v);
+void putU64(std::string& out, uint64_t v);
+void putString(std::string& out, const std::string& s);
+
+// A chat message as its fields in declaration order. The read byte doubles
+// as a flags byte; attachments follow only when its HAS_ATTACHMENTS bit is
+// set, so records written before attachments existed still decode.
+void putMessage(std::string& out, const core::ChatMessage& m);
+
+uint32_t readU32(const uint8_t* p);
+
+// Bounds-checked cursor over an encoded buffer; ok turns false on overrun
+struct Reader {
+    const uint8_t* p;
+    size_t left;
+    bool ok = true;
+
+    uint8_t u8();
+    uint32_t u32();
+    uint64_t u64();
+    std::string str();
+    core::ChatMessage message();
+};
+
+// File helpers: retry short writes, fsync a directory, mkdir -p
+bool writeAll(int fd, const std::string& data);
+void syncDirectory(const std::string& dir);
+void makeDirectories(const std::string& path);
+
+} // namespace storage
+} // namespace english_learning
+
+#endif // ENGLISH_LEARNING_STORAGE_CODEC_H
@@ -0,0 +1,350 @@
+#include "cold_store.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+#include "codec.h"
+#include "src/repository/memory/chat_store.h"
+
+namespace english_learning {
+namespace storage {
+
+using repository::memory::ChatStore;
+
+namespace {
+
+constexpr uint32_t FOOTER_MAGIC = 0x31444C43;   // "CLD1"
+constexpr size_t TRAILER_BYTES = 12;            // footer length + footer CRC + magic
+
+bool readAt(int fd, uint64_t offset, size_t size, std::string& out) {
+    out.resize(size);
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = ::pread(fd, &out[done], size - done, static_cast<off_t>(offset + done));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+ColdStore::ColdStore(std::string directory) : directory_(std::move(directory)) {}
+
+std::string ColdStore::segmentPath(uint32_t number) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "cold-%08u.seg", number);
+    return directory_ + "/" + name;
+}
+
+size_t ColdStore::open() {
+    makeDirectories(directory_);
+
+    std::vector<uint32_t> numbers;
+    if (DIR* dir = ::opendir(directory_.c_str())) {
+        while (dirent* entry = ::readdir(dir)) {
+            unsigned number = 0;
+            char tail = 0;
+            size_t length = std::strlen(entry->d_name);
+            if (length > 4 && std::strcmp(entry->d_name + length - 4, ".tmp") == 0) {
+                ::unlink((directory_ + "/" + entry->d_name).c_str());   // interrupted archive()
+            } else if (std::sscanf(entry->d_name, "cold-%8u.se%c", &number, &tail) == 2 && tail == 'g' &&
+                       length == 17 && number > 0) {
+                numbers.push_back(number);
+            }
+        }
+        ::closedir(dir);
+    }
+    std::sort(numbers.begin(), numbers.end());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (uint32_t number : numbers) {
+        lastSegment_ = number;
+        std::string path = segmentPath(number);
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) continue;
+        struct stat st;
+        size_t size = ::fstat(fd, &st) == 0 ? static_cast<size_t>(st.st_size) : 0;
+
+        std::string trailer, footer;
+        bool ok = size >= TRAILER_BYTES && readAt(fd, size - TRAILER_BYTES, TRAILER_BYTES, trailer);
+        const uint8_t* t = reinterpret_cast<const uint8_t*>(trailer.data());
+        uint32_t footerBytes = ok ? readU32(t) : 0;
+        ok = ok && readU32(t + 8) == FOOTER_MAGIC && footerBytes <= size - TRAILER_BYTES &&
+             readAt(fd, size - TRAILER_BYTES - footerBytes, footerBytes, footer) &&
+             crc32(reinterpret_cast<const uint8_t*>(footer.data()), footer.size()) == readU32(t + 4);
+        ::close(fd);
+
+        std::vector<std::pair<std::string, Block>> blocks;
+        Reader in{reinterpret_cast<const uint8_t*>(footer.data()), footer.size()};
+        uint32_t count = ok ? in.u32() : 0;
+        for (uint32_t i = 0; ok && in.ok && i < count; ++i) {
+            Block block;
+            block.segment = number;
+            std::string key = in.str();
+            block.offset = in.u64();
+            block.compressedBytes = in.u32();
+            block.rawBytes = in.u32();
+            block.crc = in.u32();
+            block.count = in.u32();
+            block.firstTs = static_cast<core::Timestamp>(in.u64());
+            block.lastTs = static_cast<core::Timestamp>(in.u64());
+            block.lastId = in.str();
+            blocks.emplace_back(std::move(key), std::move(block));
+        }
+        if (!ok || !in.ok) {
+            std::cerr << "[WARN] Chat archive: unreadable index in " << path << "; skipping it" << std::endl;
+            continue;
+        }
+        for (auto& pair : blocks) {
+            messageCount_ += pair.second.count;
+            conversations_[pair.first].push_back(std::move(pair.second));
+        }
+    }
+    return messageCount_;
+}
+
+std::string ColdStore::directKey(const core::ChatMessage& message) {
+    return ChatStore::conversationKey(message.senderId, message.recipientId);
+}
+
+std::string ColdStore::channelKey(const core::ChatMessage& message) {
+    return channelKey(message.recipientId);
+}
+
+std::string ColdStore::channelKey(const std::string& channelId) {
+    // User ids never start with '#', so no direct key does either
+    return '#' + channelId;
+}
+
+bool ColdStore::isChannelKey(const std::string& key) {
+    return !key.empty() && key[0] == '#';
+}
+
+bool ColdStore::archive(const std::vector<core::ChatMessage>& messages, KeyOf keyOf) {
+    if (messages.empty()) return true;
+
+    // Group by conversation, keeping each conversation's order
+    std::vector<std::string> order;
+    std::unordered_map<std::string, std::vector<const core::ChatMessage*>> groups;
+    for (const core::ChatMessage& m : messages) {
+        std::string key = keyOf(m);
+        auto& group = groups[key];
+        if (group.empty()) order.push_back(key);
+        group.push_back(&m);
+    }
+
+    std::string body;
+    std::vector<std::pair<std::string, Block>> blocks;
+    for (const std::string& key : order) {
+        const auto& group = groups[key];
+        for (size_t i = 0; i < group.size();) {
+            Block block{};
+            std::string raw;
+            block.firstTs = block.lastTs = group[i]->timestamp;
+            while (i < group.size() && raw.size() < BLOCK_BYTES) {
+                const core::ChatMessage& m = *group[i++];
+                putMessage(raw, m);
+                block.firstTs = std::min(block.firstTs, m.timestamp);
+                block.lastTs = std::max(block.lastTs, m.timestamp);
+                block.lastId = m.messageId;
+                block.count++;
+            }
+
+            uLongf compressedBytes = ::compressBound(raw.size());
+            std::string compressed(compressedBytes, '\0');
+            if (::compress2(reinterpret_cast<Bytef*>(&compressed[0]), &compressedBytes,
+                            reinterpret_cast<const Bytef*>(raw.data()), raw.size(),
+                            Z_DEFAULT_COMPRESSION) != Z_OK) {
+                return false;
+            }
+            compressed.resize(compressedBytes);
+
+            block.offset = body.size();
+            block.compressedBytes = static_cast<uint32_t>(compressed.size());
+            block.rawBytes = static_cast<uint32_t>(raw.size());
+            block.crc = crc32(reinterpret_cast<const uint8_t*>(compressed.data()), compressed.size());
+            body += compressed;
+            blocks.emplace_back(key, std::move(block));
+        }
+    }
+
+    std::string footer;
+    putU32(footer, static_cast<uint32_t>(blocks.size()));
+    for (const auto& pair : blocks) {
+        const Block& block = pair.second;
+        putString(footer, pair.first);
+        putU64(footer, block.offset);
+        putU32(footer, block.compressedBytes);
+        putU32(footer, block.rawBytes);
+        putU32(footer, block.crc);
+        putU32(footer, block.count);
+        putU64(footer, static_cast<uint64_t>(block.firstTs));
+        putU64(footer, static_cast<uint64_t>(block.lastTs));
+        putString(footer, block.lastId);
+    }
+    body += footer;
+    putU32(body, static_cast<uint32_t>(footer.size()));
+    putU32(body, crc32(reinterpret_cast<const uint8_t*>(footer.data()), footer.size()));
+    putU32(body, FOOTER_MAGIC);
+
+    uint32_t number;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        number = ++lastSegment_;
+    }
+    std::string path = segmentPath(number);
+    std::string tmp = path + ".tmp";
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    bool ok = fd >= 0 && writeAll(fd, body) && ::fdatasync(fd) == 0;
+    if (fd >= 0) ::close(fd);
+    ok = ok && ::rename(tmp.c_str(), path.c_str()) == 0;
+    if (!ok) {
+        std::cerr << "[ERROR] Chat archive: cannot write " << path << ": " << std::strerror(errno) << std::endl;
+        ::unlink(tmp.c_str());
+        return false;
+    }
+    syncDirectory(directory_);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& pair : blocks) {
+        pair.second.segment = number;
+        messageCount_ += pair.second.count;
+        conversations_[pair.first].push_back(std::move(pair.second));
+    }
+    return true;
+}
+
+ColdStore::Messages ColdStore::read(const Block& block) const {
+    int fd = ::open(segmentPath(block.segment).c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+    std::string compressed;
+    bool ok = readAt(fd, block.offset, block.compressedBytes, compressed);
+    ::close(fd);
+    if (!ok || crc32(reinterpret_cast<const uint8_t*>(compressed.data()), compressed.size()) != block.crc) {
+        std::cerr << "[WARN] Chat archive: corrupt block in " << segmentPath(block.segment) << std::endl;
+        return nullptr;
+    }
+
+    std::string raw(block.rawBytes, '\0');
+    uLongf rawBytes = block.rawBytes;
+    if (::uncompress(reinterpret_cast<Bytef*>(&raw[0]), &rawBytes,
+                     reinterpret_cast<const Bytef*>(compressed.data()), compressed.size()) != Z_OK ||
+        rawBytes != block.rawBytes) {
+        return nullptr;
+    }
+
+    auto messages = std::make_shared<std::vector<core::ChatMessage>>();
+    messages->reserve(block.count);
+    Reader in{reinterpret_cast<const uint8_t*>(raw.data()), raw.size()};
+    for (uint32_t i = 0; i < block.count && in.ok; ++i) messages->push_back(in.message());
+    return in.ok ? messages : nullptr;
+}
+
+ColdStore::Messages ColdStore::load(const Block& block) {
+    uint64_t key = uint64_t(block.segment) << 40 | block.offset;
+    auto hit = cacheIndex_.find(key);
+    if (hit != cacheIndex_.end()) {
+        cache_.splice(cache_.begin(), cache_, hit->second);
+        return hit->second->second;
+    }
+
+    Messages messages = read(block);
+    if (!messages) return nullptr;
+    cache_.emplace_front(key, messages);
+    cacheIndex_[key] = cache_.begin();
+    if (cache_.size() > CACHE_BLOCKS) {
+        cacheIndex_.erase(cache_.back().first);
+        cache_.pop_back();
+    }
+    return messages;
+}
+
+std::vector<core::ChatMessage> ColdStore::history(const std::string& conversationKey, const std::string& beforeId,
+                                                  core::Timestamp beforeTs, size_t count) {
+    std::vector<core::ChatMessage> page;
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = conversations_.find(conversationKey);
+    if (it == conversations_.end() || count == 0) return page;
+    const std::vector<Block>& blocks = it->second;
+
+    // Position (block, index) of the first message not to return
+    size_t b = blocks.size() - 1;
+    Messages current;
+    size_t end = 0;
+    if (!beforeId.empty()) {
+        // The cursor's timestamp narrows the search to the block holding it,
+        // or a few neighbours sharing that millisecond. It is normally the
+        // oldest message of the previous page, so that block is cached.
+        for (size_t i = blocks.size(); i-- > 0 && !current;) {
+            if (beforeTs < blocks[i].firstTs || beforeTs > blocks[i].lastTs) continue;
+            Messages messages = load(blocks[i]);
+            if (!messages) continue;
+            for (size_t j = 0; j < messages->size(); ++j) {
+                if ((*messages)[j].messageId == beforeId) {
+                    b = i;
+                    current = messages;
+                    end = j;
+                    break;
+                }
+            }
+        }
+        if (!current) return page;
+    } else {
+        if (beforeTs > 0) {
+            for (size_t i = 0; i < blocks.size(); ++i) {
+                if (blocks[i].lastTs >= beforeTs) {
+                    b = i;
+                    break;
+                }
+            }
+        }
+        current = load(blocks[b]);
+        if (!current) return page;
+        end = current->size();
+        if (beforeTs > 0) {
+            for (size_t j = 0; j < current->size(); ++j) {
+                if ((*current)[j].timestamp >= beforeTs) {
+                    end = j;
+                    break;
+                }
+            }
+        }
+    }
+
+    while (page.size() < count) {
+        if (end == 0) {
+            if (b == 0) break;
+            current = load(blocks[--b]);
+            if (!current) break;
+            end = current->size();
+            continue;
+        }
+        page.push_back((*current)[--end]);
+    }
+    std::reverse(page.begin(), page.end());
+    return page;
+}
+
+std::unordered_map<std::string, std::string> ColdStore::newestIds() const {
+    std::unordered_map<std::string, std::string> ids;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& pair : conversations_) ids[pair.first] = pair.second.back().lastId;
+    return ids;
+}
+
+size_t ColdStore::messageCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return messageCount_;
+}
+
+} // namespace storage
+} // namespace english_learning
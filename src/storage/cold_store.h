@@ -0,0 +1,114 @@
+#ifndef ENGLISH_LEARNING_STORAGE_COLD_STORE_H
+#define ENGLISH_LEARNING_STORAGE_COLD_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "include/core/chat_message.h"
+
+namespace english_learning {
+namespace storage {
+
+/**
+ * Compressed, immutable archive of old chat messages.
+ *
+ * Each archive() call writes one segment file (cold-00000001.seg, ...).
+ * Inside it, messages are grouped by conversation (a pair of users, or a
+ * channel; see directKey() / channelKey()) and cut into blocks of
+ * about BLOCK_BYTES, each deflated on its own with zlib. A footer lists the
+ * blocks (conversation, time range, count, offset, CRC); only these footers
+ * are kept in memory. history() inflates just the blocks it touches and
+ * keeps the last CACHE_BLOCKS of them in an LRU cache, so paging backwards
+ * through a conversation reads each block once.
+ *
+ * A segment is written to a temporary file, fsynced and renamed, so a crash
+ * leaves either the whole segment or nothing. Thread-safe.
+ */
+class ColdStore {
+public:
+    static constexpr size_t BLOCK_BYTES = 64 * 1024;   // uncompressed
+    static constexpr size_t CACHE_BLOCKS = 32;
+
+    using KeyOf = std::string (*)(const core::ChatMessage&);
+
+    explicit ColdStore(std::string directory);
+
+    // Conversation keys: ChatStore::conversationKey() for direct messages,
+    // '#' + channelId for a channel's
+    static std::string directKey(const core::ChatMessage& message);
+    static std::string channelKey(const core::ChatMessage& message);
+    static std::string channelKey(const std::string& channelId);
+    static bool isChannelKey(const std::string& key);
+
+    ColdStore(const ColdStore&) = delete;
+    ColdStore& operator=(const ColdStore&) = delete;
+
+    // Load the index of every segment; returns the number of archived messages
+    size_t open();
+
+    /**
+     * Write messages as a new segment, grouped into conversations by keyOf.
+     * Each conversation's messages must be in conversation order and newer
+     * than anything archived for it before. Returns false, archiving
+     * nothing, if the segment could not be written.
+     */
+    bool archive(const std::vector<core::ChatMessage>& messages, KeyOf keyOf = &ColdStore::directKey);
+
+    /**
+     * Page backwards through a conversation's archived messages: up to count
+     * messages, oldest first, preceding beforeId, which was sent at beforeTs;
+     * or with no beforeId, sent before beforeTs (0 = the newest archived).
+     * Only the blocks spanning beforeTs are searched for beforeId; one that
+     * is not there, or has no timestamp, yields an empty page.
+     */
+    std::vector<core::ChatMessage> history(const std::string& conversationKey, const std::string& beforeId,
+                                           core::Timestamp beforeTs, size_t count);
+
+    // Newest archived messageId of every conversation, by conversation key
+    std::unordered_map<std::string, std::string> newestIds() const;
+
+    size_t messageCount() const;
+
+private:
+    struct Block {
+        uint32_t segment;
+        uint64_t offset;
+        uint32_t compressedBytes;
+        uint32_t rawBytes;
+        uint32_t crc;                  // of the compressed bytes
+        uint32_t count;
+        core::Timestamp firstTs;
+        core::Timestamp lastTs;
+        std::string lastId;
+    };
+    using Messages = std::shared_ptr<const std::vector<core::ChatMessage>>;
+
+    std::string segmentPath(uint32_t number) const;
+
+    // Read, verify and inflate a block (null on failure); no caching
+    Messages read(const Block& block) const;
+
+    // read() through the LRU cache; caller holds mutex_
+    Messages load(const Block& block);
+
+    std::string directory_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, std::vector<Block>> conversations_;  // key -> blocks, oldest first
+    uint32_t lastSegment_ = 0;
+    size_t messageCount_ = 0;
+
+    // (segment << 40 | offset) -> inflated block, most recently used first
+    std::list<std::pair<uint64_t, Messages>> cache_;
+    std::unordered_map<uint64_t, std::list<std::pair<uint64_t, Messages>>::iterator> cacheIndex_;
+};
+
+} // namespace storage
+} // namespace english_learning
+
+#endif // ENGLISH_LEARNING_STORAGE_COLD_STORE_H
@@ -0,0 +1,751 @@
+#include "content_pack.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+#include "codec.h"
+
+namespace english_learning {
+namespace storage {
+
+namespace {
+
+constexpr char MAGIC[8] = {'E', 'L', 'C', 'P', 'A', 'C', 'K', '1'};
+
+// Header: magic, version, CRC-32 of bytes [CRC_START, stringsOffset), then
+// four record counts, four table offsets, string table offset and size, the
+// build time and a reference to the lesson text dictionary
+constexpr size_t HEADER_BYTES = 96;
+constexpr size_t VERSION_AT = 8;
+constexpr size_t CRC_AT = 12;
+constexpr size_t CRC_START = 16;
+constexpr size_t COUNTS_AT = 16;
+constexpr size_t TABLES_AT = 32;
+constexpr size_t STRINGS_AT = 64;
+constexpr size_t STRINGS_SIZE_AT = 72;
+constexpr size_t BUILT_AT = 80;
+constexpr size_t DICTIONARY_AT = 88;
+
+// Records are runs of little-endian u32s; a string reference is two of
+// them, offset into the string table and length
+constexpr size_t RECORD_BYTES[] = {72, 40, 48, 56};
+
+// Lesson: id, title, description, stored text, video, audio, topic, level,
+// duration, text length and CRC-32, text flags
+constexpr size_t LESSON_REFS[] = {0, 8, 16, 24, 32, 40};
+constexpr uint32_t TEXT_DEFLATED = 1;
+
+// Lesson text shorter than this is stored as is; deflate gains little on it
+constexpr size_t MIN_DEFLATE_BYTES = 128;
+
+// Dictionary training: how much lesson text to sample, the length of the
+// substrings it is built from, and the k-mers that score them
+constexpr size_t TRAINING_BYTES = 8 * 1024 * 1024;
+constexpr size_t SEGMENT_BYTES = 64;
+constexpr size_t KMER_BYTES = 8;
+// A dictionary is at most this fraction of the text it serves; a larger one
+// costs more space than it saves
+constexpr size_t DICTIONARY_RATIO = 64;
+constexpr unsigned HASH_BITS = 20;
+// Test: id, title, type, questions blob, level, topic
+constexpr size_t TEST_REFS[] = {0, 8, 16, 24};
+// Exercise: id, title, description, blob, type, level, topic, duration
+constexpr size_t EXERCISE_REFS[] = {0, 8, 16, 24};
+// Game: id, title, description, topic, pairs blob, type, level, time limit, max score
+constexpr size_t GAME_REFS[] = {0, 8, 16, 24, 32};
+
+constexpr uint32_t LEVELS = 3;
+constexpr uint32_t TOPICS = 6;
+constexpr uint32_t QUESTION_TYPES = 3;
+constexpr uint32_t EXERCISE_TYPES = 3;
+constexpr uint32_t GAME_TYPES = 3;
+constexpr uint32_t IMAGE_SOURCE_TYPES = 3;
+
+uint64_t readU64(const uint8_t* p) {
+    return uint64_t(readU32(p)) | uint64_t(readU32(p + 4)) << 32;
+}
+
+void putStrings(std::string& out, const std::vector<std::string>& list) {
+    putU32(out, static_cast<uint32_t>(list.size()));
+    for (const std::string& s : list) putString(out, s);
+}
+
+void putPairs(std::string& out, const std::vector<std::pair<std::string, std::string>>& pairs) {
+    putU32(out, static_cast<uint32_t>(pairs.size()));
+    for (const auto& pair : pairs) {
+        putString(out, pair.first);
+        putString(out, pair.second);
+    }
+}
+
+std::vector<std::string> readStrings(Reader& in) {
+    std::vector<std::string> list;
+    uint32_t count = in.u32();
+    for (uint32_t i = 0; i < count && in.ok; ++i) list.push_back(in.str());
+    return list;
+}
+
+std::vector<std::pair<std::string, std::string>> readPairs(Reader& in) {
+    std::vector<std::pair<std::string, std::string>> pairs;
+    uint32_t count = in.u32();
+    for (uint32_t i = 0; i < count && in.ok; ++i) {
+        std::string first = in.str();
+        pairs.emplace_back(std::move(first), in.str());
+    }
+    return pairs;
+}
+
+// zlib's CRC-32 (same polynomial as codec's, but much faster on the
+// megabytes of record tables a large catalog has) of [CRC_START, end)
+uint32_t tableCrc(const uint8_t* pack, uint64_t end) {
+    uLong crc = ::crc32(0L, Z_NULL, 0);
+    for (uint64_t at = CRC_START; at < end;) {
+        uInt chunk = static_cast<uInt>(std::min<uint64_t>(end - at, 1u << 30));
+        crc = ::crc32(crc, pack + at, chunk);
+        at += chunk;
+    }
+    return static_cast<uint32_t>(crc);
+}
+
+uint32_t kmerHash(const char* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return static_cast<uint32_t>((v * 0x9E3779B97F4A7C15ull) >> (64 - HASH_BITS));
+}
+
+/**
+ * A preset dictionary for the lesson texts, at most `capacity` bytes and
+ * 1/DICTIONARY_RATIO of the text: the substrings whose k-mers recur across
+ * the most lessons. The sample is cut into one epoch per segment wanted;
+ * from each epoch the segment whose distinct k-mers are shared by the most
+ * lessons is taken, and the k-mers it covers stop counting for later
+ * epochs. Deflate reaches nearby bytes most cheaply, so the best segments
+ * go last.
+ */
+std::string trainDictionary(const std::vector<core::Lesson>& lessons, size_t capacity) {
+    // A bounded sample, spread evenly over the lessons
+    size_t total = 0;
+    for (const core::Lesson& lesson : lessons) {
+        if (lesson.textContent.size() >= MIN_DEFLATE_BYTES) total += lesson.textContent.size();
+    }
+    size_t stride = std::max<size_t>(1, total / TRAINING_BYTES + (total % TRAINING_BYTES != 0));
+    std::string sample;
+    std::vector<size_t> sampleEnds;
+    size_t seen = 0;
+    for (const core::Lesson& lesson : lessons) {
+        if (lesson.textContent.size() < MIN_DEFLATE_BYTES || seen++ % stride != 0) continue;
+        sample += lesson.textContent;
+        sampleEnds.push_back(sample.size());
+    }
+    size_t wanted = std::min(capacity, total / DICTIONARY_RATIO) / SEGMENT_BYTES;
+    if (sample.size() < SEGMENT_BYTES || wanted == 0) return std::string();
+
+    // hashes[i]: k-mer at i, or 0 where one would cross into the next lesson;
+    // freq[h]: how many lessons contain k-mer h
+    const uint32_t NONE = 0;
+    std::vector<uint32_t> hashes(sample.size(), NONE);
+    std::vector<uint32_t> freq(size_t(1) << HASH_BITS, 0);
+    std::vector<uint32_t> lastLesson(size_t(1) << HASH_BITS, 0);
+    size_t begin = 0;
+    for (size_t n = 0; n < sampleEnds.size(); ++n) {
+        for (size_t i = begin; i + KMER_BYTES <= sampleEnds[n]; ++i) {
+            uint32_t h = kmerHash(&sample[i]) | 1;   // never NONE
+            hashes[i] = h;
+            if (lastLesson[h] != n + 1) {
+                lastLesson[h] = static_cast<uint32_t>(n + 1);
+                freq[h]++;
+            }
+        }
+        begin = sampleEnds[n];
+    }
+
+    struct Segment {
+        size_t at;
+        uint64_t score;
+    };
+    std::vector<Segment> chosen;
+    std::vector<uint16_t> inWindow(size_t(1) << HASH_BITS, 0);
+    size_t epoch = std::max(SEGMENT_BYTES, sample.size() / wanted);
+    for (size_t start = 0; start + SEGMENT_BYTES <= sample.size() && chosen.size() < wanted; start += epoch) {
+        size_t end = std::min(sample.size(), start + epoch);
+        size_t last = end - SEGMENT_BYTES;   // last window start in this epoch
+
+        // Slide a window over the epoch, scoring each distinct k-mer once
+        Segment best{start, 0};
+        uint64_t score = 0;
+        size_t kmers = SEGMENT_BYTES - KMER_BYTES + 1;
+        auto enter = [&](size_t i) {
+            if (hashes[i] != NONE && inWindow[hashes[i]]++ == 0) score += freq[hashes[i]];
+        };
+        auto leave = [&](size_t i) {
+            if (hashes[i] != NONE && --inWindow[hashes[i]] == 0) score -= freq[hashes[i]];
+        };
+        for (size_t i = start; i < start + kmers; ++i) enter(i);
+        for (size_t at = start;; ++at) {
+            if (score > best.score) best = Segment{at, score};
+            if (at == last) break;
+            leave(at);
+            enter(at + kmers);
+        }
+        for (size_t i = last; i < last + kmers; ++i) leave(i);
+        if (best.score == 0) continue;
+
+        for (size_t i = best.at; i < best.at + kmers; ++i) {
+            if (hashes[i] != NONE) freq[hashes[i]] = 0;
+        }
+        chosen.push_back(best);
+    }
+
+    std::stable_sort(chosen.begin(), chosen.end(),
+                     [](const Segment& a, const Segment& b) { return a.score < b.score; });
+    std::string dictionary;
+    for (const Segment& segment : chosen) dictionary.append(sample, segment.at, SEGMENT_BYTES);
+    if (dictionary.size() > capacity) dictionary.erase(0, dictionary.size() - capacity);
+    return dictionary;
+}
+
+Reader blobReader(std::string_view blob) {
+    return Reader{reinterpret_cast<const uint8_t*>(blob.data()), blob.size()};
+}
+
+template <typename T, typename IdFn>
+bool sortById(std::vector<T>& records, IdFn id, const char* kind, std::string& error) {
+    std::sort(records.begin(), records.end(), [&](const T& a, const T& b) { return id(a) < id(b); });
+    for (size_t i = 0; i < records.size(); ++i) {
+        if (id(records[i]).empty()) {
+            error = std::string(kind) + " without an id";
+            return false;
+        }
+        if (i > 0 && id(records[i]) == id(records[i - 1])) {
+            error = "duplicate " + std::string(kind) + " id " + id(records[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+// ---- ContentPack ----
+
+core::Lesson ContentPack::LessonView::metadata() const {
+    core::Lesson lesson(std::string(lessonId), std::string(title), std::string(description), topic, level, duration);
+    lesson.videoUrl = std::string(videoUrl);
+    lesson.audioUrl = std::string(audioUrl);
+    return lesson;
+}
+
+uint32_t ContentPack::textCrc(std::string_view text) {
+    return static_cast<uint32_t>(::crc32(::crc32(0L, Z_NULL, 0), reinterpret_cast<const Bytef*>(text.data()),
+                                         static_cast<uInt>(text.size())));
+}
+
+ContentPack::~ContentPack() {
+    unmap();
+}
+
+void ContentPack::unmap() {
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex_);
+        cache_.clear();
+        cacheIndex_.clear();
+        cacheBytes_ = 0;
+    }
+    dictionary_ = std::string_view();
+    if (data_) ::munmap(const_cast<uint8_t*>(data_), size_);
+    data_ = nullptr;
+    size_ = 0;
+}
+
+bool ContentPack::open(const std::string& path, std::string& error) {
+    unmap();
+    path_ = path;
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error = std::strerror(errno);
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < HEADER_BYTES) {
+        ::close(fd);
+        error = "truncated header";
+        return false;
+    }
+    size_ = static_cast<size_t>(st.st_size);
+    void* mapped = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        size_ = 0;
+        error = std::strerror(errno);
+        return false;
+    }
+    data_ = static_cast<const uint8_t*>(mapped);
+
+    if (!validate(error)) {
+        unmap();
+        return false;
+    }
+    return true;
+}
+
+bool ContentPack::validate(std::string& error) {
+    if (std::memcmp(data_, MAGIC, sizeof(MAGIC)) != 0) {
+        error = "not a content pack";
+        return false;
+    }
+    if (readU32(data_ + VERSION_AT) != VERSION) {
+        error = "unsupported version " + std::to_string(readU32(data_ + VERSION_AT));
+        return false;
+    }
+
+    uint64_t stringsOffset = readU64(data_ + STRINGS_AT);
+    uint64_t stringsSize = readU64(data_ + STRINGS_SIZE_AT);
+    if (stringsOffset < HEADER_BYTES || stringsOffset > size_ || stringsSize > size_ - stringsOffset) {
+        error = "string table out of bounds";
+        return false;
+    }
+    if (tableCrc(data_, stringsOffset) != readU32(data_ + CRC_AT)) {
+        error = "checksum mismatch";
+        return false;
+    }
+
+    strings_ = data_ + stringsOffset;
+    stringsSize_ = stringsSize;
+    builtAt_ = readU64(data_ + BUILT_AT);
+    for (int kind = 0; kind < KINDS; ++kind) {
+        uint32_t count = readU32(data_ + COUNTS_AT + 4 * kind);
+        uint64_t offset = readU64(data_ + TABLES_AT + 8 * kind);
+        if (offset < HEADER_BYTES || offset > stringsOffset ||
+            uint64_t(count) * RECORD_BYTES[kind] > stringsOffset - offset) {
+            error = "record table out of bounds";
+            return false;
+        }
+        counts_[kind] = count;
+        tables_[kind] = data_ + offset;
+    }
+    if (uint64_t(readU32(data_ + DICTIONARY_AT)) + readU32(data_ + DICTIONARY_AT + 4) > stringsSize_) {
+        error = "dictionary out of bounds";
+        return false;
+    }
+    dictionary_ = str(data_ + DICTIONARY_AT);
+
+    // Every string reference and enum once, so accessors need no checks
+    auto refsOk = [&](const uint8_t* rec, const size_t* refs, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            uint64_t offset = readU32(rec + refs[i]);
+            uint64_t length = readU32(rec + refs[i] + 4);
+            if (offset + length > stringsSize_) return false;
+        }
+        return true;
+    };
+    const char* kindNames[] = {"lesson", "test", "exercise", "game"};
+    for (int kind = 0; kind < KINDS; ++kind) {
+        for (size_t i = 0; i < counts_[kind]; ++i) {
+            const uint8_t* rec = record(static_cast<Kind>(kind), i);
+            bool ok;
+            switch (kind) {
+                case LESSONS:
+                    // Text stored as is must be as long as the text
+                    ok = refsOk(rec, LESSON_REFS, 6) && readU32(rec + 48) < TOPICS && readU32(rec + 52) < LEVELS &&
+                         (readU32(rec + 68) == TEXT_DEFLATED ||
+                          (readU32(rec + 68) == 0 && readU32(rec + 28) == readU32(rec + 60)));
+                    break;
+                case TESTS:
+                    ok = refsOk(rec, TEST_REFS, 4) && readU32(rec + 32) < LEVELS && readU32(rec + 36) < TOPICS;
+                    break;
+                case EXERCISES:
+                    ok = refsOk(rec, EXERCISE_REFS, 4) && readU32(rec + 32) < EXERCISE_TYPES &&
+                         readU32(rec + 36) < LEVELS && readU32(rec + 40) < TOPICS;
+                    break;
+                default:
+                    ok = refsOk(rec, GAME_REFS, 5) && readU32(rec + 40) < GAME_TYPES && readU32(rec + 44) < LEVELS;
+                    break;
+            }
+            // Ids sorted and unique, for binary search
+            if (ok) ok = !str(rec).empty() && (i == 0 || str(record(static_cast<Kind>(kind), i - 1)) < str(rec));
+            if (!ok) {
+                error = "corrupt " + std::string(kindNames[kind]) + " record " + std::to_string(i);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+const uint8_t* ContentPack::record(Kind kind, size_t index) const {
+    return tables_[kind] + index * RECORD_BYTES[kind];
+}
+
+std::string_view ContentPack::str(const uint8_t* ref) const {
+    return std::string_view(reinterpret_cast<const char*>(strings_) + readU32(ref), readU32(ref + 4));
+}
+
+ContentPack::LessonView ContentPack::lesson(size_t index) const {
+    const uint8_t* rec = record(LESSONS, index);
+    return LessonView{str(rec), str(rec + 8), str(rec + 16), str(rec + 24), str(rec + 32), str(rec + 40),
+                      static_cast<core::Topic>(readU32(rec + 48)), static_cast<core::Level>(readU32(rec + 52)),
+                      static_cast<int>(readU32(rec + 56)), readU32(rec + 60), readU32(rec + 64),
+                      readU32(rec + 68) == TEXT_DEFLATED};
+}
+
+ContentPack::Text ContentPack::inflateText(const LessonView& lesson) const {
+    if (!lesson.textDeflated) return std::make_shared<const std::string>(lesson.storedText);
+
+    std::string text(lesson.textBytes, '\0');
+    z_stream z{};
+    bool ok = ::inflateInit2(&z, -MAX_WBITS) == Z_OK;
+    if (ok) {
+        ok = dictionary_.empty() ||
+             ::inflateSetDictionary(&z, reinterpret_cast<const Bytef*>(dictionary_.data()),
+                                    static_cast<uInt>(dictionary_.size())) == Z_OK;
+        z.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(lesson.storedText.data()));
+        z.avail_in = static_cast<uInt>(lesson.storedText.size());
+        z.next_out = reinterpret_cast<Bytef*>(&text[0]);
+        z.avail_out = static_cast<uInt>(text.size());
+        ok = ok && ::inflate(&z, Z_FINISH) == Z_STREAM_END && z.total_out == lesson.textBytes;
+        ::inflateEnd(&z);
+    }
+    if (!ok || textCrc(text) != lesson.textCrc) {
+        std::cerr << "[WARN] Content pack: corrupt text of lesson " << lesson.lessonId << " in " << path_
+                  << std::endl;
+        return nullptr;
+    }
+    return std::make_shared<const std::string>(std::move(text));
+}
+
+ContentPack::Text ContentPack::lessonText(const LessonView& lesson, bool cache) const {
+    if (!cache || !lesson.textDeflated) return inflateText(lesson);
+
+    const char* key = lesson.storedText.data();
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex_);
+        auto hit = cacheIndex_.find(key);
+        if (hit != cacheIndex_.end()) {
+            cache_.splice(cache_.begin(), cache_, hit->second);
+            return hit->second->second;
+        }
+    }
+
+    // Inflate unlocked; if another reader raced us here, keep its copy
+    Text text = inflateText(lesson);
+    if (!text) return nullptr;
+    std::lock_guard<std::mutex> lock(cacheMutex_);
+    auto hit = cacheIndex_.find(key);
+    if (hit != cacheIndex_.end()) return hit->second->second;
+    cache_.emplace_front(key, text);
+    cacheIndex_[key] = cache_.begin();
+    cacheBytes_ += text->size();
+    while (cacheBytes_ > TEXT_CACHE_BYTES && cache_.size() > 1) {
+        cacheBytes_ -= cache_.back().second->size();
+        cacheIndex_.erase(cache_.back().first);
+        cache_.pop_back();
+    }
+    return text;
+}
+
+std::optional<ContentPack::LessonView> ContentPack::findLesson(std::string_view lessonId) const {
+    size_t lo = 0, hi = counts_[LESSONS];
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        std::string_view id = str(record(LESSONS, mid));
+        if (id == lessonId) return lesson(mid);
+        if (id < lessonId) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<core::Test> ContentPack::test(size_t index) const {
+    const uint8_t* rec = record(TESTS, index);
+    core::Test test(std::string(str(rec)), std::string(str(rec + 16)), static_cast<core::Level>(readU32(rec + 32)),
+                    static_cast<core::Topic>(readU32(rec + 36)), std::string(str(rec + 8)));
+
+    Reader in = blobReader(str(rec + 24));
+    uint32_t count = in.u32();
+    for (uint32_t i = 0; i < count && in.ok; ++i) {
+        core::TestQuestion q;
+        q.questionId = in.str();
+        uint8_t type = in.u8();
+        if (type >= QUESTION_TYPES) return std::nullopt;
+        q.type = static_cast<core::QuestionType>(type);
+        q.question = in.str();
+        q.correctAnswer = in.str();
+        q.points = static_cast<int>(in.u32());
+        q.options = readStrings(in);
+        q.words = readStrings(in);
+        test.questions.push_back(std::move(q));
+    }
+    if (!in.ok) return std::nullopt;
+    return test;
+}
+
+std::optional<core::Exercise> ContentPack::exercise(size_t index) const {
+    const uint8_t* rec = record(EXERCISES, index);
+    core::Exercise exercise(std::string(str(rec)), static_cast<core::ExerciseType>(readU32(rec + 32)),
+                            std::string(str(rec + 8)), std::string(str(rec + 16)),
+                            static_cast<core::Level>(readU32(rec + 36)), static_cast<int>(readU32(rec + 44)));
+    exercise.topic = static_cast<core::Topic>(readU32(rec + 40));
+
+    Reader in = blobReader(str(rec + 24));
+    exercise.instructions = in.str();
+    exercise.topicDescription = in.str();
+    exercise.rubric = in.str();
+    exercise.createdBy = in.str();
+    exercise.minWordCount = static_cast<int>(in.u32());
+    exercise.maxWordCount = static_cast<int>(in.u32());
+    exercise.prompts = readStrings(in);
+    exercise.requirements = readStrings(in);
+    if (!in.ok) return std::nullopt;
+    return exercise;
+}
+
+std::optional<core::Game> ContentPack::game(size_t index) const {
+    const uint8_t* rec = record(GAMES, index);
+    core::Game game(std::string(str(rec)), static_cast<core::GameType>(readU32(rec + 40)), std::string(str(rec + 8)),
+                    std::string(str(rec + 16)), static_cast<core::Level>(readU32(rec + 44)),
+                    static_cast<int>(readU32(rec + 48)), static_cast<int>(readU32(rec + 52)));
+    game.topic = std::string(str(rec + 24));
+
+    Reader in = blobReader(str(rec + 32));
+    game.pairs = readPairs(in);
+    game.sentencePairs = readPairs(in);
+    game.picturePairs = readPairs(in);
+    uint32_t count = in.u32();
+    for (uint32_t i = 0; i < count && in.ok; ++i) {
+        core::PicturePair item;
+        item.word = in.str();
+        item.imageSource = in.str();
+        uint8_t type = in.u8();
+        if (type >= IMAGE_SOURCE_TYPES) return std::nullopt;
+        item.sourceType = static_cast<core::ImageSourceType>(type);
+        game.pictureItems.push_back(std::move(item));
+    }
+    if (!in.ok) return std::nullopt;
+    return game;
+}
+
+// ---- ContentPackWriter ----
+
+uint32_t ContentPackWriter::intern(const std::string& s) {
+    auto it = interned_.find(s);
+    if (it == interned_.end()) {
+        it = interned_.emplace(s, static_cast<uint32_t>(strings_.size())).first;
+        strings_ += s;
+    }
+    return it->second;
+}
+
+void ContentPackWriter::putRef(std::string& out, const std::string& s) {
+    putU32(out, intern(s));
+    putU32(out, static_cast<uint32_t>(s.size()));
+}
+
+bool ContentPackWriter::write(const std::string& path, std::string& error) {
+    if (!sortById(lessons_, [](const core::Lesson& l) -> const std::string& { return l.lessonId; }, "lesson", error) ||
+        !sortById(tests_, [](const core::Test& t) -> const std::string& { return t.testId; }, "test", error) ||
+        !sortById(exercises_, [](const core::Exercise& e) -> const std::string& { return e.exerciseId; },
+                  "exercise", error) ||
+        !sortById(games_, [](const core::Game& g) -> const std::string& { return g.gameId; }, "game", error)) {
+        return false;
+    }
+
+    strings_.clear();
+    interned_.clear();
+
+    // Short strings first, so ids and titles share pages and loading or
+    // listing the catalog never faults in lesson text or blobs
+    for (const core::Lesson& lesson : lessons_) {
+        for (const std::string* s : {&lesson.lessonId, &lesson.title, &lesson.description, &lesson.videoUrl,
+                                     &lesson.audioUrl}) {
+            intern(*s);
+        }
+    }
+    for (const core::Test& test : tests_) {
+        for (const std::string* s : {&test.testId, &test.title, &test.testType.str()}) intern(*s);
+    }
+    for (const core::Exercise& exercise : exercises_) {
+        for (const std::string* s : {&exercise.exerciseId, &exercise.title, &exercise.description}) intern(*s);
+    }
+    for (const core::Game& game : games_) {
+        for (const std::string* s : {&game.gameId, &game.title, &game.description, &game.topic.str()}) intern(*s);
+    }
+
+    // Then the dictionary, read by the first lesson text inflated
+    std::string dictionary = trainDictionary(lessons_, DICTIONARY_BYTES);
+    uint32_t dictionaryAt = intern(dictionary);
+    textBytes_ = 0;
+    storedTextBytes_ = dictionary.size();
+
+    z_stream z{};
+    if (::deflateInit2(&z, Z_BEST_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 9, Z_DEFAULT_STRATEGY) != Z_OK) {
+        error = "cannot initialise deflate";
+        return false;
+    }
+    std::string tables[4];
+    std::string deflated;
+
+    for (const core::Lesson& lesson : lessons_) {
+        // Each text a block of its own, so one can be inflated alone; kept
+        // as is when deflate does not make it smaller
+        const std::string& text = lesson.textContent;
+        bool compress = text.size() >= MIN_DEFLATE_BYTES;
+        if (compress) {
+            deflated.resize(::deflateBound(&z, static_cast<uLong>(text.size())));
+            ::deflateReset(&z);
+            if (!dictionary.empty()) {
+                ::deflateSetDictionary(&z, reinterpret_cast<const Bytef*>(dictionary.data()),
+                                       static_cast<uInt>(dictionary.size()));
+            }
+            z.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(text.data()));
+            z.avail_in = static_cast<uInt>(text.size());
+            z.next_out = reinterpret_cast<Bytef*>(&deflated[0]);
+            z.avail_out = static_cast<uInt>(deflated.size());
+            compress = ::deflate(&z, Z_FINISH) == Z_STREAM_END && z.total_out < text.size();
+            deflated.resize(z.total_out);
+        }
+        const std::string& stored = compress ? deflated : text;
+        textBytes_ += text.size();
+        storedTextBytes_ += stored.size();
+
+        std::string& out = tables[0];
+        putRef(out, lesson.lessonId);
+        putRef(out, lesson.title);
+        putRef(out, lesson.description);
+        putRef(out, stored);
+        putRef(out, lesson.videoUrl);
+        putRef(out, lesson.audioUrl);
+        putU32(out, static_cast<uint32_t>(lesson.topic));
+        putU32(out, static_cast<uint32_t>(lesson.level));
+        putU32(out, static_cast<uint32_t>(lesson.duration));
+        putU32(out, static_cast<uint32_t>(text.size()));
+        putU32(out, ContentPack::textCrc(text));
+        putU32(out, compress ? TEXT_DEFLATED : 0);
+    }
+    ::deflateEnd(&z);
+
+    for (const core::Test& test : tests_) {
+        std::string blob;
+        putU32(blob, static_cast<uint32_t>(test.questions.size()));
+        for (const core::TestQuestion& q : test.questions) {
+            putString(blob, q.questionId);
+            blob.push_back(static_cast<char>(q.type));
+            putString(blob, q.question);
+            putString(blob, q.correctAnswer);
+            putU32(blob, static_cast<uint32_t>(q.points));
+            putStrings(blob, q.options);
+            putStrings(blob, q.words);
+        }
+        std::string& out = tables[1];
+        putRef(out, test.testId);
+        putRef(out, test.title);
+        putRef(out, test.testType.str());
+        putRef(out, blob);
+        putU32(out, static_cast<uint32_t>(test.level));
+        putU32(out, static_cast<uint32_t>(test.topic));
+    }
+
+    for (const core::Exercise& exercise : exercises_) {
+        std::string blob;
+        putString(blob, exercise.instructions);
+        putString(blob, exercise.topicDescription);
+        putString(blob, exercise.rubric);
+        putString(blob, exercise.createdBy);
+        putU32(blob, static_cast<uint32_t>(exercise.minWordCount));
+        putU32(blob, static_cast<uint32_t>(exercise.maxWordCount));
+        putStrings(blob, exercise.prompts);
+        putStrings(blob, exercise.requirements);
+        std::string& out = tables[2];
+        putRef(out, exercise.exerciseId);
+        putRef(out, exercise.title);
+        putRef(out, exercise.description);
+        putRef(out, blob);
+        putU32(out, static_cast<uint32_t>(exercise.exerciseType));
+        putU32(out, static_cast<uint32_t>(exercise.level));
+        putU32(out, static_cast<uint32_t>(exercise.topic));
+        putU32(out, static_cast<uint32_t>(exercise.duration));
+    }
+
+    for (const core::Game& game : games_) {
+        std::string blob;
+        putPairs(blob, game.pairs);
+        putPairs(blob, game.sentencePairs);
+        putPairs(blob, game.picturePairs);
+        putU32(blob, static_cast<uint32_t>(game.pictureItems.size()));
+        for (const core::PicturePair& item : game.pictureItems) {
+            putString(blob, item.word);
+            putString(blob, item.imageSource);
+            blob.push_back(static_cast<char>(item.sourceType));
+        }
+        std::string& out = tables[3];
+        putRef(out, game.gameId);
+        putRef(out, game.title);
+        putRef(out, game.description);
+        putRef(out, game.topic.str());
+        putRef(out, blob);
+        putU32(out, static_cast<uint32_t>(game.gameType));
+        putU32(out, static_cast<uint32_t>(game.level));
+        putU32(out, static_cast<uint32_t>(game.timeLimit));
+        putU32(out, static_cast<uint32_t>(game.maxScore));
+    }
+
+    if (strings_.size() > UINT32_MAX) {
+        error = "string table exceeds 4 GiB";
+        return false;
+    }
+
+    std::string header(MAGIC, sizeof(MAGIC));
+    putU32(header, ContentPack::VERSION);
+    putU32(header, 0);   // CRC, filled in below
+    size_t counts[] = {lessons_.size(), tests_.size(), exercises_.size(), games_.size()};
+    for (size_t count : counts) putU32(header, static_cast<uint32_t>(count));
+    uint64_t offset = HEADER_BYTES;
+    for (const std::string& table : tables) {
+        putU64(header, offset);
+        offset += table.size();
+    }
+    putU64(header, offset);
+    putU64(header, strings_.size());
+    putU64(header, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                       std::chrono::system_clock::now().time_since_epoch()).count()));
+    putU32(header, dictionaryAt);
+    putU32(header, static_cast<uint32_t>(dictionary.size()));
+    header.resize(HEADER_BYTES, '\0');
+
+    std::string body = header + tables[0] + tables[1] + tables[2] + tables[3];
+    uint32_t crc = tableCrc(reinterpret_cast<const uint8_t*>(body.data()), body.size());
+    std::string crcBytes;
+    putU32(crcBytes, crc);
+    body.replace(CRC_AT, 4, crcBytes);
+
+    std::string temp = path + ".tmp";
+    int fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        error = temp + ": " + std::strerror(errno);
+        return false;
+    }
+    bool ok = writeAll(fd, body) && writeAll(fd, strings_) && ::fsync(fd) == 0;
+    int savedErrno = errno;
+    ::close(fd);
+    if (!ok || ::rename(temp.c_str(), path.c_str()) != 0) {
+        error = path + ": " + std::strerror(ok ? errno : savedErrno);
+        ::unlink(temp.c_str());
+        return false;
+    }
+    size_t slash = path.rfind('/');
+    syncDirectory(slash == std::string::npos ? "." : path.substr(0, slash));
+    return true;
+}
+
+} // namespace storage
+} // namespace english_learning
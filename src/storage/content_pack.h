@@ -0,0 +1,186 @@
+#ifndef ENGLISH_LEARNING_STORAGE_CONTENT_PACK_H
+#define ENGLISH_LEARNING_STORAGE_CONTENT_PACK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "include/core/lesson.h"
+#include "include/core/test.h"
+#include "include/core/exercise.h"
+#include "include/core/game.h"
+
+namespace english_learning {
+namespace storage {
+
+/**
+ * Read-only, memory-mapped catalog of lessons, tests, exercises and games.
+ *
+ * Packs are compiled offline by tools/content_packer.cpp (ContentPackWriter)
+ * and laid out as
+ *
+ *   header    magic, version, record count and table offset of each kind,
+ *             string table offset and size, CRC-32 of header and tables,
+ *             reference to the lesson text dictionary
+ *   tables    one per kind, fixed-size records sorted by id
+ *   strings   every string a record refers to, as (offset, length)
+ *
+ * open() maps the file and validates the header and every record once, so
+ * later accesses need no checks. Lessons are exposed as views pointing
+ * straight into the mapping. Tests, exercises and games keep their nested
+ * lists in an encoded blob that is decoded on access.
+ *
+ * Lesson text, the bulk of a pack, is stored as one raw deflate block per
+ * lesson, compressed against a preset dictionary that the writer trains on
+ * the pack's own lessons (text too short to gain is stored as is). It is
+ * only inflated when a lesson is read in full, through lessonText(), which
+ * keeps recently inflated text in a small LRU cache. Loading and listing the
+ * catalog never touch it. The pack is immutable once opened apart from that
+ * cache, and any number of threads may read it.
+ */
+class ContentPack {
+public:
+    static constexpr uint32_t VERSION = 2;
+    // Inflated lesson text kept per pack, by bytes
+    static constexpr size_t TEXT_CACHE_BYTES = 4 * 1024 * 1024;
+
+    struct LessonView {
+        std::string_view lessonId;
+        std::string_view title;
+        std::string_view description;
+        std::string_view storedText;    // deflated if textDeflated, else the text itself
+        std::string_view videoUrl;
+        std::string_view audioUrl;
+        core::Topic topic;
+        core::Level level;
+        int duration;
+        uint32_t textBytes;             // length of the text once inflated
+        uint32_t textCrc;               // CRC-32 of the inflated text
+        bool textDeflated;
+
+        // Everything but textContent, which stays in the pack
+        core::Lesson metadata() const;
+    };
+
+    using Text = std::shared_ptr<const std::string>;
+
+    ContentPack() = default;
+    ~ContentPack();
+
+    ContentPack(const ContentPack&) = delete;
+    ContentPack& operator=(const ContentPack&) = delete;
+
+    // Map and validate the pack; false with a reason in error if it is unusable
+    bool open(const std::string& path, std::string& error);
+
+    const std::string& path() const { return path_; }
+    uint64_t builtAt() const { return builtAt_; }
+
+    size_t lessonCount() const { return counts_[LESSONS]; }
+    LessonView lesson(size_t index) const;
+    std::optional<LessonView> findLesson(std::string_view lessonId) const;
+
+    /**
+     * A lesson's text, inflated. With cache, recently read text is served
+     * from (and kept in) the LRU cache; bulk readers that touch every lesson
+     * pass false so as not to evict the text of lessons being studied.
+     * Null, with a warning logged, if the stored text is corrupt.
+     */
+    Text lessonText(const LessonView& lesson, bool cache = true) const;
+
+    // CRC-32 a lesson's text is stored with
+    static uint32_t textCrc(std::string_view text);
+
+    // Decoded records; nullopt if the record's blob is corrupt
+    size_t testCount() const { return counts_[TESTS]; }
+    std::optional<core::Test> test(size_t index) const;
+
+    size_t exerciseCount() const { return counts_[EXERCISES]; }
+    std::optional<core::Exercise> exercise(size_t index) const;
+
+    size_t gameCount() const { return counts_[GAMES]; }
+    std::optional<core::Game> game(size_t index) const;
+
+private:
+    enum Kind { LESSONS, TESTS, EXERCISES, GAMES, KINDS };
+
+    const uint8_t* record(Kind kind, size_t index) const;
+    std::string_view str(const uint8_t* ref) const;
+    // Locate the tables and check every record; sets the members above
+    bool validate(std::string& error);
+    void unmap();
+
+    // Inflate and verify stored text; null if corrupt. No caching
+    Text inflateText(const LessonView& lesson) const;
+
+    std::string path_;
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    const uint8_t* strings_ = nullptr;
+    uint64_t stringsSize_ = 0;
+    uint64_t builtAt_ = 0;
+    uint32_t counts_[KINDS] = {};
+    const uint8_t* tables_[KINDS] = {};
+    std::string_view dictionary_;       // preset dictionary of every deflated lesson text
+
+    // Stored text (its address in the mapping) -> inflated text, most recently used first
+    mutable std::mutex cacheMutex_;
+    mutable std::list<std::pair<const char*, Text>> cache_;
+    mutable std::unordered_map<const char*, std::list<std::pair<const char*, Text>>::iterator> cacheIndex_;
+    mutable size_t cacheBytes_ = 0;
+};
+
+/**
+ * Builds a content pack. Records are collected in memory, sorted by id and
+ * written with identical strings stored once. Lesson text is deflated
+ * against a dictionary trained on the lessons being written.
+ */
+class ContentPackWriter {
+public:
+    // Largest preset dictionary; deflate cannot look further back than this
+    static constexpr size_t DICTIONARY_BYTES = 32 * 1024;
+
+    void add(const core::Lesson& lesson) { lessons_.push_back(lesson); }
+    void add(const core::Test& test) { tests_.push_back(test); }
+    void add(const core::Exercise& exercise) { exercises_.push_back(exercise); }
+    void add(const core::Game& game) { games_.push_back(game); }
+
+    /**
+     * Write the pack to path through a temporary file and rename. Fails,
+     * leaving path untouched, on duplicate or empty ids or an I/O error.
+     */
+    bool write(const std::string& path, std::string& error);
+
+    // Lesson text written by the last write(), before and after compression
+    // (the dictionary included)
+    size_t textBytes() const { return textBytes_; }
+    size_t storedTextBytes() const { return storedTextBytes_; }
+
+private:
+    // Offset of s in the string table, appending it the first time
+    uint32_t intern(const std::string& s);
+
+    // Append the (offset, length) reference of s to out
+    void putRef(std::string& out, const std::string& s);
+
+    std::vector<core::Lesson> lessons_;
+    std::vector<core::Test> tests_;
+    std::vector<core::Exercise> exercises_;
+    std::vector<core::Game> games_;
+
+    std::string strings_;
+    std::unordered_map<std::string, uint32_t> interned_;   // string -> offset in strings_
+    size_t textBytes_ = 0;
+    size_t storedTextBytes_ = 0;
+};
+
+} // namespace storage
+} // namespace english_learning
+
+#endif // ENGLISH_LEARNING_STORAGE_CONTENT_PACK_H
@@ -0,0 +1,135 @@
+#include "progress_log.h"
+
+#include <cstdio>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "codec.h"
+
+namespace english_learning {
+namespace storage {
+
+using repository::memory::LessonProgress;
+using repository::memory::ProgressStore;
+
+namespace {
+
+constexpr size_t HEADER_BYTES = 8;              // payload length + CRC
+constexpr size_t COMPACT_MIN_RECORDS = 4096;    // don't bother below this
+
+void putRecord(std::string& out, const ProgressStore::Change& change) {
+    std::string payload;
+    putString(payload, change.userId);
+    putString(payload, change.lessonId);
+    payload += static_cast<char>(change.progress.percent);
+    putU32(payload, change.progress.position);
+    putU64(payload, static_cast<uint64_t>(change.progress.completedAt));
+    putU64(payload, static_cast<uint64_t>(change.progress.updatedAt));
+    putU32(out, static_cast<uint32_t>(payload.size()));
+    putU32(out, crc32(reinterpret_cast<const uint8_t*>(payload.data()), payload.size()));
+    out += payload;
+}
+
+} // namespace
+
+ProgressLog::ProgressLog(std::string directory) : directory_(std::move(directory)) {}
+
+ProgressLog::~ProgressLog() {
+    if (fd_ >= 0) ::close(fd_);
+}
+
+std::string ProgressLog::path() const {
+    return directory_ + "/progress.log";
+}
+
+size_t ProgressLog::open(ProgressStore& store) {
+    makeDirectories(directory_);
+    fd_ = ::open(path().c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        std::cerr << "[WARN] Progress log: cannot open " << path() << std::endl;
+        return 0;
+    }
+
+    struct stat st;
+    size_t size = ::fstat(fd_, &st) == 0 ? static_cast<size_t>(st.st_size) : 0;
+    std::string data(size, '\0');
+    size_t got = 0;
+    while (got < size) {
+        ssize_t n = ::pread(fd_, &data[got], size - got, static_cast<off_t>(got));
+        if (n <= 0) break;
+        got += static_cast<size_t>(n);
+    }
+
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data.data());
+    size_t offset = 0;
+    while (offset + HEADER_BYTES <= got) {
+        uint32_t length = readU32(bytes + offset);
+        uint32_t crc = readU32(bytes + offset + 4);
+        if (length == 0 || length > got - offset - HEADER_BYTES) break;
+        const uint8_t* payload = bytes + offset + HEADER_BYTES;
+        if (crc32(payload, length) != crc) break;
+
+        Reader in{payload, length};
+        std::string userId = in.str();
+        std::string lessonId = in.str();
+        LessonProgress progress;
+        progress.percent = in.u8();
+        progress.position = in.u32();
+        progress.completedAt = static_cast<int64_t>(in.u64());
+        progress.updatedAt = static_cast<int64_t>(in.u64());
+        if (in.ok && progress.started()) store.restore(userId, lessonId, progress);
+        records_++;
+        offset += HEADER_BYTES + length;
+    }
+
+    if (offset < size) {
+        // Torn tail from a crash mid-write: drop it so appends resume cleanly
+        std::cerr << "[WARN] Progress log: discarding " << (size - offset)
+                  << " bytes of incomplete records in " << path() << std::endl;
+        if (::ftruncate(fd_, static_cast<off_t>(offset)) != 0) {
+            std::cerr << "[WARN] Progress log: cannot truncate " << path() << std::endl;
+        }
+    }
+    return records_;
+}
+
+bool ProgressLog::append(const Changes& changes) {
+    if (changes.empty()) return true;
+    if (fd_ < 0) return false;
+    std::string batch;
+    for (const auto& change : changes) putRecord(batch, change);
+    if (!writeAll(fd_, batch) || ::fdatasync(fd_) != 0) return false;
+    records_ += changes.size();
+    return true;
+}
+
+bool ProgressLog::needsCompaction(size_t live) const {
+    return records_ >= COMPACT_MIN_RECORDS && records_ > 2 * live;
+}
+
+bool ProgressLog::rewrite(const Changes& all) {
+    std::string out;
+    for (const auto& change : all) putRecord(out, change);
+
+    std::string tmp = path() + ".tmp";
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    bool ok = fd >= 0 && writeAll(fd, out) && ::fdatasync(fd) == 0;
+    if (fd >= 0) ::close(fd);
+    if (!ok || ::rename(tmp.c_str(), path().c_str()) != 0) {
+        ::unlink(tmp.c_str());
+        return false;
+    }
+    syncDirectory(directory_);
+
+    // Later appends go to the new file
+    int fresh = ::open(path().c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+    if (fresh < 0) return false;
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = fresh;
+    records_ = all.size();
+    return true;
+}
+
+} // namespace storage
+} // namespace english_learning
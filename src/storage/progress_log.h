@@ -0,0 +1,59 @@
+#ifndef ENGLISH_LEARNING_STORAGE_PROGRESS_LOG_H
+#define ENGLISH_LEARNING_STORAGE_PROGRESS_LOG_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "src/repository/memory/progress_store.h"
+
+namespace english_learning {
+namespace storage {
+
+/**
+ * On-disk copy of the lesson progress store.
+ *
+ * progress.log is a sequence of records
+ *   [u32 payload length][u32 CRC-32 of payload][payload]
+ * each holding one (user, lesson) progress as it stood when written; a later
+ * record for the same pair replaces an earlier one. The server appends the
+ * store's dirty entries every few seconds, one write and one fdatasync per
+ * batch, and rewrites the file from a snapshot once it is mostly
+ * superseded records. Replay stops at the first torn or corrupt record.
+ *
+ * Not synchronized: open() runs before the flusher starts, and after that
+ * only the flusher uses the log.
+ */
+class ProgressLog {
+public:
+    using Changes = std::vector<repository::memory::ProgressStore::Change>;
+
+    explicit ProgressLog(std::string directory);
+    ~ProgressLog();
+
+    ProgressLog(const ProgressLog&) = delete;
+    ProgressLog& operator=(const ProgressLog&) = delete;
+
+    // Load the log into store; returns the number of records applied
+    size_t open(repository::memory::ProgressStore& store);
+
+    // Append changes durably; false if they could not be written
+    bool append(const Changes& changes);
+
+    // True once most records are superseded, given live entries in the store
+    bool needsCompaction(size_t live) const;
+
+    // Replace the log with exactly the entries in all
+    bool rewrite(const Changes& all);
+
+private:
+    std::string path() const;
+
+    std::string directory_;
+    int fd_ = -1;
+    size_t records_ = 0;   // records in the file
+};
+
+} // namespace storage
+} // namespace english_learning
+
+#endif // ENGLISH_LEARNING_STORAGE_PROGRESS_LOG_H
@@ -0,0 +1,267 @@
+/**
+ * ============================================================================
+ * ENGLISH LEARNING APP - CONTENT PACKER
+ * ============================================================================
+ * Biên dịch nội dung học (lessons, tests, exercises, games) thành content pack
+ * mà server mmap khi khởi động (xem src/storage/content_pack.h).
+ *
+ * Source layout:
+ *   <source>/lessons/<id>.md      front matter (key: value lines between
+ *                                 "---" markers), then the lesson text
+ *   <source>/tests/<id>.json      one test per file
+ *   <source>/exercises/<id>.json  one exercise per file
+ *   <source>/games/<id>.json      one game per file
+ *
+ * Run: ./content_packer <source-dir> <output.pack>
+ * ============================================================================
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <dirent.h>
+
+#include "include/core/all.h"
+#include "include/protocol/json_parser.h"
+#include "src/storage/content_pack.h"
+
+using namespace english_learning;
+using protocol::getJsonArray;
+using protocol::getJsonValue;
+using protocol::parseJsonArray;
+using protocol::unescapeJson;
+
+namespace {
+
+// Source files of one kind, sorted so packs are reproducible
+std::vector<std::string> listFiles(const std::string& dir, const std::string& extension) {
+    std::vector<std::string> files;
+    if (DIR* d = ::opendir(dir.c_str())) {
+        while (dirent* entry = ::readdir(d)) {
+            std::string name = entry->d_name;
+            if (name.size() > extension.size() &&
+                name.compare(name.size() - extension.size(), extension.size(), extension) == 0) {
+                files.push_back(dir + "/" + name);
+            }
+        }
+        ::closedir(d);
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+std::string readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error("cannot read file");
+    std::ostringstream content;
+    content << in.rdbuf();
+    return content.str();
+}
+
+std::string text(const std::string& json, const std::string& key) {
+    return unescapeJson(getJsonValue(json, key));
+}
+
+std::string required(const std::string& json, const std::string& key) {
+    std::string value = text(json, key);
+    if (value.empty()) throw std::runtime_error("missing \"" + key + "\"");
+    return value;
+}
+
+int number(const std::string& value, const std::string& key, int fallback = 0) {
+    if (value.empty()) return fallback;
+    try {
+        size_t used = 0;
+        int n = std::stoi(value, &used);
+        if (used == value.size() && n >= 0) return n;
+    } catch (const std::exception&) {
+    }
+    throw std::runtime_error("\"" + key + "\" is not a non-negative integer");
+}
+
+std::vector<std::string> strings(const std::string& json, const std::string& key) {
+    std::vector<std::string> list;
+    for (const std::string& item : parseJsonArray(getJsonArray(json, key))) list.push_back(unescapeJson(item));
+    return list;
+}
+
+std::vector<std::pair<std::string, std::string>> pairs(const std::string& json, const std::string& key) {
+    std::vector<std::pair<std::string, std::string>> list;
+    for (const std::string& item : parseJsonArray(getJsonArray(json, key))) {
+        list.emplace_back(required(item, "left"), required(item, "right"));
+    }
+    return list;
+}
+
+core::Level level(const std::string& value) {
+    core::Level out;
+    if (!core::parseLevel(value, out)) throw std::runtime_error("unknown level \"" + value + "\"");
+    return out;
+}
+
+core::Topic topic(const std::string& value) {
+    core::Topic out;
+    if (!core::parseTopic(value, out)) throw std::runtime_error("unknown topic \"" + value + "\"");
+    return out;
+}
+
+core::QuestionType questionType(const std::string& value) {
+    if (value != "multiple_choice" && value != "fill_blank" && value != "sentence_order") {
+        throw std::runtime_error("unknown question type \"" + value + "\"");
+    }
+    return core::stringToQuestionType(value);
+}
+
+core::ImageSourceType imageSourceType(const std::string& value) {
+    if (value.empty() || value == "local_file") return core::ImageSourceType::LocalFile;
+    if (value == "remote_url") return core::ImageSourceType::RemoteUrl;
+    if (value == "embedded") return core::ImageSourceType::Embedded;
+    throw std::runtime_error("unknown image source type \"" + value + "\"");
+}
+
+core::Lesson parseLesson(const std::string& source) {
+    // Front matter: "---", key: value lines, "---"; the rest is the text
+    size_t pos = 0;
+    auto nextLine = [&](std::string& line) {
+        if (pos >= source.size()) return false;
+        size_t end = source.find('\n', pos);
+        if (end == std::string::npos) end = source.size();
+        line = source.substr(pos, end - pos);
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        pos = std::min(end + 1, source.size());
+        return true;
+    };
+
+    std::string line;
+    if (!nextLine(line) || line != "---") throw std::runtime_error("missing front matter");
+    std::map<std::string, std::string> fields;
+    for (;;) {
+        if (!nextLine(line)) throw std::runtime_error("unterminated front matter");
+        if (line == "---") break;
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) throw std::runtime_error("bad front matter line \"" + line + "\"");
+        size_t start = line.find_first_not_of(' ', colon + 1);
+        fields[line.substr(0, colon)] = start == std::string::npos ? "" : line.substr(start);
+    }
+
+    auto field = [&](const std::string& key) {
+        auto it = fields.find(key);
+        if (it == fields.end() || it->second.empty()) throw std::runtime_error("missing \"" + key + "\"");
+        return it->second;
+    };
+    core::Lesson lesson(field("lessonId"), field("title"), fields["description"], topic(field("topic")),
+                        level(field("level")), number(fields["duration"], "duration"));
+    lesson.videoUrl = fields["videoUrl"];
+    lesson.audioUrl = fields["audioUrl"];
+    lesson.textContent = source.substr(pos);
+    return lesson;
+}
+
+core::Test parseTest(const std::string& json) {
+    core::Test test(required(json, "testId"), text(json, "testType"), level(required(json, "level")),
+                    topic(required(json, "topic")), required(json, "title"));
+    for (const std::string& item : parseJsonArray(getJsonArray(json, "questions"))) {
+        core::TestQuestion q(required(item, "questionId"), questionType(required(item, "type")),
+                             required(item, "question"), required(item, "correctAnswer"),
+                             number(getJsonValue(item, "points"), "points", 10));
+        q.options = strings(item, "options");
+        q.words = strings(item, "words");
+        test.addQuestion(q);
+    }
+    if (test.questions.empty()) throw std::runtime_error("test has no questions");
+    return test;
+}
+
+core::Exercise parseExercise(const std::string& json) {
+    core::ExerciseType type;
+    std::string typeName = required(json, "exerciseType");
+    if (!core::parseExerciseType(typeName, type)) throw std::runtime_error("unknown exercise type \"" + typeName + "\"");
+
+    core::Exercise exercise(required(json, "exerciseId"), type, required(json, "title"), text(json, "description"),
+                            level(required(json, "level")), number(getJsonValue(json, "duration"), "duration"));
+    exercise.topic = topic(required(json, "topic"));
+    exercise.instructions = text(json, "instructions");
+    exercise.topicDescription = text(json, "topicDescription");
+    exercise.rubric = text(json, "rubric");
+    exercise.createdBy = text(json, "createdBy");
+    exercise.minWordCount = number(getJsonValue(json, "minWordCount"), "minWordCount");
+    exercise.maxWordCount = number(getJsonValue(json, "maxWordCount"), "maxWordCount");
+    exercise.prompts = strings(json, "prompts");
+    exercise.requirements = strings(json, "requirements");
+    return exercise;
+}
+
+core::Game parseGame(const std::string& json) {
+    core::GameType type;
+    std::string typeName = required(json, "gameType");
+    if (!core::parseGameType(typeName, type)) throw std::runtime_error("unknown game type \"" + typeName + "\"");
+
+    core::Game game(required(json, "gameId"), type, required(json, "title"), text(json, "description"),
+                    level(required(json, "level")), number(getJsonValue(json, "timeLimit"), "timeLimit", 60),
+                    number(getJsonValue(json, "maxScore"), "maxScore", 100));
+    game.topic = text(json, "topic");
+    game.pairs = pairs(json, "pairs");
+    game.sentencePairs = pairs(json, "sentencePairs");
+    game.picturePairs = pairs(json, "picturePairs");
+    for (const std::string& item : parseJsonArray(getJsonArray(json, "pictureItems"))) {
+        game.pictureItems.emplace_back(required(item, "word"), required(item, "imageSource"),
+                                       imageSourceType(text(item, "sourceType")));
+    }
+    if (game.getPairCount() == 0) throw std::runtime_error("game has no pairs for its type");
+    return game;
+}
+
+// Parse every file of one kind into the writer; returns how many
+template <typename Parse>
+size_t addAll(storage::ContentPackWriter& writer, const std::string& dir, const std::string& extension,
+              Parse parse) {
+    size_t count = 0;
+    for (const std::string& path : listFiles(dir, extension)) {
+        try {
+            writer.add(parse(readFile(path)));
+        } catch (const std::exception& e) {
+            throw std::runtime_error(path + ": " + e.what());
+        }
+        count++;
+    }
+    return count;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <source-dir> <output.pack>" << std::endl;
+        return 2;
+    }
+    std::string source = argv[1];
+    std::string output = argv[2];
+
+    storage::ContentPackWriter writer;
+    size_t lessons, tests, exercises, games;
+    try {
+        lessons = addAll(writer, source + "/lessons", ".md", parseLesson);
+        tests = addAll(writer, source + "/tests", ".json", parseTest);
+        exercises = addAll(writer, source + "/exercises", ".json", parseExercise);
+        games = addAll(writer, source + "/games", ".json", parseGame);
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::string error;
+    if (!writer.write(output, error)) {
+        std::cerr << "[ERROR] " << error << std::endl;
+        return 1;
+    }
+    std::cout << "Packed " << lessons << " lessons, " << tests << " tests, " << exercises << " exercises, "
+              << games << " games into " << output << std::endl;
+    std::cout << "Lesson text: " << writer.textBytes() << " bytes stored in " << writer.storedTextBytes()
+              << " (dictionary included)" << std::endl;
+    return 0;
+}